@@ -1,13 +1,46 @@
 #include "Buffer.hpp"
+#include "BufferPool.hpp"
+#include "ByteScan.hpp"
+#include <algorithm>
+#include <cstring>
+#include <errno.h>
+#include <utility>
 
-// 构造函数，初始化缓冲区
+// 构造函数，从BufferPool取出内存块，容量为所在级别的大小，内存不做清零
 Buffer::Buffer(size_t initbuffersize)
-    : write_pos(0), read_pos(0), buffer(initbuffersize) {
+    : buffer(BufferPool::allocate(initbuffersize)),
+      buffer_size(BufferPool::blockSize(initbuffersize)), read_pos(0),
+      write_pos(0) {
+}
+
+// 析构函数，内存块归还BufferPool
+Buffer::~Buffer() {
+    BufferPool::deallocate(buffer, buffer_size);
+}
+
+// 移动构造函数，接管other的内存块
+Buffer::Buffer(Buffer&& other) noexcept
+    : buffer(std::exchange(other.buffer, nullptr)),
+      buffer_size(std::exchange(other.buffer_size, 0)),
+      read_pos(std::exchange(other.read_pos, 0)),
+      write_pos(std::exchange(other.write_pos, 0)) {
+}
+
+// 移动赋值，归还自己的内存块后接管other的
+Buffer& Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        BufferPool::deallocate(buffer, buffer_size);
+        buffer = std::exchange(other.buffer, nullptr);
+        buffer_size = std::exchange(other.buffer_size, 0);
+        read_pos = std::exchange(other.read_pos, 0);
+        write_pos = std::exchange(other.write_pos, 0);
+    }
+    return *this;
 }
 
 // 获取缓冲区可写的字节数
 const size_t Buffer::writeableBytes() const {
-    return buffer.size() - write_pos;
+    return buffer_size - write_pos;
 }
 
 // 获取缓冲区可读的字节数
@@ -27,7 +60,7 @@ const char* Buffer::peek() const {
 
 // 确保缓冲区有足够的空间来写入指定长度的数据
 void Buffer::ensureWriteable(size_t len) {
-    if (buffer.size() - write_pos < len) {
+    if (buffer_size - write_pos < len) {
         // 空间不足，需要扩展
         makeSpace(len);
     }
@@ -73,12 +106,12 @@ std::string Buffer::retrieveAllToStr() {
 
 // 获取缓冲区可写位置的常量指针
 const char* Buffer::beginWriteConst() const {
-    return buffer.data() + write_pos;
+    return buffer + write_pos;
 }
 
 // 获取缓冲区可写位置的指针
 char* Buffer::beginWrite() {
-    return buffer.data() + write_pos;
+    return buffer + write_pos;
 }
 
 // 向缓冲区追加一个字符串
@@ -106,33 +139,59 @@ void Buffer::append(const Buffer& buff) {
     append(buff.peek(), buff.readableBytes());
 }
 
+// 清空缓冲区并在开头预留len字节
+void Buffer::reserveHeadroom(size_t len) {
+    retrieveAll();
+    ensureWriteable(len);
+    read_pos = len;
+    write_pos = len;
+}
+
+// 把数据写入可读数据之前的空间
+void Buffer::prepend(const void* data, size_t len) {
+    assert(len <= prependableBytes());
+    read_pos -= len;
+    memcpy(beginPtr() + read_pos, data, len);
+}
+
 // 从文件描述符中读取数据到缓冲区
-ssize_t Buffer::readFd(int fd, int* saveerrno) {
-    char buf[65535];
-    // 准备两个缓冲区：一个是当前Buffer对象的可写区域，一个是栈上的临时缓冲区
-    iovec iv[2];
-    iv[0].iov_base = beginWrite();
-    iv[0].iov_len = writeableBytes();
-    iv[1].iov_base = buf;
-    iv[1].iov_len = sizeof(buf);
-
-    // 使用readv一次性读取数据到两个缓冲区
-    const ssize_t rlen = readv(fd, iv, 2);
-
-    if (rlen < 0) {
-        // 读取出错
-        *saveerrno = errno;
-    } else if (static_cast<size_t>(rlen) <= writeableBytes()) {
-        // 数据全部读入Buffer对象的可写区域
+// 数据直接读入可写空间；一次读满说明可能还有数据，先腾出空间再继续读，
+// 不再经过栈上的临时缓冲区中转。腾空间时优先把未读数据搬到开头，
+// 不够时才扩容，每次只按下一次读取的量扩：随已有数据量成倍增加以摊薄拷贝，
+// 但不超过maxlen中剩余的额度
+ssize_t Buffer::readFd(int fd, int* saveerrno, size_t maxlen) {
+    assert(maxlen > 0);
+    size_t total = 0;
+    while (total < maxlen) {
+        const size_t toread = prepareRead(maxlen - total);
+        const ssize_t rlen = read(fd, beginWrite(), toread);
+        if (rlen < 0) {
+            if (total == 0) {
+                // 读取出错
+                *saveerrno = errno;
+                return rlen;
+            }
+            // 已经读到数据，错误留给下一次读取处理
+            break;
+        }
         hasWritten(rlen);
-    } else {
-        // 数据部分读入Buffer对象，部分读入栈上临时缓冲区
-        int rawwriteable = writeableBytes();
-        hasWritten(rawwriteable);
-        // 将栈上临时缓冲区的数据追加到Buffer对象
-        append(buf, rlen - rawwriteable);
+        total += rlen;
+        if (static_cast<size_t>(rlen) < toread) {
+            // 没有读满或对端已关闭，内核中暂时没有更多数据
+            break;
+        }
     }
-    return rlen;
+    return static_cast<ssize_t>(total);
+}
+
+// 准备可写空间，读满后腾出的空间按已有数据量成倍增长
+size_t Buffer::prepareRead(size_t maxlen) {
+    assert(maxlen > 0);
+    if (writeableBytes() == 0) {
+        size_t want = std::max(readableBytes(), BufferPool::MIN_BLOCK);
+        makeSpace(std::min(maxlen, want));
+    }
+    return std::min(writeableBytes(), maxlen);
 }
 
 // 将缓冲区中的数据写入到文件描述符
@@ -151,31 +210,85 @@ ssize_t Buffer::writeFd(int fd, int* saveerrno) {
     return wlen;
 }
 
+// 查找"\r\n"，由ByteScan按CPU支持情况向量化
+const char* Buffer::findCRLF() const {
+    return ByteScan::findCRLF(peek(), beginWriteConst());
+}
+
+// 从start开始查找"\r\n"
+const char* Buffer::findCRLF(const char* start) const {
+    assert(peek() <= start && start <= beginWriteConst());
+    return ByteScan::findCRLF(start, beginWriteConst());
+}
+
+// 查找请求头结束标志"\r\n\r\n"
+const char* Buffer::findHeaderEnd() const {
+    return ByteScan::findHeaderEnd(peek(), beginWriteConst());
+}
+
+// 从start开始查找请求头结束标志"\r\n\r\n"
+const char* Buffer::findHeaderEnd(const char* start) const {
+    assert(peek() <= start && start <= beginWriteConst());
+    return ByteScan::findHeaderEnd(start, beginWriteConst());
+}
+
+// 查找字符c
+const char* Buffer::findChar(char c) const {
+    return ByteScan::findChar(peek(), beginWriteConst(), c);
+}
+
+// 获取内存块大小
+size_t Buffer::capacity() const {
+    return buffer_size;
+}
+
+// 容量超过keepsize时换成较小的内存块，未读数据较多时保留足够的容量
+void Buffer::shrink(size_t keepsize) {
+    size_t target = BufferPool::blockSize(std::max(readableBytes(), keepsize));
+    if (target < buffer_size) {
+        reallocate(target);
+    }
+}
+
 // 获取缓冲区的起始指针
 char* Buffer::beginPtr() {
-    return buffer.data();
+    return buffer;
 }
 
 // 获取缓冲区的起始常量指针
 const char* Buffer::beginPtr() const {
-    return buffer.data();
+    return buffer;
 }
 
 // 确保缓冲区有足够的空间来容纳指定长度的数据
 void Buffer::makeSpace(size_t len) {
     size_t left = prependableBytes();
     size_t right = writeableBytes();
+    size_t readable = readableBytes();
 
-    if (left + right >= len) {
-        // 通过移动数据来腾出空间
-        std::copy(
-            buffer.begin() + read_pos,
-            buffer.begin() + write_pos,
-            buffer.begin());
-        write_pos -= read_pos;
-        read_pos = 0;
-    } else {
-        // 空间不足，需要扩展缓冲区
-        buffer.resize(write_pos + len);
+    if (left + right < len) {
+        // 搬移后仍然不够，换一块更大的内存，只拷贝尚未读取的数据
+        reallocate(readable + len);
+        return;
+    }
+    // 通过移动数据来腾出空间
+    memmove(beginPtr(), peek(), readable);
+    read_pos = 0;
+    write_pos = readable;
+}
+
+// 换成一块至少size字节的内存块
+void Buffer::reallocate(size_t size) {
+    size_t readable = readableBytes();
+    assert(size >= readable);
+    size_t newsize = BufferPool::blockSize(size);
+    char* newbuffer = BufferPool::allocate(newsize);
+    if (readable > 0) {
+        memcpy(newbuffer, peek(), readable);
     }
-}
\ No newline at end of file
+    BufferPool::deallocate(buffer, buffer_size);
+    buffer = newbuffer;
+    buffer_size = newsize;
+    read_pos = 0;
+    write_pos = readable;
+}
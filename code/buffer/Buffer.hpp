@@ -1,6 +1,7 @@
 #pragma once
 
 #include <assert.h>
+#include <stdint.h>
 #include <sys/uio.h>
 #include <unistd.h>
 //#include <atomic>
@@ -8,12 +9,18 @@
 #include <vector>
 
 // 缓冲区类，用于管理数据的读写操作
+// 存储是一整块连续内存，供解析器直接在原始字节上查找；
+// 内存块取自BufferPool，扩容时只拷贝尚未读取的数据，新空间不做清零
 class Buffer {
    public:
     // 构造函数，初始化缓冲区大小，默认为 1024 字节
     Buffer(size_t initbuffersize = 1024);
-    // 析构函数
-    ~Buffer() = default;
+    // 析构函数，内存块归还BufferPool
+    ~Buffer();
+    Buffer(Buffer&& other) noexcept;
+    Buffer& operator=(Buffer&& other) noexcept;
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
 
     // 获取缓冲区可写的字节数
     const size_t writeableBytes() const;
@@ -49,10 +56,35 @@ class Buffer {
     void append(const void* data, size_t len);
     // 向缓冲区追加另一个 Buffer 对象的数据
     void append(const Buffer& buff);
-    // 从文件描述符中读取数据到缓冲区，返回读取的字节数，errno 用于存储错误码
-    ssize_t readFd(int fd, int* saveerrno);
+    // 清空缓冲区并在开头预留len字节，之后可以用prepend写入
+    void reserveHeadroom(size_t len);
+    // 把数据写入可读数据之前的空间，len不能超过prependableBytes()
+    void prepend(const void* data, size_t len);
+    // 从文件描述符中读取数据到缓冲区，直接读入可写空间，读满则腾出空间
+    // 后继续读，最多读取maxlen（须大于0）字节，其余数据留在内核中。
+    // 返回读取的字节数，errno 用于存储错误码
+    ssize_t readFd(int fd, int* saveerrno, size_t maxlen = SIZE_MAX);
+    // 为一次读取准备可写空间：没有可写空间时按readFd的规则扩容，
+    // 返回本次最多读入beginWrite()处的字节数（不超过maxlen，须大于0）。
+    // 供异步读取使用时，读取完成并hasWritten之前不能再改动缓冲区
+    size_t prepareRead(size_t maxlen);
     // 将缓冲区中的数据写入到文件描述符，返回写入的字节数，errno 用于存储错误码
     ssize_t writeFd(int fd, int* saveerrno);
+    // 在可读数据中查找"\r\n"，返回'\r'的位置，找不到时返回nullptr
+    const char* findCRLF() const;
+    // 从start开始查找"\r\n"，start须位于可读数据中
+    const char* findCRLF(const char* start) const;
+    // 在可读数据中查找请求头结束标志"\r\n\r\n"，返回第一个'\r'的位置
+    const char* findHeaderEnd() const;
+    // 从start开始查找"\r\n\r\n"，start须位于可读数据中
+    const char* findHeaderEnd(const char* start) const;
+    // 在可读数据中查找字符c
+    const char* findChar(char c) const;
+    // 获取内存块大小
+    size_t capacity() const;
+    // 容量超过keepsize时换成能容纳未读数据的较小内存块（至少keepsize），
+    // 用于把空闲连接多占的内存还给BufferPool
+    void shrink(size_t keepsize);
 
    private:
     // 获取缓冲区的起始指针
@@ -61,9 +93,13 @@ class Buffer {
     const char* beginPtr() const;
     // 确保缓冲区有足够的空间来容纳指定长度的数据
     void makeSpace(size_t len);
+    // 换成一块至少size字节的内存块，未读数据移到开头
+    void reallocate(size_t size);
 
-    // 存储数据的向量
-    std::vector<char> buffer;
+    // 存储数据的内存块
+    char* buffer;
+    // 内存块大小
+    size_t buffer_size;
     // 读取位置的原子变量
     size_t read_pos;
     // 写入位置的原子变量
@@ -0,0 +1,154 @@
+#include "BufferPool.hpp"
+#include <atomic>
+#include <bit>
+#include <vector>
+
+namespace {
+
+// 全局计数，只用于统计，使用relaxed顺序
+struct PoolCounters {
+    std::atomic<size_t> in_use_bytes{0};
+    std::atomic<size_t> in_use_blocks{0};
+    std::atomic<size_t> cached_bytes{0};
+    std::atomic<size_t> cached_blocks{0};
+    std::atomic<size_t> hit_count{0};
+    std::atomic<size_t> miss_count{0};
+};
+
+PoolCounters pool_counters;
+
+// 计数加减
+void addCount(std::atomic<size_t>& counter, size_t n) {
+    counter.fetch_add(n, std::memory_order_relaxed);
+}
+void subCount(std::atomic<size_t>& counter, size_t n) {
+    counter.fetch_sub(n, std::memory_order_relaxed);
+}
+
+// 获取size所在的级别，超过最大级别时返回CLASS_NUM
+size_t classOf(size_t size) {
+    if (size <= BufferPool::MIN_BLOCK) {
+        return 0;
+    }
+    if (size > BufferPool::MAX_BLOCK) {
+        return BufferPool::CLASS_NUM;
+    }
+    return std::bit_width(size - 1) - std::bit_width(BufferPool::MIN_BLOCK - 1);
+}
+
+// 级别对应的内存块大小
+size_t classSize(size_t index) {
+    return BufferPool::MIN_BLOCK << index;
+}
+
+// 级别对应的缓存上限（内存块数）
+size_t classLimit(size_t index) {
+    size_t limit = BufferPool::MAX_CACHED_BYTES / classSize(index);
+    return limit > BufferPool::MIN_CACHED ? limit : BufferPool::MIN_CACHED;
+}
+
+// 当前线程的缓存是否已经析构。没有析构函数的thread_local变量在线程
+// 退出的整个过程中都可以访问，用它判断缓存还能不能用
+thread_local bool cache_destroyed = false;
+
+// 线程私有的内存块缓存，线程退出时释放。
+// 析构顺序不受控制：比它后析构的thread_local对象和主线程中的静态对象
+// （如Log中的Buffer）仍会释放内存块，此后的分配和释放都直接使用new/delete
+struct ThreadCache {
+    std::vector<char*> free_blocks[BufferPool::CLASS_NUM];
+
+    ~ThreadCache() {
+        trim();
+        cache_destroyed = true;
+    }
+
+    // 释放所有缓存的内存块
+    void trim() {
+        for (size_t i = 0; i < BufferPool::CLASS_NUM; i++) {
+            for (char* block : free_blocks[i]) {
+                delete[] block;
+            }
+            subCount(pool_counters.cached_blocks, free_blocks[i].size());
+            subCount(
+                pool_counters.cached_bytes,
+                free_blocks[i].size() * classSize(i));
+            free_blocks[i].clear();
+        }
+    }
+};
+
+thread_local ThreadCache thread_cache;
+
+} // namespace
+
+// 分配内存块：优先从当前线程的缓存中取，不做清零
+char* BufferPool::allocate(size_t size) {
+    size_t index = classOf(size);
+    size_t blocksize = blockSize(size);
+    char* block = nullptr;
+    if (index < CLASS_NUM && !cache_destroyed
+        && !thread_cache.free_blocks[index].empty()) {
+        block = thread_cache.free_blocks[index].back();
+        thread_cache.free_blocks[index].pop_back();
+        subCount(pool_counters.cached_blocks, 1);
+        subCount(pool_counters.cached_bytes, blocksize);
+        addCount(pool_counters.hit_count, 1);
+    } else {
+        block = new char[blocksize];
+        addCount(pool_counters.miss_count, 1);
+    }
+    addCount(pool_counters.in_use_blocks, 1);
+    addCount(pool_counters.in_use_bytes, blocksize);
+    return block;
+}
+
+// 归还内存块：放入当前线程的缓存，超过上限或最大级别时直接释放
+void BufferPool::deallocate(char* block, size_t size) {
+    if (!block) {
+        return;
+    }
+    size_t index = classOf(size);
+    subCount(pool_counters.in_use_blocks, 1);
+    subCount(pool_counters.in_use_bytes, size);
+    if (index < CLASS_NUM && !cache_destroyed
+        && thread_cache.free_blocks[index].size() < classLimit(index)) {
+        thread_cache.free_blocks[index].push_back(block);
+        addCount(pool_counters.cached_blocks, 1);
+        addCount(pool_counters.cached_bytes, size);
+        return;
+    }
+    delete[] block;
+}
+
+// 获取size所在级别的内存块大小
+size_t BufferPool::blockSize(size_t size) {
+    size_t index = classOf(size);
+    return index < CLASS_NUM ? classSize(index) : size;
+}
+
+// 当前线程缓存的内存块数
+size_t BufferPool::cachedBlocks(size_t size) {
+    size_t index = classOf(size);
+    if (index >= CLASS_NUM || cache_destroyed) {
+        return 0;
+    }
+    return thread_cache.free_blocks[index].size();
+}
+
+// 释放当前线程缓存的所有内存块
+void BufferPool::trimThreadCache() {
+    if (!cache_destroyed) {
+        thread_cache.trim();
+    }
+}
+
+// 获取全局占用情况
+BufferPool::Stats BufferPool::stats() {
+    return {
+        pool_counters.in_use_bytes.load(std::memory_order_relaxed),
+        pool_counters.in_use_blocks.load(std::memory_order_relaxed),
+        pool_counters.cached_bytes.load(std::memory_order_relaxed),
+        pool_counters.cached_blocks.load(std::memory_order_relaxed),
+        pool_counters.hit_count.load(std::memory_order_relaxed),
+        pool_counters.miss_count.load(std::memory_order_relaxed)};
+}
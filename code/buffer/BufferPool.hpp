@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+
+// 缓冲区内存块池
+// 按2的幂划分大小级别（1KB到1MB），每个线程为每个级别缓存自己释放的内存块，
+// 分配和释放都不加锁；某级别的缓存超过上限时多余的内存块直接释放。
+// 超过最大级别的内存块不缓存，直接向系统申请和释放。
+// 所有线程的占用和缓存情况汇总在全局计数中，供运行时查看
+class BufferPool {
+  public:
+    // 最小级别的内存块大小
+    static constexpr size_t MIN_BLOCK = 1024;
+    // 最大级别的内存块大小
+    static constexpr size_t MAX_BLOCK = 1024 * 1024;
+    // 大小级别数
+    static constexpr size_t CLASS_NUM = 11;
+    // 每个线程每个级别最多缓存的字节数（至少缓存MIN_CACHED个内存块）
+    static constexpr size_t MAX_CACHED_BYTES = 4 * 1024 * 1024;
+    // 每个线程每个级别至少可缓存的内存块数
+    static constexpr size_t MIN_CACHED = 4;
+
+    // 内存池的占用情况
+    struct Stats {
+        size_t in_use_bytes;  // 分配出去尚未归还的字节数
+        size_t in_use_blocks; // 分配出去尚未归还的内存块数
+        size_t cached_bytes;  // 各线程缓存中的字节数
+        size_t cached_blocks; // 各线程缓存中的内存块数
+        size_t hit_count;     // 从缓存中直接取到内存块的次数
+        size_t miss_count;    // 缓存为空或超过最大级别而向系统申请的次数
+    };
+
+    // 分配一个至少size字节的内存块，实际大小为blockSize(size)，内容未初始化
+    static char* allocate(size_t size);
+    // 归还内存块，size必须是分配时的blockSize(size)
+    static void deallocate(char* block, size_t size);
+    // 获取size所在级别的内存块大小，超过最大级别时即为size本身
+    static size_t blockSize(size_t size);
+    // 当前线程缓存的、大小为blockSize(size)的内存块数
+    static size_t cachedBlocks(size_t size);
+    // 释放当前线程缓存的所有内存块
+    static void trimThreadCache();
+    // 获取全局占用情况
+    static Stats stats();
+};
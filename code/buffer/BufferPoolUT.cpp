@@ -0,0 +1,125 @@
+#include "Buffer.hpp"
+#include "BufferPool.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+
+/**
+ * 测试大小按级别向上取整，超过最大级别时保持原值
+ */
+TEST(BufferPoolTest, BlockSizeShouldRoundUpToClass) {
+    EXPECT_EQ(BufferPool::blockSize(1), BufferPool::MIN_BLOCK);
+    EXPECT_EQ(BufferPool::blockSize(1024), 1024u);
+    EXPECT_EQ(BufferPool::blockSize(1025), 2048u);
+    EXPECT_EQ(BufferPool::blockSize(100000), 131072u);
+    EXPECT_EQ(
+        BufferPool::blockSize(BufferPool::MAX_BLOCK),
+        BufferPool::MAX_BLOCK);
+    EXPECT_EQ(
+        BufferPool::blockSize(BufferPool::MAX_BLOCK + 1),
+        BufferPool::MAX_BLOCK + 1);
+}
+
+/**
+ * 测试归还的内存块被同一线程复用，统计随之变化
+ */
+TEST(BufferPoolTest, ReleasedBlockShouldBeReused) {
+    BufferPool::trimThreadCache();
+    BufferPool::Stats before = BufferPool::stats();
+    char* block = BufferPool::allocate(3000);
+    BufferPool::Stats used = BufferPool::stats();
+    EXPECT_EQ(used.in_use_bytes, before.in_use_bytes + 4096);
+    EXPECT_EQ(used.in_use_blocks, before.in_use_blocks + 1);
+
+    BufferPool::deallocate(block, 4096);
+    EXPECT_EQ(BufferPool::cachedBlocks(4096), 1u);
+    BufferPool::Stats cached = BufferPool::stats();
+    EXPECT_EQ(cached.in_use_bytes, before.in_use_bytes);
+    EXPECT_EQ(cached.cached_bytes, before.cached_bytes + 4096);
+
+    EXPECT_EQ(BufferPool::allocate(4000), block);
+    EXPECT_EQ(BufferPool::stats().hit_count, cached.hit_count + 1);
+    BufferPool::deallocate(block, 4096);
+    BufferPool::trimThreadCache();
+    EXPECT_EQ(BufferPool::cachedBlocks(4096), 0u);
+    EXPECT_EQ(BufferPool::stats().cached_bytes, before.cached_bytes);
+}
+
+/**
+ * 测试每个级别的缓存有上限，超出部分直接释放
+ */
+TEST(BufferPoolTest, CacheShouldBeBounded) {
+    BufferPool::trimThreadCache();
+    const size_t size = BufferPool::MAX_BLOCK;
+    std::vector<char*> blocks;
+    for (size_t i = 0; i < BufferPool::MIN_CACHED + 2; i++) {
+        blocks.push_back(BufferPool::allocate(size));
+    }
+    for (char* block : blocks) {
+        BufferPool::deallocate(block, size);
+    }
+    EXPECT_EQ(BufferPool::cachedBlocks(size), BufferPool::MIN_CACHED);
+    BufferPool::trimThreadCache();
+}
+
+/**
+ * 测试线程退出时其缓存被释放
+ */
+TEST(BufferPoolTest, ThreadCacheShouldBeFreedOnExit) {
+    BufferPool::Stats before = BufferPool::stats();
+    std::thread([] {
+        BufferPool::deallocate(BufferPool::allocate(8192), 8192);
+        EXPECT_EQ(BufferPool::cachedBlocks(8192), 1u);
+    }).join();
+    BufferPool::Stats after = BufferPool::stats();
+    EXPECT_EQ(after.cached_bytes, before.cached_bytes);
+    EXPECT_EQ(after.in_use_bytes, before.in_use_bytes);
+}
+
+namespace {
+
+// 在线程的缓存之前构造、因而在它之后析构的thread_local对象，
+// 析构时才归还持有的内存块，模拟主线程退出时静态对象中的Buffer
+struct LateHolder {
+    char* block = nullptr;
+
+    ~LateHolder() {
+        BufferPool::deallocate(block, 8192);
+    }
+};
+
+} // namespace
+
+/**
+ * 测试缓存析构后归还的内存块直接释放，不再放入已析构的缓存
+ */
+TEST(BufferPoolTest, BlockFreedAfterCacheTeardownShouldBeDeleted) {
+    BufferPool::Stats before = BufferPool::stats();
+    std::thread([] {
+        thread_local LateHolder holder;
+        holder.block = BufferPool::allocate(8192);
+    }).join();
+    BufferPool::Stats after = BufferPool::stats();
+    EXPECT_EQ(after.cached_blocks, before.cached_blocks);
+    EXPECT_EQ(after.cached_bytes, before.cached_bytes);
+    EXPECT_EQ(after.in_use_blocks, before.in_use_blocks);
+    EXPECT_EQ(after.in_use_bytes, before.in_use_bytes);
+}
+
+/**
+ * 测试Buffer扩容后可以缩小，且保留未读数据
+ */
+TEST(BufferPoolTest, BufferShouldShrinkKeepingData) {
+    Buffer buff(1024);
+    EXPECT_EQ(buff.capacity(), 1024u);
+    std::string data(200000, 'x');
+    buff.append(data);
+    EXPECT_GE(buff.capacity(), data.size());
+    buff.retrieve(data.size() - 10);
+
+    buff.shrink(4096);
+    EXPECT_EQ(buff.capacity(), 4096u);
+    EXPECT_EQ(buff.retrieveAllToStr(), std::string(10, 'x'));
+
+    buff.shrink(8192);
+    EXPECT_EQ(buff.capacity(), 4096u);
+}
@@ -0,0 +1,340 @@
+#include "ByteScan.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BYTESCAN_X86 1
+#endif
+
+namespace {
+
+// 标量实现：单字符查找交给memchr
+const char* scalarFindChar(const char* begin, const char* end, char c) {
+    if (begin >= end) {
+        return nullptr;
+    }
+    return static_cast<const char*>(memchr(begin, c, end - begin));
+}
+
+// 标量实现：逐字节比较
+const char*
+scalarFindEither(const char* begin, const char* end, char a, char b) {
+    for (const char* p = begin; p < end; p++) {
+        if (*p == a || *p == b) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// 标量实现：先找'\r'，再看下一个字节是否为'\n'
+const char* scalarFindCRLF(const char* begin, const char* end) {
+    const char* p = begin;
+    while (end - p >= 2) {
+        p = static_cast<const char*>(memchr(p, '\r', end - p - 1));
+        if (!p) {
+            return nullptr;
+        }
+        if (p[1] == '\n') {
+            return p;
+        }
+        p++;
+    }
+    return nullptr;
+}
+
+// 标量实现：逐个CRLF检查其后是否紧跟另一个CRLF
+const char* scalarFindHeaderEnd(const char* begin, const char* end) {
+    const char* p = begin;
+    while (end - p >= 4) {
+        p = scalarFindCRLF(p, end - 2);
+        if (!p) {
+            return nullptr;
+        }
+        if (p[2] == '\r' && p[3] == '\n') {
+            return p;
+        }
+        p++;
+    }
+    return nullptr;
+}
+
+#ifdef BYTESCAN_X86
+
+// SSE2实现：每次比较16个字节，剩余不足一组的部分用标量实现
+const char* sse2FindChar(const char* begin, const char* end, char c) {
+    const __m128i target = _mm_set1_epi8(c);
+    const char* p = begin;
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, target));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return scalarFindChar(p, end, c);
+}
+
+// SSE2实现：分别与a和b比较后相或
+const char*
+sse2FindEither(const char* begin, const char* end, char a, char b) {
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const char* p = begin;
+    for (; end - p >= 16; p += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_or_si128(
+            _mm_cmpeq_epi8(block, va),
+            _mm_cmpeq_epi8(block, vb)));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return scalarFindEither(p, end, a, b);
+}
+
+// SSE2实现：错开一个字节各读一组，分别与'\r'和'\n'比较后相与，
+// 跨组的CRLF由下一组或末尾的标量查找覆盖
+const char* sse2FindCRLF(const char* begin, const char* end) {
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 17; p += 16) {
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        int mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(b0, cr), _mm_cmpeq_epi8(b1, lf)));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return scalarFindCRLF(p, end);
+}
+
+// SSE2实现：错开0到3个字节读四组，依次匹配"\r\n\r\n"
+const char* sse2FindHeaderEnd(const char* begin, const char* end) {
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 19; p += 16) {
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 2));
+        __m128i b3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 3));
+        __m128i m = _mm_and_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(b0, cr), _mm_cmpeq_epi8(b1, lf)),
+            _mm_and_si128(_mm_cmpeq_epi8(b2, cr), _mm_cmpeq_epi8(b3, lf)));
+        int mask = _mm_movemask_epi8(m);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return scalarFindHeaderEnd(p, end);
+}
+
+// AVX2实现：每次比较32个字节，其余同SSE2实现
+__attribute__((target("avx2"))) const char*
+avx2FindChar(const char* begin, const char* end, char c) {
+    const __m256i target = _mm256_set1_epi8(c);
+    const char* p = begin;
+    for (; end - p >= 32; p += 32) {
+        __m256i block =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = static_cast<unsigned>(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, target)));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return sse2FindChar(p, end, c);
+}
+
+// AVX2实现
+__attribute__((target("avx2"))) const char*
+avx2FindEither(const char* begin, const char* end, char a, char b) {
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    const char* p = begin;
+    for (; end - p >= 32; p += 32) {
+        __m256i block =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(block, va),
+                _mm256_cmpeq_epi8(block, vb))));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return sse2FindEither(p, end, a, b);
+}
+
+// AVX2实现
+__attribute__((target("avx2"))) const char*
+avx2FindCRLF(const char* begin, const char* end) {
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 33; p += 32) {
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i b1 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_and_si256(
+                _mm256_cmpeq_epi8(b0, cr),
+                _mm256_cmpeq_epi8(b1, lf))));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return sse2FindCRLF(p, end);
+}
+
+// AVX2实现
+__attribute__((target("avx2"))) const char*
+avx2FindHeaderEnd(const char* begin, const char* end) {
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const char* p = begin;
+    for (; end - p >= 35; p += 32) {
+        __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i b1 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        __m256i b2 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 2));
+        __m256i b3 =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 3));
+        __m256i m = _mm256_and_si256(
+            _mm256_and_si256(
+                _mm256_cmpeq_epi8(b0, cr),
+                _mm256_cmpeq_epi8(b1, lf)),
+            _mm256_and_si256(
+                _mm256_cmpeq_epi8(b2, cr),
+                _mm256_cmpeq_epi8(b3, lf)));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    return sse2FindHeaderEnd(p, end);
+}
+
+#endif // BYTESCAN_X86
+
+// 一种实现级别的函数表
+struct ScanOps {
+    ByteScan::LEVEL level;
+    const char* (*find_char)(const char*, const char*, char);
+    const char* (*find_either)(const char*, const char*, char, char);
+    const char* (*find_crlf)(const char*, const char*);
+    const char* (*find_header_end)(const char*, const char*);
+};
+
+constexpr ScanOps SCALAR_OPS{
+    ByteScan::LEVEL::SCALAR,
+    scalarFindChar,
+    scalarFindEither,
+    scalarFindCRLF,
+    scalarFindHeaderEnd};
+
+#ifdef BYTESCAN_X86
+constexpr ScanOps SSE2_OPS{
+    ByteScan::LEVEL::SSE2,
+    sse2FindChar,
+    sse2FindEither,
+    sse2FindCRLF,
+    sse2FindHeaderEnd};
+
+constexpr ScanOps AVX2_OPS{
+    ByteScan::LEVEL::AVX2,
+    avx2FindChar,
+    avx2FindEither,
+    avx2FindCRLF,
+    avx2FindHeaderEnd};
+#endif
+
+// 获取级别对应的函数表，当前CPU不支持时返回nullptr
+const ScanOps* opsFor(ByteScan::LEVEL level) {
+    switch (level) {
+#ifdef BYTESCAN_X86
+    case ByteScan::LEVEL::AVX2:
+        return __builtin_cpu_supports("avx2") ? &AVX2_OPS : nullptr;
+    case ByteScan::LEVEL::SSE2:
+        return __builtin_cpu_supports("sse2") ? &SSE2_OPS : nullptr;
+#endif
+    case ByteScan::LEVEL::SCALAR:
+        return &SCALAR_OPS;
+    default:
+        return nullptr;
+    }
+}
+
+// 选出当前CPU支持的最快实现
+const ScanOps* detectOps() {
+#ifdef BYTESCAN_X86
+    // 在静态初始化阶段调用，需先初始化CPU特性信息
+    __builtin_cpu_init();
+#endif
+    if (const ScanOps* ops = opsFor(ByteScan::LEVEL::AVX2)) {
+        return ops;
+    }
+    if (const ScanOps* ops = opsFor(ByteScan::LEVEL::SSE2)) {
+        return ops;
+    }
+    return &SCALAR_OPS;
+}
+
+// 当前使用的函数表。先静态初始化为标量实现，保证其他静态对象的构造
+// 也能安全调用，随后在动态初始化阶段换成检测到的最快实现
+const ScanOps* scan_ops = &SCALAR_OPS;
+const bool scan_detected = (scan_ops = detectOps(), true);
+
+} // namespace
+
+// 查找字符c
+const char* ByteScan::findChar(const char* begin, const char* end, char c) {
+    return scan_ops->find_char(begin, end, c);
+}
+
+// 查找字符a或b
+const char*
+ByteScan::findEither(const char* begin, const char* end, char a, char b) {
+    return scan_ops->find_either(begin, end, a, b);
+}
+
+// 查找"\r\n"
+const char* ByteScan::findCRLF(const char* begin, const char* end) {
+    return scan_ops->find_crlf(begin, end);
+}
+
+// 查找"\r\n\r\n"
+const char* ByteScan::findHeaderEnd(const char* begin, const char* end) {
+    return scan_ops->find_header_end(begin, end);
+}
+
+// 获取当前使用的实现级别
+ByteScan::LEVEL ByteScan::level() {
+    return scan_ops->level;
+}
+
+// 获取实现级别的名称
+const char* ByteScan::levelName(LEVEL level) {
+    switch (level) {
+    case LEVEL::AVX2:
+        return "avx2";
+    case LEVEL::SSE2:
+        return "sse2";
+    default:
+        return "scalar";
+    }
+}
+
+// 切换实现级别
+bool ByteScan::setLevel(LEVEL level) {
+    const ScanOps* ops = opsFor(level);
+    if (!ops) {
+        return false;
+    }
+    scan_ops = ops;
+    return true;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+// 向量化的字节查找
+// 在[begin, end)中查找单个字符、两个字符之一、CRLF和请求头结束标志CRLFCRLF，
+// 找不到时返回nullptr。x86上按CPU支持情况在运行时选择AVX2或SSE2实现，
+// 一次比较32或16个字节；其他平台使用标量实现（基于memchr）
+class ByteScan {
+  public:
+    // 实现级别
+    enum class LEVEL {
+        SCALAR, // 标量实现
+        SSE2,   // 每次比较16字节
+        AVX2,   // 每次比较32字节
+    };
+
+    // 查找字符c
+    static const char* findChar(const char* begin, const char* end, char c);
+    // 查找第一个等于a或b的字符
+    static const char*
+    findEither(const char* begin, const char* end, char a, char b);
+    // 查找"\r\n"，返回'\r'的位置
+    static const char* findCRLF(const char* begin, const char* end);
+    // 查找"\r\n\r\n"，返回第一个'\r'的位置
+    static const char* findHeaderEnd(const char* begin, const char* end);
+
+    // 获取当前使用的实现级别
+    static LEVEL level();
+    // 获取实现级别的名称
+    static const char* levelName(LEVEL level);
+    // 切换实现级别（用于测试和对比），CPU不支持时返回false且不切换。
+    // 只应在没有其他线程查找时调用
+    static bool setLevel(LEVEL level);
+};
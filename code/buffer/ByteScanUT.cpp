@@ -0,0 +1,108 @@
+#include "Buffer.hpp"
+#include "ByteScan.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+/**
+ * 用std::search作为参照实现，找不到时返回nullptr
+ */
+static const char* refSearch(
+    const char* begin,
+    const char* end,
+    const std::string& pattern) {
+    const char* p =
+        std::search(begin, end, pattern.begin(), pattern.end());
+    return p == end ? nullptr : p;
+}
+
+/**
+ * 在所有可用的实现级别上运行检查
+ */
+template <typename Fn> static void forEachLevel(Fn check) {
+    ByteScan::LEVEL saved = ByteScan::level();
+    for (ByteScan::LEVEL level :
+         {ByteScan::LEVEL::SCALAR,
+          ByteScan::LEVEL::SSE2,
+          ByteScan::LEVEL::AVX2}) {
+        if (!ByteScan::setLevel(level)) {
+            continue;
+        }
+        SCOPED_TRACE(ByteScan::levelName(level));
+        check();
+    }
+    ByteScan::setLevel(saved);
+}
+
+/**
+ * 测试各实现在任意起止位置上与参照实现一致，覆盖跨组的匹配
+ */
+TEST(ByteScanTest, AllLevelsShouldMatchReference) {
+    std::mt19937 rng(12345);
+    const char alphabet[] = "ab\r\n:";
+    std::string data(300, 'a');
+    for (char& c : data) {
+        c = alphabet[rng() % 5];
+    }
+    forEachLevel([&] {
+        for (size_t from = 0; from < 40; from++) {
+            for (size_t to = from; to <= data.size(); to += 7) {
+                const char* b = data.data() + from;
+                const char* e = data.data() + to;
+                ASSERT_EQ(ByteScan::findCRLF(b, e), refSearch(b, e, "\r\n"));
+                ASSERT_EQ(
+                    ByteScan::findHeaderEnd(b, e),
+                    refSearch(b, e, "\r\n\r\n"));
+                ASSERT_EQ(ByteScan::findChar(b, e, ':'), refSearch(b, e, ":"));
+                const char* either = std::find_if(b, e, [](char c) {
+                    return c == ':' || c == '\n';
+                });
+                ASSERT_EQ(
+                    ByteScan::findEither(b, e, ':', '\n'),
+                    either == e ? nullptr : either);
+            }
+        }
+    });
+}
+
+/**
+ * 测试匹配位于长数据的末尾、跨越向量分组边界的情况
+ */
+TEST(ByteScanTest, MatchAtGroupBoundaryShouldBeFound) {
+    forEachLevel([] {
+        for (size_t pos = 0; pos < 70; pos++) {
+            std::string data(pos, 'x');
+            data += "\r\n\r\n";
+            data += std::string(5, 'y');
+            const char* b = data.data();
+            const char* e = b + data.size();
+            ASSERT_EQ(ByteScan::findCRLF(b, e), b + pos);
+            ASSERT_EQ(ByteScan::findHeaderEnd(b, e), b + pos);
+            ASSERT_EQ(ByteScan::findChar(b, e, '\n'), b + pos + 1);
+            ASSERT_EQ(ByteScan::findEither(b, e, 'y', '\n'), b + pos + 1);
+            ASSERT_EQ(ByteScan::findEither(b, b + pos, '\r', '\n'), nullptr);
+            // 截断在CRLF中间时找不到
+            ASSERT_EQ(ByteScan::findCRLF(b, b + pos + 1), nullptr);
+            ASSERT_EQ(ByteScan::findHeaderEnd(b, b + pos + 3), nullptr);
+        }
+    });
+}
+
+/**
+ * 测试Buffer上的查找只在可读数据范围内进行
+ */
+TEST(ByteScanTest, BufferFindShouldStayInReadableRange) {
+    Buffer buff(64);
+    buff.append("\r\nGET / HTTP/1.1\r\nHost: a\r\n\r\nbody");
+    buff.retrieve(2);
+    const char* line = buff.findCRLF();
+    ASSERT_NE(line, nullptr);
+    EXPECT_EQ(std::string(buff.peek(), line), "GET / HTTP/1.1");
+    const char* headerend = buff.findHeaderEnd();
+    ASSERT_NE(headerend, nullptr);
+    EXPECT_EQ(std::string(headerend + 4, buff.beginWriteConst()), "body");
+    EXPECT_EQ(buff.findCRLF(headerend + 4), nullptr);
+    EXPECT_EQ(*buff.findChar(':'), ':');
+    EXPECT_EQ(buff.findChar('#'), nullptr);
+}
@@ -0,0 +1,339 @@
+#include "ChainBuffer.hpp"
+#include "BufferPool.hpp"
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+#include <errno.h>
+
+static_assert(
+    (SlicePool::SLICE_SIZE & (SlicePool::SLICE_SIZE - 1)) == 0
+        && SlicePool::SLICE_SIZE >= BufferPool::MIN_BLOCK
+        && SlicePool::SLICE_SIZE <= BufferPool::MAX_BLOCK,
+    "slice size must be a BufferPool size class");
+
+// 取出一个内存片
+char* SlicePool::acquire() {
+    return BufferPool::allocate(SLICE_SIZE);
+}
+
+// 归还内存片
+void SlicePool::release(char* slice) {
+    BufferPool::deallocate(slice, SLICE_SIZE);
+}
+
+// 当前线程缓存的内存片数
+size_t SlicePool::cachedCount() {
+    return BufferPool::cachedBlocks(SLICE_SIZE);
+}
+
+// 析构函数
+ChainBuffer::~ChainBuffer() {
+    retrieveAll();
+}
+
+// 获取可读的字节数
+size_t ChainBuffer::readableBytes() const {
+    return chain_bytes;
+}
+
+// 获取当前的内存段数
+size_t ChainBuffer::segmentCount() const {
+    return chain_segs.size() - chain_head;
+}
+
+// 向缓冲区追加数据，写满末尾内存片后再取新的内存片
+void ChainBuffer::append(const char* str, size_t len) {
+    while (len > 0) {
+        size_t space = tailSpace();
+        if (space == 0) {
+            pushSlice(SlicePool::acquire());
+            space = SlicePool::SLICE_SIZE;
+        }
+        size_t n = std::min(space, len);
+        Segment& tail = chain_segs.back();
+        memcpy(tail.base + tail.end, str, n);
+        tail.end += n;
+        chain_bytes += n;
+        str += n;
+        len -= n;
+    }
+}
+
+// 向缓冲区追加一个字符串
+void ChainBuffer::append(const std::string& str) {
+    append(str.data(), str.length());
+}
+
+// 向缓冲区追加一个指定长度的数据
+void ChainBuffer::append(const void* data, size_t len) {
+    append(static_cast<const char*>(data), len);
+}
+
+// 挂入一段外部内存，空的内存段不挂入，带释放函数时立即释放
+void ChainBuffer::appendExternal(
+    const char* data, size_t len, Releaser release) {
+    Segment seg{const_cast<char*>(data), 0, len, false, release};
+    if (len == 0) {
+        releaseSegment(seg);
+        return;
+    }
+    chain_segs.push_back(seg);
+    chain_bytes += len;
+}
+
+// 预留头部空间
+// 末尾内存片还放得下时，在已有数据之后切出一个新段，内存片改由新段归还，
+// 流水线上的多个小响应因此共用同一个内存片；否则新取一个内存片
+void ChainBuffer::reserveHeadroom(size_t len) {
+    assert(len <= SlicePool::SLICE_SIZE);
+    if (tailSpace() >= len) {
+        Segment& tail = chain_segs.back();
+        size_t offset = tail.end + len;
+        tail.owned = false;
+        chain_segs.push_back({tail.base, offset, offset, true, nullptr});
+    } else {
+        pushSlice(SlicePool::acquire());
+        chain_segs.back().begin = len;
+        chain_segs.back().end = len;
+    }
+    chain_headroom = chain_segs.size() - 1;
+}
+
+// 前置写入头部，数据从预留空间的末尾往前放，与其后的正文首尾相接
+void ChainBuffer::prepend(const char* data, size_t len) {
+    assert(chain_headroom != NO_HEADROOM && chain_headroom >= chain_head);
+    Segment& seg = chain_segs[chain_headroom];
+    if (len <= seg.begin) {
+        seg.begin -= len;
+        memcpy(seg.base + seg.begin, data, len);
+        chain_bytes += len;
+        return;
+    }
+    // 预留空间不够，在预留段之前插入若干内存片，预留段的剩余空间不再使用
+    size_t pos = chain_headroom;
+    while (len > 0) {
+        size_t n = std::min(len, SlicePool::SLICE_SIZE);
+        char* slice = SlicePool::acquire();
+        memcpy(slice, data, n);
+        chain_segs.insert(
+            chain_segs.begin() + pos,
+            {slice, 0, n, true, nullptr});
+        chain_bytes += n;
+        data += n;
+        len -= n;
+        pos++;
+    }
+    chain_headroom = pos;
+}
+
+// 移动开头的数据，不拷贝映射区等外部内存
+void ChainBuffer::splice(ChainBuffer& from, size_t len) {
+    assert(&from != this && len <= from.chain_bytes);
+    while (len > 0) {
+        Segment& front = from.chain_segs[from.chain_head];
+        size_t n = front.end - front.begin;
+        if (n <= len) {
+            chain_segs.push_back(front);
+            chain_bytes += n;
+            from.chain_bytes -= n;
+            from.skipFront();
+            len -= n;
+            continue;
+        }
+        if (front.owned) {
+            // 内存片最多16KB，拷贝比共享所有权简单
+            append(front.base + front.begin, len);
+        } else {
+            chain_segs.push_back(
+                {front.base, front.begin, front.begin + len, false, nullptr});
+            chain_bytes += len;
+        }
+        from.retrieve(len);
+        len = 0;
+    }
+}
+
+// 接管from中剩下的内存段，数据清空，释放推迟到前面的数据取走之后
+void ChainBuffer::adopt(ChainBuffer& from) {
+    assert(&from != this);
+    if (chain_bytes == 0) {
+        from.retrieveAll();
+        return;
+    }
+    for (size_t i = from.chain_head; i < from.chain_segs.size(); i++) {
+        Segment seg = from.chain_segs[i];
+        if (seg.owned || seg.release) {
+            seg.begin = seg.end;
+            chain_segs.push_back(seg);
+        }
+    }
+    from.chain_segs.clear();
+    from.chain_head = 0;
+    from.chain_bytes = 0;
+    from.chain_headroom = NO_HEADROOM;
+}
+
+// 标记已经取走了指定长度的数据，取完的内存段立即移除
+void ChainBuffer::retrieve(size_t len) {
+    assert(len <= chain_bytes);
+    while (len > 0) {
+        Segment& front = chain_segs[chain_head];
+        size_t n = std::min(front.end - front.begin, len);
+        front.begin += n;
+        chain_bytes -= n;
+        len -= n;
+        if (front.begin == front.end) {
+            popFront();
+        }
+    }
+    // 紧跟在已取走数据之后的空段（adopt()挂入的内存）也到了释放的时候，
+    // 预留的头部空间除外
+    while (chain_head < chain_segs.size() && chain_head != chain_headroom
+           && chain_segs[chain_head].begin == chain_segs[chain_head].end) {
+        popFront();
+    }
+}
+
+// 取走所有数据，归还所有内存片
+void ChainBuffer::retrieveAll() {
+    for (size_t i = chain_head; i < chain_segs.size(); i++) {
+        releaseSegment(chain_segs[i]);
+    }
+    chain_segs.clear();
+    chain_head = 0;
+    chain_bytes = 0;
+    chain_headroom = NO_HEADROOM;
+}
+
+// 将缓冲区中的所有数据读取为一个字符串
+std::string ChainBuffer::retrieveAllToStr() {
+    std::string str;
+    str.reserve(chain_bytes);
+    for (size_t i = chain_head; i < chain_segs.size(); i++) {
+        const Segment& seg = chain_segs[i];
+        str.append(seg.base + seg.begin, seg.end - seg.begin);
+    }
+    retrieveAll();
+    return str;
+}
+
+// 从文件描述符中读取数据
+// 末尾内存片的剩余空间和若干新内存片一起交给readv，数据直接落在链上，
+// 没有用到的新内存片归还缓存池
+ssize_t ChainBuffer::readFd(int fd, int* saveerrno) {
+    iovec iv[READ_SLICES + 1];
+    char* fresh[READ_SLICES];
+    int cnt = 0;
+    size_t space = tailSpace();
+    if (space > 0) {
+        Segment& tail = chain_segs.back();
+        iv[cnt].iov_base = tail.base + tail.end;
+        iv[cnt].iov_len = space;
+        cnt++;
+    }
+    for (size_t i = 0; i < READ_SLICES; i++) {
+        fresh[i] = SlicePool::acquire();
+        iv[cnt].iov_base = fresh[i];
+        iv[cnt].iov_len = SlicePool::SLICE_SIZE;
+        cnt++;
+    }
+
+    const ssize_t rlen = readv(fd, iv, cnt);
+    size_t left = 0;
+    if (rlen < 0) {
+        *saveerrno = errno;
+    } else {
+        left = static_cast<size_t>(rlen);
+        chain_bytes += left;
+    }
+
+    // 先填满原末尾内存片，再依次挂入读到数据的新内存片
+    if (space > 0) {
+        size_t n = std::min(space, left);
+        chain_segs.back().end += n;
+        left -= n;
+    }
+    for (size_t i = 0; i < READ_SLICES; i++) {
+        if (left == 0) {
+            SlicePool::release(fresh[i]);
+            continue;
+        }
+        pushSlice(fresh[i]);
+        size_t n = std::min(SlicePool::SLICE_SIZE, left);
+        chain_segs.back().end = n;
+        left -= n;
+    }
+    return rlen;
+}
+
+// 将缓冲区中的数据写入到文件描述符，一次writev提交多个内存段
+ssize_t ChainBuffer::writeFd(int fd, int* saveerrno) {
+    iovec iv[WRITE_SEGMENTS];
+    int cnt = fillIov(iv, static_cast<int>(WRITE_SEGMENTS));
+    const ssize_t wlen = writev(fd, iv, cnt);
+    if (wlen < 0) {
+        *saveerrno = errno;
+    } else {
+        retrieve(static_cast<size_t>(wlen));
+    }
+    return wlen;
+}
+
+// 从头部开始依次描述各内存段
+int ChainBuffer::fillIov(iovec* iov, int maxcnt) const {
+    int cnt = 0;
+    for (size_t i = chain_head; i < chain_segs.size() && cnt < maxcnt; i++) {
+        const Segment& seg = chain_segs[i];
+        iov[cnt].iov_base = seg.base + seg.begin;
+        iov[cnt].iov_len = seg.end - seg.begin;
+        cnt++;
+    }
+    return cnt;
+}
+
+// 末尾内存片的剩余空间
+size_t ChainBuffer::tailSpace() const {
+    if (chain_head == chain_segs.size() || !chain_segs.back().owned) {
+        return 0;
+    }
+    return SlicePool::SLICE_SIZE - chain_segs.back().end;
+}
+
+// 在末尾挂入一个新的内存片
+void ChainBuffer::pushSlice(char* slice) {
+    chain_segs.push_back({slice, 0, 0, true, nullptr});
+}
+
+// 移除第一个内存段
+// 链变空时从头复用数组；前面移除的段较多时整体前移，避免数组无限增长
+void ChainBuffer::popFront() {
+    releaseSegment(chain_segs[chain_head]);
+    skipFront();
+}
+
+// 移除第一个内存段，不释放内存
+void ChainBuffer::skipFront() {
+    chain_head++;
+    if (chain_head == chain_segs.size()) {
+        chain_segs.clear();
+        chain_head = 0;
+        chain_headroom = NO_HEADROOM;
+    } else if (chain_head >= 32 && chain_head * 2 >= chain_segs.size()) {
+        chain_segs.erase(chain_segs.begin(), chain_segs.begin() + chain_head);
+        if (chain_headroom != NO_HEADROOM) {
+            chain_headroom = chain_headroom >= chain_head
+                                 ? chain_headroom - chain_head
+                                 : NO_HEADROOM;
+        }
+        chain_head = 0;
+    }
+}
+
+// 释放一个内存段：自有内存片归还缓存池，外部内存调用其释放函数
+void ChainBuffer::releaseSegment(const Segment& seg) {
+    if (seg.owned) {
+        SlicePool::release(seg.base);
+    } else if (seg.release) {
+        seg.release(seg.base, seg.end);
+    }
+}
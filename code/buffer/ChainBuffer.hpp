@@ -0,0 +1,125 @@
+#pragma once
+
+#include <string>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <vector>
+
+// 固定大小内存片的来源，内存片是BufferPool中一个级别的内存块，
+// 与Buffer共用各线程的缓存和全局统计
+class SlicePool {
+  public:
+    // 内存片大小
+    static constexpr size_t SLICE_SIZE = 16 * 1024;
+
+    // 取出一个内存片，内容未初始化
+    static char* acquire();
+    // 归还内存片
+    static void release(char* slice);
+    // 当前线程缓存的内存片数
+    static size_t cachedCount();
+};
+
+// 分段缓冲区：由若干内存片串成的链
+// 追加数据时写满一片再取下一片，已有数据从不搬移，也不会清零新空间；
+// 读写套接字时用readv/writev一次跨越多个内存片。
+// 除了自有的内存片，还可以挂入外部内存段（如mmap映射的文件），
+// 发送时与前后的数据一起writev出去而不拷贝，外部内存需保持有效直到被取走，
+// 也可以连同释放函数一起交给缓冲区，在这段数据被取走时释放。
+// 可以先预留头部空间、写入正文，得知正文长度后再把头部前置写入预留空间；
+// 连续生成多个响应时，预留空间尽量切在末尾内存片的剩余部分上。
+// 数据被取走后内存片立即归还缓存池，空闲的连接不占用内存片。
+// 还可以把另一个缓冲区开头的数据移过来而不拷贝（如HTTP/2把响应正文切成
+// 多个DATA帧，与帧头交错排列）
+class ChainBuffer {
+  public:
+    // 一次readFd最多新取的内存片数，与原先的64KB栈上缓冲区相当
+    static constexpr size_t READ_SLICES = 4;
+    // 一次writeFd最多提交的内存段数
+    static constexpr size_t WRITE_SEGMENTS = 64;
+
+    ChainBuffer() = default;
+    ChainBuffer(const ChainBuffer&) = delete;
+    ChainBuffer& operator=(const ChainBuffer&) = delete;
+    // 析构函数：归还所有内存片
+    ~ChainBuffer();
+
+    // 获取可读的字节数
+    size_t readableBytes() const;
+    // 获取当前的内存段数
+    size_t segmentCount() const;
+    // 向缓冲区追加数据
+    void append(const char* str, size_t len);
+    // 向缓冲区追加一个字符串
+    void append(const std::string& str);
+    // 向缓冲区追加一个指定长度的数据
+    void append(const void* data, size_t len);
+    // 外部内存段的释放函数，参数为挂入时的起始地址和长度
+    using Releaser = void (*)(char* data, size_t len);
+
+    // 挂入一段外部内存，不拷贝。release为空时data需保持有效直到这段数据
+    // 被取走；否则内存归缓冲区所有，取走或丢弃后调用release释放
+    void appendExternal(
+        const char* data,
+        size_t len,
+        Releaser release = nullptr);
+    // 在末尾预留len字节（不超过一个内存片）的头部空间，
+    // 此后追加的数据排在预留空间之后。末尾内存片剩余空间足够时
+    // 直接从中切出，否则新取一个内存片
+    void reserveHeadroom(size_t len);
+    // 把数据写入最近一次预留的头部空间的末尾，紧贴其后的数据之前；
+    // 超出预留空间时改为在该处插入新的内存片
+    void prepend(const char* data, size_t len);
+    // 把from开头的len字节移到末尾，from中随之取走。整段移动的内存段连同
+    // 所有权一起移过来；需要拆开的自有内存片拷贝前一部分，需要拆开的外部
+    // 内存段只引用前一部分，仍由from中剩下的部分负责释放。
+    // 因此from中剩下的数据要么也移过来，要么用adopt()交给本缓冲区丢弃
+    void splice(ChainBuffer& from, size_t len);
+    // 把from中剩下的内存段以不含数据的空段挂到末尾，from随之清空：
+    // 其中的数据不会写出，内存在前面的数据都被取走后才释放。
+    // 用于丢弃可能被本缓冲区引用着的数据，本缓冲区为空时直接释放
+    void adopt(ChainBuffer& from);
+    // 标记已经取走了指定长度的数据
+    void retrieve(size_t len);
+    // 取走所有数据，归还所有内存片
+    void retrieveAll();
+    // 将缓冲区中的所有数据读取为一个字符串
+    std::string retrieveAllToStr();
+    // 从文件描述符中读取数据，返回读取的字节数，errno 用于存储错误码
+    ssize_t readFd(int fd, int* saveerrno);
+    // 将缓冲区中的数据写入到文件描述符，返回写入的字节数，errno 用于存储错误码
+    ssize_t writeFd(int fd, int* saveerrno);
+    // 用前maxcnt个内存段填充iov，不取走数据，返回填充的段数。
+    // 供异步写出使用，写出完成并retrieve之前各段数据保持有效
+    int fillIov(iovec* iov, int maxcnt) const;
+
+  private:
+    // 没有预留头部空间时chain_headroom的值
+    static constexpr size_t NO_HEADROOM = static_cast<size_t>(-1);
+
+    // 一个内存段
+    // 同一内存片可以被相邻的多个段共用，由最后一段负责归还
+    struct Segment {
+        char* base;       // 内存起始地址
+        size_t begin;     // 可读数据起始偏移
+        size_t end;       // 可读数据结束偏移
+        bool owned;       // 是否负责把内存片归还缓存池
+        Releaser release; // 外部内存段的释放函数，可为空
+    };
+
+    // 末尾内存片的剩余空间，末尾是外部内存段或没有内存段时为0
+    size_t tailSpace() const;
+    // 在末尾挂入一个新的内存片
+    void pushSlice(char* slice);
+    // 移除第一个内存段，自有内存片归还缓存池
+    void popFront();
+    // 移除第一个内存段，不释放内存（已经移到其他缓冲区）
+    void skipFront();
+    // 释放一个内存段占用的内存
+    static void releaseSegment(const Segment& seg);
+
+    std::vector<Segment> chain_segs;     // 内存段，从chain_head开始有效
+    size_t chain_head = 0;               // 第一个有效内存段的下标
+    size_t chain_bytes = 0;              // 可读的字节数
+    size_t chain_headroom = NO_HEADROOM; // 预留了头部空间的内存段下标
+};
@@ -0,0 +1,329 @@
+#include "Buffer.hpp"
+#include "BufferPool.hpp"
+#include "ChainBuffer.hpp"
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+
+/**
+ * 生成指定长度的测试数据
+ */
+static std::string makeData(size_t len) {
+    std::string data(len, '\0');
+    for (size_t i = 0; i < len; i++) {
+        data[i] = static_cast<char>('a' + i % 26);
+    }
+    return data;
+}
+
+/**
+ * 创建一对非阻塞的本地套接字
+ */
+static void makeSocketPair(int fds[2]) {
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+}
+
+/**
+ * 测试跨越多个内存片的追加和取出
+ */
+TEST(ChainBufferTest, AppendShouldSpanSlices) {
+    ChainBuffer buff;
+    std::string data = makeData(SlicePool::SLICE_SIZE * 2 + 100);
+    buff.append(data.data(), 10);
+    buff.append(data.data() + 10, data.size() - 10);
+    EXPECT_EQ(buff.readableBytes(), data.size());
+    EXPECT_EQ(buff.segmentCount(), 3u);
+
+    buff.retrieve(SlicePool::SLICE_SIZE + 1);
+    EXPECT_EQ(buff.segmentCount(), 2u);
+    EXPECT_EQ(buff.retrieveAllToStr(), data.substr(SlicePool::SLICE_SIZE + 1));
+    EXPECT_EQ(buff.readableBytes(), 0u);
+    EXPECT_EQ(buff.segmentCount(), 0u);
+}
+
+/**
+ * 测试外部内存段按顺序夹在自有数据之间，且不拷贝
+ */
+TEST(ChainBufferTest, ExternalSegmentShouldKeepOrder) {
+    ChainBuffer buff;
+    std::string body = makeData(1000);
+    buff.append("head\r\n");
+    buff.appendExternal(body.data(), body.size());
+    buff.append("tail");
+    EXPECT_EQ(buff.segmentCount(), 3u);
+    EXPECT_EQ(buff.readableBytes(), 6 + body.size() + 4);
+    EXPECT_EQ(buff.retrieveAllToStr(), "head\r\n" + body + "tail");
+}
+
+/**
+ * 测试readFd和writeFd一次跨越多个内存段
+ */
+TEST(ChainBufferTest, ReadvAndWritevShouldRoundTrip) {
+    int fds[2];
+    makeSocketPair(fds);
+    std::string head = "HTTP/1.1 200 OK\r\n\r\n";
+    std::string body = makeData(SlicePool::SLICE_SIZE + 500);
+
+    ChainBuffer out;
+    out.append(head);
+    out.appendExternal(body.data(), body.size());
+    int err = 0;
+    ssize_t written = 0;
+    while (out.readableBytes() > 0) {
+        ssize_t len = out.writeFd(fds[0], &err);
+        ASSERT_GT(len, 0);
+        written += len;
+    }
+    EXPECT_EQ(static_cast<size_t>(written), head.size() + body.size());
+
+    ChainBuffer in;
+    while (in.readableBytes() < head.size() + body.size()) {
+        ASSERT_GT(in.readFd(fds[1], &err), 0);
+    }
+    EXPECT_EQ(in.readFd(fds[1], &err), -1);
+    EXPECT_EQ(err, EAGAIN);
+    EXPECT_EQ(in.retrieveAllToStr(), head + body);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * 测试取完的内存片归还缓存池并被复用
+ */
+TEST(ChainBufferTest, DrainedSlicesShouldReturnToPool) {
+    ChainBuffer buff;
+    std::string data = makeData(SlicePool::SLICE_SIZE * 3);
+    buff.append(data);
+    size_t before = SlicePool::cachedCount();
+    buff.retrieve(data.size());
+    EXPECT_EQ(SlicePool::cachedCount(), before + 3);
+    buff.append("x");
+    EXPECT_EQ(SlicePool::cachedCount(), before + 2);
+    buff.retrieveAll();
+    EXPECT_EQ(SlicePool::cachedCount(), before + 3);
+}
+
+/**
+ * 测试Buffer::readFd一次读满时扩容继续读，读到全部数据
+ */
+TEST(BufferTest, ReadFdShouldGrowWithoutSpill) {
+    int fds[2];
+    makeSocketPair(fds);
+    std::string data = makeData(100000);
+    ASSERT_EQ(write(fds[0], data.data(), data.size()), (ssize_t)data.size());
+
+    Buffer buff(1024);
+    int err = 0;
+    ASSERT_EQ(buff.readFd(fds[1], &err), (ssize_t)data.size());
+    EXPECT_EQ(buff.retrieveAllToStr(), data);
+    EXPECT_EQ(buff.readFd(fds[1], &err), -1);
+    EXPECT_EQ(err, EAGAIN);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * 测试Buffer::readFd最多读取maxlen字节，其余数据留在套接字中
+ */
+TEST(BufferTest, ReadFdShouldStopAtLimit) {
+    int fds[2];
+    makeSocketPair(fds);
+    std::string data = makeData(10000);
+    ASSERT_EQ(write(fds[0], data.data(), data.size()), (ssize_t)data.size());
+
+    Buffer buff(1024);
+    int err = 0;
+    ASSERT_EQ(buff.readFd(fds[1], &err, 3000), 3000);
+    EXPECT_LT(buff.capacity(), 8192u);
+    EXPECT_EQ(buff.readFd(fds[1], &err), 7000);
+    EXPECT_EQ(buff.retrieveAllToStr(), data);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * 测试Buffer::readFd读满时先把未读数据搬到开头，腾出的空间足够时不扩容
+ */
+TEST(BufferTest, ReadFdShouldCompactBeforeGrow) {
+    int fds[2];
+    makeSocketPair(fds);
+    Buffer buff(4096);
+    size_t capacity = buff.capacity();
+    buff.append(makeData(capacity));
+    buff.retrieve(capacity - 100);
+    std::string data = makeData(2000);
+    ASSERT_EQ(write(fds[0], data.data(), data.size()), (ssize_t)data.size());
+
+    int err = 0;
+    ASSERT_EQ(buff.readFd(fds[1], &err), 2000);
+    EXPECT_EQ(buff.capacity(), capacity);
+    EXPECT_EQ(buff.readableBytes(), 2100u);
+    EXPECT_EQ(std::string(buff.peek() + 100, 2000), data);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+/**
+ * 测试先写正文再把头部前置写入预留空间
+ */
+TEST(ChainBufferTest, PrependShouldFillHeadroom) {
+    ChainBuffer buff;
+    buff.append("previous");
+    buff.reserveHeadroom(64);
+    buff.append("body");
+    std::string file = makeData(100);
+    buff.appendExternal(file.data(), file.size());
+    buff.prepend("head:", 5);
+    buff.prepend("\r\n", 2);
+    EXPECT_EQ(buff.segmentCount(), 3u);
+    EXPECT_EQ(buff.retrieveAllToStr(), "previous\r\nhead:body" + file);
+}
+
+/**
+ * 测试头部超出预留空间时插入新的内存片，顺序不变
+ */
+TEST(ChainBufferTest, PrependLargerThanHeadroomShouldInsertSlices) {
+    ChainBuffer buff;
+    buff.reserveHeadroom(4);
+    buff.append("body");
+    std::string head = makeData(SlicePool::SLICE_SIZE + 10);
+    buff.prepend(head.data(), head.size());
+    buff.prepend("ab", 2);
+    EXPECT_EQ(buff.readableBytes(), head.size() + 6);
+    EXPECT_EQ(buff.retrieveAllToStr(), head + "ab" + "body");
+}
+
+/**
+ * 测试Buffer的前置写入
+ */
+TEST(BufferTest, PrependShouldWriteBeforeReadable) {
+    Buffer buff(64);
+    buff.reserveHeadroom(16);
+    buff.append("body");
+    EXPECT_EQ(buff.prependableBytes(), 16u);
+    buff.prepend("head:", 5);
+    EXPECT_EQ(buff.retrieveAllToStr(), "head:body");
+}
+
+static size_t released_len = 0; // 释放函数收到的长度之和
+static int released_count = 0;  // 释放函数的调用次数
+
+/**
+ * 记录调用情况的外部内存释放函数
+ */
+static void recordRelease(char*, size_t len) {
+    released_len += len;
+    released_count++;
+}
+
+/**
+ * 测试外部内存段在数据被全部取走或丢弃时才调用释放函数
+ */
+TEST(ChainBufferTest, ExternalReleaserShouldRunWhenDrained) {
+    released_len = 0;
+    released_count = 0;
+    std::string file = makeData(100);
+    ChainBuffer buff;
+    buff.appendExternal(file.data(), file.size(), recordRelease);
+    buff.retrieve(60);
+    EXPECT_EQ(released_count, 0);
+    buff.retrieve(40);
+    EXPECT_EQ(released_count, 1);
+    EXPECT_EQ(released_len, file.size());
+
+    buff.append("head");
+    buff.appendExternal(file.data(), file.size(), recordRelease);
+    buff.retrieveAll();
+    EXPECT_EQ(released_count, 2);
+    // 空的内存段不挂入，直接释放
+    buff.appendExternal(file.data(), 0, recordRelease);
+    EXPECT_EQ(released_count, 3);
+    EXPECT_EQ(buff.segmentCount(), 0u);
+}
+
+/**
+ * 测试连续生成的多个小响应从同一个内存片切出头部空间
+ */
+TEST(ChainBufferTest, PipelinedHeadroomShouldShareSlice) {
+    size_t before = BufferPool::stats().in_use_blocks;
+    ChainBuffer buff;
+    std::string expect;
+    for (int i = 0; i < 3; i++) {
+        std::string body = "body" + std::to_string(i);
+        std::string head = "head" + std::to_string(i) + ":";
+        buff.reserveHeadroom(64);
+        buff.append(body);
+        buff.prepend(head.data(), head.size());
+        expect += head + body;
+    }
+    EXPECT_EQ(BufferPool::stats().in_use_blocks, before + 1);
+    buff.retrieve(expect.size() - 5);
+    EXPECT_EQ(BufferPool::stats().in_use_blocks, before + 1);
+    EXPECT_EQ(buff.retrieveAllToStr(), expect.substr(expect.size() - 5));
+    EXPECT_EQ(BufferPool::stats().in_use_blocks, before);
+}
+
+/**
+ * 测试移动数据：外部内存段拆开时只引用前一部分，由剩下的部分负责释放，
+ * 自有内存片拆开时拷贝前一部分
+ */
+TEST(ChainBufferTest, SpliceShouldMoveWithoutCopy) {
+    released_len = 0;
+    released_count = 0;
+    std::string file = makeData(100);
+    ChainBuffer body;
+    body.append("abc");
+    body.appendExternal(file.data(), file.size(), recordRelease);
+    body.append("xyz");
+
+    ChainBuffer out;
+    out.append("[1]");
+    out.splice(body, 3 + 40);
+    out.append("[2]");
+    out.splice(body, 60 + 1);
+    EXPECT_EQ(body.readableBytes(), 2u);
+    EXPECT_EQ(released_count, 0);
+
+    // 前一部分引用映射区本身，没有拷贝
+    std::string expect = "[1]abc" + file.substr(0, 40) + "[2]" + file.substr(40)
+                         + "x";
+    EXPECT_EQ(out.readableBytes(), expect.size());
+    out.retrieve(6 + 40 + 3);
+    EXPECT_EQ(released_count, 0);
+    out.retrieve(60);
+    EXPECT_EQ(released_count, 1);
+    EXPECT_EQ(released_len, file.size());
+    EXPECT_EQ(out.retrieveAllToStr(), "x");
+    EXPECT_EQ(body.retrieveAllToStr(), "yz");
+}
+
+/**
+ * 测试接管丢弃的数据：数据不写出，前面引用它的数据取走后才释放
+ */
+TEST(ChainBufferTest, AdoptShouldDeferRelease) {
+    released_len = 0;
+    released_count = 0;
+    std::string file = makeData(100);
+    ChainBuffer body;
+    body.appendExternal(file.data(), file.size(), recordRelease);
+    ChainBuffer out;
+    out.append("head");
+    out.splice(body, 30);
+    out.adopt(body);
+    EXPECT_EQ(body.readableBytes(), 0u);
+    EXPECT_EQ(out.readableBytes(), 34u);
+    out.append("tail");
+    out.retrieve(4 + 29);
+    EXPECT_EQ(released_count, 0);
+    out.retrieve(1);
+    EXPECT_EQ(released_count, 1);
+    EXPECT_EQ(out.retrieveAllToStr(), "tail");
+
+    // 没有待写数据时直接释放
+    body.appendExternal(file.data(), file.size(), recordRelease);
+    out.adopt(body);
+    EXPECT_EQ(released_count, 2);
+    EXPECT_EQ(out.segmentCount(), 0u);
+}
@@ -0,0 +1,310 @@
+#include "FormParser.hpp"
+#include "../buffer/ByteScan.hpp"
+#include "HttpParser.hpp"
+
+namespace {
+
+// multipart分隔行中boundary的最大长度（RFC 2046）
+constexpr size_t MAX_BOUNDARY = 70;
+
+// 十六进制字符的值，不是十六进制字符时返回-1
+int hexValue(char ch) {
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    }
+    if (ch >= 'a' && ch <= 'f') {
+        return ch - 'a' + 10;
+    }
+    if (ch >= 'A' && ch <= 'F') {
+        return ch - 'A' + 10;
+    }
+    return -1;
+}
+
+// 是否为空格或制表符
+bool isBlank(char ch) {
+    return ch == ' ' || ch == '\t';
+}
+
+// 去掉末尾的空白
+std::string_view trimRight(std::string_view str) {
+    while (!str.empty() && isBlank(str.back())) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+
+// 从rest开头取出一个"; key=value"形式的参数并从rest中去掉，
+// 值两边的引号不属于值，引号内的'\'转义按原样保留。没有参数时返回false
+bool nextParam(
+    std::string_view& rest,
+    std::string_view& key,
+    std::string_view& value) {
+    size_t pos = 0;
+    while (pos < rest.size() && (rest[pos] == ';' || isBlank(rest[pos]))) {
+        pos++;
+    }
+    if (pos == rest.size()) {
+        return false;
+    }
+    size_t eq = pos;
+    while (eq < rest.size() && rest[eq] != '=' && rest[eq] != ';') {
+        eq++;
+    }
+    key = trimRight(rest.substr(pos, eq - pos));
+    value = {};
+    if (eq == rest.size() || rest[eq] == ';') {
+        rest.remove_prefix(eq);
+        return true;
+    }
+    size_t start = eq + 1;
+    while (start < rest.size() && isBlank(rest[start])) {
+        start++;
+    }
+    if (start < rest.size() && rest[start] == '"') {
+        size_t end = start + 1;
+        while (end < rest.size() && rest[end] != '"') {
+            end += (rest[end] == '\\' && end + 1 < rest.size()) ? 2 : 1;
+        }
+        value = rest.substr(start + 1, end - start - 1);
+        rest.remove_prefix(end < rest.size() ? end + 1 : end);
+    } else {
+        size_t end = rest.find(';', start);
+        if (end == std::string_view::npos) {
+            end = rest.size();
+        }
+        value = trimRight(rest.substr(start, end - start));
+        rest.remove_prefix(end);
+    }
+    return true;
+}
+
+// 去掉参数后的媒体类型
+std::string_view mediaType(std::string_view contenttype) {
+    return trimRight(contenttype.substr(0, contenttype.find(';')));
+}
+
+// pos处是否为"--boundary"
+bool isDelimiter(
+    std::string_view body,
+    size_t pos,
+    std::string_view boundary) {
+    return body.size() - pos >= boundary.size() + 2 && body[pos] == '-'
+           && body[pos + 1] == '-'
+           && body.substr(pos + 2, boundary.size()) == boundary;
+}
+
+// 从from开始查找"\r\n--boundary"，返回CRLF的位置，找不到时返回npos。
+// 上传的文件可能很大，用向量化查找在CRLF之间跳过
+size_t findDelimiter(
+    std::string_view body,
+    size_t from,
+    std::string_view boundary) {
+    const char* begin = body.data();
+    const char* end = begin + body.size();
+    const char* p = begin + from;
+    while ((p = ByteScan::findCRLF(p, end))) {
+        size_t pos = p - begin;
+        if (isDelimiter(body, pos + 2, boundary)) {
+            return pos;
+        }
+        p += 2;
+    }
+    return std::string_view::npos;
+}
+
+// 解析multipart中一个部分的头部，取出字段名、文件名和类型，
+// 格式错误或不是form-data时返回false
+bool parsePartHeaders(std::string_view headers, FormField& field) {
+    bool hasname = false;
+    while (!headers.empty()) {
+        size_t lineend = headers.find("\r\n");
+        std::string_view line = headers.substr(0, lineend);
+        headers.remove_prefix(
+            lineend == std::string_view::npos ? headers.size() : lineend + 2);
+        std::string_view name, value;
+        if (!HttpParser::parseHeaderLine(line, name, value)) {
+            return false;
+        }
+        if (HttpParser::equalsIgnoreCase(name, "Content-Type")) {
+            field.content_type = value;
+        } else if (HttpParser::equalsIgnoreCase(name, "Content-Disposition")) {
+            if (!HttpParser::equalsIgnoreCase(mediaType(value), "form-data")) {
+                return false;
+            }
+            size_t semicolon = value.find(';');
+            std::string_view rest = semicolon == std::string_view::npos
+                                        ? std::string_view()
+                                        : value.substr(semicolon);
+            std::string_view key, param;
+            while (nextParam(rest, key, param)) {
+                if (HttpParser::equalsIgnoreCase(key, "name")) {
+                    field.name = param;
+                    hasname = true;
+                } else if (HttpParser::equalsIgnoreCase(key, "filename")) {
+                    field.filename = param;
+                }
+            }
+        }
+    }
+    return hasname;
+}
+
+} // namespace
+
+// 判断表单格式
+FormParser::TYPE FormParser::typeOf(std::string_view contenttype) {
+    std::string_view type = mediaType(contenttype);
+    if (HttpParser::equalsIgnoreCase(
+            type,
+            "application/x-www-form-urlencoded")) {
+        return TYPE::URLENCODED;
+    }
+    if (HttpParser::equalsIgnoreCase(type, "multipart/form-data")) {
+        return TYPE::MULTIPART;
+    }
+    return TYPE::NONE;
+}
+
+// 取出boundary参数
+std::string_view FormParser::boundary(std::string_view contenttype) {
+    size_t semicolon = contenttype.find(';');
+    if (semicolon == std::string_view::npos) {
+        return {};
+    }
+    std::string_view rest = contenttype.substr(semicolon);
+    std::string_view key, value;
+    while (nextParam(rest, key, value)) {
+        if (HttpParser::equalsIgnoreCase(key, "boundary")) {
+            if (value.empty() || value.size() > MAX_BOUNDARY) {
+                return {};
+            }
+            return value;
+        }
+    }
+    return {};
+}
+
+// 原地解码：向量化查找下一个需要解码的字节，其间的字节整段前移，
+// 写位置永远不超过读位置
+size_t FormParser::percentDecode(char* data, size_t len, bool plusasspace) {
+    const char* end = data + len;
+    const char* in = data;
+    char* out = data;
+    while (in < end) {
+        const char* hit = plusasspace ? ByteScan::findEither(in, end, '%', '+')
+                                      : ByteScan::findChar(in, end, '%');
+        if (!hit) {
+            hit = end;
+        }
+        size_t run = hit - in;
+        if (out != in) {
+            std::char_traits<char>::move(out, in, run);
+        }
+        out += run;
+        in = hit;
+        if (in == end) {
+            break;
+        }
+        if (*in == '+') {
+            *out++ = ' ';
+            in++;
+            continue;
+        }
+        // 检查边界，末尾不完整的"%X"按原样保留
+        int high = end - in >= 3 ? hexValue(in[1]) : -1;
+        int low = high >= 0 ? hexValue(in[2]) : -1;
+        if (low >= 0) {
+            *out++ = static_cast<char>(high * 16 + low);
+            in += 3;
+        } else {
+            *out++ = *in++;
+        }
+    }
+    return out - data;
+}
+
+// 解析URL编码的表单：先切出每个"name=value"，再分别原地解码名称和值，
+// 解码出的'&'和'='不会影响切分
+void FormParser::parseUrlEncoded(
+    char* data, size_t len, std::vector<FormField>& fields) {
+    char* p = data;
+    char* end = data + len;
+    while (p < end) {
+        char* amp = const_cast<char*>(ByteScan::findChar(p, end, '&'));
+        if (!amp) {
+            amp = end;
+        }
+        if (amp != p) {
+            char* eq = const_cast<char*>(ByteScan::findChar(p, amp, '='));
+            char* nameend = eq ? eq : amp;
+            FormField field;
+            field.name =
+                std::string_view(p, percentDecode(p, nameend - p, true));
+            if (eq) {
+                field.value = std::string_view(
+                    eq + 1,
+                    percentDecode(eq + 1, amp - eq - 1, true));
+            }
+            fields.push_back(field);
+        }
+        p = amp + 1;
+    }
+}
+
+// 解析multipart/form-data：第一个分隔行之前是可以忽略的前言，
+// 每个部分依次是分隔行、头部、空行和内容，内容到下一个"\r\n--boundary"
+// 为止，"--boundary--"表示结束
+bool FormParser::parseMultipart(
+    std::string_view body,
+    std::string_view boundary,
+    std::vector<FormField>& fields) {
+    if (boundary.empty()) {
+        return false;
+    }
+    size_t pos = 0;
+    if (!isDelimiter(body, 0, boundary)) {
+        pos = findDelimiter(body, 0, boundary);
+        if (pos == std::string_view::npos) {
+            return false;
+        }
+        pos += 2;
+    }
+    while (true) {
+        size_t p = pos + 2 + boundary.size();
+        if (body.substr(p, 2) == "--") {
+            return true;
+        }
+        // 分隔行末尾可以有空白
+        while (p < body.size() && isBlank(body[p])) {
+            p++;
+        }
+        if (body.substr(p, 2) != "\r\n") {
+            return false;
+        }
+        p += 2;
+        std::string_view headers;
+        size_t start = p + 2;
+        if (body.substr(p, 2) != "\r\n") {
+            const char* headerend = ByteScan::findHeaderEnd(
+                body.data() + p,
+                body.data() + body.size());
+            if (!headerend) {
+                return false;
+            }
+            headers = body.substr(p, headerend - body.data() - p);
+            start = headerend + 4 - body.data();
+        }
+        size_t end = findDelimiter(body, start, boundary);
+        if (end == std::string_view::npos) {
+            return false;
+        }
+        FormField field;
+        field.value = body.substr(start, end - start);
+        if (!parsePartHeaders(headers, field)) {
+            return false;
+        }
+        fields.push_back(field);
+        pos = end + 2;
+    }
+}
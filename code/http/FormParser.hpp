@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// 表单中的一个字段，各部分都指向请求体，只在请求体不变时有效
+struct FormField {
+    std::string_view name;         // 字段名
+    std::string_view value;        // 字段值，上传文件时为文件内容
+    std::string_view filename;     // 上传文件的文件名，普通字段为空
+    std::string_view content_type; // multipart中该部分的类型，未指定时为空
+};
+
+// 请求体中表单的解析
+// URL编码的表单在请求体上原地解码：先按'&'和'='切分，再逐段解码，
+// 每个字节只读写一次；解码用向量化查找跳过不含'%'和'+'的连续字节。
+// multipart/form-data不需要解码，各部分直接引用请求体。
+// 两种格式的解析结果都是指向请求体的string_view，不申请内存
+// （除了fields自身扩容）
+class FormParser {
+  public:
+    // 请求体的表单格式
+    enum class TYPE {
+        NONE,       // 不是表单
+        URLENCODED, // application/x-www-form-urlencoded
+        MULTIPART,  // multipart/form-data
+    };
+
+    // 按Content-Type的媒体类型（忽略大小写和参数）判断表单格式
+    static TYPE typeOf(std::string_view contenttype);
+    // 取出Content-Type中的boundary参数，可以带引号。
+    // 没有该参数或长度不在1到70之间时返回空
+    static std::string_view boundary(std::string_view contenttype);
+    // 原地解码百分号编码，plusasspace为真时把'+'解码为空格，
+    // 返回解码后的长度。不完整或不是十六进制的"%XX"按原样保留
+    static size_t percentDecode(char* data, size_t len, bool plusasspace);
+    // 解析URL编码的表单，原地解码data，字段追加到fields，空字段被忽略
+    static void
+    parseUrlEncoded(char* data, size_t len, std::vector<FormField>& fields);
+    // 解析multipart/form-data，字段追加到fields。
+    // 找不到分隔行、部分缺少结束分隔行或没有字段名时返回false
+    static bool parseMultipart(
+        std::string_view body,
+        std::string_view boundary,
+        std::vector<FormField>& fields);
+};
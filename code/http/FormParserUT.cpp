@@ -0,0 +1,152 @@
+#include "FormParser.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+// 在字符串副本上解码，返回解码结果
+std::string decode(std::string str, bool plusasspace = true) {
+    str.resize(FormParser::percentDecode(str.data(), str.size(), plusasspace));
+    return str;
+}
+
+} // namespace
+
+/**
+ * 测试百分号解码：合法的%XX和'+'被解码，不完整或非法的按原样保留，
+ * 末尾的'%'不会越界读取
+ */
+TEST(FormParserTest, PercentDecodeShouldCheckBounds) {
+    EXPECT_EQ(decode("a%20b+c"), "a b c");
+    EXPECT_EQ(decode("a+b", false), "a+b");
+    EXPECT_EQ(decode("%41%4a%4A"), "AJJ");
+    EXPECT_EQ(decode("%E4%B8%AD"), "\xE4\xB8\xAD");
+    EXPECT_EQ(decode("100%"), "100%");
+    EXPECT_EQ(decode("x%4"), "x%4");
+    EXPECT_EQ(decode("%zz%2"), "%zz%2");
+    EXPECT_EQ(decode("%%41"), "%A");
+    EXPECT_EQ(decode(""), "");
+
+    // 比向量宽度长的数据中，需要解码的字节出现在各个位置
+    for (size_t pos = 0; pos < 70; pos++) {
+        std::string plain(pos, 'x');
+        EXPECT_EQ(decode(plain + "%2B" + plain), plain + "+" + plain);
+    }
+}
+
+/**
+ * 测试URL编码的表单：先切分再解码，解码出的'&'和'='属于字段内容，
+ * 字段指向原数据
+ */
+TEST(FormParserTest, UrlEncodedShouldSplitBeforeDecode) {
+    std::string body = "username=a%26b&password=x%3Dy+z&&flag&empty=&%";
+    std::vector<FormField> fields;
+    FormParser::parseUrlEncoded(body.data(), body.size(), fields);
+    ASSERT_EQ(fields.size(), 5u);
+    EXPECT_EQ(fields[0].name, "username");
+    EXPECT_EQ(fields[0].value, "a&b");
+    EXPECT_EQ(fields[0].name.data(), body.data());
+    EXPECT_EQ(fields[1].name, "password");
+    EXPECT_EQ(fields[1].value, "x=y z");
+    EXPECT_EQ(fields[2].name, "flag");
+    EXPECT_EQ(fields[2].value, "");
+    EXPECT_EQ(fields[3].name, "empty");
+    EXPECT_EQ(fields[3].value, "");
+    EXPECT_EQ(fields[4].name, "%");
+    EXPECT_TRUE(fields[4].filename.empty());
+}
+
+/**
+ * 测试按Content-Type判断表单格式和取出boundary
+ */
+TEST(FormParserTest, ContentTypeShouldSelectFormat) {
+    EXPECT_EQ(
+        FormParser::typeOf("application/x-www-form-urlencoded"),
+        FormParser::TYPE::URLENCODED);
+    EXPECT_EQ(
+        FormParser::typeOf("Application/X-WWW-Form-Urlencoded; charset=UTF-8"),
+        FormParser::TYPE::URLENCODED);
+    EXPECT_EQ(
+        FormParser::typeOf("multipart/form-data; boundary=abc"),
+        FormParser::TYPE::MULTIPART);
+    EXPECT_EQ(FormParser::typeOf("text/plain"), FormParser::TYPE::NONE);
+
+    EXPECT_EQ(FormParser::boundary("multipart/form-data; boundary=abc"), "abc");
+    EXPECT_EQ(
+        FormParser::boundary("multipart/form-data;charset=x; BOUNDARY=\"a b\""),
+        "a b");
+    EXPECT_EQ(FormParser::boundary("multipart/form-data"), "");
+    EXPECT_EQ(FormParser::boundary("multipart/form-data; boundary="), "");
+    EXPECT_EQ(
+        FormParser::boundary(
+            "multipart/form-data; boundary=" + std::string(71, 'b')),
+        "");
+}
+
+/**
+ * 测试multipart/form-data：普通字段和上传文件，文件内容可以包含CRLF和
+ * 与分隔行相似的数据，字段都指向请求体
+ */
+TEST(FormParserTest, MultipartShouldSplitParts) {
+    std::string file = "line1\r\n--XY\r\n-XYZ\r\n\r\nbinary";
+    file.push_back('\0');
+    std::string body = "preamble\r\n"
+                       "--XYZ\r\n"
+                       "Content-Disposition: form-data; name=\"title\"\r\n"
+                       "\r\n"
+                       "hello world\r\n"
+                       "--XYZ  \r\n"
+                       "content-disposition: form-data; name=\"upload\"; "
+                       "filename=\"a;b.txt\"\r\n"
+                       "Content-Type: application/octet-stream\r\n"
+                       "\r\n"
+                       + file
+                       + "\r\n"
+                         "--XYZ\r\n"
+                         "Content-Disposition: form-data; name=empty\r\n"
+                         "\r\n"
+                         "\r\n"
+                         "--XYZ--\r\n"
+                         "epilogue";
+    std::vector<FormField> fields;
+    ASSERT_TRUE(FormParser::parseMultipart(body, "XYZ", fields));
+    ASSERT_EQ(fields.size(), 3u);
+    EXPECT_EQ(fields[0].name, "title");
+    EXPECT_EQ(fields[0].value, "hello world");
+    EXPECT_TRUE(fields[0].filename.empty());
+    EXPECT_TRUE(fields[0].content_type.empty());
+    EXPECT_EQ(fields[1].name, "upload");
+    EXPECT_EQ(fields[1].filename, "a;b.txt");
+    EXPECT_EQ(fields[1].content_type, "application/octet-stream");
+    EXPECT_EQ(fields[1].value, file);
+    EXPECT_GE(fields[1].value.data(), body.data());
+    EXPECT_LE(
+        fields[1].value.data() + fields[1].value.size(),
+        body.data() + body.size());
+    EXPECT_EQ(fields[2].name, "empty");
+    EXPECT_EQ(fields[2].value, "");
+}
+
+/**
+ * 测试格式错误的multipart：缺少分隔行、缺少结束分隔行、没有字段名
+ */
+TEST(FormParserTest, BadMultipartShouldFail) {
+    std::vector<FormField> fields;
+    EXPECT_FALSE(FormParser::parseMultipart("no delimiter", "XYZ", fields));
+    EXPECT_FALSE(FormParser::parseMultipart(
+        "--XYZ\r\nContent-Disposition: form-data; name=a\r\n\r\nunterminated",
+        "XYZ",
+        fields));
+    EXPECT_FALSE(FormParser::parseMultipart(
+        "--XYZ\r\nContent-Type: text/plain\r\n\r\nx\r\n--XYZ--",
+        "XYZ",
+        fields));
+    EXPECT_FALSE(FormParser::parseMultipart(
+        "--XYZ\r\nContent-Disposition: attachment; name=a\r\n\r\nx\r\n--XYZ--",
+        "XYZ",
+        fields));
+    EXPECT_FALSE(FormParser::parseMultipart("--XYZ--", "", fields));
+    // 没有任何部分的表单是合法的
+    EXPECT_TRUE(FormParser::parseMultipart("--XYZ--\r\n", "XYZ", fields));
+    EXPECT_TRUE(fields.empty());
+}
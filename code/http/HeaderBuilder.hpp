@@ -0,0 +1,85 @@
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// 响应头构建器
+// 在对象内部固定大小的数组中拼接状态行和响应头，整数用std::to_chars直接
+// 格式化，不产生任何临时std::string。超出容量时把已拼接的内容拷贝到
+// std::string中继续拼接，响应头总是完整的
+class HeaderBuilder {
+  public:
+    // 容量，也是HttpResponse在写缓冲区中预留的头部空间大小
+    static constexpr size_t CAPACITY = 512;
+
+    HeaderBuilder() : hb_len(0), hb_overflow(false) {
+    }
+
+    // 追加一段文本
+    HeaderBuilder& append(std::string_view str) {
+        if (!hb_overflow && str.size() <= CAPACITY - hb_len) {
+            str.copy(hb_buf + hb_len, str.size());
+            hb_len += str.size();
+            return *this;
+        }
+        spill();
+        hb_spill.append(str);
+        return *this;
+    }
+
+    // 追加一个十进制整数
+    HeaderBuilder& appendInt(long long value) {
+        if (!hb_overflow) {
+            std::to_chars_result ret =
+                std::to_chars(hb_buf + hb_len, hb_buf + CAPACITY, value);
+            if (ret.ec == std::errc()) {
+                hb_len = ret.ptr - hb_buf;
+                return *this;
+            }
+        }
+        char num[24];
+        std::to_chars_result ret = std::to_chars(num, num + sizeof(num), value);
+        return append(std::string_view(num, ret.ptr - num));
+    }
+
+    // 追加一行"name: value\r\n"
+    HeaderBuilder& appendHeader(std::string_view name, std::string_view value) {
+        return append(name).append(": ").append(value).append("\r\n");
+    }
+
+    // 追加一行值为整数的响应头
+    HeaderBuilder& appendHeader(std::string_view name, long long value) {
+        return append(name).append(": ").appendInt(value).append("\r\n");
+    }
+
+    // 获取已拼接的数据
+    const char* data() const {
+        return hb_overflow ? hb_spill.data() : hb_buf;
+    }
+
+    // 获取已拼接的字节数
+    size_t size() const {
+        return hb_overflow ? hb_spill.size() : hb_len;
+    }
+
+    // 是否超出了容量，即响应头放不进预留的头部空间
+    bool overflow() const {
+        return hb_overflow;
+    }
+
+  private:
+    // 第一次超出容量时把数组中的内容拷贝到hb_spill，之后都追加到hb_spill
+    void spill() {
+        if (!hb_overflow) {
+            hb_spill.assign(hb_buf, hb_len);
+            hb_overflow = true;
+        }
+    }
+
+    char hb_buf[CAPACITY]; // 拼接用的数组
+    size_t hb_len;         // 数组中已拼接的字节数
+    bool hb_overflow;      // 是否溢出
+    std::string hb_spill;  // 溢出后拼接用的字符串
+};
@@ -0,0 +1,601 @@
+#include "Hpack.hpp"
+#include "PerfectHash.hpp"
+#include <algorithm>
+
+namespace {
+
+// 静态表（RFC 7541 附录A），下标加1为编号
+constexpr HpackField STATIC_TABLE[Hpack::STATIC_COUNT] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+// 静态表中各名称第一次出现的编号，同名条目的编号是连续的
+constexpr auto STATIC_NAMES =
+    makePerfectHash<std::string_view, int>({
+        {":authority", 1},
+        {":method", 2},
+        {":path", 4},
+        {":scheme", 6},
+        {":status", 8},
+        {"accept-charset", 15},
+        {"accept-encoding", 16},
+        {"accept-language", 17},
+        {"accept-ranges", 18},
+        {"accept", 19},
+        {"access-control-allow-origin", 20},
+        {"age", 21},
+        {"allow", 22},
+        {"authorization", 23},
+        {"cache-control", 24},
+        {"content-disposition", 25},
+        {"content-encoding", 26},
+        {"content-language", 27},
+        {"content-length", 28},
+        {"content-location", 29},
+        {"content-range", 30},
+        {"content-type", 31},
+        {"cookie", 32},
+        {"date", 33},
+        {"etag", 34},
+        {"expect", 35},
+        {"expires", 36},
+        {"from", 37},
+        {"host", 38},
+        {"if-match", 39},
+        {"if-modified-since", 40},
+        {"if-none-match", 41},
+        {"if-range", 42},
+        {"if-unmodified-since", 43},
+        {"last-modified", 44},
+        {"link", 45},
+        {"location", 46},
+        {"max-forwards", 47},
+        {"proxy-authenticate", 48},
+        {"proxy-authorization", 49},
+        {"range", 50},
+        {"referer", 51},
+        {"refresh", 52},
+        {"retry-after", 53},
+        {"server", 54},
+        {"set-cookie", 55},
+        {"strict-transport-security", 56},
+        {"transfer-encoding", 57},
+        {"user-agent", 58},
+        {"vary", 59},
+        {"via", 60},
+        {"www-authenticate", 61},
+    });
+static_assert(STATIC_NAMES.perfect(), "no perfect hash for HPACK names");
+
+// 各符号霍夫曼编码的码长（RFC 7541 附录B），下标256为EOS
+constexpr uint8_t HUFFMAN_LENGTH[257] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+    30,
+};
+
+// 最长的码长
+constexpr int MAX_CODE_LENGTH = 30;
+
+// 由码长生成的范式霍夫曼码表
+// 附录B的编码是范式的：码长相同的符号按符号值递增分配连续的码字，
+// 码长增加时码字左移一位。解码时逐位累积码字，只要它落在当前码长的
+// 区间内就能直接算出符号，不需要树或大的查找表
+struct HuffmanTable {
+    uint32_t code[257];                        // 各符号的码字
+    uint32_t first_code[MAX_CODE_LENGTH + 1];  // 各码长的第一个码字
+    uint16_t first_index[MAX_CODE_LENGTH + 1]; // 各码长首个符号的位置
+    uint16_t count[MAX_CODE_LENGTH + 1];       // 各码长的符号数
+    uint16_t symbol[257];                      // 按码长和值排序的符号
+
+    constexpr HuffmanTable()
+        : code{}, first_code{}, first_index{}, count{}, symbol{} {
+        uint32_t next = 0;
+        uint16_t index = 0;
+        for (int len = 1; len <= MAX_CODE_LENGTH; len++) {
+            first_code[len] = next;
+            first_index[len] = index;
+            for (int sym = 0; sym < 257; sym++) {
+                if (HUFFMAN_LENGTH[sym] == len) {
+                    code[sym] = next++;
+                    symbol[index++] = static_cast<uint16_t>(sym);
+                    count[len]++;
+                }
+            }
+            next <<= 1;
+        }
+    }
+};
+
+constexpr HuffmanTable HUFFMAN;
+static_assert(HUFFMAN.code[256] == 0x3fffffff, "HPACK Huffman EOS mismatch");
+static_assert(HUFFMAN.code['a'] == 0x3, "HPACK Huffman code mismatch");
+
+} // namespace
+
+// 按编号取静态表条目
+bool Hpack::staticEntry(
+    size_t index, std::string_view& name, std::string_view& value) {
+    if (index == 0 || index > STATIC_COUNT) {
+        return false;
+    }
+    name = STATIC_TABLE[index - 1].name;
+    value = STATIC_TABLE[index - 1].value;
+    return true;
+}
+
+// 先用完美哈希找到名称，再在同名的连续条目中找值
+size_t Hpack::findStatic(
+    std::string_view name, std::string_view value, bool& valuematch) {
+    valuematch = false;
+    const int* first = STATIC_NAMES.find(name);
+    if (!first) {
+        return 0;
+    }
+    for (size_t i = *first; i <= STATIC_COUNT; i++) {
+        if (STATIC_TABLE[i - 1].name != name) {
+            break;
+        }
+        if (STATIC_TABLE[i - 1].value == value) {
+            valuematch = true;
+            return i;
+        }
+    }
+    return *first;
+}
+
+// 逐位累积码字，落在当前码长的区间内时输出符号。
+// 结尾剩下的位是填充，必须少于8位且是EOS码字的前缀（全1）
+bool Hpack::huffmanDecode(std::string_view in, std::string& out) {
+    uint32_t code = 0;
+    int len = 0;
+    for (unsigned char byte : in) {
+        for (int bit = 7; bit >= 0; bit--) {
+            code = code << 1 | ((byte >> bit) & 1);
+            len++;
+            uint32_t offset = code - HUFFMAN.first_code[len];
+            if (code >= HUFFMAN.first_code[len]
+                && offset < HUFFMAN.count[len]) {
+                uint16_t sym =
+                    HUFFMAN.symbol[HUFFMAN.first_index[len] + offset];
+                if (sym == 256) {
+                    return false;
+                }
+                out.push_back(static_cast<char>(sym));
+                code = 0;
+                len = 0;
+            } else if (len == MAX_CODE_LENGTH) {
+                return false;
+            }
+        }
+    }
+    return len < 8 && code == (1u << len) - 1;
+}
+
+// 按码字拼接，凑满一个字节就输出，最后用全1填充
+void Hpack::huffmanEncode(std::string_view in, std::string& out) {
+    uint64_t bits = 0;
+    int count = 0;
+    for (unsigned char ch : in) {
+        bits = bits << HUFFMAN_LENGTH[ch] | HUFFMAN.code[ch];
+        count += HUFFMAN_LENGTH[ch];
+        while (count >= 8) {
+            count -= 8;
+            out.push_back(static_cast<char>(bits >> count));
+        }
+    }
+    if (count > 0) {
+        out.push_back(static_cast<char>(bits << (8 - count) | (0xff >> count)));
+    }
+}
+
+// 霍夫曼编码后的字节数
+size_t Hpack::huffmanLength(std::string_view in) {
+    size_t bits = 0;
+    for (unsigned char ch : in) {
+        bits += HUFFMAN_LENGTH[ch];
+    }
+    return (bits + 7) / 8;
+}
+
+// 前缀的值小于全1时就是整数本身，否则后续字节每个携带7位，
+// 最高位为1表示还有后续字节（RFC 7541 5.1）
+bool Hpack::decodeInt(
+    const uint8_t*& p, const uint8_t* end, int prefix, uint32_t& value) {
+    if (p >= end) {
+        return false;
+    }
+    uint32_t mask = (1u << prefix) - 1;
+    uint64_t result = *p++ & mask;
+    if (result < mask) {
+        value = static_cast<uint32_t>(result);
+        return true;
+    }
+    for (int shift = 0; p < end && shift <= 28; shift += 7) {
+        uint8_t byte = *p++;
+        result += static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (result > UINT32_MAX) {
+            return false;
+        }
+        if (!(byte & 0x80)) {
+            value = static_cast<uint32_t>(result);
+            return true;
+        }
+    }
+    return false;
+}
+
+// 编码整数
+void Hpack::encodeInt(
+    std::string& out, uint8_t first, int prefix, uint32_t value) {
+    uint32_t mask = (1u << prefix) - 1;
+    if (value < mask) {
+        out.push_back(static_cast<char>(first | value));
+        return;
+    }
+    out.push_back(static_cast<char>(first | mask));
+    value -= mask;
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// 编码字符串，长度前缀的最高位表示是否使用霍夫曼编码
+void Hpack::encodeString(std::string& out, std::string_view str) {
+    size_t huffman = huffmanLength(str);
+    if (huffman < str.size()) {
+        encodeInt(out, 0x80, 7, static_cast<uint32_t>(huffman));
+        huffmanEncode(str, out);
+    } else {
+        encodeInt(out, 0, 7, static_cast<uint32_t>(str.size()));
+        out.append(str);
+    }
+}
+
+// 初始化动态表
+HpackTable::HpackTable(size_t maxsize) : ht_size(0), ht_max_size(maxsize) {}
+
+// 按编号取条目
+bool HpackTable::get(
+    size_t index, std::string_view& name, std::string_view& value) const {
+    if (index >= ht_entries.size()) {
+        return false;
+    }
+    name = ht_entries[index].name;
+    value = ht_entries[index].value;
+    return true;
+}
+
+// 先淘汰旧条目腾出空间再插入，name和value可以指向将被淘汰的条目，
+// 所以先复制
+void HpackTable::add(std::string_view name, std::string_view value) {
+    size_t entrysize = name.size() + value.size() + Hpack::ENTRY_OVERHEAD;
+    if (entrysize > ht_max_size) {
+        evict(0);
+        return;
+    }
+    Entry entry{std::string(name), std::string(value)};
+    evict(ht_max_size - entrysize);
+    ht_entries.push_front(std::move(entry));
+    ht_size += entrysize;
+}
+
+// 查找字段，完全匹配优先
+int HpackTable::find(
+    std::string_view name, std::string_view value, bool& valuematch) const {
+    valuematch = false;
+    int namematch = -1;
+    for (size_t i = 0; i < ht_entries.size(); i++) {
+        if (ht_entries[i].name != name) {
+            continue;
+        }
+        if (ht_entries[i].value == value) {
+            valuematch = true;
+            return static_cast<int>(i);
+        }
+        if (namematch < 0) {
+            namematch = static_cast<int>(i);
+        }
+    }
+    return namematch;
+}
+
+// 修改大小上限
+void HpackTable::setMaxSize(size_t maxsize) {
+    ht_max_size = maxsize;
+    evict(maxsize);
+}
+
+// 大小上限
+size_t HpackTable::maxSize() const {
+    return ht_max_size;
+}
+
+// 当前大小
+size_t HpackTable::size() const {
+    return ht_size;
+}
+
+// 条目数
+size_t HpackTable::count() const {
+    return ht_entries.size();
+}
+
+// 从最旧的条目开始淘汰
+void HpackTable::evict(size_t limit) {
+    while (ht_size > limit) {
+        const Entry& entry = ht_entries.back();
+        ht_size -=
+            entry.name.size() + entry.value.size() + Hpack::ENTRY_OVERHEAD;
+        ht_entries.pop_back();
+    }
+}
+
+// 初始化解码器
+HpackDecoder::HpackDecoder(size_t maxtablesize)
+    : hd_table(maxtablesize), hd_max_table_size(maxtablesize) {}
+
+// 逐个解码字段表示（RFC 7541 6）：
+//   1xxxxxxx 索引字段
+//   01xxxxxx 带索引的字面字段，解码后加入动态表
+//   001xxxxx 动态表大小更新
+//   0000xxxx 不带索引的字面字段，0001xxxx 永不索引的字面字段
+// 名称和值先追加到hd_storage，全部解码后才生成string_view，
+// 避免存储扩容使之前的视图失效。头部列表超过上限后继续解码以保持
+// 动态表与对端一致，但不再保存字段，防止少量索引字段展开成大量数据
+bool HpackDecoder::decode(
+    std::string_view block,
+    std::vector<HpackField>& fields,
+    size_t maxlistsize,
+    bool& overflow) {
+    hd_storage.clear();
+    std::vector<size_t> lengths;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(block.data());
+    const uint8_t* end = p + block.size();
+    size_t listsize = 0;
+    bool fieldseen = false;
+    overflow = false;
+    while (p < end) {
+        uint8_t first = *p;
+        if ((first & 0xe0) == 0x20) {
+            uint32_t size = 0;
+            if (fieldseen || !Hpack::decodeInt(p, end, 5, size)
+                || size > hd_max_table_size) {
+                return false;
+            }
+            hd_table.setMaxSize(size);
+            continue;
+        }
+        fieldseen = true;
+        size_t mark = hd_storage.size();
+        size_t namelen = 0;
+        uint32_t index = 0;
+        if (first & 0x80) {
+            std::string_view name, value;
+            if (!Hpack::decodeInt(p, end, 7, index)
+                || !entry(index, name, value)) {
+                return false;
+            }
+            hd_storage.append(name);
+            hd_storage.append(value);
+            namelen = name.size();
+        } else {
+            bool indexing = first & 0x40;
+            if (!Hpack::decodeInt(p, end, indexing ? 6 : 4, index)) {
+                return false;
+            }
+            if (index == 0) {
+                if (!readString(p, end)) {
+                    return false;
+                }
+            } else {
+                std::string_view name, value;
+                if (!entry(index, name, value)) {
+                    return false;
+                }
+                hd_storage.append(name);
+            }
+            namelen = hd_storage.size() - mark;
+            if (!readString(p, end)) {
+                return false;
+            }
+            if (indexing) {
+                std::string_view field(hd_storage);
+                hd_table.add(
+                    field.substr(mark, namelen),
+                    field.substr(mark + namelen));
+            }
+        }
+        size_t fieldsize = hd_storage.size() - mark;
+        listsize += fieldsize + Hpack::ENTRY_OVERHEAD;
+        if (overflow || listsize > maxlistsize) {
+            overflow = true;
+            hd_storage.resize(mark);
+            continue;
+        }
+        lengths.push_back(namelen);
+        lengths.push_back(fieldsize - namelen);
+    }
+    if (overflow) {
+        return false;
+    }
+    std::string_view storage(hd_storage);
+    size_t offset = 0;
+    for (size_t i = 0; i < lengths.size(); i += 2) {
+        HpackField field;
+        field.name = storage.substr(offset, lengths[i]);
+        field.value = storage.substr(offset + lengths[i], lengths[i + 1]);
+        offset += lengths[i] + lengths[i + 1];
+        fields.push_back(field);
+    }
+    return true;
+}
+
+// 编号1到61是静态表，之后是动态表
+bool HpackDecoder::entry(
+    size_t index, std::string_view& name, std::string_view& value) const {
+    if (index <= Hpack::STATIC_COUNT) {
+        return Hpack::staticEntry(index, name, value);
+    }
+    return hd_table.get(index - Hpack::STATIC_COUNT - 1, name, value);
+}
+
+// 解码字符串：长度前缀的最高位表示霍夫曼编码
+bool HpackDecoder::readString(const uint8_t*& p, const uint8_t* end) {
+    if (p >= end) {
+        return false;
+    }
+    bool huffman = *p & 0x80;
+    uint32_t len = 0;
+    if (!Hpack::decodeInt(p, end, 7, len)
+        || len > static_cast<size_t>(end - p)) {
+        return false;
+    }
+    std::string_view str(reinterpret_cast<const char*>(p), len);
+    p += len;
+    if (huffman) {
+        return Hpack::huffmanDecode(str, hd_storage);
+    }
+    hd_storage.append(str);
+    return true;
+}
+
+// 初始化编码器
+HpackEncoder::HpackEncoder()
+    : he_target_size(Hpack::DEFAULT_TABLE_SIZE),
+      he_min_size(Hpack::DEFAULT_TABLE_SIZE),
+      he_size_changed(false) {}
+
+// 上限在两个头部块之间先减小又增大时，对端可能已经按较小的上限淘汰了
+// 条目，要先发出最小值再发出最终值（RFC 7541 4.2）
+void HpackEncoder::beginBlock(std::string& out) {
+    if (!he_size_changed) {
+        return;
+    }
+    he_size_changed = false;
+    if (he_min_size < he_target_size) {
+        Hpack::encodeInt(out, 0x20, 5, static_cast<uint32_t>(he_min_size));
+    }
+    Hpack::encodeInt(out, 0x20, 5, static_cast<uint32_t>(he_target_size));
+    he_table.setMaxSize(he_target_size);
+}
+
+// 依次尝试完全匹配的索引、名称匹配的索引加字面值、完全字面编码
+void HpackEncoder::encode(
+    std::string& out,
+    std::string_view name,
+    std::string_view value,
+    bool indexing) {
+    bool valuematch = false;
+    size_t index = Hpack::findStatic(name, value, valuematch);
+    if (valuematch) {
+        Hpack::encodeInt(out, 0x80, 7, static_cast<uint32_t>(index));
+        return;
+    }
+    bool dynamicmatch = false;
+    int dynamic = he_table.find(name, value, dynamicmatch);
+    if (dynamic >= 0 && (dynamicmatch || index == 0)) {
+        size_t dynamicindex = Hpack::STATIC_COUNT + 1 + dynamic;
+        if (dynamicmatch) {
+            Hpack::encodeInt(out, 0x80, 7, static_cast<uint32_t>(dynamicindex));
+            return;
+        }
+        index = dynamicindex;
+    }
+    if (indexing) {
+        Hpack::encodeInt(out, 0x40, 6, static_cast<uint32_t>(index));
+    } else {
+        Hpack::encodeInt(out, 0, 4, static_cast<uint32_t>(index));
+    }
+    if (index == 0) {
+        Hpack::encodeString(out, name);
+    }
+    Hpack::encodeString(out, value);
+    if (indexing) {
+        he_table.add(name, value);
+    }
+}
+
+// 本端编码时使用的上限不超过默认值，对端允许更大也不占用更多内存
+void HpackEncoder::setMaxTableSize(size_t size) {
+    size = std::min(size, Hpack::DEFAULT_TABLE_SIZE);
+    he_min_size = he_size_changed ? std::min(he_min_size, size) : size;
+    he_target_size = size;
+    he_size_changed = true;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 头部块中的一个字段
+struct HpackField {
+    std::string_view name;  // 名称，HTTP/2要求小写
+    std::string_view value; // 值
+};
+
+// HPACK头部压缩的公共部分（RFC 7541）
+// 静态表和霍夫曼码表在编译期生成，整数和字符串按规定的前缀格式编解码
+class Hpack {
+  public:
+    // 静态表条目数，动态表的编号紧接其后
+    static constexpr size_t STATIC_COUNT = 61;
+    // 动态表大小上限的初始值
+    static constexpr size_t DEFAULT_TABLE_SIZE = 4096;
+    // 计算表大小时每个条目的额外开销
+    static constexpr size_t ENTRY_OVERHEAD = 32;
+
+    // 按编号（从1开始）取静态表条目，编号超出范围时返回false
+    static bool
+    staticEntry(size_t index, std::string_view& name, std::string_view& value);
+    // 在静态表中查找字段，返回完全匹配的编号，否则返回名称匹配的编号并把
+    // valuematch置为false，名称也不存在时返回0
+    static size_t
+    findStatic(std::string_view name, std::string_view value, bool& valuematch);
+
+    // 霍夫曼解码追加到out，填充超过7位、填充不全是1或遇到EOS时返回false
+    static bool huffmanDecode(std::string_view in, std::string& out);
+    // 霍夫曼编码追加到out
+    static void huffmanEncode(std::string_view in, std::string& out);
+    // 霍夫曼编码后的字节数
+    static size_t huffmanLength(std::string_view in);
+
+    // 解码prefix位前缀的整数，p前进到整数之后。
+    // 数据不完整或超过32位时返回false
+    static bool decodeInt(
+        const uint8_t*& p, const uint8_t* end, int prefix, uint32_t& value);
+    // 编码prefix位前缀的整数追加到out，first为首字节中前缀之外的位
+    static void
+    encodeInt(std::string& out, uint8_t first, int prefix, uint32_t value);
+    // 编码字符串追加到out，霍夫曼编码更短时使用霍夫曼编码
+    static void encodeString(std::string& out, std::string_view str);
+};
+
+// HPACK动态表
+// 新条目插入在最前，超出大小上限时从最旧的条目开始淘汰；
+// 单个条目比上限还大时清空整张表而不插入
+class HpackTable {
+  public:
+    explicit HpackTable(size_t maxsize = Hpack::DEFAULT_TABLE_SIZE);
+
+    // 按动态表内的编号（从0开始，0为最新的条目）取条目
+    bool get(size_t index, std::string_view& name, std::string_view& value)
+        const;
+    // 插入条目
+    void add(std::string_view name, std::string_view value);
+    // 查找字段，返回动态表内的编号，规则同Hpack::findStatic()，找不到返回-1
+    int
+    find(std::string_view name, std::string_view value, bool& valuematch) const;
+    // 修改大小上限并淘汰超出的条目
+    void setMaxSize(size_t maxsize);
+    // 大小上限
+    size_t maxSize() const;
+    // 当前大小，即各条目名称、值长度加额外开销之和
+    size_t size() const;
+    // 条目数
+    size_t count() const;
+
+  private:
+    // 动态表中的条目
+    struct Entry {
+        std::string name;  // 名称
+        std::string value; // 值
+    };
+
+    // 淘汰最旧的条目直到大小不超过limit
+    void evict(size_t limit);
+
+    std::deque<Entry> ht_entries; // 条目，最新的在最前
+    size_t ht_size;               // 当前大小
+    size_t ht_max_size;           // 大小上限
+};
+
+// HPACK解码器，每个连接一个，解码对端发来的头部块
+class HpackDecoder {
+  public:
+    explicit HpackDecoder(size_t maxtablesize = Hpack::DEFAULT_TABLE_SIZE);
+
+    // 解码一个完整的头部块，字段追加到fields，名称和值指向解码器内部的存储，
+    // 在下一次decode()之前有效。格式错误、编号不存在、动态表大小更新超出
+    // 本端上限或不在块开头时返回false（COMPRESSION_ERROR），头部列表大小
+    // 超过maxlistsize时也返回false并把overflow置为true
+    bool decode(
+        std::string_view block,
+        std::vector<HpackField>& fields,
+        size_t maxlistsize,
+        bool& overflow);
+
+  private:
+    // 按编号（静态表和动态表统一编号）取条目
+    bool entry(size_t index, std::string_view& name, std::string_view& value)
+        const;
+    // 解码一个字符串追加到hd_storage
+    bool readString(const uint8_t*& p, const uint8_t* end);
+
+    HpackTable hd_table;      // 动态表
+    size_t hd_max_table_size; // 本端允许的动态表大小上限
+    std::string hd_storage;   // 解码出的名称和值
+};
+
+// HPACK编码器，每个连接一个，编码发给对端的头部块
+class HpackEncoder {
+  public:
+    HpackEncoder();
+
+    // 开始一个新的头部块，动态表大小上限改变过时先写入大小更新
+    void beginBlock(std::string& out);
+    // 编码一个字段追加到out。indexing为真时加入动态表，之后同样的字段只需
+    // 一个字节；每次都不同的值（如Content-Length）不应加入
+    void encode(
+        std::string& out,
+        std::string_view name,
+        std::string_view value,
+        bool indexing);
+    // 对端通过SETTINGS_HEADER_TABLE_SIZE修改了动态表大小上限
+    void setMaxTableSize(size_t size);
+
+  private:
+    HpackTable he_table;   // 动态表
+    size_t he_target_size; // 对端最新允许的上限
+    size_t he_min_size;    // 两次头部块之间出现过的最小上限
+    bool he_size_changed;  // 下一个头部块是否要写入大小更新
+};
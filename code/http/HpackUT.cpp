@@ -0,0 +1,239 @@
+#include "Hpack.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+// 十六进制字符串转字节，忽略空格
+std::string fromHex(std::string_view hex) {
+    std::string bytes;
+    std::string digits;
+    for (char ch : hex) {
+        if (ch != ' ') {
+            digits.push_back(ch);
+        }
+    }
+    for (size_t i = 0; i + 1 < digits.size(); i += 2) {
+        bytes.push_back(
+            static_cast<char>(std::stoi(digits.substr(i, 2), nullptr, 16)));
+    }
+    return bytes;
+}
+
+// 把解码出的字段拼成"name: value\n"便于比较
+std::string joinFields(const std::vector<HpackField>& fields) {
+    std::string joined;
+    for (const HpackField& field : fields) {
+        joined.append(field.name);
+        joined.append(": ");
+        joined.append(field.value);
+        joined.push_back('\n');
+    }
+    return joined;
+}
+
+// 解码一个头部块，失败时返回"<error>"
+std::string decodeBlock(HpackDecoder& decoder, std::string_view hex) {
+    std::vector<HpackField> fields;
+    bool overflow = false;
+    std::string block = fromHex(hex);
+    if (!decoder.decode(block, fields, 65536, overflow)) {
+        return "<error>";
+    }
+    return joinFields(fields);
+}
+
+// RFC 7541 附录C.4中三个带霍夫曼编码的请求
+constexpr std::string_view REQUEST1 =
+    "8286 8441 8cf1 e3c2 e5f2 3a6b a0ab 90f4 ff";
+constexpr std::string_view REQUEST2 = "8286 84be 5886 a8eb 1064 9cbf";
+constexpr std::string_view REQUEST3 =
+    "8287 85bf 4088 25a8 49e9 5ba9 7d7f 8925 a849 e95b b8e8 b4bf";
+
+} // namespace
+
+/**
+ * 测试整数编解码（RFC 7541 C.1）：前缀放得下、需要后续字节、
+ * 数据不完整和超出32位
+ */
+TEST(HpackTest, IntegerShouldUsePrefix) {
+    std::string out;
+    Hpack::encodeInt(out, 0, 5, 10);
+    EXPECT_EQ(out, fromHex("0a"));
+    out.clear();
+    Hpack::encodeInt(out, 0xe0, 5, 1337);
+    EXPECT_EQ(out, fromHex("ff 9a 0a"));
+
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(out.data());
+    uint32_t value = 0;
+    ASSERT_TRUE(Hpack::decodeInt(p, p + out.size(), 5, value));
+    EXPECT_EQ(value, 1337u);
+
+    std::string partial = fromHex("1f 9a");
+    p = reinterpret_cast<const uint8_t*>(partial.data());
+    EXPECT_FALSE(Hpack::decodeInt(p, p + partial.size(), 5, value));
+    std::string huge = fromHex("1f ff ff ff ff 7f");
+    p = reinterpret_cast<const uint8_t*>(huge.data());
+    EXPECT_FALSE(Hpack::decodeInt(p, p + huge.size(), 5, value));
+}
+
+/**
+ * 测试霍夫曼编解码：附录C中的字符串、全部字节值的往返，
+ * 以及非法的填充和EOS
+ */
+TEST(HpackTest, HuffmanShouldRoundTrip) {
+    std::string out;
+    Hpack::huffmanEncode("www.example.com", out);
+    EXPECT_EQ(out, fromHex("f1e3 c2e5 f23a 6ba0 ab90 f4ff"));
+    EXPECT_EQ(Hpack::huffmanLength("www.example.com"), out.size());
+    std::string decoded;
+    ASSERT_TRUE(Hpack::huffmanDecode(out, decoded));
+    EXPECT_EQ(decoded, "www.example.com");
+
+    std::string all;
+    for (int ch = 0; ch < 256; ch++) {
+        all.push_back(static_cast<char>(ch));
+    }
+    out.clear();
+    decoded.clear();
+    Hpack::huffmanEncode(all, out);
+    ASSERT_TRUE(Hpack::huffmanDecode(out, decoded));
+    EXPECT_EQ(decoded, all);
+
+    // 8位以上的填充、不全是1的填充、EOS
+    EXPECT_FALSE(Hpack::huffmanDecode(fromHex("1f ff"), decoded));
+    EXPECT_FALSE(Hpack::huffmanDecode(fromHex("00"), decoded));
+    EXPECT_FALSE(Hpack::huffmanDecode(fromHex("ff ff ff ff"), decoded));
+}
+
+/**
+ * 测试解码（RFC 7541 C.3、C.4）：同一个解码器依次解码三个请求，
+ * 后面的请求引用前面加入动态表的条目
+ */
+TEST(HpackTest, DecoderShouldFollowAppendixC) {
+    HpackDecoder plain;
+    EXPECT_EQ(
+        decodeBlock(
+            plain,
+            "8286 8441 0f77 7777 2e65 7861 6d70 6c65 2e63 6f6d"),
+        ":method: GET\n:scheme: http\n:path: /\n"
+        ":authority: www.example.com\n");
+    EXPECT_EQ(
+        decodeBlock(plain, "8286 84be 5808 6e6f 2d63 6163 6865"),
+        ":method: GET\n:scheme: http\n:path: /\n"
+        ":authority: www.example.com\ncache-control: no-cache\n");
+
+    HpackDecoder huffman;
+    decodeBlock(huffman, REQUEST1);
+    decodeBlock(huffman, REQUEST2);
+    EXPECT_EQ(
+        decodeBlock(huffman, REQUEST3),
+        ":method: GET\n:scheme: https\n:path: /index.html\n"
+        ":authority: www.example.com\ncustom-key: custom-value\n");
+}
+
+/**
+ * 测试编码：同样的字段序列编码结果与附录C.4逐字节一致
+ */
+TEST(HpackTest, EncoderShouldFollowAppendixC) {
+    HpackEncoder encoder;
+    std::string out;
+    encoder.beginBlock(out);
+    encoder.encode(out, ":method", "GET", true);
+    encoder.encode(out, ":scheme", "http", true);
+    encoder.encode(out, ":path", "/", true);
+    encoder.encode(out, ":authority", "www.example.com", true);
+    EXPECT_EQ(out, fromHex(REQUEST1));
+
+    out.clear();
+    encoder.encode(out, ":method", "GET", true);
+    encoder.encode(out, ":scheme", "http", true);
+    encoder.encode(out, ":path", "/", true);
+    encoder.encode(out, ":authority", "www.example.com", true);
+    encoder.encode(out, "cache-control", "no-cache", true);
+    EXPECT_EQ(out, fromHex(REQUEST2));
+
+    out.clear();
+    encoder.encode(out, ":method", "GET", true);
+    encoder.encode(out, ":scheme", "https", true);
+    encoder.encode(out, ":path", "/index.html", true);
+    encoder.encode(out, ":authority", "www.example.com", true);
+    encoder.encode(out, "custom-key", "custom-value", true);
+    EXPECT_EQ(out, fromHex(REQUEST3));
+
+    // 不加入动态表的字段每次都完整编码，对端能解码
+    out.clear();
+    encoder.encode(out, "content-length", "123", false);
+    encoder.encode(out, "content-length", "123", false);
+    EXPECT_EQ(out, fromHex("0f0d 8208 99 0f0d 8208 99"));
+    HpackDecoder decoder;
+    EXPECT_EQ(
+        decodeBlock(decoder, "0f0d 8208 99 0f0d 0331 3233"),
+        "content-length: 123\ncontent-length: 123\n");
+}
+
+/**
+ * 测试动态表大小更新：对端缩小上限后，编码器在下一个块开头发出最小值和
+ * 最终值，解码器拒绝超出上限或不在块开头的更新
+ */
+TEST(HpackTest, TableSizeUpdateShouldBeSignalled) {
+    HpackEncoder encoder;
+    encoder.setMaxTableSize(0);
+    encoder.setMaxTableSize(100);
+    std::string out;
+    encoder.beginBlock(out);
+    EXPECT_EQ(out, fromHex("20 3f45"));
+    out.clear();
+    encoder.beginBlock(out);
+    EXPECT_TRUE(out.empty());
+
+    HpackDecoder decoder;
+    EXPECT_EQ(decodeBlock(decoder, "20 3f45 82"), ":method: GET\n");
+    EXPECT_EQ(decodeBlock(decoder, "3fe2 1f"), "<error>");
+    EXPECT_EQ(decodeBlock(decoder, "82 20"), "<error>");
+}
+
+/**
+ * 测试动态表淘汰：超出上限时淘汰最旧的条目，过大的条目清空整张表
+ */
+TEST(HpackTest, TableShouldEvictOldest) {
+    HpackTable table(100);
+    table.add("aaaa", "1111");
+    table.add("bbbb", "2222");
+    EXPECT_EQ(table.count(), 2u);
+    EXPECT_EQ(table.size(), 80u);
+    table.add("cccc", "3333");
+    ASSERT_EQ(table.count(), 2u);
+    std::string_view name, value;
+    ASSERT_TRUE(table.get(0, name, value));
+    EXPECT_EQ(name, "cccc");
+    ASSERT_TRUE(table.get(1, name, value));
+    EXPECT_EQ(name, "bbbb");
+    bool valuematch = false;
+    EXPECT_EQ(table.find("bbbb", "2222", valuematch), 1);
+    EXPECT_TRUE(valuematch);
+    EXPECT_EQ(table.find("dddd", "", valuematch), -1);
+
+    table.add(std::string(80, 'x'), "");
+    EXPECT_EQ(table.count(), 0u);
+    EXPECT_EQ(table.size(), 0u);
+}
+
+/**
+ * 测试非法的头部块：编号为0、编号不存在、字符串越界，以及头部列表超过
+ * 上限时仍然更新动态表
+ */
+TEST(HpackTest, BadBlockShouldFail) {
+    HpackDecoder decoder;
+    EXPECT_EQ(decodeBlock(decoder, "80"), "<error>");
+    EXPECT_EQ(decodeBlock(decoder, "be"), "<error>");
+    EXPECT_EQ(decodeBlock(decoder, "4105 6162"), "<error>");
+
+    std::vector<HpackField> fields;
+    bool overflow = false;
+    std::string block = fromHex("4003 6b65 7903 7661 6c");
+    EXPECT_FALSE(decoder.decode(block, fields, 10, overflow));
+    EXPECT_TRUE(overflow);
+    EXPECT_TRUE(fields.empty());
+    EXPECT_EQ(decodeBlock(decoder, "be"), "key: val\n");
+}
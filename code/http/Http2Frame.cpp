@@ -0,0 +1,175 @@
+#include "Http2Frame.hpp"
+
+// 解析帧头：长度24位、类型、标志和31位流标识，流标识的保留位忽略
+bool Http2Frame::parseHeader(const Buffer& buff, FrameHeader& header) {
+    if (buff.readableBytes() < HEADER_LEN) {
+        return false;
+    }
+    const char* data = buff.peek();
+    header.length = readUint24(data);
+    header.type = static_cast<TYPE>(data[3]);
+    header.flags = static_cast<uint8_t>(data[4]);
+    header.stream_id = readUint32(data + 5) & 0x7fffffff;
+    return true;
+}
+
+// 判断负载是否收完整
+bool Http2Frame::payload(
+    const Buffer& buff,
+    const FrameHeader& header,
+    std::string_view& payload) {
+    if (buff.readableBytes() - HEADER_LEN < header.length) {
+        return false;
+    }
+    payload = std::string_view(buff.peek() + HEADER_LEN, header.length);
+    return true;
+}
+
+// 去掉填充和优先级字段：PADDED时第一个字节是填充长度，
+// PRIORITY时随后是5字节的依赖流和权重
+bool Http2Frame::stripPadding(
+    const FrameHeader& header, std::string_view& payload) {
+    size_t padding = 0;
+    if (header.flags & FLAG_PADDED) {
+        if (payload.empty()) {
+            return false;
+        }
+        padding = static_cast<uint8_t>(payload[0]);
+        payload.remove_prefix(1);
+    }
+    if (header.type == TYPE::HEADERS && (header.flags & FLAG_PRIORITY)) {
+        if (payload.size() < 5) {
+            return false;
+        }
+        payload.remove_prefix(5);
+    }
+    if (padding > payload.size()) {
+        return false;
+    }
+    payload.remove_suffix(padding);
+    return true;
+}
+
+// 追加帧头
+void Http2Frame::appendHeader(
+    ChainBuffer& buff,
+    uint32_t length,
+    TYPE type,
+    uint8_t flags,
+    uint32_t streamid) {
+    char header[HEADER_LEN];
+    header[0] = static_cast<char>(length >> 16);
+    header[1] = static_cast<char>(length >> 8);
+    header[2] = static_cast<char>(length);
+    header[3] = static_cast<char>(type);
+    header[4] = static_cast<char>(flags);
+    writeUint32(header + 5, streamid & 0x7fffffff);
+    buff.append(header, HEADER_LEN);
+}
+
+// 追加完整的帧
+void Http2Frame::appendFrame(
+    ChainBuffer& buff,
+    TYPE type,
+    uint8_t flags,
+    uint32_t streamid,
+    std::string_view payload) {
+    appendHeader(
+        buff,
+        static_cast<uint32_t>(payload.size()),
+        type,
+        flags,
+        streamid);
+    buff.append(payload.data(), payload.size());
+}
+
+// 追加SETTINGS帧，每项参数6字节
+void Http2Frame::appendSettings(
+    ChainBuffer& buff, const Setting* settings, size_t count) {
+    appendHeader(
+        buff,
+        static_cast<uint32_t>(count * 6),
+        TYPE::SETTINGS,
+        0,
+        0);
+    for (size_t i = 0; i < count; i++) {
+        char item[6];
+        writeUint16(item, static_cast<uint16_t>(settings[i].id));
+        writeUint32(item + 2, settings[i].value);
+        buff.append(item, sizeof(item));
+    }
+}
+
+// 追加WINDOW_UPDATE帧
+void Http2Frame::appendWindowUpdate(
+    ChainBuffer& buff, uint32_t streamid, uint32_t increment) {
+    char payload[4];
+    writeUint32(payload, increment & 0x7fffffff);
+    appendFrame(
+        buff,
+        TYPE::WINDOW_UPDATE,
+        0,
+        streamid,
+        std::string_view(payload, sizeof(payload)));
+}
+
+// 追加RST_STREAM帧
+void Http2Frame::appendRstStream(
+    ChainBuffer& buff, uint32_t streamid, ERROR_CODE error) {
+    char payload[4];
+    writeUint32(payload, static_cast<uint32_t>(error));
+    appendFrame(
+        buff,
+        TYPE::RST_STREAM,
+        0,
+        streamid,
+        std::string_view(payload, sizeof(payload)));
+}
+
+// 追加GOAWAY帧，不带调试数据
+void Http2Frame::appendGoaway(
+    ChainBuffer& buff, uint32_t laststreamid, ERROR_CODE error) {
+    char payload[8];
+    writeUint32(payload, laststreamid & 0x7fffffff);
+    writeUint32(payload + 4, static_cast<uint32_t>(error));
+    appendFrame(
+        buff,
+        TYPE::GOAWAY,
+        0,
+        0,
+        std::string_view(payload, sizeof(payload)));
+}
+
+// 读取16位大端整数
+uint16_t Http2Frame::readUint16(const char* data) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+// 读取24位大端整数
+uint32_t Http2Frame::readUint24(const char* data) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint32_t>(p[0]) << 16 | static_cast<uint32_t>(p[1]) << 8
+           | p[2];
+}
+
+// 读取32位大端整数
+uint32_t Http2Frame::readUint32(const char* data) {
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16
+           | static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+
+// 写入16位大端整数
+void Http2Frame::writeUint16(char* out, uint16_t value) {
+    out[0] = static_cast<char>(value >> 8);
+    out[1] = static_cast<char>(value);
+}
+
+// 写入32位大端整数
+void Http2Frame::writeUint32(char* out, uint32_t value) {
+    out[0] = static_cast<char>(value >> 24);
+    out[1] = static_cast<char>(value >> 16);
+    out[2] = static_cast<char>(value >> 8);
+    out[3] = static_cast<char>(value);
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "../buffer/Buffer.hpp"
+#include "../buffer/ChainBuffer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// HTTP/2帧的编解码（RFC 9113 第4、6节）
+// 解码直接在读缓冲区上进行：帧头解析为结构体，负载是指向缓冲区的
+// string_view，在取走该帧之前有效。编码把9字节帧头和负载追加到写缓冲区，
+// DATA帧的负载可以用ChainBuffer::splice从响应正文移过来而不拷贝
+class Http2Frame {
+  public:
+    // 帧类型，未知类型的帧按规定忽略
+    enum class TYPE : uint8_t {
+        DATA = 0x0,
+        HEADERS = 0x1,
+        PRIORITY = 0x2,
+        RST_STREAM = 0x3,
+        SETTINGS = 0x4,
+        PUSH_PROMISE = 0x5,
+        PING = 0x6,
+        GOAWAY = 0x7,
+        WINDOW_UPDATE = 0x8,
+        CONTINUATION = 0x9,
+    };
+
+    // RST_STREAM和GOAWAY中的错误码
+    enum class ERROR_CODE : uint32_t {
+        NO_ERROR = 0x0,
+        PROTOCOL_ERROR = 0x1,
+        INTERNAL_ERROR = 0x2,
+        FLOW_CONTROL_ERROR = 0x3,
+        SETTINGS_TIMEOUT = 0x4,
+        STREAM_CLOSED = 0x5,
+        FRAME_SIZE_ERROR = 0x6,
+        REFUSED_STREAM = 0x7,
+        CANCEL = 0x8,
+        COMPRESSION_ERROR = 0x9,
+        CONNECT_ERROR = 0xa,
+        ENHANCE_YOUR_CALM = 0xb,
+        INADEQUATE_SECURITY = 0xc,
+        HTTP_1_1_REQUIRED = 0xd,
+    };
+
+    // SETTINGS帧中的参数
+    enum class SETTING : uint16_t {
+        HEADER_TABLE_SIZE = 0x1,
+        ENABLE_PUSH = 0x2,
+        MAX_CONCURRENT_STREAMS = 0x3,
+        INITIAL_WINDOW_SIZE = 0x4,
+        MAX_FRAME_SIZE = 0x5,
+        MAX_HEADER_LIST_SIZE = 0x6,
+    };
+
+    // 帧头
+    struct FrameHeader {
+        uint32_t length;    // 负载长度
+        TYPE type;          // 帧类型
+        uint8_t flags;      // 标志位
+        uint32_t stream_id; // 流标识，0表示整个连接
+    };
+
+    // SETTINGS帧中的一项参数
+    struct Setting {
+        SETTING id;     // 参数
+        uint32_t value; // 值
+    };
+
+    // 标志位，同一个值在不同帧类型中含义不同
+    static constexpr uint8_t FLAG_END_STREAM = 0x1;  // DATA、HEADERS
+    static constexpr uint8_t FLAG_ACK = 0x1;         // SETTINGS、PING
+    static constexpr uint8_t FLAG_END_HEADERS = 0x4; // HEADERS、CONTINUATION
+    static constexpr uint8_t FLAG_PADDED = 0x8;      // DATA、HEADERS
+    static constexpr uint8_t FLAG_PRIORITY = 0x20;   // HEADERS
+
+    // 帧头长度
+    static constexpr size_t HEADER_LEN = 9;
+    // 帧负载长度上限（SETTINGS_MAX_FRAME_SIZE）的初始值和允许的最大值
+    static constexpr uint32_t DEFAULT_MAX_FRAME = 16384;
+    static constexpr uint32_t MAX_FRAME_LIMIT = (1u << 24) - 1;
+    // 流量控制窗口的初始值和允许的最大值
+    static constexpr int64_t DEFAULT_WINDOW = 65535;
+    static constexpr int64_t MAX_WINDOW = 0x7fffffff;
+    // 客户端连接前言
+    static constexpr std::string_view PREFACE =
+        "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+    // 解析buff开头的帧头，不足9字节时返回false
+    static bool parseHeader(const Buffer& buff, FrameHeader& header);
+    // buff开头是否已经收完整一个帧，是则payload指向其负载。
+    // header须是parseHeader()对同一位置的解析结果
+    static bool payload(
+        const Buffer& buff,
+        const FrameHeader& header,
+        std::string_view& payload);
+    // 去掉DATA或HEADERS帧负载中的填充，带优先级的HEADERS帧同时去掉
+    // 优先级字段。填充长度超出负载时返回false（PROTOCOL_ERROR）
+    static bool
+    stripPadding(const FrameHeader& header, std::string_view& payload);
+
+    // 追加一个帧头，负载由调用方随后追加
+    static void appendHeader(
+        ChainBuffer& buff,
+        uint32_t length,
+        TYPE type,
+        uint8_t flags,
+        uint32_t streamid);
+    // 追加一个完整的帧
+    static void appendFrame(
+        ChainBuffer& buff,
+        TYPE type,
+        uint8_t flags,
+        uint32_t streamid,
+        std::string_view payload);
+    // 追加SETTINGS帧
+    static void
+    appendSettings(ChainBuffer& buff, const Setting* settings, size_t count);
+    // 追加WINDOW_UPDATE帧
+    static void appendWindowUpdate(
+        ChainBuffer& buff, uint32_t streamid, uint32_t increment);
+    // 追加RST_STREAM帧
+    static void
+    appendRstStream(ChainBuffer& buff, uint32_t streamid, ERROR_CODE error);
+    // 追加GOAWAY帧，laststreamid为已经或将要处理的最大流标识
+    static void
+    appendGoaway(ChainBuffer& buff, uint32_t laststreamid, ERROR_CODE error);
+
+    // 按大端序读取16位、24位、32位整数
+    static uint16_t readUint16(const char* data);
+    static uint32_t readUint24(const char* data);
+    static uint32_t readUint32(const char* data);
+    // 按大端序写入16位、32位整数
+    static void writeUint16(char* out, uint16_t value);
+    static void writeUint32(char* out, uint32_t value);
+};
@@ -0,0 +1,88 @@
+#include "Http2Frame.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+/**
+ * 测试帧头解析：不足9字节时等待，流标识的保留位被忽略，
+ * 负载收完整后才能取出
+ */
+TEST(Http2FrameTest, HeaderShouldWaitForPayload) {
+    Buffer buff;
+    Http2Frame::FrameHeader header;
+    buff.append("\x00\x00\x03\x00\x01\x80\x00", 7);
+    EXPECT_FALSE(Http2Frame::parseHeader(buff, header));
+    buff.append("\x00\x05", 2);
+    ASSERT_TRUE(Http2Frame::parseHeader(buff, header));
+    EXPECT_EQ(header.length, 3u);
+    EXPECT_EQ(header.type, Http2Frame::TYPE::DATA);
+    EXPECT_EQ(header.flags, Http2Frame::FLAG_END_STREAM);
+    EXPECT_EQ(header.stream_id, 5u);
+
+    std::string_view payload;
+    buff.append("ab", 2);
+    EXPECT_FALSE(Http2Frame::payload(buff, header, payload));
+    buff.append("c", 1);
+    ASSERT_TRUE(Http2Frame::payload(buff, header, payload));
+    EXPECT_EQ(payload, "abc");
+}
+
+/**
+ * 测试去掉填充和优先级字段，填充长度超出负载时失败
+ */
+TEST(Http2FrameTest, PaddingShouldBeStripped) {
+    Http2Frame::FrameHeader header{0, Http2Frame::TYPE::HEADERS, 0, 1};
+    header.flags = Http2Frame::FLAG_PADDED | Http2Frame::FLAG_PRIORITY;
+    std::string_view payload("\x02" "PPPPPblock--", 13);
+    ASSERT_TRUE(Http2Frame::stripPadding(header, payload));
+    EXPECT_EQ(payload, "block");
+
+    header.type = Http2Frame::TYPE::DATA;
+    payload = std::string_view("\x02" "PPPPPblock--", 13);
+    ASSERT_TRUE(Http2Frame::stripPadding(header, payload));
+    EXPECT_EQ(payload, "PPPPPblock");
+
+    payload = std::string_view("\x05" "abc", 4);
+    EXPECT_FALSE(Http2Frame::stripPadding(header, payload));
+    payload = std::string_view();
+    EXPECT_FALSE(Http2Frame::stripPadding(header, payload));
+}
+
+/**
+ * 测试控制帧的编码：帧头、负载和大端整数
+ */
+TEST(Http2FrameTest, ControlFramesShouldEncode) {
+    ChainBuffer buff;
+    Http2Frame::Setting settings[] = {
+        {Http2Frame::SETTING::MAX_CONCURRENT_STREAMS, 100},
+        {Http2Frame::SETTING::INITIAL_WINDOW_SIZE, 0x10000},
+    };
+    Http2Frame::appendSettings(buff, settings, 2);
+    EXPECT_EQ(
+        buff.retrieveAllToStr(),
+        std::string("\x00\x00\x0c\x04\x00\x00\x00\x00\x00"
+                    "\x00\x03\x00\x00\x00\x64"
+                    "\x00\x04\x00\x01\x00\x00",
+                    21));
+
+    Http2Frame::appendWindowUpdate(buff, 3, 0x12345678);
+    EXPECT_EQ(
+        buff.retrieveAllToStr(),
+        std::string(
+            "\x00\x00\x04\x08\x00\x00\x00\x00\x03\x12\x34\x56\x78",
+            13));
+
+    Http2Frame::appendGoaway(
+        buff, 7, Http2Frame::ERROR_CODE::ENHANCE_YOUR_CALM);
+    std::string goaway = buff.retrieveAllToStr();
+    ASSERT_EQ(goaway.size(), 17u);
+    EXPECT_EQ(Http2Frame::readUint24(goaway.data()), 8u);
+    EXPECT_EQ(goaway[3], '\x07');
+    EXPECT_EQ(Http2Frame::readUint32(goaway.data() + 9), 7u);
+    EXPECT_EQ(Http2Frame::readUint32(goaway.data() + 13), 0xbu);
+
+    Http2Frame::appendRstStream(buff, 1, Http2Frame::ERROR_CODE::CANCEL);
+    std::string rst = buff.retrieveAllToStr();
+    ASSERT_EQ(rst.size(), 13u);
+    EXPECT_EQ(Http2Frame::readUint32(rst.data() + 5), 1u);
+    EXPECT_EQ(Http2Frame::readUint32(rst.data() + 9), 8u);
+}
@@ -0,0 +1,1060 @@
+#include "Http2Session.hpp"
+#include "../log/Log.hpp"
+#include "HttpParser.hpp"
+#include <algorithm>
+#include <charconv>
+
+namespace {
+
+using FrameHeader = Http2Frame::FrameHeader;
+using ERROR_CODE = Http2Frame::ERROR_CODE;
+
+// HTTP/2中不允许出现的连接相关请求头（RFC 9113 8.2.2）
+constexpr std::string_view CONNECTION_HEADERS[] = {
+    "connection",
+    "keep-alive",
+    "proxy-connection",
+    "transfer-encoding",
+    "upgrade",
+};
+
+// 是否为连接相关的请求头，名称已是小写
+bool isConnectionHeader(std::string_view name) {
+    return std::find(
+               std::begin(CONNECTION_HEADERS),
+               std::end(CONNECTION_HEADERS),
+               name)
+           != std::end(CONNECTION_HEADERS);
+}
+
+// 字段名是否合法：非空的token，不含大写字母
+bool isValidName(std::string_view name) {
+    if (name.empty()) {
+        return false;
+    }
+    for (char ch : name) {
+        if (!HttpParser::isTokenChar(ch) || (ch >= 'A' && ch <= 'Z')) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 字段值是否合法：不含NUL、CR、LF，否则合成的请求会被截断或注入请求头
+bool isValidValue(std::string_view value) {
+    for (char ch : value) {
+        if (ch == '\0' || ch == '\r' || ch == '\n') {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 请求目标是否能放进请求行：不含空白和控制字符
+bool isValidTarget(std::string_view target) {
+    for (char ch : target) {
+        if (static_cast<unsigned char>(ch) <= 0x20 || ch == 0x7f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 解码base64url（RFC 4648 5），允许末尾的'='，也接受标准base64的字符
+bool decodeBase64Url(std::string_view in, std::string& out) {
+    while (!in.empty() && in.back() == '=') {
+        in.remove_suffix(1);
+    }
+    uint32_t bits = 0;
+    int count = 0;
+    for (char ch : in) {
+        int value = 0;
+        if (ch >= 'A' && ch <= 'Z') {
+            value = ch - 'A';
+        } else if (ch >= 'a' && ch <= 'z') {
+            value = ch - 'a' + 26;
+        } else if (ch >= '0' && ch <= '9') {
+            value = ch - '0' + 52;
+        } else if (ch == '-' || ch == '+') {
+            value = 62;
+        } else if (ch == '_' || ch == '/') {
+            value = 63;
+        } else {
+            return false;
+        }
+        bits = bits << 6 | value;
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            out.push_back(static_cast<char>(bits >> count));
+        }
+    }
+    // 剩下6位说明字符数除以4余1，不是合法的编码
+    return count < 6;
+}
+
+} // namespace
+
+// 构造函数，窗口和帧长度上限取协议规定的初始值
+Http2Session::Http2Session(
+    ChainBuffer& out,
+    const char* srcdir,
+    const Router* router,
+    const HttpRequest::Limits& limits)
+    : hs_out(out), hs_src_dir(srcdir), hs_router(router), hs_limits(limits),
+      hs_block_stream(0), hs_block_end_stream(false), hs_last_stream(0),
+      hs_preface_pending(true), hs_settings_received(false), hs_closed(false),
+      hs_peer_goaway(false), hs_send_window(Http2Frame::DEFAULT_WINDOW),
+      hs_recv_window(Http2Frame::DEFAULT_WINDOW),
+      hs_initial_window(Http2Frame::DEFAULT_WINDOW),
+      hs_peer_max_frame(Http2Frame::DEFAULT_MAX_FRAME), hs_buffered(0) {
+}
+
+// 析构函数：没发完的正文可能还被写缓冲区引用着，交给它延后释放
+Http2Session::~Http2Session() {
+    for (std::unique_ptr<Stream>& stream : hs_streams) {
+        hs_out.adopt(stream->body_out);
+    }
+}
+
+// 发送本端的SETTINGS，服务端的连接前言就是这个帧
+void Http2Session::start() {
+    Http2Frame::Setting settings[] = {
+        {Http2Frame::SETTING::MAX_CONCURRENT_STREAMS, MAX_CONCURRENT_STREAMS},
+        {Http2Frame::SETTING::MAX_HEADER_LIST_SIZE,
+         static_cast<uint32_t>(
+             std::min<size_t>(hs_limits.header_bytes, UINT32_MAX))},
+    };
+    Http2Frame::appendSettings(hs_out, settings, 2);
+}
+
+// HTTP2-Settings的值相当于对端的第一个SETTINGS帧，不需要确认。
+// 升级请求没有请求体，直接用它的请求行和请求头（去掉逐跳的）合成流1的请求
+bool Http2Session::upgrade(std::string_view settings, HttpRequest& request) {
+    std::string payload;
+    ERROR_CODE error = ERROR_CODE::NO_ERROR;
+    if (!decodeBase64Url(settings, payload) || payload.size() % 6 != 0
+        || !applySettings(payload, error)) {
+        return false;
+    }
+    constexpr std::string_view SWITCHING =
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Connection: Upgrade\r\n"
+        "Upgrade: h2c\r\n\r\n";
+    hs_out.append(SWITCHING.data(), SWITCHING.size());
+    start();
+    Stream& stream = openStream(1);
+    hs_last_stream = 1;
+    stream.remote_closed = true;
+    stream.head.assign(request.method())
+        .append(" ")
+        .append(request.path())
+        .append(" HTTP/2.0\r\n");
+    for (size_t i = 0; i < request.headerCount(); i++) {
+        std::string_view name = request.headerName(i);
+        if (HttpParser::equalsIgnoreCase(name, "Connection")
+            || HttpParser::equalsIgnoreCase(name, "Upgrade")
+            || HttpParser::equalsIgnoreCase(name, "HTTP2-Settings")
+            || HttpParser::equalsIgnoreCase(name, "Keep-Alive")) {
+            continue;
+        }
+        stream.head.append(name)
+            .append(": ")
+            .append(request.headerValue(i))
+            .append("\r\n");
+    }
+    finishRequest(stream);
+    return true;
+}
+
+// 逐个处理完整的帧，帧负载指向in，处理完才取走。
+// 发生连接错误后丢弃其余数据
+bool Http2Session::parse(Buffer& in) {
+    size_t before = hs_out.readableBytes();
+    while (!hs_closed) {
+        if (hs_preface_pending && !readPreface(in)) {
+            break;
+        }
+        FrameHeader header;
+        std::string_view payload;
+        if (!Http2Frame::parseHeader(in, header)) {
+            break;
+        }
+        // 本端没有放宽帧长度上限
+        if (header.length > Http2Frame::DEFAULT_MAX_FRAME) {
+            connectionError(ERROR_CODE::FRAME_SIZE_ERROR);
+            break;
+        }
+        if (!Http2Frame::payload(in, header, payload)) {
+            break;
+        }
+        onFrame(header, payload);
+        in.retrieve(Http2Frame::HEADER_LEN + header.length);
+    }
+    if (hs_closed) {
+        in.retrieveAll();
+        return hs_out.readableBytes() > before;
+    }
+    if (!hs_settings_received) {
+        return hs_out.readableBytes() > before;
+    }
+    for (const std::unique_ptr<Stream>& stream : hs_streams) {
+        if (stream->ready && !stream->responded) {
+            return true;
+        }
+    }
+    return hs_out.readableBytes() > before || canSend();
+}
+
+// 待生成响应的流中是否有可能阻塞的处理函数
+bool Http2Session::isBlocking() const {
+    for (const std::unique_ptr<Stream>& stream : hs_streams) {
+        if (stream->ready && !stream->responded && stream->route
+            && stream->route->blocking && !stream->unavailable) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 执行可能阻塞的处理函数，每个流只执行一次
+void Http2Session::runBlocking() {
+    for (std::unique_ptr<Stream>& stream : hs_streams) {
+        if (stream->ready && !stream->responded && stream->route
+            && stream->route->blocking && !stream->unavailable) {
+            stream->route->handler(
+                stream->request,
+                stream->params,
+                stream->reply);
+            stream->route = nullptr;
+        }
+    }
+}
+
+// 放弃可能阻塞的操作
+void Http2Session::rejectBlocking() {
+    for (std::unique_ptr<Stream>& stream : hs_streams) {
+        if (stream->ready && !stream->responded && stream->route
+            && stream->route->blocking) {
+            stream->unavailable = true;
+        }
+    }
+}
+
+// 先为所有请求已收完的流发出响应头，再轮流发送正文。
+// 升级而来的连接等收到客户端的连接前言和SETTINGS后才响应流1：
+// 有的客户端只缓存101之后很少的数据，在切换协议前就收到大量帧会出错
+void Http2Session::respond() {
+    if (hs_closed || !hs_settings_received) {
+        return;
+    }
+    for (std::unique_ptr<Stream>& stream : hs_streams) {
+        if (stream->ready && !stream->responded) {
+            respondStream(*stream);
+        }
+    }
+    sendData();
+}
+
+// 主动结束连接
+void Http2Session::goaway() {
+    if (!hs_closed) {
+        Http2Frame::appendGoaway(hs_out, hs_last_stream, ERROR_CODE::NO_ERROR);
+        hs_closed = true;
+    }
+}
+
+// 连接是否继续
+bool Http2Session::isOpen() const {
+    return !hs_closed && !(hs_peer_goaway && hs_streams.empty());
+}
+
+// 请求已收完的流都还在等待响应发完，发完后流即被回收
+bool Http2Session::hasPendingOutput() const {
+    for (const std::unique_ptr<Stream>& stream : hs_streams) {
+        if (stream->ready) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 是否有流正在接收请求
+bool Http2Session::isReceiving() const {
+    if (hs_block_stream != 0) {
+        return true;
+    }
+    for (const std::unique_ptr<Stream>& stream : hs_streams) {
+        if (!stream->ready) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 检查客户端的连接前言
+bool Http2Session::readPreface(Buffer& in) {
+    const std::string_view preface = Http2Frame::PREFACE;
+    size_t len = std::min(in.readableBytes(), preface.size());
+    if (std::string_view(in.peek(), len) != preface.substr(0, len)) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return false;
+    }
+    if (len < preface.size()) {
+        return false;
+    }
+    in.retrieve(len);
+    hs_preface_pending = false;
+    return true;
+}
+
+// 按帧类型分发。头部块必须连续，中间不能插入其他帧；
+// 客户端前言之后的第一个帧必须是SETTINGS；未知类型的帧忽略
+void Http2Session::onFrame(
+    const FrameHeader& header, std::string_view payload) {
+    if (hs_block_stream != 0
+        && (header.type != Http2Frame::TYPE::CONTINUATION
+            || header.stream_id != hs_block_stream)) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    if (!hs_settings_received && header.type != Http2Frame::TYPE::SETTINGS) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    switch (header.type) {
+    case Http2Frame::TYPE::DATA:
+        onData(header, payload);
+        break;
+    case Http2Frame::TYPE::HEADERS:
+        onHeaders(header, payload);
+        break;
+    case Http2Frame::TYPE::PRIORITY:
+        // 不按优先级调度，只检查格式
+        if (header.stream_id == 0) {
+            connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        } else if (header.length != 5) {
+            resetStream(header.stream_id, ERROR_CODE::FRAME_SIZE_ERROR);
+        }
+        break;
+    case Http2Frame::TYPE::RST_STREAM:
+        onRstStream(header, payload);
+        break;
+    case Http2Frame::TYPE::SETTINGS:
+        onSettings(header, payload);
+        break;
+    case Http2Frame::TYPE::PUSH_PROMISE:
+        // 客户端不能推送
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        break;
+    case Http2Frame::TYPE::PING:
+        onPing(header, payload);
+        break;
+    case Http2Frame::TYPE::GOAWAY:
+        // 对端不再发起新的流，已有的流处理完后结束连接
+        if (header.stream_id != 0) {
+            connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        } else {
+            hs_peer_goaway = true;
+        }
+        break;
+    case Http2Frame::TYPE::WINDOW_UPDATE:
+        onWindowUpdate(header, payload);
+        break;
+    case Http2Frame::TYPE::CONTINUATION:
+        onContinuation(header, payload);
+        break;
+    default:
+        break;
+    }
+}
+
+// 连接窗口按整个负载（含填充）计算并立即归还；流窗口在请求体还没收完时
+// 归还，请求体超出上限时不再保存，直接响应413
+void Http2Session::onData(
+    const FrameHeader& header, std::string_view payload) {
+    uint32_t id = header.stream_id;
+    if (id == 0) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    hs_recv_window -= header.length;
+    if (hs_recv_window < 0) {
+        connectionError(ERROR_CODE::FLOW_CONTROL_ERROR);
+        return;
+    }
+    std::string_view data = payload;
+    if (!Http2Frame::stripPadding(header, data)) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    if (header.length > 0) {
+        Http2Frame::appendWindowUpdate(hs_out, 0, header.length);
+        hs_recv_window += header.length;
+    }
+    Stream* stream = findStream(id);
+    if (!stream) {
+        // 已经结束的流上还在路上的数据忽略，从未打开的流是协议错误
+        if (id > hs_last_stream) {
+            connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        }
+        return;
+    }
+    if (stream->remote_closed) {
+        resetStream(id, ERROR_CODE::STREAM_CLOSED);
+        return;
+    }
+    stream->recv_window -= header.length;
+    if (stream->recv_window < 0) {
+        resetStream(id, ERROR_CODE::FLOW_CONTROL_ERROR);
+        return;
+    }
+    if (stream->error_status == 0) {
+        if (stream->body.size() + data.size() > hs_limits.body_bytes) {
+            LOG_WARN(
+                "Http2Session.cpp: 414     Body too large on stream %u",
+                id);
+            stream->error_status = 413;
+            stream->body.clear();
+            hs_buffered -= stream->buffered;
+            stream->buffered = 0;
+            stream->ready = true;
+        } else if (hs_buffered + data.size() > hs_limits.body_bytes) {
+            // 窗口收到即归还，各流的请求体加起来不能超过一个请求体的上限，
+            // 否则一个连接能让服务端缓存上百个请求体
+            LOG_WARN(
+                "Http2Session.cpp: 425     Buffered bodies too large on %u",
+                id);
+            resetStream(id, ERROR_CODE::ENHANCE_YOUR_CALM);
+            return;
+        } else {
+            stream->body.append(data);
+            stream->buffered += data.size();
+            hs_buffered += data.size();
+        }
+    }
+    if (header.flags & Http2Frame::FLAG_END_STREAM) {
+        stream->remote_closed = true;
+        if (!stream->ready) {
+            finishRequest(*stream);
+        }
+    } else if (header.length > 0 && !stream->ready) {
+        Http2Frame::appendWindowUpdate(hs_out, id, header.length);
+        stream->recv_window += header.length;
+    }
+}
+
+// 去掉填充和优先级字段后保存头部块片段
+void Http2Session::onHeaders(
+    const FrameHeader& header, std::string_view payload) {
+    if (header.stream_id == 0) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    std::string_view block = payload;
+    if (!Http2Frame::stripPadding(header, block)) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    hs_block.assign(block);
+    hs_block_end_stream = header.flags & Http2Frame::FLAG_END_STREAM;
+    if (header.flags & Http2Frame::FLAG_END_HEADERS) {
+        onHeaderBlock(header.stream_id, hs_block_end_stream);
+    } else {
+        hs_block_stream = header.stream_id;
+    }
+}
+
+// 拼接头部块片段，超过请求头块的上限时不再等待，结束连接
+void Http2Session::onContinuation(
+    const FrameHeader& header, std::string_view payload) {
+    if (hs_block_stream == 0) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    hs_block.append(payload);
+    if (hs_block.size() > hs_limits.header_bytes) {
+        LOG_WARN("Http2Session.cpp: 477     Header block too large");
+        connectionError(ERROR_CODE::ENHANCE_YOUR_CALM);
+        return;
+    }
+    if (header.flags & Http2Frame::FLAG_END_HEADERS) {
+        uint32_t id = hs_block_stream;
+        hs_block_stream = 0;
+        onHeaderBlock(id, hs_block_end_stream);
+    }
+}
+
+// 应用对端的设置并确认
+void Http2Session::onSettings(
+    const FrameHeader& header, std::string_view payload) {
+    if (header.stream_id != 0) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    if (header.flags & Http2Frame::FLAG_ACK) {
+        if (header.length != 0) {
+            connectionError(ERROR_CODE::FRAME_SIZE_ERROR);
+        }
+        return;
+    }
+    if (header.length % 6 != 0) {
+        connectionError(ERROR_CODE::FRAME_SIZE_ERROR);
+        return;
+    }
+    ERROR_CODE error = ERROR_CODE::NO_ERROR;
+    if (!applySettings(payload, error)) {
+        connectionError(error);
+        return;
+    }
+    hs_settings_received = true;
+    Http2Frame::appendFrame(
+        hs_out,
+        Http2Frame::TYPE::SETTINGS,
+        Http2Frame::FLAG_ACK,
+        0,
+        {});
+}
+
+// 增加连接或流的发送窗口，窗口不能超过2^31-1
+void Http2Session::onWindowUpdate(
+    const FrameHeader& header, std::string_view payload) {
+    if (header.length != 4) {
+        connectionError(ERROR_CODE::FRAME_SIZE_ERROR);
+        return;
+    }
+    uint32_t increment = Http2Frame::readUint32(payload.data()) & 0x7fffffff;
+    uint32_t id = header.stream_id;
+    if (id == 0) {
+        hs_send_window += increment;
+        if (increment == 0) {
+            connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        } else if (hs_send_window > Http2Frame::MAX_WINDOW) {
+            connectionError(ERROR_CODE::FLOW_CONTROL_ERROR);
+        }
+        return;
+    }
+    Stream* stream = findStream(id);
+    if (!stream) {
+        if (id > hs_last_stream) {
+            connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        }
+        return;
+    }
+    stream->send_window += increment;
+    if (increment == 0) {
+        resetStream(id, ERROR_CODE::PROTOCOL_ERROR);
+    } else if (stream->send_window > Http2Frame::MAX_WINDOW) {
+        resetStream(id, ERROR_CODE::FLOW_CONTROL_ERROR);
+    }
+}
+
+// 对端取消了流，还没发出的正文随之丢弃
+void Http2Session::onRstStream(
+    const FrameHeader& header, std::string_view payload) {
+    if (header.stream_id == 0 || header.stream_id > hs_last_stream) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    if (header.length != 4) {
+        connectionError(ERROR_CODE::FRAME_SIZE_ERROR);
+        return;
+    }
+    LOG_DEBUG(
+        "Http2Session.cpp: 563     stream %u reset: %u",
+        header.stream_id,
+        Http2Frame::readUint32(payload.data()));
+    closeStream(header.stream_id);
+}
+
+// 原样回应PING
+void Http2Session::onPing(
+    const FrameHeader& header, std::string_view payload) {
+    if (header.stream_id != 0) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    if (header.length != 8) {
+        connectionError(ERROR_CODE::FRAME_SIZE_ERROR);
+        return;
+    }
+    if (!(header.flags & Http2Frame::FLAG_ACK)) {
+        Http2Frame::appendFrame(
+            hs_out,
+            Http2Frame::TYPE::PING,
+            Http2Frame::FLAG_ACK,
+            0,
+            payload);
+    }
+}
+
+// 应用设置：流初始窗口的变化作用于所有已打开的流，
+// 头部表大小只影响编码器，推送和并发流数本端不使用
+bool Http2Session::applySettings(std::string_view payload, ERROR_CODE& error) {
+    for (size_t pos = 0; pos + 6 <= payload.size(); pos += 6) {
+        uint16_t id = Http2Frame::readUint16(payload.data() + pos);
+        uint32_t value = Http2Frame::readUint32(payload.data() + pos + 2);
+        switch (static_cast<Http2Frame::SETTING>(id)) {
+        case Http2Frame::SETTING::HEADER_TABLE_SIZE:
+            hs_encoder.setMaxTableSize(value);
+            break;
+        case Http2Frame::SETTING::ENABLE_PUSH:
+            if (value > 1) {
+                error = ERROR_CODE::PROTOCOL_ERROR;
+                return false;
+            }
+            break;
+        case Http2Frame::SETTING::INITIAL_WINDOW_SIZE: {
+            if (value > Http2Frame::MAX_WINDOW) {
+                error = ERROR_CODE::FLOW_CONTROL_ERROR;
+                return false;
+            }
+            int64_t delta = static_cast<int64_t>(value) - hs_initial_window;
+            for (std::unique_ptr<Stream>& stream : hs_streams) {
+                stream->send_window += delta;
+                if (stream->send_window > Http2Frame::MAX_WINDOW) {
+                    error = ERROR_CODE::FLOW_CONTROL_ERROR;
+                    return false;
+                }
+            }
+            hs_initial_window = value;
+            break;
+        }
+        case Http2Frame::SETTING::MAX_FRAME_SIZE:
+            if (value < Http2Frame::DEFAULT_MAX_FRAME
+                || value > Http2Frame::MAX_FRAME_LIMIT) {
+                error = ERROR_CODE::PROTOCOL_ERROR;
+                return false;
+            }
+            hs_peer_max_frame = value;
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+// 解码头部块。解码失败时动态表已与对端不一致，只能结束连接；
+// 头部列表超出上限时动态表仍然一致，只对这个流响应431
+void Http2Session::onHeaderBlock(uint32_t streamid, bool endstream) {
+    hs_fields.clear();
+    bool overflow = false;
+    if (!hs_decoder.decode(
+            hs_block, hs_fields, hs_limits.header_bytes, overflow)
+        && !overflow) {
+        connectionError(ERROR_CODE::COMPRESSION_ERROR);
+        return;
+    }
+    Stream* existing = findStream(streamid);
+    if (existing) {
+        // 已有的流上再次出现头部块只能是结束请求的尾部字段，内容忽略
+        if (existing->remote_closed) {
+            resetStream(streamid, ERROR_CODE::STREAM_CLOSED);
+        } else if (!endstream) {
+            resetStream(streamid, ERROR_CODE::PROTOCOL_ERROR);
+        } else {
+            existing->remote_closed = true;
+            if (!existing->ready) {
+                finishRequest(*existing);
+            }
+        }
+        return;
+    }
+    // 客户端发起的流标识是递增的奇数
+    if ((streamid & 1) == 0 || streamid <= hs_last_stream) {
+        connectionError(ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    hs_last_stream = streamid;
+    if (hs_streams.size() >= MAX_CONCURRENT_STREAMS) {
+        resetStream(streamid, ERROR_CODE::REFUSED_STREAM);
+        return;
+    }
+    Stream& stream = openStream(streamid);
+    stream.remote_closed = endstream;
+    if (overflow) {
+        LOG_WARN("Http2Session.cpp: 677     Header list too large");
+        stream.error_status = 431;
+        stream.ready = true;
+        return;
+    }
+    if (!buildHead(hs_fields, stream)) {
+        LOG_WARN("Http2Session.cpp: 683     Malformed request on %u", streamid);
+        resetStream(streamid, ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    // 与HTTP/1.1相同，content-length超出上限时不等请求体到达
+    if (stream.expect_len != NO_LENGTH
+        && stream.expect_len > hs_limits.body_bytes) {
+        stream.error_status = 413;
+        stream.ready = true;
+        return;
+    }
+    if (endstream) {
+        finishRequest(stream);
+    }
+}
+
+// 合成请求行和请求头（RFC 9113 8.3）：伪头部必须在普通字段之前且不能重复，
+// :authority换成Host，多个cookie字段合并成一个，content-length留到请求体
+// 收完后按实际长度生成并检查是否一致
+bool Http2Session::buildHead(
+    const std::vector<HpackField>& fields, Stream& stream) {
+    std::string_view method, scheme, path, authority;
+    size_t regular = fields.size();
+    for (size_t i = 0; i < fields.size(); i++) {
+        const HpackField& field = fields[i];
+        if (!isValidValue(field.value)) {
+            return false;
+        }
+        if (!field.name.empty() && field.name[0] == ':') {
+            std::string_view* slot = nullptr;
+            if (field.name == ":method") {
+                slot = &method;
+            } else if (field.name == ":scheme") {
+                slot = &scheme;
+            } else if (field.name == ":path") {
+                slot = &path;
+            } else if (field.name == ":authority") {
+                slot = &authority;
+            }
+            // 未知的、重复的或出现在普通字段之后的伪头部
+            if (!slot || slot->data() || regular != fields.size()) {
+                return false;
+            }
+            *slot = field.value;
+            continue;
+        }
+        if (regular == fields.size()) {
+            regular = i;
+        }
+        if (!isValidName(field.name) || isConnectionHeader(field.name)
+            || (field.name == "te" && field.value != "trailers")) {
+            return false;
+        }
+    }
+    if (method.empty() || scheme.empty() || path.empty()
+        || !isValidTarget(method) || !isValidTarget(path)) {
+        return false;
+    }
+    std::string& head = stream.head;
+    head.assign(method).append(" ").append(path).append(" HTTP/2.0\r\n");
+    if (!authority.empty()) {
+        head.append("host: ").append(authority).append("\r\n");
+    }
+    bool hascookie = false;
+    for (size_t i = regular; i < fields.size(); i++) {
+        const HpackField& field = fields[i];
+        if (field.name == "content-length") {
+            size_t len = 0;
+            std::from_chars_result ret = std::from_chars(
+                field.value.data(),
+                field.value.data() + field.value.size(),
+                len);
+            if (field.value.empty() || ret.ec != std::errc()
+                || ret.ptr != field.value.data() + field.value.size()
+                || (stream.expect_len != NO_LENGTH
+                    && stream.expect_len != len)) {
+                return false;
+            }
+            stream.expect_len = len;
+        } else if (field.name == "host" && !authority.empty()) {
+            continue;
+        } else if (field.name != "cookie") {
+            head.append(field.name)
+                .append(": ")
+                .append(field.value)
+                .append("\r\n");
+        } else {
+            hascookie = true;
+        }
+    }
+    if (hascookie) {
+        head.append("cookie: ");
+        const char* separator = "";
+        for (size_t i = regular; i < fields.size(); i++) {
+            if (fields[i].name == "cookie") {
+                head.append(separator).append(fields[i].value);
+                separator = "; ";
+            }
+        }
+        head.append("\r\n");
+    }
+    return true;
+}
+
+// 把合成的请求交给HttpRequest解析，解析结果和大小上限的检查与HTTP/1.1
+// 相同；请求体已经全部收到，不会返回NO_REQUEST
+void Http2Session::finishRequest(Stream& stream) {
+    stream.ready = true;
+    if (stream.error_status != 0) {
+        return;
+    }
+    if (stream.expect_len != NO_LENGTH
+        && stream.expect_len != stream.body.size()) {
+        resetStream(stream.id, ERROR_CODE::PROTOCOL_ERROR);
+        return;
+    }
+    Buffer& buff = stream.request_buff;
+    buff.retrieveAll();
+    buff.append(stream.head);
+    if (!stream.body.empty()) {
+        char len[24];
+        std::to_chars_result ret =
+            std::to_chars(len, len + sizeof(len), stream.body.size());
+        buff.append("content-length: ", 16);
+        buff.append(len, ret.ptr - len);
+        buff.append("\r\n", 2);
+    }
+    buff.append("\r\n", 2);
+    buff.append(stream.body);
+    stream.body.clear();
+    stream.body.shrink_to_fit();
+    HttpRequest::HTTP_CODE ret = stream.request.parse(buff, hs_limits);
+    if (ret != HttpRequest::HTTP_CODE::GET_REQUEST) {
+        stream.error_status = ret == HttpRequest::HTTP_CODE::BAD_REQUEST
+                                  ? stream.request.errorStatus()
+                                  : 400;
+        return;
+    }
+    // 与HTTP/1.1相同，按不含查询字符串的路径匹配路由
+    if (hs_router) {
+        std::string_view path = stream.request.path();
+        stream.route = hs_router->match(
+            stream.request.method(),
+            path.substr(0, path.find('?')),
+            stream.params);
+    }
+}
+
+// 生成响应：正文的来源与HTTP/1.1相同，响应头只有状态码、类型和长度。
+// HTTP/2没有原因短语，状态码不必在HttpResponse的表中
+void Http2Session::respondStream(Stream& stream) {
+    if (stream.error_status == 0 && !stream.unavailable && stream.route) {
+        stream.route->handler(stream.request, stream.params, stream.reply);
+        stream.route = nullptr;
+    }
+    std::string_view contenttype;
+    if (stream.error_status != 0) {
+        hs_response.res_init(
+            hs_src_dir,
+            stream.request.path(),
+            false,
+            stream.error_status);
+        contenttype = hs_response.makeBody(stream.body_out);
+    } else {
+        LOG_DEBUG(
+            "Http2Session.cpp: 847     [%u] %s",
+            stream.id,
+            stream.request.path().c_str());
+        hs_response.res_init(
+            hs_src_dir,
+            stream.request.path(),
+            false,
+            stream.unavailable ? 503 : stream.reply.code);
+        if (!stream.unavailable && !stream.reply.content_type.empty()) {
+            hs_response.makeBody(stream.body_out, stream.reply.body);
+            contenttype = stream.reply.content_type;
+        } else {
+            contenttype = hs_response.makeBody(stream.body_out);
+        }
+    }
+    int code = hs_response.resCode();
+    if (code < 100 || code > 999) {
+        code = 400;
+    }
+    // HEAD请求的正文还没有挂入写缓冲区，直接丢弃
+    if (stream.request.method() == "HEAD") {
+        stream.body_out.retrieveAll();
+    }
+    char status[4];
+    std::to_chars(status, status + 3, code);
+    char len[24];
+    std::to_chars_result ret =
+        std::to_chars(len, len + sizeof(len), hs_response.contentLen());
+
+    hs_out_block.clear();
+    hs_encoder.beginBlock(hs_out_block);
+    hs_encoder.encode(
+        hs_out_block, ":status", std::string_view(status, 3), true);
+    hs_encoder.encode(hs_out_block, "content-type", contenttype, true);
+    hs_encoder.encode(
+        hs_out_block,
+        "content-length",
+        std::string_view(len, ret.ptr - len),
+        false);
+    sendHeaderBlock(
+        stream.id,
+        hs_out_block,
+        stream.body_out.readableBytes() == 0);
+    stream.responded = true;
+}
+
+// 每一轮每个流最多发出一个DATA帧，直到窗口用完、正文发完或写缓冲区中的
+// 数据达到OUTPUT_BATCH。正文用splice移入写缓冲区，文件映射区只被引用。
+// 正文发完的流随即回收，对端还没结束发送时用RST_STREAM(NO_ERROR)告知
+// 不再需要请求的剩余部分
+void Http2Session::sendData() {
+    bool progress = true;
+    while (progress && hs_out.readableBytes() < OUTPUT_BATCH) {
+        progress = false;
+        for (size_t i = 0; i < hs_streams.size();) {
+            Stream& stream = *hs_streams[i];
+            if (!stream.responded) {
+                i++;
+                continue;
+            }
+            size_t remain = stream.body_out.readableBytes();
+            int64_t window = std::min(stream.send_window, hs_send_window);
+            size_t len = 0;
+            if (remain > 0) {
+                if (window <= 0 || hs_out.readableBytes() >= OUTPUT_BATCH) {
+                    i++;
+                    continue;
+                }
+                len = std::min<size_t>(
+                    remain,
+                    std::min<int64_t>(window, hs_peer_max_frame));
+                Http2Frame::appendHeader(
+                    hs_out,
+                    static_cast<uint32_t>(len),
+                    Http2Frame::TYPE::DATA,
+                    len == remain ? Http2Frame::FLAG_END_STREAM : 0,
+                    stream.id);
+                hs_out.splice(stream.body_out, len);
+                stream.send_window -= len;
+                hs_send_window -= len;
+                progress = true;
+            }
+            if (len < remain) {
+                i++;
+                continue;
+            }
+            if (!stream.remote_closed) {
+                Http2Frame::appendRstStream(
+                    hs_out,
+                    stream.id,
+                    ERROR_CODE::NO_ERROR);
+            }
+            closeStream(i);
+        }
+    }
+}
+
+// 与sendData()的条件一致：有已发出响应头的流，且正文已发完或窗口未用完
+bool Http2Session::canSend() const {
+    if (hs_closed || hs_out.readableBytes() >= OUTPUT_BATCH) {
+        return false;
+    }
+    for (const std::unique_ptr<Stream>& stream : hs_streams) {
+        if (stream->responded
+            && (stream->body_out.readableBytes() == 0
+                || (stream->send_window > 0 && hs_send_window > 0))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 发送头部块，END_STREAM只能出现在HEADERS帧上
+void Http2Session::sendHeaderBlock(
+    uint32_t streamid, std::string_view block, bool end) {
+    Http2Frame::TYPE type = Http2Frame::TYPE::HEADERS;
+    uint8_t flags = end ? Http2Frame::FLAG_END_STREAM : 0;
+    do {
+        size_t len = std::min<size_t>(block.size(), hs_peer_max_frame);
+        if (len == block.size()) {
+            flags |= Http2Frame::FLAG_END_HEADERS;
+        }
+        Http2Frame::appendFrame(
+            hs_out,
+            type,
+            flags,
+            streamid,
+            block.substr(0, len));
+        block.remove_prefix(len);
+        type = Http2Frame::TYPE::CONTINUATION;
+        flags = 0;
+    } while (!block.empty());
+}
+
+// 按标识查找流，同时处理的流不多，顺序查找
+Http2Session::Stream* Http2Session::findStream(uint32_t streamid) {
+    for (std::unique_ptr<Stream>& stream : hs_streams) {
+        if (stream->id == streamid) {
+            return stream.get();
+        }
+    }
+    return nullptr;
+}
+
+// 新建流，复用的对象保留各字符串和请求解析器已申请的空间
+Http2Session::Stream& Http2Session::openStream(uint32_t streamid) {
+    std::unique_ptr<Stream> stream;
+    if (!hs_free.empty()) {
+        stream = std::move(hs_free.back());
+        hs_free.pop_back();
+    } else {
+        stream = std::make_unique<Stream>();
+    }
+    stream->id = streamid;
+    stream->remote_closed = false;
+    stream->ready = false;
+    stream->responded = false;
+    stream->unavailable = false;
+    stream->error_status = 0;
+    stream->send_window = hs_initial_window;
+    stream->recv_window = Http2Frame::DEFAULT_WINDOW;
+    stream->expect_len = NO_LENGTH;
+    stream->buffered = 0;
+    stream->head.clear();
+    stream->body.clear();
+    stream->request.initHttprq();
+    stream->route = nullptr;
+    stream->params.clear();
+    stream->reply.clear();
+    hs_streams.push_back(std::move(stream));
+    return *hs_streams.back();
+}
+
+// 结束并回收流，大请求体占用的内存不随空闲的流对象保留
+void Http2Session::closeStream(size_t index) {
+    std::unique_ptr<Stream> stream = std::move(hs_streams[index]);
+    hs_streams.erase(hs_streams.begin() + index);
+    hs_buffered -= stream->buffered;
+    hs_out.adopt(stream->body_out);
+    if (hs_free.size() < FREE_STREAMS) {
+        stream->request_buff.retrieveAll();
+        stream->request_buff.shrink(REQUEST_BUFF_KEEP);
+        hs_free.push_back(std::move(stream));
+    }
+}
+
+// 按标识结束流
+void Http2Session::closeStream(uint32_t streamid) {
+    for (size_t i = 0; i < hs_streams.size(); i++) {
+        if (hs_streams[i]->id == streamid) {
+            closeStream(i);
+            return;
+        }
+    }
+}
+
+// 流错误
+void Http2Session::resetStream(uint32_t streamid, ERROR_CODE error) {
+    Http2Frame::appendRstStream(hs_out, streamid, error);
+    closeStream(streamid);
+}
+
+// 连接错误
+void Http2Session::connectionError(ERROR_CODE error) {
+    if (hs_closed) {
+        return;
+    }
+    LOG_WARN(
+        "Http2Session.cpp: 1055     connection error %u",
+        static_cast<unsigned>(error));
+    Http2Frame::appendGoaway(hs_out, hs_last_stream, error);
+    hs_closed = true;
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "../buffer/Buffer.hpp"
+#include "../buffer/ChainBuffer.hpp"
+#include "Hpack.hpp"
+#include "Http2Frame.hpp"
+#include "HttpRequest.hpp"
+#include "HttpResponse.hpp"
+#include "Router.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 一个HTTP/2（h2c）连接的协议状态（RFC 9113）
+// 读缓冲区中的帧逐个解析，每个流的请求头和请求体收完后合成一个HTTP/1.1
+// 格式的请求，交给该流自己的HttpRequest解析，因此大小上限、表单解析和
+// 路由都与HTTP/1.1相同。响应正文由HttpResponse生成到流自己的ChainBuffer，
+// 再按流量控制窗口切成DATA帧，用splice移入连接的写缓冲区，文件映射区不拷贝。
+// 多个流的DATA帧轮流发出，一个大文件不会阻塞其他流的响应。
+// 与HttpConn一样，同一时刻只被一个线程使用
+class Http2Session {
+  public:
+    // 同时处理的流数上限，超出时以REFUSED_STREAM拒绝新的流
+    static constexpr uint32_t MAX_CONCURRENT_STREAMS = 100;
+    // 一次respond()最多追加到写缓冲区的数据量，其余的等写出后再追加
+    static constexpr size_t OUTPUT_BATCH = 256 * 1024;
+    // 一次最多读入读缓冲区的数据量，parse()每次都会处理完其中所有完整的帧
+    static constexpr size_t INPUT_BATCH = 256 * 1024;
+
+    // out为连接的写缓冲区，srcdir、router和limits在会话期间保持有效
+    Http2Session(
+        ChainBuffer& out,
+        const char* srcdir,
+        const Router* router,
+        const HttpRequest::Limits& limits);
+    ~Http2Session();
+
+    // 以连接前言开始的连接（prior knowledge）：发送本端的SETTINGS，
+    // 之后parse()先检查客户端的连接前言
+    void start();
+    // 由HTTP/1.1升级而来：settings为HTTP2-Settings请求头的值。
+    // 先写出101响应和本端的SETTINGS，已解析的请求成为流1，只等待生成响应。
+    // settings格式错误时什么也不写，返回false，此时不应升级
+    bool upgrade(std::string_view settings, HttpRequest& request);
+    // 处理in中所有完整的帧并取走，返回是否有新的工作：
+    // 待生成响应的流、可以发送的正文或新追加的控制帧
+    bool parse(Buffer& in);
+    // 待生成响应的流中是否有处理函数可能阻塞
+    bool isBlocking() const;
+    // 执行待生成响应的流中可能阻塞的处理函数
+    void runBlocking();
+    // 放弃待生成响应的流中可能阻塞的操作，这些流响应503
+    void rejectBlocking();
+    // 为请求已收完的流生成响应头，并在窗口允许的范围内发出各流的正文
+    void respond();
+    // 主动结束连接（如超时）：发送GOAWAY，之后不再处理新的帧
+    void goaway();
+    // 连接是否继续：没有发生连接错误，对端也没有在发送GOAWAY后结束所有流
+    bool isOpen() const;
+    // 是否有响应还没有发完（包括因流量控制窗口用完而等待的）
+    bool hasPendingOutput() const;
+    // 是否有流正在接收请求头或请求体
+    bool isReceiving() const;
+
+  private:
+    // 一个流
+    struct Stream {
+        uint32_t id = 0;          // 流标识
+        bool remote_closed = false; // 对端是否已结束发送
+        bool ready = false;       // 请求是否已收完，等待生成响应
+        bool responded = false;   // 响应头是否已发出，正文在body_out中
+        bool unavailable = false; // 阻塞操作是否被拒绝（响应503）
+        int error_status = 0;     // 不为0时不解析请求，直接以此状态码响应
+        int64_t send_window = 0;  // 发送窗口
+        int64_t recv_window = 0;  // 接收窗口
+        size_t expect_len = 0;    // content-length的值，没有时为NO_LENGTH
+        size_t buffered = 0;      // 计入hs_buffered的请求体字节数
+        std::string head;         // 合成的请求行和请求头，不含结束空行
+        std::string body;         // 收到的请求体
+        Buffer request_buff;      // 合成的完整请求，请求头指向其中
+        HttpRequest request;      // 请求
+        const Router::Route* route = nullptr; // 匹配到的、还没执行的路由
+        RouteParams params;                   // 路径参数
+        RouteReply reply;                     // 处理函数生成的响应
+        ChainBuffer body_out;                 // 还没发出的响应正文
+    };
+
+    // expect_len中表示没有content-length
+    static constexpr size_t NO_LENGTH = static_cast<size_t>(-1);
+    // 空闲时保留以备复用的流对象数
+    static constexpr size_t FREE_STREAMS = 16;
+    // 回收的流对象保留的请求缓冲区大小
+    static constexpr size_t REQUEST_BUFF_KEEP = 4 * 1024;
+
+    // 检查并取走客户端的连接前言，前言不完整时返回false
+    bool readPreface(Buffer& in);
+    // 处理一个完整的帧
+    void onFrame(
+        const Http2Frame::FrameHeader& header, std::string_view payload);
+    // 处理DATA帧
+    void onData(
+        const Http2Frame::FrameHeader& header, std::string_view payload);
+    // 处理HEADERS帧，头部块不完整时等待CONTINUATION
+    void onHeaders(
+        const Http2Frame::FrameHeader& header, std::string_view payload);
+    // 处理CONTINUATION帧
+    void onContinuation(
+        const Http2Frame::FrameHeader& header, std::string_view payload);
+    // 处理SETTINGS帧
+    void onSettings(
+        const Http2Frame::FrameHeader& header, std::string_view payload);
+    // 处理WINDOW_UPDATE帧
+    void onWindowUpdate(
+        const Http2Frame::FrameHeader& header, std::string_view payload);
+    // 处理RST_STREAM帧
+    void onRstStream(
+        const Http2Frame::FrameHeader& header, std::string_view payload);
+    // 处理PING帧
+    void onPing(
+        const Http2Frame::FrameHeader& header, std::string_view payload);
+    // 应用SETTINGS负载中的参数，参数值非法时返回false并给出错误码
+    bool applySettings(
+        std::string_view payload, Http2Frame::ERROR_CODE& error);
+    // 头部块接收完整：解码并建立流
+    void onHeaderBlock(uint32_t streamid, bool endstream);
+    // 由解码出的字段合成请求行和请求头，字段不合法时返回false
+    bool buildHead(const std::vector<HpackField>& fields, Stream& stream);
+    // 请求收完：合成完整请求交给HttpRequest解析并匹配路由
+    void finishRequest(Stream& stream);
+    // 为一个流生成响应头，正文放入body_out
+    void respondStream(Stream& stream);
+    // 在窗口允许的范围内轮流发出各流的DATA帧
+    void sendData();
+    // 是否有流的正文可以立即发出
+    bool canSend() const;
+    // 发送头部块，超过对端的帧长度上限时拆成CONTINUATION帧
+    void sendHeaderBlock(uint32_t streamid, std::string_view block, bool end);
+    // 按标识查找正在处理的流，找不到时返回nullptr
+    Stream* findStream(uint32_t streamid);
+    // 新建流，优先复用空闲的流对象
+    Stream& openStream(uint32_t streamid);
+    // 结束并回收第index个流，没发完的正文交给写缓冲区延后释放
+    void closeStream(size_t index);
+    // 按标识结束流，不存在时什么也不做
+    void closeStream(uint32_t streamid);
+    // 流错误：发送RST_STREAM并结束该流
+    void resetStream(uint32_t streamid, Http2Frame::ERROR_CODE error);
+    // 连接错误：发送GOAWAY，之后不再处理任何帧
+    void connectionError(Http2Frame::ERROR_CODE error);
+
+    ChainBuffer& hs_out;                    // 连接的写缓冲区
+    const char* hs_src_dir;                 // 资源目录
+    const Router* hs_router;                // 路由器，可为空
+    const HttpRequest::Limits& hs_limits;   // 请求大小上限
+    HpackDecoder hs_decoder;                // 请求头解码器
+    HpackEncoder hs_encoder;                // 响应头编码器
+    HttpResponse hs_response;               // 生成响应正文，各流共用
+    std::vector<std::unique_ptr<Stream>> hs_streams; // 正在处理的流
+    std::vector<std::unique_ptr<Stream>> hs_free;    // 空闲的流对象
+    std::vector<HpackField> hs_fields;      // 解码出的字段
+    std::string hs_block;                   // 正在接收的头部块
+    std::string hs_out_block;               // 正在发送的响应头部块
+    uint32_t hs_block_stream;               // 正在接收头部块的流，0表示没有
+    bool hs_block_end_stream;               // 头部块是否带END_STREAM
+    uint32_t hs_last_stream;                // 已开始处理的最大流标识
+    bool hs_preface_pending;                // 是否还没收到客户端的连接前言
+    bool hs_settings_received;              // 是否已收到客户端的第一个SETTINGS
+    bool hs_closed;                         // 是否已发送GOAWAY
+    bool hs_peer_goaway;                    // 对端是否已发送GOAWAY
+    int64_t hs_send_window;                 // 连接的发送窗口
+    int64_t hs_recv_window;                 // 连接的接收窗口
+    int64_t hs_initial_window;              // 对端设置的流初始发送窗口
+    uint32_t hs_peer_max_frame;             // 对端允许的最大帧负载长度
+    size_t hs_buffered;                     // 各流缓存的请求体总字节数
+};
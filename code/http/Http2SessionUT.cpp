@@ -0,0 +1,470 @@
+#include "Http2Session.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using TYPE = Http2Frame::TYPE;
+
+// 输出中的一个帧
+struct Frame {
+    TYPE type;
+    uint8_t flags;
+    uint32_t stream_id;
+    std::string payload;
+};
+
+// 编码一个帧
+std::string frame(
+    TYPE type,
+    uint8_t flags,
+    uint32_t streamid,
+    std::string_view payload = {}) {
+    ChainBuffer buff;
+    Http2Frame::appendFrame(buff, type, flags, streamid, payload);
+    return buff.retrieveAllToStr();
+}
+
+// 编码SETTINGS帧的负载
+std::string settings(
+    std::initializer_list<std::pair<Http2Frame::SETTING, uint32_t>> params) {
+    std::string payload;
+    for (const auto& [id, value] : params) {
+        uint16_t code = static_cast<uint16_t>(id);
+        payload.push_back(static_cast<char>(code >> 8));
+        payload.push_back(static_cast<char>(code));
+        for (int shift = 24; shift >= 0; shift -= 8) {
+            payload.push_back(static_cast<char>(value >> shift));
+        }
+    }
+    return payload;
+}
+
+// 编码4字节的大端整数，用于WINDOW_UPDATE和RST_STREAM的负载
+std::string uint32Payload(uint32_t value) {
+    std::string payload;
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        payload.push_back(static_cast<char>(value >> shift));
+    }
+    return payload;
+}
+
+// 拆分输出中的帧
+std::vector<Frame> splitFrames(std::string_view data) {
+    std::vector<Frame> frames;
+    size_t pos = 0;
+    while (pos + Http2Frame::HEADER_LEN <= data.size()) {
+        uint32_t len = Http2Frame::readUint24(data.data() + pos);
+        frames.push_back(
+            {static_cast<TYPE>(data[pos + 3]),
+             static_cast<uint8_t>(data[pos + 4]),
+             Http2Frame::readUint32(data.data() + pos + 5) & 0x7fffffff,
+             std::string(data.substr(pos + Http2Frame::HEADER_LEN, len))});
+        pos += Http2Frame::HEADER_LEN + len;
+    }
+    return frames;
+}
+
+// 编码一个请求的头部块，不使用动态表
+std::string requestBlock(
+    std::string_view method,
+    std::string_view path,
+    std::initializer_list<HpackField> extra = {}) {
+    HpackEncoder encoder;
+    std::string block;
+    encoder.encode(block, ":method", method, false);
+    encoder.encode(block, ":scheme", "http", false);
+    encoder.encode(block, ":path", path, false);
+    encoder.encode(block, ":authority", "localhost", false);
+    for (const HpackField& field : extra) {
+        encoder.encode(block, field.name, field.value, false);
+    }
+    return block;
+}
+
+// 取出帧中的错误码：RST_STREAM在负载开头，GOAWAY在最后流标识之后
+uint32_t errorCode(const Frame& frame) {
+    size_t offset = frame.type == TYPE::GOAWAY ? 4 : 0;
+    return Http2Frame::readUint32(frame.payload.data() + offset);
+}
+
+} // namespace
+
+// 在内存中驱动一个会话：写入客户端的帧，检查写缓冲区中的输出
+class Http2SessionTest : public ::testing::Test {
+  protected:
+    Http2SessionTest() : session(out, "/nonexistent", &router, limits) {
+        router.add("GET", "/hello", [](HttpRequest&, const RouteParams&,
+                                       RouteReply& reply) {
+            reply.content_type = "text/plain";
+            reply.body = "hello";
+        });
+        router.add("GET", "/big", [](HttpRequest&, const RouteParams&,
+                                     RouteReply& reply) {
+            reply.content_type = "text/plain";
+            reply.body = std::string(40000, 'x');
+        });
+        router.add("POST", "/echo", [](HttpRequest& request,
+                                       const RouteParams&, RouteReply& reply) {
+            reply.content_type = "text/plain";
+            reply.body = std::string(request.getPost("a"));
+        });
+    }
+
+    // 写入客户端数据并解析
+    bool feed(std::string_view data) {
+        in.append(data.data(), data.size());
+        return session.parse(in);
+    }
+
+    // 取出写缓冲区中的全部帧
+    std::vector<Frame> take() {
+        return splitFrames(out.retrieveAllToStr());
+    }
+
+    // 完成连接前言和SETTINGS交换，丢弃双方的SETTINGS
+    void handshake(std::string_view payload = {}) {
+        session.start();
+        feed(std::string(Http2Frame::PREFACE)
+             + frame(TYPE::SETTINGS, 0, 0, payload));
+        take();
+    }
+
+    // 解码响应头部块，拼成"name: value\n"
+    std::string decode(const std::string& block) {
+        std::vector<HpackField> fields;
+        bool overflow = false;
+        if (!decoder.decode(block, fields, 65536, overflow)) {
+            return "<error>";
+        }
+        std::string joined;
+        for (const HpackField& field : fields) {
+            joined.append(field.name).append(": ").append(field.value);
+            joined.push_back('\n');
+        }
+        return joined;
+    }
+
+    ChainBuffer out;
+    Router router;
+    HttpRequest::Limits limits;
+    Http2Session session;
+    Buffer in;
+    HpackDecoder decoder;
+};
+
+/**
+ * 测试连接前言：本端先发SETTINGS，前言分多次到达时等待，
+ * 客户端的SETTINGS和PING都得到确认
+ */
+TEST_F(Http2SessionTest, PrefaceAndSettingsShouldBeAcked) {
+    session.start();
+    std::vector<Frame> frames = take();
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].type, TYPE::SETTINGS);
+    EXPECT_EQ(frames[0].flags, 0);
+
+    std::string_view preface = Http2Frame::PREFACE;
+    EXPECT_FALSE(feed(preface.substr(0, 10)));
+    EXPECT_TRUE(take().empty());
+    feed(std::string(preface.substr(10)) + frame(TYPE::SETTINGS, 0, 0));
+    frames = take();
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].type, TYPE::SETTINGS);
+    EXPECT_EQ(frames[0].flags, Http2Frame::FLAG_ACK);
+
+    feed(frame(TYPE::PING, 0, 0, "12345678"));
+    frames = take();
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].type, TYPE::PING);
+    EXPECT_EQ(frames[0].flags, Http2Frame::FLAG_ACK);
+    EXPECT_EQ(frames[0].payload, "12345678");
+    EXPECT_TRUE(session.isOpen());
+}
+
+/**
+ * 测试错误的连接前言和前言之后不是SETTINGS：发送GOAWAY(PROTOCOL_ERROR)
+ */
+TEST_F(Http2SessionTest, BadPrefaceShouldGoaway) {
+    feed("PRI * HTTP/2.0\r\n\r\nXX\r\n\r\n");
+    std::vector<Frame> frames = take();
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].type, TYPE::GOAWAY);
+    EXPECT_EQ(errorCode(frames[0]), 1u);
+    EXPECT_FALSE(session.isOpen());
+}
+
+/**
+ * 测试客户端前言之后的第一个帧必须是SETTINGS
+ */
+TEST_F(Http2SessionTest, FirstFrameShouldBeSettings) {
+    feed(std::string(Http2Frame::PREFACE)
+         + frame(TYPE::PING, 0, 0, "12345678"));
+    std::vector<Frame> frames = take();
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].type, TYPE::GOAWAY);
+    EXPECT_FALSE(session.isOpen());
+}
+
+/**
+ * 测试一个完整的请求：响应头和正文分别在HEADERS和DATA帧中，发完后流被回收
+ */
+TEST_F(Http2SessionTest, RequestShouldGetResponse) {
+    handshake();
+    EXPECT_TRUE(feed(frame(
+        TYPE::HEADERS,
+        Http2Frame::FLAG_END_STREAM | Http2Frame::FLAG_END_HEADERS,
+        1,
+        requestBlock("GET", "/hello"))));
+    EXPECT_TRUE(session.hasPendingOutput());
+    session.respond();
+    std::vector<Frame> frames = take();
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0].type, TYPE::HEADERS);
+    EXPECT_EQ(frames[0].stream_id, 1u);
+    EXPECT_EQ(frames[0].flags, Http2Frame::FLAG_END_HEADERS);
+    EXPECT_EQ(
+        decode(frames[0].payload),
+        ":status: 200\ncontent-type: text/plain\ncontent-length: 5\n");
+    EXPECT_EQ(frames[1].type, TYPE::DATA);
+    EXPECT_EQ(frames[1].flags, Http2Frame::FLAG_END_STREAM);
+    EXPECT_EQ(frames[1].payload, "hello");
+    EXPECT_FALSE(session.hasPendingOutput());
+    EXPECT_FALSE(session.isReceiving());
+}
+
+/**
+ * 测试头部块分在HEADERS和CONTINUATION中时拼接后再解码，
+ * 中间插入其他帧是连接错误
+ */
+TEST_F(Http2SessionTest, ContinuationShouldBeReassembled) {
+    handshake();
+    std::string block = requestBlock("GET", "/hello");
+    feed(frame(
+        TYPE::HEADERS,
+        Http2Frame::FLAG_END_STREAM,
+        1,
+        block.substr(0, 5)));
+    EXPECT_TRUE(session.isReceiving());
+    EXPECT_TRUE(feed(frame(
+        TYPE::CONTINUATION,
+        Http2Frame::FLAG_END_HEADERS,
+        1,
+        block.substr(5))));
+    session.respond();
+    std::vector<Frame> frames = take();
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(decode(frames[0].payload).substr(0, 13), ":status: 200\n");
+    EXPECT_EQ(frames[1].payload, "hello");
+
+    feed(frame(TYPE::HEADERS, 0, 3, block.substr(0, 5)));
+    feed(frame(TYPE::PING, 0, 0, "12345678"));
+    frames = take();
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].type, TYPE::GOAWAY);
+    EXPECT_EQ(errorCode(frames[0]), 1u);
+}
+
+/**
+ * 测试同时处理的流数达到上限后，新的流以REFUSED_STREAM拒绝
+ */
+TEST_F(Http2SessionTest, StreamsBeyondLimitShouldBeRefused) {
+    handshake();
+    std::string block = requestBlock("POST", "/echo");
+    uint32_t id = 1;
+    for (uint32_t i = 0; i < Http2Session::MAX_CONCURRENT_STREAMS; i++) {
+        feed(frame(TYPE::HEADERS, Http2Frame::FLAG_END_HEADERS, id, block));
+        id += 2;
+    }
+    EXPECT_TRUE(take().empty());
+    feed(frame(TYPE::HEADERS, Http2Frame::FLAG_END_HEADERS, id, block));
+    std::vector<Frame> frames = take();
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].type, TYPE::RST_STREAM);
+    EXPECT_EQ(frames[0].stream_id, id);
+    EXPECT_EQ(errorCode(frames[0]), 7u);
+    EXPECT_TRUE(session.isOpen());
+}
+
+/**
+ * 测试客户端取消流：流被回收，之后还在路上的DATA只归还连接窗口
+ */
+TEST_F(Http2SessionTest, ClientResetShouldCloseStream) {
+    handshake();
+    feed(frame(
+        TYPE::HEADERS,
+        Http2Frame::FLAG_END_HEADERS,
+        1,
+        requestBlock("POST", "/echo")));
+    EXPECT_TRUE(session.isReceiving());
+    feed(frame(TYPE::RST_STREAM, 0, 1, uint32Payload(8)));
+    EXPECT_FALSE(session.isReceiving());
+    feed(frame(TYPE::DATA, 0, 1, "a=1"));
+    std::vector<Frame> frames = take();
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].type, TYPE::WINDOW_UPDATE);
+    EXPECT_EQ(frames[0].stream_id, 0u);
+    EXPECT_TRUE(session.isOpen());
+}
+
+/**
+ * 测试请求体分在多个DATA帧中，收完后交给处理函数，
+ * 收到的数据随即归还连接窗口和流窗口
+ */
+TEST_F(Http2SessionTest, RequestBodyShouldReachHandler) {
+    handshake();
+    feed(frame(
+        TYPE::HEADERS,
+        Http2Frame::FLAG_END_HEADERS,
+        1,
+        requestBlock(
+            "POST",
+            "/echo",
+            {{"content-type", "application/x-www-form-urlencoded"}})));
+    feed(frame(TYPE::DATA, 0, 1, "a=he"));
+    std::vector<Frame> frames = take();
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[0].type, TYPE::WINDOW_UPDATE);
+    EXPECT_EQ(frames[0].stream_id, 0u);
+    EXPECT_EQ(frames[1].type, TYPE::WINDOW_UPDATE);
+    EXPECT_EQ(frames[1].stream_id, 1u);
+    EXPECT_EQ(Http2Frame::readUint32(frames[1].payload.data()), 4u);
+
+    EXPECT_TRUE(feed(frame(TYPE::DATA, Http2Frame::FLAG_END_STREAM, 1, "llo")));
+    session.respond();
+    frames = take();
+    ASSERT_EQ(frames.size(), 3u);
+    EXPECT_EQ(frames[1].type, TYPE::HEADERS);
+    EXPECT_EQ(frames[2].payload, "hello");
+}
+
+/**
+ * 测试DATA帧受流窗口、连接窗口和对端帧长度上限的限制，
+ * 窗口增加后继续发送，最后一帧带END_STREAM
+ */
+TEST_F(Http2SessionTest, DataShouldFollowFlowControl) {
+    handshake(settings({{Http2Frame::SETTING::INITIAL_WINDOW_SIZE, 10}}));
+    feed(frame(
+        TYPE::HEADERS,
+        Http2Frame::FLAG_END_STREAM | Http2Frame::FLAG_END_HEADERS,
+        1,
+        requestBlock("GET", "/big")));
+    session.respond();
+    std::vector<Frame> frames = take();
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[1].type, TYPE::DATA);
+    EXPECT_EQ(frames[1].payload.size(), 10u);
+    EXPECT_EQ(frames[1].flags, 0);
+    EXPECT_TRUE(session.hasPendingOutput());
+
+    // 窗口用完时没有可做的事
+    EXPECT_FALSE(feed(""));
+    EXPECT_TRUE(feed(frame(TYPE::WINDOW_UPDATE, 0, 1, uint32Payload(100000))));
+    session.respond();
+    frames = take();
+    ASSERT_EQ(frames.size(), 3u);
+    EXPECT_EQ(frames[0].payload.size(), Http2Frame::DEFAULT_MAX_FRAME);
+    EXPECT_EQ(frames[1].payload.size(), Http2Frame::DEFAULT_MAX_FRAME);
+    EXPECT_EQ(frames[2].payload.size(), 40000u - 10 - 2 * 16384);
+    EXPECT_EQ(frames[2].flags, Http2Frame::FLAG_END_STREAM);
+    EXPECT_FALSE(session.hasPendingOutput());
+}
+
+/**
+ * 测试请求体上限：单个流超出时响应413；各流缓存的请求体总量超出时，
+ * 让总量超出的流以ENHANCE_YOUR_CALM重置，其他流不受影响
+ */
+TEST_F(Http2SessionTest, BufferedBodiesShouldBeCapped) {
+    limits.body_bytes = 100;
+    handshake();
+    std::string block = requestBlock(
+        "POST",
+        "/echo",
+        {{"content-type", "application/x-www-form-urlencoded"}});
+    feed(frame(TYPE::HEADERS, Http2Frame::FLAG_END_HEADERS, 1, block));
+    feed(frame(TYPE::HEADERS, Http2Frame::FLAG_END_HEADERS, 3, block));
+    feed(frame(TYPE::DATA, 0, 1, "a=" + std::string(58, 'x')));
+    take();
+    feed(frame(TYPE::DATA, 0, 3, "a=" + std::string(58, 'y')));
+    std::vector<Frame> frames = take();
+    ASSERT_EQ(frames.size(), 2u);
+    EXPECT_EQ(frames[1].type, TYPE::RST_STREAM);
+    EXPECT_EQ(frames[1].stream_id, 3u);
+    EXPECT_EQ(errorCode(frames[1]), 0xbu);
+
+    feed(frame(TYPE::DATA, Http2Frame::FLAG_END_STREAM, 1, "xx"));
+    session.respond();
+    frames = take();
+    ASSERT_EQ(frames.size(), 3u);
+    EXPECT_EQ(frames[2].payload, std::string(60, 'x'));
+
+    feed(frame(TYPE::HEADERS, Http2Frame::FLAG_END_HEADERS, 5, block));
+    feed(frame(TYPE::DATA, 0, 5, std::string(101, 'z')));
+    session.respond();
+    frames = take();
+    ASSERT_GE(frames.size(), 2u);
+    EXPECT_EQ(frames[1].type, TYPE::HEADERS);
+    EXPECT_EQ(decode(frames[1].payload).substr(0, 13), ":status: 413\n");
+}
+
+/**
+ * 测试由HTTP/1.1升级：先写出101和SETTINGS，收到客户端的前言和SETTINGS后
+ * 才响应流1；HTTP2-Settings格式错误时什么也不写
+ */
+TEST_F(Http2SessionTest, UpgradeShouldAnswerStreamOne) {
+    Buffer buff;
+    buff.append(
+        "GET /hello HTTP/1.1\r\nHost: localhost\r\n"
+        "Connection: Upgrade, HTTP2-Settings\r\nUpgrade: h2c\r\n"
+        "HTTP2-Settings: AAMAAABkAAQAAQAA\r\n\r\n");
+    HttpRequest request;
+    ASSERT_EQ(
+        request.parse(buff, limits),
+        HttpRequest::HTTP_CODE::GET_REQUEST);
+    EXPECT_FALSE(session.upgrade("A", request));
+    EXPECT_EQ(out.readableBytes(), 0u);
+
+    ASSERT_TRUE(session.upgrade(request.getHeader("HTTP2-Settings"), request));
+    std::string data = out.retrieveAllToStr();
+    size_t end = data.find("\r\n\r\n");
+    ASSERT_NE(end, std::string::npos);
+    EXPECT_EQ(
+        data.substr(0, end + 4),
+        "HTTP/1.1 101 Switching Protocols\r\nConnection: Upgrade\r\n"
+        "Upgrade: h2c\r\n\r\n");
+    std::vector<Frame> frames = splitFrames(data.substr(end + 4));
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].type, TYPE::SETTINGS);
+
+    session.respond();
+    EXPECT_EQ(out.readableBytes(), 0u);
+    EXPECT_TRUE(feed(
+        std::string(Http2Frame::PREFACE) + frame(TYPE::SETTINGS, 0, 0)));
+    session.respond();
+    frames = take();
+    ASSERT_EQ(frames.size(), 3u);
+    EXPECT_EQ(frames[1].type, TYPE::HEADERS);
+    EXPECT_EQ(frames[1].stream_id, 1u);
+    EXPECT_EQ(frames[2].payload, "hello");
+}
+
+/**
+ * 测试GOAWAY：本端结束连接时发送NO_ERROR，之后的帧都被丢弃；
+ * 对端发送GOAWAY后流都结束时连接不再继续
+ */
+TEST_F(Http2SessionTest, GoawayShouldCloseSession) {
+    handshake();
+    feed(frame(TYPE::GOAWAY, 0, 0, uint32Payload(0) + uint32Payload(0)));
+    EXPECT_FALSE(session.isOpen());
+
+    session.goaway();
+    std::vector<Frame> frames = take();
+    ASSERT_EQ(frames.size(), 1u);
+    EXPECT_EQ(frames[0].type, TYPE::GOAWAY);
+    EXPECT_EQ(errorCode(frames[0]), 0u);
+    EXPECT_FALSE(feed(frame(TYPE::PING, 0, 0, "12345678")));
+    EXPECT_TRUE(take().empty());
+    EXPECT_EQ(in.readableBytes(), 0u);
+}
@@ -1,15 +1,26 @@
 #include "HttpConn.hpp"
 #include "../log/Log.hpp"
+#include "Http2Session.hpp"
+#include <algorithm>
+#include <chrono>
 
 // 静态成员变量初始化
 bool HttpConn::is_et;
 const char* HttpConn::src_dir;
 std::atomic<int> HttpConn::user_count;
+const Router* HttpConn::router;
+HttpRequest::Limits HttpConn::limits;
+bool HttpConn::h2c;
 
-// 构造函数
-HttpConn::HttpConn()
-    : httpcn_fd(-1), httpcn_addr{}, httpcn_isclose(true), httpcn_iocnt(0),
-      httpcn_iovec{} {
+// 构造函数，预先分配读缓冲区，写缓冲区的内存片按需从缓存池取用
+HttpConn::HttpConn(size_t buffreserve)
+    : httpcn_fd(-1), httpcn_addr{}, httpcn_isclose(true),
+      httpcn_parse_ok(false), httpcn_pending(false), httpcn_keepalive(false),
+      httpcn_unavailable(false), httpcn_read_capped(false),
+      httpcn_suspended(false), httpcn_tasks(0),
+      httpcn_read_buff(buffreserve),
+      httpcn_route(nullptr), httpcn_phase(PHASE::IDLE),
+      httpcn_phase_since(0) {
 }
 
 // 析构函数
@@ -26,11 +37,22 @@ void HttpConn::httpcnInit(int sockfd, const sockaddr_in& addr) {
     httpcn_addr = addr;
     // 增加用户计数
     user_count++;
-    // 清空读写缓冲区
+    // 清空读写缓冲区和上一个连接遗留的响应状态，对象可能来自连接池
+    httpcn_h2.reset();
     httpcn_read_buff.retrieveAll();
     httpcn_write_buff.retrieveAll();
+    httpcn_request.initHttprq();
     // 设置连接为开启状态
     httpcn_isclose = false;
+    httpcn_pending = false;
+    httpcn_keepalive = false;
+    httpcn_unavailable = false;
+    httpcn_read_capped = false;
+    httpcn_suspended = false;
+    httpcn_route = nullptr;
+    // 新连接必须在请求头的期限内发来第一个请求
+    httpcn_phase = PHASE::HEADER;
+    httpcn_phase_since = nowMs();
     // 记录连接信息到日志
     LOG_INFO(
         "HttpConn.cpp: 27     Client[%d](%s:%d) in, userCount:%d",
@@ -40,57 +62,108 @@ void HttpConn::httpcnInit(int sockfd, const sockaddr_in& addr) {
         static_cast<int>(user_count));
 }
 
-// 读取客户端数据
+// 读取客户端数据，最多读到readBudget()为止
 ssize_t HttpConn::httpcnRead(int* saveerrno) {
     ssize_t len = -1;
+    size_t before = httpcn_read_buff.readableBytes();
+    httpcn_read_capped = false;
     do {
+        size_t budget = readBudget();
+        if (budget == 0) {
+            // 已有的数据还没处理完，不是对端关闭，当作暂时没有数据
+            *saveerrno = EAGAIN;
+            break;
+        }
         // 从套接字读取数据到缓冲区
-        len = httpcn_read_buff.readFd(httpcn_fd, saveerrno);
+        len = httpcn_read_buff.readFd(httpcn_fd, saveerrno, budget);
         if (len <= 0) {
             // 读取失败或无数据可读，退出循环
             break;
         }
+        if (static_cast<size_t>(len) == budget) {
+            httpcn_read_capped = true;
+            break;
+        }
     } while (is_et); // 在ET模式下需要一次性读取所有数据
+    // 空闲的长连接收到数据，开始接收下一个请求
+    if (httpcn_read_buff.readableBytes() > before) {
+        updatePhase(false);
+    }
     return len;
 }
 
+// 准备一次接收，与httpcnRead相同只接收到readBudget()为止
+size_t HttpConn::prepareRecv(char** buf) {
+    size_t budget = readBudget();
+    if (budget == 0) {
+        return 0;
+    }
+    size_t len = httpcn_read_buff.prepareRead(budget);
+    *buf = httpcn_read_buff.beginWrite();
+    return len;
+}
+
+// 接收完成，数据已在读缓冲区的可写空间中
+void HttpConn::recvDone(size_t len) {
+    httpcn_read_buff.hasWritten(len);
+    httpcn_read_capped = len > 0 && readBudget() == 0;
+    if (len > 0) {
+        updatePhase(false);
+    }
+}
+
+// 准备一次写出，数据仍留在写缓冲区中，写出完成后再取走
+const iovec* HttpConn::prepareWritev(int* cnt) {
+    *cnt = httpcn_write_buff.fillIov(httpcn_iov, IO_SEGMENTS);
+    return httpcn_iov;
+}
+
+// 写出完成，取走已写出的数据
+void HttpConn::writevDone(size_t len) {
+    httpcn_write_buff.retrieve(len);
+    updatePhase(len > 0);
+}
+
+// 上次读取是否因达到读取额度而停止
+bool HttpConn::isReadCapped() const {
+    return httpcn_read_capped;
+}
+
+// 本次最多还能读入的字节数。HTTP/1.1只读到当前请求为止，大请求体或
+// 超长的请求头不会让读缓冲区无限增长；HTTP/2每次都会处理完所有完整的帧，
+// 按固定的批量读取
+size_t HttpConn::readBudget() const {
+    size_t readable = httpcn_read_buff.readableBytes();
+    size_t wanted = httpcn_h2 ? Http2Session::INPUT_BATCH
+                              : httpcn_request.wantedBytes(limits);
+    return wanted > readable ? wanted - readable : 0;
+}
+
 // 向客户端写入数据
 ssize_t HttpConn::httpcnWrite(int* saveerror) {
     ssize_t len = -1;
+    bool progress = false;
     do {
-        // 使用writev一次性写入多个缓冲区的数据
-        len = writev(httpcn_fd, httpcn_iovec, httpcn_iocnt);
+        // 响应头和文件映射区都在写缓冲区中，一次writev跨越所有内存段写出
+        len = httpcn_write_buff.writeFd(httpcn_fd, saveerror);
         if (len <= 0) {
-            // 写入失败，保存错误码并退出
-            *saveerror = errno;
-            break;
-        }
-
-        // 检查是否所有数据都已写入
-        if (httpcn_iovec[0].iov_len + httpcn_iovec[1].iov_len == 0) {
             break;
-        } else if (static_cast<size_t>(len) > httpcn_iovec[0].iov_len) {
-            // 第一个缓冲区已全部写入，调整第二个缓冲区的指针和长度
-            httpcn_iovec[1].iov_base = (uint8_t*)httpcn_iovec[1].iov_base
-                                       + (len - httpcn_iovec[0].iov_len);
-            httpcn_iovec[1].iov_len -= (len - httpcn_iovec[0].iov_len);
-            // 清空第一个缓冲区
-            httpcn_write_buff.retrieveAll();
-            httpcn_iovec[0].iov_len = 0;
-        } else {
-            // 只写入了第一个缓冲区的部分数据，调整指针和长度
-            httpcn_iovec[0].iov_base = (uint8_t*)httpcn_iovec[0].iov_base + len;
-            httpcn_iovec[0].iov_len -= len;
-            httpcn_write_buff.retrieve(len);
         }
-    } while (is_et || toWriteBytes() > 10240); // ET模式或剩余数据量大时继续写入
+        progress = true;
+        // 全部写完就退出，否则ET模式下还会多调用一次空的writev；
+        // 未写完时ET模式或剩余数据量大时继续写入
+    } while (toWriteBytes() > 0 && (is_et || toWriteBytes() > 10240));
+    // 写阶段的期限从最近一次写出数据算起，写完后进入下一阶段
+    updatePhase(progress);
     return len;
 }
 
 // 关闭连接
 void HttpConn::httpcnClose() {
-    // 解除文件映射
-    httpcn_response.unMapfile();
+    // 丢弃未写出的响应，归还内存片并解除其中的文件映射。
+    // HTTP/2各流还没发出的正文先交给写缓冲区
+    httpcn_h2.reset();
+    httpcn_write_buff.retrieveAll();
     // 检查连接是否已关闭
     if (!httpcn_isclose) {
         httpcn_isclose = true;
@@ -132,58 +205,320 @@ sockaddr_in HttpConn::getAddr() const {
 
 // 处理HTTP请求
 bool HttpConn::process() {
-    // 初始化HTTP请求对象
-    httpcn_request.initHttprq();
+    if (!parse()) {
+        return false;
+    }
+    respond();
+    return true;
+}
 
+// 解析读缓冲区中的请求，请求不完整时保留解析进度，等待更多数据。
+// HTTP/2连接上返回是否有流待生成响应或有数据可以发出
+bool HttpConn::parse() {
+    if (httpcn_h2) {
+        bool ret = httpcn_h2->parse(httpcn_read_buff);
+        updatePhase(false);
+        return ret;
+    }
+    // 上次解析出的请求（如等待前面的响应写完的数据库请求）还没处理
+    if (httpcn_pending) {
+        return true;
+    }
     // 检查读缓冲区是否有数据
     if (httpcn_read_buff.readableBytes() <= 0) {
         return false;
-    } else if (httpcn_request.parse(httpcn_read_buff)) {
+    }
+    bool waiting = false;
+    if (startHttp2(waiting)) {
+        return parse();
+    }
+    if (waiting) {
+        updatePhase(false);
+        return false;
+    }
+    HttpRequest::HTTP_CODE ret =
+        httpcn_request.parse(httpcn_read_buff, limits);
+    if (ret == HttpRequest::HTTP_CODE::NO_REQUEST) {
+        // 请求头收完后开始计算请求体的期限
+        updatePhase(false);
+        return false;
+    }
+    httpcn_unavailable = false;
+    httpcn_parse_ok = ret == HttpRequest::HTTP_CODE::GET_REQUEST;
+    httpcn_pending = true;
+    // 按方法和不含查询字符串的路径匹配路由，参数指向请求路径，不拷贝
+    httpcn_reply.clear();
+    httpcn_route = nullptr;
+    if (httpcn_parse_ok && router) {
+        std::string_view path = httpcn_request.path();
+        httpcn_route = router->match(
+            httpcn_request.method(),
+            path.substr(0, path.find('?')),
+            httpcn_params);
+    }
+    if (httpcn_parse_ok && upgradeHttp2()) {
+        httpcn_pending = false;
+        httpcn_route = nullptr;
+    }
+    return true;
+}
+
+// 只在开始解析一个新请求时检查连接前言，前言之前不能有其他数据
+bool HttpConn::startHttp2(bool& waiting) {
+    if (!h2c
+        || httpcn_request.state() != HttpRequest::PARSE_STATE::REQUEST_LINE) {
+        return false;
+    }
+    const std::string_view preface = Http2Frame::PREFACE;
+    size_t len = std::min(httpcn_read_buff.readableBytes(), preface.size());
+    if (std::string_view(httpcn_read_buff.peek(), len)
+        != preface.substr(0, len)) {
+        return false;
+    }
+    if (len < preface.size()) {
+        waiting = true;
+        return false;
+    }
+    httpcn_h2 = std::make_unique<Http2Session>(
+        httpcn_write_buff,
+        src_dir,
+        router,
+        limits);
+    httpcn_h2->start();
+    LOG_INFO("HttpConn.cpp: 255     Client[%d] HTTP/2", httpcn_fd);
+    return true;
+}
+
+// 升级到h2c（RFC 7540 3.2）：Upgrade中有h2c，Connection中有
+// HTTP2-Settings。带请求体的请求不升级，它的请求体可能已被表单解析改写，
+// 无法原样交给流1
+bool HttpConn::upgradeHttp2() {
+    std::string_view upgrade = httpcn_request.getHeader("Upgrade");
+    std::string_view connection = httpcn_request.getHeader("Connection");
+    if (!h2c || !HttpParser::hasToken(upgrade, "h2c")
+        || !HttpParser::hasToken(connection, "HTTP2-Settings")
+        || !httpcn_request.getHeader("Transfer-Encoding").empty()) {
+        return false;
+    }
+    std::string_view len = httpcn_request.getHeader("Content-Length");
+    if (!len.empty() && len != "0") {
+        return false;
+    }
+    httpcn_h2 = std::make_unique<Http2Session>(
+        httpcn_write_buff,
+        src_dir,
+        router,
+        limits);
+    if (!httpcn_h2->upgrade(
+            httpcn_request.getHeader("HTTP2-Settings"),
+            httpcn_request)) {
+        // 设置格式错误时按HTTP/1.1响应
+        httpcn_h2.reset();
+        return false;
+    }
+    LOG_INFO("HttpConn.cpp: 284     Client[%d] upgraded to h2c", httpcn_fd);
+    return true;
+}
+
+// 已解析的请求匹配到的处理函数是否可能阻塞
+bool HttpConn::isBlocking() const {
+    if (httpcn_h2) {
+        return httpcn_h2->isBlocking();
+    }
+    return httpcn_route && httpcn_route->blocking;
+}
+
+// 标记连接是否挂起
+void HttpConn::setSuspended(bool suspended) {
+    httpcn_suspended = suspended;
+}
+
+// 连接是否挂起等待阻塞操作完成
+bool HttpConn::isSuspended() const {
+    return httpcn_suspended;
+}
+
+// 提交一个处理该连接的线程池任务
+void HttpConn::beginTask() {
+    httpcn_tasks.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 线程池任务结束，之前对连接的修改对事件循环线程可见
+void HttpConn::endTask() {
+    httpcn_tasks.fetch_sub(1, std::memory_order_release);
+}
+
+// 是否有线程池任务正在或即将处理该连接。
+// 以计数而不是标志记录：任务重新注册事件后，事件循环可能在它结束之前
+// 就为同一连接提交了下一个任务
+bool HttpConn::isBusy() const {
+    return httpcn_tasks.load(std::memory_order_acquire) > 0;
+}
+
+// 执行处理函数，如登录/注册请求访问数据库，根据结果确定响应的页面。
+// 每个请求只执行一次
+void HttpConn::runBlocking() {
+    if (httpcn_h2) {
+        httpcn_h2->runBlocking();
+        return;
+    }
+    if (httpcn_route) {
+        httpcn_route->handler(httpcn_request, httpcn_params, httpcn_reply);
+        httpcn_route = nullptr;
+    }
+}
+
+// 放弃阻塞操作，数据库繁忙时不再排队等待
+void HttpConn::rejectBlocking() {
+    if (httpcn_h2) {
+        httpcn_h2->rejectBlocking();
+        return;
+    }
+    httpcn_unavailable = true;
+}
+
+// 为已解析的请求生成响应，HTTP/2连接上为各流生成响应并发出正文
+void HttpConn::respond() {
+    if (httpcn_h2) {
+        httpcn_h2->respond();
+        updatePhase(false);
+        return;
+    }
+    if (httpcn_parse_ok) {
+        // 处理函数还没有执行（不会阻塞或没有交给其他线程）时在当前线程执行
+        if (!httpcn_unavailable) {
+            runBlocking();
+        }
         // 请求解析成功，记录请求路径
         LOG_DEBUG("HttpConn.cpp: 112     %s", httpcn_request.path().c_str());
-        // 初始化响应对象，状态码200
+        // 初始化响应对象，阻塞操作被拒绝时状态码503，否则由处理函数决定
         httpcn_response.res_init(
             src_dir,
             httpcn_request.path(),
             httpcn_request.isKeepAlive(),
-            200);
+            httpcn_unavailable ? 503 : httpcn_reply.code);
     } else {
-        // 请求解析失败，返回400错误
-        httpcn_response.res_init(src_dir, httpcn_request.path(), false, 400);
+        // 请求解析失败返回400，超出大小上限返回413、414或431
+        httpcn_response.res_init(
+            src_dir,
+            httpcn_request.path(),
+            false,
+            httpcn_request.errorStatus());
     }
+    // 之后可能紧接着解析下一个请求，连接是否保持以已生成的响应为准
+    httpcn_keepalive = httpcn_parse_ok && httpcn_request.isKeepAlive();
+    httpcn_pending = false;
 
-    // 生成HTTP响应并写入缓冲区
-    httpcn_response.makeResponse(httpcn_write_buff);
-
-    // 设置第一个iovec指向响应头部数据
-    httpcn_iovec[0].iov_base = const_cast<char*>(httpcn_write_buff.peek());
-    httpcn_iovec[0].iov_len = httpcn_write_buff.readableBytes();
-    httpcn_iocnt = 1;
-
-    // 如果有文件数据，设置第二个iovec指向文件映射
-    if (httpcn_response.fileLen() > 0 && httpcn_response.mmapFile()) {
-        httpcn_iovec[1].iov_base = httpcn_response.mmapFile();
-        httpcn_iovec[1].iov_len = httpcn_response.fileLen();
-        httpcn_iocnt = 2;
+    // 生成HTTP响应并写入缓冲区：处理函数生成了正文时直接使用，
+    // 否则文件内容以映射区引用的形式挂在响应头之后
+    if (httpcn_parse_ok && !httpcn_unavailable
+        && !httpcn_reply.content_type.empty()) {
+        httpcn_response.makeResponse(
+            httpcn_write_buff,
+            httpcn_reply.content_type,
+            httpcn_reply.body);
+    } else {
+        httpcn_response.makeResponse(httpcn_write_buff);
     }
 
     // 记录文件大小和待写入数据量
     LOG_DEBUG(
         "HttpConn.cpp: 127     filesize:%d, %d to %d",
         httpcn_response.fileLen(),
-        httpcn_iocnt,
+        static_cast<int>(httpcn_write_buff.segmentCount()),
         toWriteBytes());
-    return true;
+    updatePhase(false);
 }
 
 // 获取待写入的字节数
 int HttpConn::toWriteBytes() {
-    // 计算所有iovec中的数据总量
-    return httpcn_iovec[0].iov_len + httpcn_iovec[1].iov_len;
+    return static_cast<int>(httpcn_write_buff.readableBytes());
+}
+
+// 获取读缓冲区中尚未处理的字节数
+size_t HttpConn::toReadBytes() const {
+    return httpcn_read_buff.readableBytes();
+}
+
+// 读缓冲区容量超过keepsize时缩小，写缓冲区写完后已不占用内存片
+void HttpConn::shrinkBuffer(size_t keepsize) {
+    httpcn_read_buff.shrink(keepsize);
 }
 
 // 判断是否为长连接
 bool HttpConn::isKeepAlive() const {
-    // 从请求对象获取连接类型
-    return httpcn_request.isKeepAlive();
-}
\ No newline at end of file
+    if (httpcn_h2) {
+        return httpcn_h2->isOpen();
+    }
+    return httpcn_keepalive;
+}
+
+// 判断连接是否已关闭
+bool HttpConn::isClose() const {
+    return httpcn_isclose;
+}
+
+// 获取连接所处的阶段
+HttpConn::PHASE HttpConn::phase() const {
+    return httpcn_phase;
+}
+
+// 获取进入当前阶段以来经过的毫秒数
+int64_t HttpConn::phaseElapsedMs() const {
+    return nowMs() - httpcn_phase_since;
+}
+
+// 生成408响应并只尝试写出一次，超时的客户端不值得再等待。
+// HTTP/2连接上改为发送GOAWAY
+void HttpConn::respondTimeout() {
+    int saveerrno = 0;
+    if (httpcn_h2) {
+        httpcn_h2->goaway();
+        httpcn_write_buff.writeFd(httpcn_fd, &saveerrno);
+        return;
+    }
+    httpcn_response.res_init(src_dir, httpcn_request.path(), false, 408);
+    httpcn_keepalive = false;
+    httpcn_response.makeResponse(httpcn_write_buff);
+    httpcn_write_buff.writeFd(httpcn_fd, &saveerrno);
+}
+
+// 更新所处的阶段：有待写数据时在写阶段，请求头已收完时在请求体阶段；
+// 否则已经开始接收的请求保持在请求头阶段，即使收到的只是请求之前的空行，
+// 读缓冲区中没有数据时才回到空闲阶段。HTTP/2连接上有响应没发完
+// （包括等待流量控制窗口）时在写阶段，有流正在接收请求时在请求体阶段
+void HttpConn::updatePhase(bool progress) {
+    if (httpcn_pending) {
+        // 已解析的请求还没有响应，生成响应后再确定
+        return;
+    }
+    PHASE current = httpcn_phase;
+    PHASE next = PHASE::IDLE;
+    if (httpcn_h2) {
+        if (toWriteBytes() > 0 || httpcn_h2->hasPendingOutput()) {
+            next = PHASE::WRITE;
+        } else if (httpcn_h2->isReceiving()) {
+            next = PHASE::BODY;
+        } else if (httpcn_read_buff.readableBytes() > 0) {
+            next = PHASE::HEADER;
+        }
+    } else if (toWriteBytes() > 0) {
+        next = PHASE::WRITE;
+    } else if (httpcn_request.state() == HttpRequest::PARSE_STATE::BODY) {
+        next = PHASE::BODY;
+    } else if (
+        current == PHASE::HEADER || httpcn_read_buff.readableBytes() > 0) {
+        next = PHASE::HEADER;
+    }
+    if (next != current || (progress && next == PHASE::WRITE)) {
+        httpcn_phase = next;
+        httpcn_phase_since = nowMs();
+    }
+}
+
+// 获取单调时钟的当前时刻
+int64_t HttpConn::nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
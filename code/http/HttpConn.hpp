@@ -1,24 +1,51 @@
 #pragma once
 #include "../buffer/Buffer.hpp"
+#include "../buffer/ChainBuffer.hpp"
 #include "HttpRequest.hpp"
 #include "HttpResponse.hpp"
+#include "Router.hpp"
 #include <arpa/inet.h>
 #include <assert.h>
 #include <atomic>
+#include <cstdint>
 #include <cstdlib>
-#include <sys/uio.h>
+#include <memory>
+
+class Http2Session;
 
 class HttpConn {
   public:
-    HttpConn();
+    // 连接所处的阶段，各阶段有各自的超时时间
+    enum class PHASE {
+        IDLE,   // 长连接等待下一个请求，还没有收到它的任何数据
+        HEADER, // 正在接收请求头，新连接从这里开始
+        BODY,   // 请求头已收完，正在接收请求体
+        WRITE,  // 正在写出响应
+    };
+
+    // 构造函数，buffreserve为读缓冲区的初始大小
+    explicit HttpConn(size_t buffreserve = 1024);
     ~HttpConn();
 
     // 初始化HTTP连接
     void httpcnInit(int sockfd, const sockaddr_in& addr);
     // 读取HTTP请求数据
     ssize_t httpcnRead(int* saveerrno);
+    // 上次读取是否因达到readBudget()而停止，内核中可能还有数据
+    bool isReadCapped() const;
     // 写入HTTP响应数据
     ssize_t httpcnWrite(int* saveerror);
+    // 以下供完成方式的IO（io_uring）使用，内核直接读写连接的缓冲区。
+    // 准备一次接收：数据读入*buf，返回最多读入的字节数，为0表示已有的数据
+    // 足够解析出结果，不需要再接收。接收完成前不能再改动读缓冲区
+    size_t prepareRecv(char** buf);
+    // 接收完成，len为读入的字节数
+    void recvDone(size_t len);
+    // 准备一次写出：返回描述待写数据的iovec，段数存入cnt，
+    // iovec和它描述的数据在写出完成前都保持有效
+    const iovec* prepareWritev(int* cnt);
+    // 写出完成，len为写出的字节数
+    void writevDone(size_t len);
     // 关闭HTTP连接
     void httpcnClose();
     // 获取文件描述符
@@ -29,25 +56,95 @@ class HttpConn {
     const char* getIp() const;
     // 获取地址结构
     sockaddr_in getAddr() const;
-    // 处理HTTP请求
+    // 处理HTTP请求：parse()+respond()，返回是否生成了响应
     bool process();
+    // 解析读缓冲区中的请求，返回是否有需要响应的请求。
+    // 已解析的请求还没有响应时直接返回true，不会解析下一个
+    bool parse();
+    // 已解析的请求匹配到的处理函数是否可能阻塞（如访问数据库）
+    bool isBlocking() const;
+    // 执行已解析请求匹配到的处理函数，处理函数可能阻塞时只能在允许阻塞的
+    // 线程中调用
+    void runBlocking();
+    // 放弃已解析请求中可能阻塞的操作，随后的respond()生成503响应
+    void rejectBlocking();
+    // 为已解析的请求生成响应并追加到写缓冲区，之前的响应可能还没写完
+    // （流水线），阻塞操作尚未执行时先在当前线程执行
+    void respond();
+    // 标记连接是否挂起：阻塞操作交给其他线程执行期间，
+    // 事件循环不处理该连接的事件，也不关闭它
+    void setSuspended(bool suspended);
+    // 连接是否挂起等待阻塞操作完成
+    bool isSuspended() const;
+    // 线程池任务开始/结束处理该连接，由事件循环在提交任务时调用beginTask()，
+    // 任务在最后调用endTask()。任务执行期间事件循环线程不能写出或关闭连接
+    void beginTask();
+    void endTask();
+    // 是否有线程池任务正在或即将处理该连接，可在任意线程调用
+    bool isBusy() const;
     // 获取待写入的字节数
     int toWriteBytes();
-    // 判断是否为长连接
+    // 获取读缓冲区中尚未处理的字节数
+    size_t toReadBytes() const;
+    // 读缓冲区容量超过keepsize时缩小，连接空闲时调用
+    void shrinkBuffer(size_t keepsize);
+    // 最近一个已生成的响应是否保持连接，HTTP/2连接为连接是否继续
     bool isKeepAlive() const;
+    // 判断连接是否已关闭
+    bool isClose() const;
+    // 连接当前所处的阶段，可在任意线程调用
+    PHASE phase() const;
+    // 进入当前阶段以来经过的毫秒数。收发数据不会重新计时，
+    // 只有阶段改变或写出了数据（写阶段）时才重新计时
+    int64_t phaseElapsedMs() const;
+    // 请求头或请求体没有在期限内收完：尽力写出一次408响应，
+    // 写不完也不再等待，随后由调用方关闭连接
+    void respondTimeout();
 
     static bool is_et;                  // 是否使用ET模式
     static const char* src_dir;         // 资源目录
     static std::atomic<int> user_count; // 用户计数
+    static const Router* router;        // 路由器，为空时只返回静态文件
+    static HttpRequest::Limits limits;  // 请求大小上限
+    static bool h2c;                    // 是否支持明文HTTP/2
 
   private:
-    int httpcn_fd;                  // 连接的文件描述符
-    struct sockaddr_in httpcn_addr; // 客户端地址
-    bool httpcn_isclose;            // 连接是否关闭
-    int httpcn_iocnt;               // IO向量计数
-    struct iovec httpcn_iovec[2];   // IO向量
-    Buffer httpcn_read_buff;        // 读缓冲区
-    Buffer httpcn_write_buff;       // 写缓冲区
-    HttpRequest httpcn_request;     // HTTP请求对象
-    HttpResponse httpcn_response;   // HTTP响应对象
+    // 一次完成方式的写出最多提交的内存段数
+    static constexpr int IO_SEGMENTS = 16;
+
+    // 根据读写缓冲区和解析状态更新所处的阶段，阶段改变时重新计时，
+    // progress为真表示写出了数据，写阶段也重新计时
+    void updatePhase(bool progress);
+    // 本次最多还能读入的字节数：读缓冲区中的数据已经足够当前请求解析出结果
+    // （完整的请求或超出上限）时为0，其余数据留在内核中，等它处理完再读
+    size_t readBudget() const;
+    // 单调时钟的当前时刻（毫秒）
+    static int64_t nowMs();
+    // 读缓冲区以HTTP/2连接前言开始时切换到HTTP/2，前言不完整时返回false
+    // 并设置waiting
+    bool startHttp2(bool& waiting);
+    // 已解析的请求要求升级到h2c且条件满足时切换到HTTP/2
+    bool upgradeHttp2();
+
+    int httpcn_fd;                     // 连接的文件描述符
+    struct sockaddr_in httpcn_addr;    // 客户端地址
+    bool httpcn_isclose;               // 连接是否关闭
+    bool httpcn_parse_ok;              // 最近一次请求是否解析成功
+    bool httpcn_pending;               // 是否有已解析但还没响应的请求
+    bool httpcn_keepalive;             // 最近一个响应是否保持连接
+    bool httpcn_unavailable;           // 阻塞操作是否失败或被拒绝（响应503）
+    bool httpcn_read_capped;           // 上次读取是否因达到读取额度而停止
+    std::atomic_bool httpcn_suspended; // 是否挂起等待阻塞操作完成
+    std::atomic<int> httpcn_tasks;     // 已提交但还没结束的线程池任务数
+    Buffer httpcn_read_buff;           // 读缓冲区
+    ChainBuffer httpcn_write_buff; // 写缓冲区：依次排列的响应头和文件映射区
+    iovec httpcn_iov[IO_SEGMENTS]; // 完成方式写出时提交给内核的iovec
+    HttpRequest httpcn_request;        // HTTP请求对象
+    HttpResponse httpcn_response;      // HTTP响应对象
+    const Router::Route* httpcn_route; // 已解析请求匹配到的、还没执行的路由
+    RouteParams httpcn_params;         // 路由匹配得到的路径参数
+    RouteReply httpcn_reply;           // 处理函数生成的响应
+    std::atomic<PHASE> httpcn_phase;   // 所处的阶段
+    std::atomic<int64_t> httpcn_phase_since; // 进入当前阶段的时刻（毫秒）
+    std::unique_ptr<Http2Session> httpcn_h2; // HTTP/2会话，HTTP/1.1时为空
 };
\ No newline at end of file
@@ -0,0 +1,58 @@
+#include "HttpConnPool.hpp"
+
+// 构造函数：预先创建pool_size个对象
+HttpConnPool::HttpConnPool(size_t poolsize, size_t buffreserve)
+    : pool_size(poolsize), buff_reserve(buffreserve), hit_count(0),
+      miss_count(0) {
+    idle_conns.reserve(pool_size);
+    for (size_t i = 0; i < pool_size; i++) {
+        idle_conns.emplace_back(std::make_unique<HttpConn>(buff_reserve));
+    }
+}
+
+// 取出一个空闲对象，池为空时新建一个
+std::unique_ptr<HttpConn> HttpConnPool::acquire() {
+    {
+        std::lock_guard<std::mutex> lock(pool_mtx);
+        if (!idle_conns.empty()) {
+            std::unique_ptr<HttpConn> conn = std::move(idle_conns.back());
+            idle_conns.pop_back();
+            hit_count++;
+            return conn;
+        }
+    }
+    // 在锁外创建，避免内存分配拖慢其他线程
+    miss_count++;
+    return std::make_unique<HttpConn>(buff_reserve);
+}
+
+// 归还一个已关闭的对象，池已满时直接释放
+void HttpConnPool::release(std::unique_ptr<HttpConn> conn) {
+    assert(conn && conn->isClose());
+    // 放回池中的对象只保留初始大小的缓冲区
+    conn->shrinkBuffer(buff_reserve);
+    {
+        std::lock_guard<std::mutex> lock(pool_mtx);
+        if (idle_conns.size() < pool_size) {
+            idle_conns.emplace_back(std::move(conn));
+            return;
+        }
+    }
+    // 池已满，conn离开作用域时在锁外释放
+}
+
+// 获取从池中直接取到对象的次数
+size_t HttpConnPool::getHitCount() const {
+    return hit_count;
+}
+
+// 获取池为空而新建对象的次数
+size_t HttpConnPool::getMissCount() const {
+    return miss_count;
+}
+
+// 获取当前空闲对象数量
+size_t HttpConnPool::getIdleCount() {
+    std::lock_guard<std::mutex> lock(pool_mtx);
+    return idle_conns.size();
+}
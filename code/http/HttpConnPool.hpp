@@ -0,0 +1,41 @@
+#pragma once
+
+#include "HttpConn.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// HttpConn对象池
+// 预先创建一批缓冲区已分配好的HttpConn，新连接到来时直接取出使用，
+// 连接关闭后放回池中，避免连接频繁建立和断开时反复申请释放内存。
+// 取用和归还可能发生在不同的事件循环线程，内部由互斥锁保护
+class HttpConnPool {
+  public:
+    // 构造函数
+    // poolsize: 池中保留的空闲对象上限，同时也是预先创建的对象数
+    // buffreserve: 每个对象读写缓冲区的初始大小
+    HttpConnPool(size_t poolsize = 1024, size_t buffreserve = 1024);
+    ~HttpConnPool() = default;
+
+    // 取出一个空闲对象，池为空时新建一个
+    std::unique_ptr<HttpConn> acquire();
+    // 归还一个已关闭的对象，池已满时直接释放
+    void release(std::unique_ptr<HttpConn> conn);
+
+    // 获取从池中直接取到对象的次数
+    size_t getHitCount() const;
+    // 获取池为空而新建对象的次数
+    size_t getMissCount() const;
+    // 获取当前空闲对象数量
+    size_t getIdleCount();
+
+  private:
+    size_t pool_size;    // 空闲对象上限
+    size_t buff_reserve; // 读写缓冲区初始大小
+
+    std::vector<std::unique_ptr<HttpConn>> idle_conns; // 空闲对象
+    std::mutex pool_mtx;                               // 互斥锁
+    std::atomic<size_t> hit_count;                     // 命中次数
+    std::atomic<size_t> miss_count;                    // 未命中次数
+};
@@ -0,0 +1,132 @@
+#include "HttpConnPool.hpp"
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+// 通过socketpair的一端初始化池中取出的连接，另一端作为客户端
+class HttpConnPoolTest : public ::testing::Test {
+  protected:
+    HttpConnPoolTest() {
+        HttpConn::src_dir = "/nonexistent";
+        HttpConn::router = &router;
+        HttpConn::limits = HttpRequest::Limits();
+        HttpConn::h2c = false;
+        HttpConn::is_et = false;
+        router.add("GET", "/hello", [](HttpRequest&, const RouteParams&,
+                                       RouteReply& reply) {
+            reply.content_type = "text/plain";
+            reply.body = "hello";
+        });
+    }
+
+    ~HttpConnPoolTest() override {
+        if (client_fd >= 0) {
+            close(client_fd);
+        }
+    }
+
+    // 为连接建立一对新的套接字并初始化连接
+    void attach(HttpConn* conn) {
+        if (client_fd >= 0) {
+            close(client_fd);
+        }
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        client_fd = fds[0];
+        conn->httpcnInit(fds[1], sockaddr_in{});
+    }
+
+    // 客户端发送数据，连接读入读缓冲区
+    void feed(HttpConn* conn, const std::string& data) {
+        ASSERT_EQ(
+            write(client_fd, data.data(), data.size()),
+            static_cast<ssize_t>(data.size()));
+        int readerror = 0;
+        ASSERT_GT(conn->httpcnRead(&readerror), 0);
+    }
+
+    Router router;
+    int client_fd = -1;
+};
+
+/**
+ * 测试归还的对象被再次取出复用，命中和未命中次数正确
+ */
+TEST_F(HttpConnPoolTest, ReleasedConnShouldBeReused) {
+    HttpConnPool pool(1, 1024);
+    EXPECT_EQ(pool.getIdleCount(), 1u);
+    std::unique_ptr<HttpConn> conn = pool.acquire();
+    HttpConn* raw = conn.get();
+    EXPECT_EQ(pool.getIdleCount(), 0u);
+    attach(raw);
+    conn->httpcnClose();
+    pool.release(std::move(conn));
+    EXPECT_EQ(pool.getIdleCount(), 1u);
+    EXPECT_EQ(pool.acquire().get(), raw);
+    EXPECT_EQ(pool.getHitCount(), 2u);
+    EXPECT_EQ(pool.getMissCount(), 0u);
+}
+
+/**
+ * 测试池为空时新建对象，归还时最多保留conn_pool_size个空闲对象
+ */
+TEST_F(HttpConnPoolTest, IdleConnsShouldNotExceedPoolSize) {
+    HttpConnPool pool(2, 1024);
+    std::vector<std::unique_ptr<HttpConn>> conns;
+    for (int i = 0; i < 3; i++) {
+        conns.push_back(pool.acquire());
+        attach(conns.back().get());
+        conns.back()->httpcnClose();
+    }
+    EXPECT_EQ(pool.getHitCount(), 2u);
+    EXPECT_EQ(pool.getMissCount(), 1u);
+    EXPECT_EQ(pool.getIdleCount(), 0u);
+    for (std::unique_ptr<HttpConn>& conn : conns) {
+        pool.release(std::move(conn));
+    }
+    EXPECT_EQ(pool.getIdleCount(), 2u);
+}
+
+/**
+ * 测试复用的对象不带上一个连接的状态：缓冲区清空、回到请求头阶段、
+ * 不保持连接，新连接上的请求正常解析和响应
+ */
+TEST_F(HttpConnPoolTest, ReusedConnShouldBeReset) {
+    HttpConnPool pool(1, 1024);
+    std::unique_ptr<HttpConn> conn = pool.acquire();
+    attach(conn.get());
+    // 上一个连接：一个已响应但没写出的长连接请求，后面跟着半个请求
+    feed(conn.get(), "GET /hello HTTP/1.1\r\n\r\nGET /hel");
+    ASSERT_TRUE(conn->process());
+    EXPECT_TRUE(conn->isKeepAlive());
+    EXPECT_GT(conn->toWriteBytes(), 0);
+    EXPECT_GT(conn->toReadBytes(), 0u);
+    EXPECT_EQ(conn->phase(), HttpConn::PHASE::WRITE);
+    conn->httpcnClose();
+    pool.release(std::move(conn));
+
+    conn = pool.acquire();
+    attach(conn.get());
+    EXPECT_FALSE(conn->isClose());
+    EXPECT_EQ(conn->toReadBytes(), 0u);
+    EXPECT_EQ(conn->toWriteBytes(), 0);
+    EXPECT_EQ(conn->phase(), HttpConn::PHASE::HEADER);
+    EXPECT_FALSE(conn->isKeepAlive());
+    EXPECT_FALSE(conn->isSuspended());
+    EXPECT_FALSE(conn->isBusy());
+    // 新连接的请求从头解析，不与上一个连接的残留拼接
+    feed(conn.get(), "GET /hello HTTP/1.0\r\n\r\n");
+    ASSERT_TRUE(conn->process());
+    EXPECT_FALSE(conn->isKeepAlive());
+    int writeerror = 0;
+    ASSERT_GT(conn->httpcnWrite(&writeerror), 0);
+    char buf[1024];
+    ssize_t len = read(client_fd, buf, sizeof(buf));
+    ASSERT_GT(len, 0);
+    std::string response(buf, len);
+    EXPECT_EQ(response.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+    EXPECT_EQ(response.substr(response.size() - 5), "hello");
+    conn->httpcnClose();
+}
@@ -0,0 +1,242 @@
+#include "HttpParser.hpp"
+#include "PerfectHash.hpp"
+#include <array>
+#include <iterator>
+
+namespace {
+
+// 字符类别，按位组合
+enum CHAR_CLASS : unsigned char {
+    TCHAR = 1,  // token字符
+    VCHAR = 2,  // 可见ASCII字符（0x21-0x7E）
+    FIELD = 4,  // 头部值允许的字符：可见字符、obs-text、空格和制表符
+    DIGIT = 8,  // 数字
+};
+
+// 编译期生成的256项字符类别表，逐字节查表代替多次比较
+constexpr std::array<unsigned char, 256> makeCharTable() {
+    std::array<unsigned char, 256> table{};
+    for (int ch = 0x21; ch <= 0x7E; ch++) {
+        table[ch] |= VCHAR | FIELD;
+    }
+    for (int ch = 0x80; ch <= 0xFF; ch++) {
+        table[ch] |= FIELD;
+    }
+    table[' '] |= FIELD;
+    table['\t'] |= FIELD;
+    for (int ch = '0'; ch <= '9'; ch++) {
+        table[ch] |= TCHAR | DIGIT;
+    }
+    for (int ch = 'a'; ch <= 'z'; ch++) {
+        table[ch] |= TCHAR;
+        table[ch - 'a' + 'A'] |= TCHAR;
+    }
+    for (char ch : std::string_view("!#$%&'*+-.^_`|~")) {
+        table[static_cast<unsigned char>(ch)] |= TCHAR;
+    }
+    return table;
+}
+
+constexpr std::array<unsigned char, 256> CHAR_TABLE = makeCharTable();
+
+// 字符是否属于指定类别
+inline bool is(char ch, CHAR_CLASS cls) {
+    return CHAR_TABLE[static_cast<unsigned char>(ch)] & cls;
+}
+
+// ASCII字母转小写
+constexpr char lowerChar(char ch) {
+    return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch + 'a' - 'A') : ch;
+}
+
+// 常用请求头的规范名称，下标为HEADER的值
+constexpr std::string_view HEADER_NAMES[] = {
+    "Connection",
+    "Content-Length",
+    "Content-Type",
+    "Host",
+    "If-None-Match",
+    "Range",
+    "Accept-Encoding",
+    "Cookie",
+    "Transfer-Encoding",
+};
+static_assert(
+    std::size(HEADER_NAMES) == HttpParser::HEADER_COUNT,
+    "every HEADER needs a name");
+
+// 常用请求头小写名称到HEADER的完美哈希表
+using HEADER = HttpParser::HEADER;
+constexpr auto HEADER_IDS = makePerfectHash<std::string_view, HEADER>({
+    {"connection", HEADER::CONNECTION},
+    {"content-length", HEADER::CONTENT_LENGTH},
+    {"content-type", HEADER::CONTENT_TYPE},
+    {"host", HEADER::HOST},
+    {"if-none-match", HEADER::IF_NONE_MATCH},
+    {"range", HEADER::RANGE},
+    {"accept-encoding", HEADER::ACCEPT_ENCODING},
+    {"cookie", HEADER::COOKIE},
+    {"transfer-encoding", HEADER::TRANSFER_ENCODING},
+});
+static_assert(HEADER_IDS.perfect(), "no perfect hash for header names");
+static_assert(
+    HEADER_IDS.size() == HttpParser::HEADER_COUNT,
+    "every HEADER needs an entry");
+
+// 检查哈希表中的小写名称与规范名称一致
+constexpr bool matchesHeaderNames() {
+    for (size_t i = 0; i < HEADER_IDS.size(); i++) {
+        std::string_view key = HEADER_IDS[i].key;
+        std::string_view name =
+            HEADER_NAMES[static_cast<size_t>(HEADER_IDS[i].value)];
+        if (key.size() != name.size()) {
+            return false;
+        }
+        for (size_t j = 0; j < key.size(); j++) {
+            if (key[j] != lowerChar(name[j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+static_assert(matchesHeaderNames(), "header keys must match HEADER_NAMES");
+
+// 最长的常用请求头名称的长度，更长的名称不必查表
+constexpr size_t makeMaxHeaderLen() {
+    size_t len = 0;
+    for (std::string_view name : HEADER_NAMES) {
+        len = name.size() > len ? name.size() : len;
+    }
+    return len;
+}
+
+constexpr size_t MAX_HEADER_LEN = makeMaxHeaderLen();
+
+// 从pos开始跳过属于cls的字符，返回第一个不属于cls的位置
+inline size_t skip(std::string_view line, size_t pos, CHAR_CLASS cls) {
+    while (pos < line.size() && is(line[pos], cls)) {
+        pos++;
+    }
+    return pos;
+}
+
+} // namespace
+
+// 解析请求行：依次是token组成的方法、一个空格、可见字符组成的目标、
+// 一个空格和固定8个字符的版本，每一段出现非法字符都立即失败
+bool HttpParser::parseRequestLine(std::string_view line, RequestLine& result) {
+    size_t end = skip(line, 0, TCHAR);
+    if (end == 0 || end == line.size() || line[end] != ' ') {
+        return false;
+    }
+    result.method = line.substr(0, end);
+
+    size_t start = end + 1;
+    end = skip(line, start, VCHAR);
+    if (end == start || end == line.size() || line[end] != ' ') {
+        return false;
+    }
+    result.target = line.substr(start, end - start);
+
+    // HTTP-version = "HTTP/" DIGIT "." DIGIT
+    std::string_view version = line.substr(end + 1);
+    if (version.size() != 8 || version.substr(0, 5) != "HTTP/"
+        || !is(version[5], DIGIT) || version[6] != '.'
+        || !is(version[7], DIGIT)) {
+        return false;
+    }
+    result.version = version.substr(5);
+    return true;
+}
+
+// 解析请求头：name紧跟冒号，值两端的空格和制表符不属于值
+bool HttpParser::parseHeaderLine(
+    std::string_view line,
+    std::string_view& name,
+    std::string_view& value) {
+    size_t colon = skip(line, 0, TCHAR);
+    if (colon == 0 || colon == line.size() || line[colon] != ':') {
+        return false;
+    }
+    size_t begin = colon + 1;
+    size_t end = line.size();
+    for (size_t i = begin; i < end; i++) {
+        if (!is(line[i], FIELD)) {
+            return false;
+        }
+    }
+    while (begin < end && (line[begin] == ' ' || line[begin] == '\t')) {
+        begin++;
+    }
+    while (end > begin && (line[end - 1] == ' ' || line[end - 1] == '\t')) {
+        end--;
+    }
+    name = line.substr(0, colon);
+    value = line.substr(begin, end - begin);
+    return true;
+}
+
+// 识别请求头名称：转成小写后查完美哈希表，只计算一次哈希、比较一次名称
+HttpParser::HEADER HttpParser::headerId(std::string_view name) {
+    if (name.empty() || name.size() > MAX_HEADER_LEN) {
+        return HEADER::OTHER;
+    }
+    char lower[MAX_HEADER_LEN];
+    for (size_t i = 0; i < name.size(); i++) {
+        lower[i] = lowerChar(name[i]);
+    }
+    const HEADER* id = HEADER_IDS.find(std::string_view(lower, name.size()));
+    return id ? *id : HEADER::OTHER;
+}
+
+// 常用请求头的规范名称
+std::string_view HttpParser::headerName(HEADER id) {
+    size_t index = static_cast<size_t>(id);
+    return index < HEADER_COUNT ? HEADER_NAMES[index] : std::string_view();
+}
+
+// 是否为token字符
+bool HttpParser::isTokenChar(char ch) {
+    return is(ch, TCHAR);
+}
+
+// ASCII字母转小写，其他字符不变
+char HttpParser::toLower(char ch) {
+    return lowerChar(ch);
+}
+
+// 忽略大小写比较两个ASCII字符串
+bool HttpParser::equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (toLower(a[i]) != toLower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 逗号分隔的列表中是否有token
+bool HttpParser::hasToken(std::string_view list, std::string_view token) {
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) {
+            item.remove_prefix(1);
+        }
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) {
+            item.remove_suffix(1);
+        }
+        if (equalsIgnoreCase(item, token)) {
+            return true;
+        }
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        list.remove_prefix(comma + 1);
+    }
+    return false;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+// HTTP/1.x请求行和请求头的词法解析
+// 直接在读缓冲区的字节上逐字符查表扫描，不使用正则表达式，也不拷贝数据：
+// 解析结果都是指向输入行的string_view，只在输入数据不变时有效。
+// 按RFC 9110/9112严格校验：方法和头部名必须是token，
+// 请求目标只能是可见ASCII字符，版本必须形如HTTP/d.d，
+// 头部名与冒号之间不允许空白，任何位置都不允许出现控制字符。
+// 常用请求头的名称在解析时经完美哈希识别为枚举值，之后按枚举值查找
+class HttpParser {
+  public:
+    // 按名称识别的常用请求头
+    enum class HEADER : unsigned char {
+        CONNECTION,
+        CONTENT_LENGTH,
+        CONTENT_TYPE,
+        HOST,
+        IF_NONE_MATCH,
+        RANGE,
+        ACCEPT_ENCODING,
+        COOKIE,
+        TRANSFER_ENCODING,
+        OTHER, // 其他请求头
+    };
+    // 常用请求头的个数
+    static constexpr size_t HEADER_COUNT = static_cast<size_t>(HEADER::OTHER);
+
+    // 请求行的解析结果
+    struct RequestLine {
+        std::string_view method;  // 请求方法
+        std::string_view target;  // 请求目标（路径）
+        std::string_view version; // 版本号，如"1.1"
+    };
+
+    // 解析不含CRLF的请求行"METHOD SP target SP HTTP/d.d"，格式错误时返回false
+    static bool parseRequestLine(std::string_view line, RequestLine& result);
+    // 解析不含CRLF的请求头"name: value"，去掉值两端的空白，格式错误时返回false
+    static bool parseHeaderLine(
+        std::string_view line,
+        std::string_view& name,
+        std::string_view& value);
+    // 识别请求头名称（忽略大小写），不是常用请求头时返回OTHER
+    static HEADER headerId(std::string_view name);
+    // 常用请求头的规范名称，OTHER返回空
+    static std::string_view headerName(HEADER id);
+    // 是否为token字符（RFC 9110 tchar）
+    static bool isTokenChar(char ch);
+    // ASCII字母转小写
+    static char toLower(char ch);
+    // 忽略大小写比较两个ASCII字符串
+    static bool equalsIgnoreCase(std::string_view a, std::string_view b);
+    // 逗号分隔的列表（如Connection、Upgrade请求头的值）中是否有token，
+    // 忽略大小写和两侧的空白
+    static bool hasToken(std::string_view list, std::string_view token);
+};
@@ -0,0 +1,134 @@
+#include "HttpParser.hpp"
+#include <cctype>
+#include <gtest/gtest.h>
+#include <string>
+
+/**
+ * 测试合法请求行被切分为方法、目标和版本，且结果指向输入
+ */
+TEST(HttpParserTest, ValidRequestLineShouldBeSplit) {
+    std::string line = "GET /index.html?a=1 HTTP/1.1";
+    HttpParser::RequestLine result;
+    ASSERT_TRUE(HttpParser::parseRequestLine(line, result));
+    EXPECT_EQ(result.method, "GET");
+    EXPECT_EQ(result.target, "/index.html?a=1");
+    EXPECT_EQ(result.version, "1.1");
+    EXPECT_EQ(result.method.data(), line.data());
+    EXPECT_EQ(result.target.data(), line.data() + 4);
+}
+
+/**
+ * 测试格式错误的请求行被拒绝
+ */
+TEST(HttpParserTest, MalformedRequestLineShouldFail) {
+    HttpParser::RequestLine result;
+    for (const char* line :
+         {"",
+          "BAD",
+          "GET /",
+          "GET / HTTP/1.1 ",
+          "GET  / HTTP/1.1",
+          " GET / HTTP/1.1",
+          "GE(T / HTTP/1.1",
+          "GET / HTTP/11",
+          "GET / HTTP/1.x",
+          "GET / http/1.1",
+          "GET / HTTP/1.1x",
+          "GET /a\tb HTTP/1.1",
+          "GET /\x7f HTTP/1.1"}) {
+        SCOPED_TRACE(line);
+        EXPECT_FALSE(HttpParser::parseRequestLine(line, result));
+    }
+}
+
+/**
+ * 测试请求头的值去掉两端空白，值可以为空
+ */
+TEST(HttpParserTest, HeaderValueShouldBeTrimmed) {
+    std::string_view name, value;
+    ASSERT_TRUE(
+        HttpParser::parseHeaderLine("Host: \t example.com  ", name, value));
+    EXPECT_EQ(name, "Host");
+    EXPECT_EQ(value, "example.com");
+
+    ASSERT_TRUE(HttpParser::parseHeaderLine("X-Empty:", name, value));
+    EXPECT_EQ(name, "X-Empty");
+    EXPECT_TRUE(value.empty());
+
+    ASSERT_TRUE(HttpParser::parseHeaderLine("Accept:a: b", name, value));
+    EXPECT_EQ(name, "Accept");
+    EXPECT_EQ(value, "a: b");
+}
+
+/**
+ * 测试格式错误的请求头被拒绝
+ */
+TEST(HttpParserTest, MalformedHeaderShouldFail) {
+    std::string_view name, value;
+    for (const char* line :
+         {": value",
+          "Host : example.com",
+          "Host",
+          "Bad Name: x",
+          " Host: example.com",
+          "Host: a\x01"
+          "b"}) {
+        SCOPED_TRACE(line);
+        EXPECT_FALSE(HttpParser::parseHeaderLine(line, name, value));
+    }
+}
+
+/**
+ * 测试字符分类和忽略大小写比较
+ */
+TEST(HttpParserTest, CharClassAndCaseInsensitiveCompare) {
+    EXPECT_TRUE(HttpParser::isTokenChar('a'));
+    EXPECT_TRUE(HttpParser::isTokenChar('~'));
+    EXPECT_FALSE(HttpParser::isTokenChar(':'));
+    EXPECT_FALSE(HttpParser::isTokenChar(' '));
+    EXPECT_FALSE(HttpParser::isTokenChar('\x80'));
+
+    EXPECT_TRUE(HttpParser::equalsIgnoreCase("Keep-Alive", "keep-alive"));
+    EXPECT_FALSE(HttpParser::equalsIgnoreCase("keep-alive", "keep-alivex"));
+    // '@'和'`'只差0x20，不能被当作同一字母
+    EXPECT_FALSE(HttpParser::equalsIgnoreCase("@", "`"));
+}
+
+/**
+ * 测试常用请求头忽略大小写识别为枚举值，其他名称识别为OTHER
+ */
+TEST(HttpParserTest, CommonHeadersShouldBeInterned) {
+    for (size_t i = 0; i < HttpParser::HEADER_COUNT; i++) {
+        HttpParser::HEADER id = static_cast<HttpParser::HEADER>(i);
+        std::string name(HttpParser::headerName(id));
+        SCOPED_TRACE(name);
+        EXPECT_EQ(HttpParser::headerId(name), id);
+        for (char& ch : name) {
+            ch = static_cast<char>(toupper(static_cast<unsigned char>(ch)));
+        }
+        EXPECT_EQ(HttpParser::headerId(name), id);
+    }
+    EXPECT_EQ(
+        HttpParser::headerId("content-lengtH"),
+        HttpParser::HEADER::CONTENT_LENGTH);
+    // 与常用请求头只差一个字符、比最长的常用请求头还长或为空
+    for (const char* name :
+         {"Dontent-Lengtg", "User-Agent", "Transfer-Encodings", ""}) {
+        SCOPED_TRACE(name);
+        EXPECT_EQ(HttpParser::headerId(name), HttpParser::HEADER::OTHER);
+    }
+    EXPECT_TRUE(HttpParser::headerName(HttpParser::HEADER::OTHER).empty());
+}
+
+/**
+ * 测试在逗号分隔的列表中查找token：忽略大小写和两侧空白，只匹配完整的项
+ */
+TEST(HttpParserTest, TokenListShouldMatchWholeItems) {
+    EXPECT_TRUE(HttpParser::hasToken("close", "close"));
+    EXPECT_TRUE(
+        HttpParser::hasToken("Upgrade,\tHTTP2-Settings ", "http2-settings"));
+    EXPECT_TRUE(HttpParser::hasToken(" keep-alive , Close", "close"));
+    EXPECT_FALSE(HttpParser::hasToken("closed, x", "close"));
+    EXPECT_FALSE(HttpParser::hasToken("", "close"));
+    EXPECT_FALSE(HttpParser::hasToken(",,", "close"));
+}
@@ -1,17 +1,16 @@
 #include "HttpRequest.hpp"
+#include "../buffer/ByteScan.hpp"
 #include "../log/Log.hpp"
 #include "../pool/SqlConnRAII.hpp"
+#include "HttpParser.hpp"
 #include <algorithm>
-#include <regex>
-
-// 初始化静态成员变量
-const std::unordered_set<std::string> HttpRequest::DEFAULT_HTML{
-    "/index", "/register", "/login", "/welcome", "/video", "/picture"};
-const std::unordered_map<std::string, int> HttpRequest::DEFAULT_HTML_TAG{
-    {"/register.html", 0}, {"/login.html", 1}};
+#include <charconv>
 
 // 构造函数
 HttpRequest::HttpRequest() {
+    // 预留常见请求头数量的空间，clear()不会释放，对象复用时无需再扩容
+    httprq_header.reserve(16);
+    httprq_post.reserve(8);
     initHttprq();
 }
 
@@ -21,58 +20,71 @@ void HttpRequest::initHttprq() {
     httprq_state = PARSE_STATE::REQUEST_LINE;
     // 清空所有字符串成员
     httprq_method = httprq_path = httprq_version = httprq_body = "";
+    httprq_keepalive = false;
+    httprq_error = 400;
+    httprq_form = FormParser::TYPE::NONE;
+    httprq_scanned = httprq_header_len = httprq_content_len = 0;
+    httprq_raw = {};
     // 清空请求头和POST数据容器
     httprq_header.clear();
+    httprq_known.fill(NO_HEADER);
     httprq_post.clear();
 }
 
 // 解析HTTP请求
-bool HttpRequest::parse(Buffer& buff) {
-    const char CRLF[] = "\r\n";
-    // 检查缓冲区是否有可读数据
-    if (buff.readableBytes() <= 0) {
-        return false;
+HttpRequest::HTTP_CODE
+HttpRequest::parse(Buffer& buff, const Limits& limits) {
+    // 上一个请求已经处理完，开始解析新的请求
+    if (httprq_state == PARSE_STATE::FINISH) {
+        initHttprq();
     }
 
-    // 循环解析请求，直到缓冲区为空或解析完成
-    while (buff.readableBytes() && httprq_state != PARSE_STATE::FINISH) {
-        // 查找行结束符（CRLF）
-        const char* lineend =
-            std::search(buff.peek(), buff.beginWriteConst(), CRLF, CRLF + 2);
-        std::string line(buff.peek(), lineend);
-
-        // 根据当前解析状态处理数据
-        switch (httprq_state) {
-        case PARSE_STATE::REQUEST_LINE:
-            // 解析请求行，失败则返回false
-            if (!parseRequestLine(line)) {
-                return false;
-            }
-            // 解析请求路径
-            parsePath();
-            break;
-        case PARSE_STATE::HEADERS:
-            // 解析请求头
-            parseHeader(line);
-            // 如果缓冲区剩余数据不足，则认为请求解析完成
-            if (buff.readableBytes() <= 2) {
-                httprq_state = PARSE_STATE::FINISH;
+    if (httprq_state == PARSE_STATE::REQUEST_LINE) {
+        // 忽略请求行之前的空行（RFC 9112 2.2）
+        while (buff.readableBytes() >= 2 && buff.peek()[0] == '\r'
+               && buff.peek()[1] == '\n') {
+            buff.retrieve(2);
+        }
+        // 请求头收完整之前不解析，从上次查找结束的位置继续查找结束标志，
+        // 慢速客户端逐字节发送时也不会重复扫描已经收到的数据
+        const char* headerend =
+            buff.findHeaderEnd(buff.peek() + httprq_scanned);
+        if (!headerend) {
+            // 末尾3个字节可能是结束标志的前半部分，下次从这里开始查找
+            size_t readable = buff.readableBytes();
+            httprq_scanned = readable > 3 ? readable - 3 : 0;
+            if (checkPartialHeader(buff, limits)) {
+                return HTTP_CODE::NO_REQUEST;
             }
-            break;
-        case PARSE_STATE::BODY:
-            // 解析请求体
-            parseBody(line);
-            break;
-        default:
-            break;
+            // 已经超出上限，不再等待请求头的剩余部分
+            httprq_keepalive = false;
+            httprq_state = PARSE_STATE::FINISH;
+            return HTTP_CODE::BAD_REQUEST;
         }
-
-        // 如果已经到达缓冲区末尾，则退出循环
-        if (lineend == buff.beginWrite()) {
-            break;
+        httprq_header_len = headerend + 4 - buff.peek();
+        std::string_view block(buff.peek(), headerend - buff.peek());
+        if (!parseHeaderBlock(block, limits)) {
+            // 格式错误的请求不再复用连接
+            httprq_keepalive = false;
+            httprq_state = PARSE_STATE::FINISH;
+            return HTTP_CODE::BAD_REQUEST;
         }
-        // 移动缓冲区读指针，跳过已处理的数据
-        buff.retrieveUntill(lineend + 2);
+    }
+
+    // 请求头块留在缓冲区中，两次调用之间缓冲区可能扩容移动了数据
+    httprq_raw = std::string_view(buff.peek(), httprq_raw.size());
+    if (buff.readableBytes() - httprq_header_len < httprq_content_len) {
+        // 请求体不完整，等待更多数据
+        return HTTP_CODE::NO_REQUEST;
+    }
+    bool bodyok = parseBody(std::string_view(
+        buff.peek() + httprq_header_len,
+        httprq_content_len));
+    // 取走整个请求，其后的数据属于下一个请求
+    buff.retrieve(httprq_header_len + httprq_content_len);
+    if (!bodyok) {
+        httprq_keepalive = false;
+        return HTTP_CODE::BAD_REQUEST;
     }
 
     // 记录请求行信息到日志
@@ -81,7 +93,25 @@ bool HttpRequest::parse(Buffer& buff) {
         httprq_method.c_str(),
         httprq_path.c_str(),
         httprq_version.c_str());
-    return true;
+    return HTTP_CODE::GET_REQUEST;
+}
+
+// 获取当前解析状态
+HttpRequest::PARSE_STATE HttpRequest::state() const {
+    return httprq_state;
+}
+
+// 读缓冲区开头属于当前请求的最大字节数
+size_t HttpRequest::wantedBytes(const Limits& limits) const {
+    if (httprq_state == PARSE_STATE::BODY) {
+        return httprq_header_len + httprq_content_len;
+    }
+    return limits.header_bytes + 1;
+}
+
+// 获取请求错误时应答的状态码
+int HttpRequest::errorStatus() const {
+    return httprq_error;
 }
 
 // 获取路径的常量版本
@@ -104,46 +134,175 @@ std::string HttpRequest::version() const {
     return httprq_version;
 }
 
-// 根据string类型的键获取POST数据
-std::string HttpRequest::getPost(const std::string& key) const {
-    // 确保键不为空
-    assert(key != "");
-    // 查找并返回对应的值，如果不存在则返回空字符串
-    if (httprq_post.count(key) == 1) {
-        return httprq_post.find(key)->second;
+// 按枚举值获取常用请求头的值
+std::string_view HttpRequest::getHeader(HttpParser::HEADER id) const {
+    if (id == HttpParser::HEADER::OTHER) {
+        return {};
+    }
+    unsigned short index = httprq_known[static_cast<size_t>(id)];
+    if (index == NO_HEADER) {
+        return {};
+    }
+    const HeaderField& field = httprq_header[index];
+    return httprq_raw.substr(field.value_off, field.value_len);
+}
+
+// 按名称（忽略大小写）获取请求头的值：常用请求头转为按枚举值查找，
+// 其他请求头逐个比较名称
+std::string_view HttpRequest::getHeader(std::string_view name) const {
+    HttpParser::HEADER id = HttpParser::headerId(name);
+    if (id != HttpParser::HEADER::OTHER) {
+        return getHeader(id);
     }
-    return "";
+    for (const HeaderField& field : httprq_header) {
+        if (field.id == HttpParser::HEADER::OTHER
+            && HttpParser::equalsIgnoreCase(
+                httprq_raw.substr(field.name_off, field.name_len),
+                name)) {
+            return httprq_raw.substr(field.value_off, field.value_len);
+        }
+    }
+    return {};
 }
 
-// 根据const char*类型的键获取POST数据
-std::string HttpRequest::getPost(const char* key) const {
-    // 确保键不为空
-    assert(key != nullptr);
-    // 转换为string类型并调用对应的重载函数
-    return getPost(std::string(key));
+// 获取请求头的个数
+size_t HttpRequest::headerCount() const {
+    return httprq_header.size();
+}
+
+// 获取第index个请求头的名称
+std::string_view HttpRequest::headerName(size_t index) const {
+    const HeaderField& field = httprq_header[index];
+    return httprq_raw.substr(field.name_off, field.name_len);
+}
+
+// 获取第index个请求头的值
+std::string_view HttpRequest::headerValue(size_t index) const {
+    const HeaderField& field = httprq_header[index];
+    return httprq_raw.substr(field.value_off, field.value_len);
+}
+
+// 获取POST表单字段的值，同名字段取第一个
+std::string_view HttpRequest::getPost(std::string_view key) const {
+    for (const FormField& field : httprq_post) {
+        if (field.name == key) {
+            return field.value;
+        }
+    }
+    return {};
+}
+
+// 获取POST表单的所有字段
+const std::vector<FormField>& HttpRequest::formFields() const {
+    return httprq_post;
 }
 
 // 判断是否为长连接
 bool HttpRequest::isKeepAlive() const {
-    // 检查Connection头是否存在
-    if (httprq_header.count("Connection") == 1) {
-        // HTTP/1.1且Connection为keep-alive时返回true
-        return httprq_header.find("Connection")->second == "keep-alive"
-               && httprq_version == "1.1";
+    return httprq_keepalive;
+}
+
+// 执行登录/注册验证，并根据结果改写请求路径
+bool HttpRequest::verify(bool islogin) {
+    // 验证用户信息
+    int ret = userVerify(
+        std::string(getPost("username")),
+        std::string(getPost("password")),
+        islogin);
+    if (ret < 0) {
+        // 数据库不可用，保持原路径，由调用方返回503
+        return false;
     }
-    return false;
+    if (ret > 0) {
+        // 验证成功，重定向到欢迎页面
+        httprq_path = "/welcome.html";
+    } else {
+        // 验证失败，重定向到错误页面
+        httprq_path = "/error.html";
+    }
+    return true;
+}
+
+// 请求头还没收完时检查上限：已收到的数据超出请求头块的上限，
+// 或者请求行的上限之内还没有出现CRLF。只检查有限长度，逐字节发送时开销固定
+bool HttpRequest::checkPartialHeader(const Buffer& buff, const Limits& limits) {
+    size_t readable = buff.readableBytes();
+    if (readable > limits.header_bytes) {
+        LOG_WARN("HttpRequest.cpp: 215     Header too large");
+        httprq_error = 431;
+        return false;
+    }
+    if (readable >= limits.request_line + 2
+        && !ByteScan::findCRLF(
+            buff.peek(),
+            buff.peek() + limits.request_line + 2)) {
+        LOG_WARN("HttpRequest.cpp: 222     RequestLine too long");
+        httprq_error = 414;
+        return false;
+    }
+    return true;
+}
+
+// 解析请求头块：第一行是请求行，其余每行一个请求头
+bool HttpRequest::parseHeaderBlock(
+    std::string_view block, const Limits& limits) {
+    httprq_raw = block;
+    // 请求头块连同结束空行的长度
+    if (block.size() + 4 > limits.header_bytes) {
+        LOG_WARN("HttpRequest.cpp: 233     Header too large");
+        httprq_error = 431;
+        return false;
+    }
+    size_t lineend = block.find("\r\n");
+    if (std::min(lineend, block.size()) > limits.request_line) {
+        LOG_WARN("HttpRequest.cpp: 238     RequestLine too long");
+        httprq_error = 414;
+        return false;
+    }
+    if (!parseRequestLine(block.substr(0, lineend))) {
+        return false;
+    }
+    // 请求头的下标以unsigned short保存，个数不能达到NO_HEADER
+    size_t maxcount =
+        std::min(limits.header_count, static_cast<size_t>(NO_HEADER));
+    while (lineend != std::string_view::npos) {
+        if (httprq_header.size() >= maxcount) {
+            LOG_WARN("HttpRequest.cpp: 250     Too many headers");
+            httprq_error = 431;
+            return false;
+        }
+        size_t start = lineend + 2;
+        lineend = block.find("\r\n", start);
+        std::string_view line = block.substr(
+            start,
+            lineend == std::string_view::npos ? lineend : lineend - start);
+        if (!parseHeader(line)) {
+            return false;
+        }
+    }
+    // 请求体过大时不必等它到达
+    if (httprq_content_len > limits.body_bytes) {
+        LOG_WARN(
+            "HttpRequest.cpp: 265     Body too large: %zu",
+            httprq_content_len);
+        httprq_error = 413;
+        return false;
+    }
+    // 请求头结束，开始接收请求体
+    httprq_state = PARSE_STATE::BODY;
+    return true;
 }
 
 // 解析请求行
-bool HttpRequest::parseRequestLine(const std::string& line) {
-    // 使用正则表达式匹配请求行格式：METHOD PATH HTTP/VERSION
-    std::regex patten("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
-    std::smatch submatch;
-    if (std::regex_match(line, submatch, patten)) {
-        // 提取请求方法、路径和HTTP版本
-        httprq_method = submatch[1];
-        httprq_path = submatch[2];
-        httprq_version = submatch[3];
+bool HttpRequest::parseRequestLine(std::string_view line) {
+    HttpParser::RequestLine result;
+    if (HttpParser::parseRequestLine(line, result)) {
+        // 请求方法和版本很短，拷贝不会申请堆内存；路径之后可能被改写
+        httprq_method.assign(result.method);
+        httprq_path.assign(result.target);
+        httprq_version.assign(result.version);
+        // HTTP/1.1默认为长连接，HTTP/1.0默认不是，可由Connection请求头改变
+        httprq_keepalive = httprq_version == "1.1";
         // 更新解析状态为请求头
         httprq_state = PARSE_STATE::HEADERS;
         return true;
@@ -154,144 +313,134 @@ bool HttpRequest::parseRequestLine(const std::string& line) {
 }
 
 // 解析请求头
-void HttpRequest::parseHeader(const std::string& line) {
-    // 使用正则表达式匹配请求头格式：Key: Value
-    std::regex patten("^([^:]*): ?(.*)$");
-    std::smatch submatch;
-    if (std::regex_match(line, submatch, patten)) {
-        // 将键值对存入请求头映射
-        httprq_header[submatch[1]] = submatch[2];
-    } else {
-        // 遇到空行，表示请求头结束，开始解析请求体
-        httprq_state = PARSE_STATE::BODY;
+bool HttpRequest::parseHeader(std::string_view line) {
+    std::string_view name, value;
+    if (!HttpParser::parseHeaderLine(line, name, value)) {
+        LOG_ERROR("HttpRequest.cpp: 140     Header Error");
+        return false;
+    }
+    // 名称只在这里识别一次，之后按枚举值查找
+    HttpParser::HEADER id = HttpParser::headerId(name);
+    // 常用请求头重复出现时，按枚举值查到的是第一个
+    std::string_view prev;
+    if (id != HttpParser::HEADER::OTHER) {
+        prev = getHeader(id);
+        if (httprq_known[static_cast<size_t>(id)] == NO_HEADER) {
+            httprq_known[static_cast<size_t>(id)] =
+                static_cast<unsigned short>(httprq_header.size());
+        }
+    }
+    httprq_header.push_back(HeaderField{
+        id,
+        static_cast<uint32_t>(name.data() - httprq_raw.data()),
+        static_cast<uint32_t>(name.size()),
+        static_cast<uint32_t>(value.data() - httprq_raw.data()),
+        static_cast<uint32_t>(value.size())});
+
+    // 之后还要用到的请求头在这里解析出结果，
+    // 请求体到达时缓冲区可能已经移动，不再回头查找请求头
+    switch (id) {
+    case HttpParser::HEADER::CONNECTION:
+        // 带close时不是长连接；HTTP/1.0带keep-alive时也是长连接
+        if (HttpParser::hasToken(value, "close")) {
+            httprq_keepalive = false;
+        } else if (HttpParser::hasToken(value, "keep-alive")) {
+            httprq_keepalive = true;
+        }
+        break;
+    case HttpParser::HEADER::CONTENT_LENGTH: {
+        // 长度必须全部是数字，重复出现时必须一致
+        size_t len = 0;
+        std::from_chars_result ret =
+            std::from_chars(value.data(), value.data() + value.size(), len);
+        if (value.empty() || ret.ec != std::errc()
+            || ret.ptr != value.data() + value.size()
+            || (!prev.empty() && prev != value)) {
+            LOG_ERROR("HttpRequest.cpp: 150     Content-Length Error");
+            return false;
+        }
+        httprq_content_len = len;
+        break;
+    }
+    case HttpParser::HEADER::CONTENT_TYPE:
+        httprq_form = FormParser::typeOf(value);
+        if (httprq_form == FormParser::TYPE::MULTIPART
+            && FormParser::boundary(value).empty()) {
+            LOG_ERROR("HttpRequest.cpp: 155     multipart boundary Error");
+            return false;
+        }
+        break;
+    case HttpParser::HEADER::TRANSFER_ENCODING:
+        // 不支持分块传输，无法确定请求体的边界
+        LOG_ERROR("HttpRequest.cpp: 160     Transfer-Encoding unsupported");
+        return false;
+    default:
+        break;
     }
+    return true;
 }
 
 // 解析请求体
-void HttpRequest::parseBody(const std::string& line) {
+bool HttpRequest::parseBody(std::string_view body) {
     // 保存请求体内容
-    httprq_body = line;
-    // 解析POST数据
-    parsePost();
+    httprq_body.assign(body);
     // 更新解析状态为完成
     httprq_state = PARSE_STATE::FINISH;
     // 记录请求体信息到日志
     LOG_DEBUG(
         "HttpRequest.cpp: 143     Body:%s, len:%d",
-        line.c_str(),
-        line.size());
+        httprq_body.c_str(),
+        httprq_body.size());
+    // 解析POST数据
+    return parsePost();
 }
 
-// 解析路径
-void HttpRequest::parsePath() {
-    // 处理根路径，默认为index.html
-    if (httprq_path == "/") {
-        httprq_path = "/index.html";
-    } else {
-        // 检查是否为预定义路径，如果是则添加.html后缀
-        for (const auto& item : DEFAULT_HTML) {
-            if (item == httprq_path) {
-                httprq_path += ".html";
-                break;
-            }
-        }
+// 解析POST请求的表单，字段都指向httprq_body。URL编码的表单原地解码，
+// 解码后的字段之间留有空隙，httprq_body不能再改变长度
+bool HttpRequest::parsePost() {
+    if (httprq_method != "POST") {
+        return true;
     }
-}
-
-// 解析POST请求
-void HttpRequest::parsePost() {
-    // 检查是否为POST请求且内容类型为表单数据
-    if (httprq_method == "POST"
-        && httprq_header["Content-Type"]
-               == "application/x-www-form-urlencoded") {
-        // 解析URL编码的表单数据
-        parseFromUrlEncoded();
-        // 处理登录和注册请求
-        if (DEFAULT_HTML_TAG.count(httprq_path) != 0) {
-            int tag = DEFAULT_HTML_TAG.find(httprq_path)->second;
-            LOG_DEBUG("HttpRequest.cpp: 168     Tag:%d", tag);
-            // 0表示注册，1表示登录
-            if (tag == 0 || tag == 1) {
-                bool isLogin = (tag == 1);
-                // 验证用户信息
-                if (userVerify(
-                        httprq_post["username"],
-                        httprq_post["password"],
-                        isLogin)) {
-                    // 验证成功，重定向到欢迎页面
-                    httprq_path = "/welcome.html";
-                } else {
-                    // 验证失败，重定向到错误页面
-                    httprq_path = "/error.html";
-                }
-            }
-        }
-    }
-}
-
-// 解析URL编码的数据
-void HttpRequest::parseFromUrlEncoded() {
-    // 请求体为空则直接返回
-    if (httprq_body.size() == 0) {
-        return;
-    }
-
-    std::string key, value;
-    int num = 0;
-    int n = httprq_body.size();
-    int i = 0, j = 0;
-
-    // 逐字符解析URL编码的表单数据
-    for (; i < n; i++) {
-        char ch = httprq_body[i];
-        switch (ch) {
-        case '=':
-            // 遇到等号，提取键名
-            key = httprq_body.substr(j, i - j);
-            j = i + 1;
-            break;
-        case '+':
-            // 将加号转换为空格
-            httprq_body[i] = ' ';
-            break;
-        case '%':
-            // 处理百分号编码（如%20表示空格）
-            num = converHex(httprq_body[i + 1]) * 16
-                  + converHex(httprq_body[i + 2]);
-            httprq_body[i] = static_cast<char>(num);
-            // 删除后续两个字符（十六进制编码）
-            httprq_body.erase(i + 1, 2);
-            break;
-        case '&':
-            // 遇到&符号，提取键值并存入映射
-            value = httprq_body.substr(j, i - j);
-            j = i + 1;
-            httprq_post[key] = value;
-            // 记录键值对到日志
-            LOG_DEBUG(
-                "HttpRequest.cpp: 210     %s = %s",
-                key.c_str(),
-                value.c_str());
-            break;
-        default:
-            break;
+    switch (httprq_form) {
+    case FormParser::TYPE::URLENCODED:
+        FormParser::parseUrlEncoded(
+            httprq_body.data(),
+            httprq_body.size(),
+            httprq_post);
+        break;
+    case FormParser::TYPE::MULTIPART:
+        // 请求头块还在读缓冲区中，httprq_raw已经指向它的当前位置
+        if (!FormParser::parseMultipart(
+                httprq_body,
+                FormParser::boundary(
+                    getHeader(HttpParser::HEADER::CONTENT_TYPE)),
+                httprq_post)) {
+            LOG_ERROR("HttpRequest.cpp: 175     multipart body Error");
+            return false;
         }
+        break;
+    default:
+        return true;
     }
-
-    // 处理最后一个键值对（没有&结尾的情况）
-    assert(j <= i);
-    if (httprq_post.count(key) == 0 && j < i) {
-        value = httprq_body.substr(j, i - j);
-        httprq_post[key] = value;
+    for (const FormField& field : httprq_post) {
+        LOG_DEBUG(
+            "HttpRequest.cpp: 210     %.*s = %.*s",
+            static_cast<int>(field.name.size()),
+            field.name.data(),
+            static_cast<int>(field.filename.empty() ? field.value.size()
+                                                    : field.filename.size()),
+            field.filename.empty() ? field.value.data()
+                                   : field.filename.data());
     }
+    return true;
 }
 
 // 用户验证
-bool HttpRequest::userVerify(
+int HttpRequest::userVerify(
     const std::string& name, const std::string& pwd, bool isLogin) {
     // 检查用户名和密码是否为空
     if (name == "" || pwd == "") {
-        return false;
+        return 0;
     }
 
     // 记录验证信息到日志
@@ -300,10 +449,13 @@ bool HttpRequest::userVerify(
         name.c_str(),
         pwd.c_str());
 
-    // 获取数据库连接
+    // 获取数据库连接，等待超时说明数据库过于繁忙
     MYSQL* sql;
     SqlConnRAII sqlConn(&sql, &SqlConnPool::instance());
-    assert(sql);
+    if (!sql) {
+        LOG_WARN("HttpRequest.cpp: 240     No sql connection available!");
+        return -1;
+    }
 
     bool flag = false;
     unsigned int j = 0;
@@ -327,7 +479,7 @@ bool HttpRequest::userVerify(
     // 执行SQL查询
     if (mysql_query(sql, order)) {
         mysql_free_result(res);
-        return false;
+        return 0;
     }
 
     // 获取查询结果
@@ -377,22 +529,7 @@ bool HttpRequest::userVerify(
         flag = true;
     }
 
-    // 释放数据库连接
-    SqlConnPool::instance().freeConn(sql);
+    // 数据库连接由sqlConn析构时归还，不能再手动释放，否则同一连接会入队两次
     LOG_DEBUG("HttpRequest.cpp: 286     UserVerify success!!");
-    return flag;
+    return flag ? 1 : 0;
 }
-
-// 转换十六进制字符
-int HttpRequest::converHex(char ch) {
-    // 处理大写十六进制字符（A-F）
-    if (ch >= 'A' && ch <= 'F') {
-        return ch - 'A' + 10;
-    }
-    // 处理小写十六进制字符（a-f）
-    if (ch >= 'a' && ch <= 'f') {
-        return ch - 'a' + 10;
-    }
-    // 处理数字字符（0-9）
-    return ch - '0';
-}
\ No newline at end of file
@@ -1,10 +1,15 @@
 #pragma once
 
 #include "../buffer/Buffer.hpp"
+#include "FormParser.hpp"
+#include "HttpParser.hpp"
+#include <array>
+#include <cstdint>
 #include <cstring>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 class HttpRequest {
   public:
@@ -22,13 +27,35 @@ class HttpRequest {
         CLOSED_CONNECTION
     };
 
+    // 请求大小的上限，超出时parse()返回BAD_REQUEST，
+    // errorStatus()给出对应的响应状态码
+    struct Limits {
+        size_t request_line = 8 * 1024;      // 请求行最大长度，超出返回414
+        size_t header_count = 100;           // 请求头最多个数，超出返回431
+        size_t header_bytes = 32 * 1024;     // 请求头块最大长度，超出返回431
+        size_t body_bytes = 8 * 1024 * 1024; // 请求体最大长度，超出返回413
+    };
+
     HttpRequest();
     ~HttpRequest() = default;
 
     // 初始化HTTP请求
     void initHttprq();
-    // 解析HTTP请求
-    bool parse(Buffer& buff);
+    // 解析读缓冲区中的请求，数据可以分多次到达：
+    // 请求不完整时返回NO_REQUEST并保留解析进度，下次调用从中断处继续；
+    // 收到完整请求时返回GET_REQUEST并将其从缓冲区取走；格式错误返回
+    // BAD_REQUEST。返回后者两种结果后再次调用开始解析下一个请求。
+    // 请求头还没收完就超出limits时立即返回BAD_REQUEST，不再等待剩余数据；
+    // Content-Length超出上限时在收到请求体之前返回
+    HTTP_CODE parse(Buffer& buff, const Limits& limits);
+    // 当前解析状态，请求头收完、请求体还没收完时为BODY
+    PARSE_STATE state() const;
+    // 读缓冲区开头最多有多少字节属于当前请求：请求头已收完时为整个请求的
+    // 长度，否则为请求头块的上限多一个字节，多出的字节让parse()发现超限
+    size_t wantedBytes(const Limits& limits) const;
+    // parse()返回BAD_REQUEST时应答的状态码：格式错误为400，
+    // 超出大小上限为413、414或431
+    int errorStatus() const;
     // 获取请求路径(常量版本)
     const std::string& path() const;
     // 获取请求路径(非常量版本)
@@ -37,42 +64,75 @@ class HttpRequest {
     std::string method() const;
     // 获取HTTP版本
     std::string version() const;
-    // 获取POST请求参数(string版本)
-    std::string getPost(const std::string& key) const;
-    // 获取POST请求参数(char*版本)
-    std::string getPost(const char* key) const;
-    // 判断是否为长连接
+    // 按名称（忽略大小写）获取请求头的值，不存在时返回空。
+    // 返回值指向读缓冲区，只在parse()返回GET_REQUEST之后、
+    // 读缓冲区再次写入之前有效
+    std::string_view getHeader(std::string_view name) const;
+    // 按枚举值获取常用请求头的值，有效期同上
+    std::string_view getHeader(HttpParser::HEADER id) const;
+    // 请求头的个数，与下面两个函数一起按出现顺序遍历所有请求头，有效期同上
+    size_t headerCount() const;
+    // 第index个请求头的名称
+    std::string_view headerName(size_t index) const;
+    // 第index个请求头的值
+    std::string_view headerValue(size_t index) const;
+    // 获取POST表单中第一个名为key的字段的值，不存在时返回空。
+    // 返回值指向请求体，在开始解析下一个请求之前有效
+    std::string_view getPost(std::string_view key) const;
+    // 获取POST表单的所有字段，包括multipart上传的文件，有效期同上
+    const std::vector<FormField>& formFields() const;
+    // 判断是否为长连接：HTTP/1.1默认是，Connection中有close时不是；
+    // HTTP/1.0只有Connection中有keep-alive时才是
     bool isKeepAlive() const;
+    // 用表单中的用户名和密码执行登录（islogin为真）或注册验证，
+    // 并根据结果改写请求路径。会访问数据库，只能在允许阻塞的线程中调用，
+    // 返回false表示数据库不可用（在等待时间内没有取到连接）
+    bool verify(bool islogin);
 
   private:
+    // httprq_known中表示没有该请求头的值
+    static constexpr unsigned short NO_HEADER = 0xFFFF;
+
+    // 请求头在请求头块中的位置。请求完整之前请求头块一直留在读缓冲区中，
+    // 缓冲区扩容移动数据后只需更新请求头块的起始地址
+    struct HeaderField {
+        HttpParser::HEADER id; // 解析时识别出的名称
+        uint32_t name_off;     // 名称的偏移
+        uint32_t name_len;     // 名称的长度
+        uint32_t value_off;    // 值的偏移
+        uint32_t value_len;    // 值的长度
+    };
+
+    // 解析不含结束空行的请求头块：请求行和所有请求头，并检查大小上限
+    bool parseHeaderBlock(std::string_view block, const Limits& limits);
+    // 请求头还没收完时检查已收到的部分是否已经超出上限
+    bool checkPartialHeader(const Buffer& buff, const Limits& limits);
     // 解析请求行
-    bool parseRequestLine(const std::string& line);
-    // 解析请求头
-    void parseHeader(const std::string& line);
-    // 解析请求体
-    void parseBody(const std::string& line);
-    // 解析请求路径
-    void parsePath();
-    // 解析POST请求
-    void parsePost();
-    // 解析URL编码的数据
-    void parseFromUrlEncoded();
-    // 用户验证
-    static bool
+    bool parseRequestLine(std::string_view line);
+    // 解析一行请求头，格式错误时返回false
+    bool parseHeader(std::string_view line);
+    // 解析请求体，表单格式错误时返回false
+    bool parseBody(std::string_view body);
+    // 解析POST请求的表单，格式错误时返回false
+    bool parsePost();
+    // 用户验证，返回1表示通过，0表示未通过，-1表示数据库不可用
+    static int
     userVerify(const std::string& name, const std::string& pwd, bool islogin);
-    // 转换十六进制字符
-    static int converHex(char ch);
 
     PARSE_STATE httprq_state;   // 当前解析状态
     std::string httprq_method;  // 请求方法
     std::string httprq_path;    // 请求路径
     std::string httprq_version; // HTTP版本
     std::string httprq_body;    // 请求体
-    std::unordered_map<std::string, std::string> httprq_header; // 请求头
-    std::unordered_map<std::string, std::string> httprq_post; // POST请求参数
-
-    static const std::unordered_set<std::string>
-        DEFAULT_HTML; // 默认HTML页面集合
-    static const std::unordered_map<std::string, int>
-        DEFAULT_HTML_TAG; // HTML页面标签映射
+    bool httprq_keepalive;      // 是否为长连接，解析请求头时确定
+    int httprq_error;           // 请求错误时应答的状态码
+    size_t httprq_scanned;      // 已查找过请求头结束标志的字节数
+    size_t httprq_header_len;   // 请求头块连同结束空行的长度
+    size_t httprq_content_len;  // 请求体长度（Content-Length）
+    FormParser::TYPE httprq_form;           // 请求体的表单格式
+    std::string_view httprq_raw;            // 请求头块，指向读缓冲区
+    std::vector<HeaderField> httprq_header; // 请求头，不拷贝
+    // 各常用请求头第一次出现时在httprq_header中的下标
+    std::array<unsigned short, HttpParser::HEADER_COUNT> httprq_known;
+    std::vector<FormField> httprq_post; // POST表单字段，指向httprq_body
 };
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include "HttpRequest.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+using HTTP_CODE = HttpRequest::HTTP_CODE;
+
+// 带请求体的表单请求
+const std::string POST_REQUEST =
+    "POST /echo HTTP/1.1\r\n"
+    "Host: localhost\r\n"
+    "Content-Type: application/x-www-form-urlencoded\r\n"
+    "Content-Length: 13\r\n"
+    "X-Trace: abc\r\n"
+    "\r\n"
+    "a=hello&b=xyz";
+
+// 检查POST_REQUEST解析出的各部分
+void expectPostRequest(const HttpRequest& request) {
+    EXPECT_EQ(request.method(), "POST");
+    EXPECT_EQ(request.path(), "/echo");
+    EXPECT_EQ(request.version(), "1.1");
+    EXPECT_EQ(request.getHeader("host"), "localhost");
+    EXPECT_EQ(request.getHeader("X-Trace"), "abc");
+    EXPECT_EQ(request.getPost("a"), "hello");
+    EXPECT_EQ(request.getPost("b"), "xyz");
+}
+
+} // namespace
+
+/**
+ * 测试请求逐字节到达：收完之前都返回NO_REQUEST，最后一个字节到达时解析完成
+ */
+TEST(HttpRequestTest, ByteByByteRequestShouldParse) {
+    HttpRequest::Limits limits;
+    HttpRequest request;
+    Buffer buff;
+    for (size_t i = 0; i + 1 < POST_REQUEST.size(); i++) {
+        buff.append(POST_REQUEST.data() + i, 1);
+        ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::NO_REQUEST) << i;
+    }
+    buff.append(POST_REQUEST.data() + POST_REQUEST.size() - 1, 1);
+    ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::GET_REQUEST);
+    expectPostRequest(request);
+    EXPECT_EQ(buff.readableBytes(), 0u);
+}
+
+/**
+ * 测试请求头结束标志"\r\n\r\n"被拆在两次读取之间的每一个位置
+ */
+TEST(HttpRequestTest, SplitInsideHeaderEndShouldParse) {
+    HttpRequest::Limits limits;
+    size_t headerend = POST_REQUEST.find("\r\n\r\n");
+    for (size_t split = headerend; split <= headerend + 4; split++) {
+        SCOPED_TRACE(split);
+        HttpRequest request;
+        Buffer buff;
+        buff.append(POST_REQUEST.data(), split);
+        ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::NO_REQUEST);
+        buff.append(POST_REQUEST.data() + split, POST_REQUEST.size() - split);
+        ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::GET_REQUEST);
+        expectPostRequest(request);
+    }
+}
+
+/**
+ * 测试请求体分多次到达：请求头收完后进入BODY状态，收齐Content-Length后完成
+ */
+TEST(HttpRequestTest, BodySplitAcrossReadsShouldWait) {
+    HttpRequest::Limits limits;
+    HttpRequest request;
+    Buffer buff;
+    size_t bodystart = POST_REQUEST.find("\r\n\r\n") + 4;
+    buff.append(POST_REQUEST.data(), bodystart + 3);
+    ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::NO_REQUEST);
+    EXPECT_EQ(request.state(), HttpRequest::PARSE_STATE::BODY);
+    buff.append(POST_REQUEST.data() + bodystart + 3, 5);
+    ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::NO_REQUEST);
+    EXPECT_EQ(request.state(), HttpRequest::PARSE_STATE::BODY);
+    // 最后一段和下一个请求的开头一起到达
+    buff.append(POST_REQUEST.data() + bodystart + 8, 5);
+    buff.append("GET / HTTP/1.1\r\n");
+    ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::GET_REQUEST);
+    expectPostRequest(request);
+    EXPECT_EQ(buff.retrieveAllToStr(), "GET / HTTP/1.1\r\n");
+}
+
+/**
+ * 测试请求头收完、请求体到达时缓冲区扩容换了内存块，请求头仍然有效
+ */
+TEST(HttpRequestTest, HeadersShouldSurviveBufferGrowth) {
+    HttpRequest::Limits limits;
+    HttpRequest request;
+    Buffer buff(1024);
+    std::string body = "a=" + std::string(100000, 'x');
+    std::string head =
+        "POST /echo HTTP/1.1\r\nHost: localhost\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    buff.append(head);
+    ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::NO_REQUEST);
+    const char* before = buff.peek();
+    buff.append(body);
+    ASSERT_NE(buff.peek(), before);
+    ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::GET_REQUEST);
+    EXPECT_EQ(request.getHeader("Host"), "localhost");
+    EXPECT_EQ(request.getHeader(HttpParser::HEADER::CONTENT_LENGTH), "100002");
+    ASSERT_EQ(request.headerCount(), 3u);
+    EXPECT_EQ(request.headerName(0), "Host");
+    EXPECT_EQ(request.headerValue(2), "100002");
+    EXPECT_EQ(request.getPost("a").size(), 100000u);
+}
+
+/**
+ * 测试前一个请求被取走后，缓冲区把未读数据搬到开头腾出空间，请求头仍然有效
+ */
+TEST(HttpRequestTest, HeadersShouldSurviveCompaction) {
+    HttpRequest::Limits limits;
+    HttpRequest request;
+    Buffer buff(1024);
+    size_t capacity = buff.capacity();
+    std::string first = "GET /" + std::string(capacity - 200, 'p')
+                        + " HTTP/1.1\r\nHost: a\r\n\r\n";
+    buff.append(first);
+    ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::GET_REQUEST);
+    std::string head =
+        "POST /echo HTTP/1.1\r\nHost: b\r\nX-Trace: abc\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "Content-Length: 100\r\n\r\n";
+    buff.append(head);
+    ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::NO_REQUEST);
+    const char* before = buff.peek();
+    buff.append("a=" + std::string(98, 'y'));
+    ASSERT_EQ(buff.capacity(), capacity);
+    ASSERT_NE(buff.peek(), before);
+    ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::GET_REQUEST);
+    EXPECT_EQ(request.getHeader("Host"), "b");
+    EXPECT_EQ(request.getHeader("X-Trace"), "abc");
+    EXPECT_EQ(request.getPost("a"), std::string(98, 'y'));
+}
+
+/**
+ * 测试长连接的判断：HTTP/1.1默认保持连接，Connection中有close时不保持；
+ * HTTP/1.0只有带keep-alive时才保持
+ */
+TEST(HttpRequestTest, KeepAliveShouldFollowVersionAndConnection) {
+    HttpRequest::Limits limits;
+    const std::pair<const char*, bool> cases[] = {
+        {"GET / HTTP/1.1\r\n\r\n", true},
+        {"GET / HTTP/1.1\r\nConnection: close\r\n\r\n", false},
+        {"GET / HTTP/1.1\r\nConnection: Upgrade, Close\r\n\r\n", false},
+        {"GET / HTTP/1.1\r\nConnection: keep-alive\r\n\r\n", true},
+        {"GET / HTTP/1.0\r\n\r\n", false},
+        {"GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n", true},
+    };
+    for (const auto& [text, keepalive] : cases) {
+        SCOPED_TRACE(text);
+        HttpRequest request;
+        Buffer buff;
+        buff.append(std::string(text));
+        ASSERT_EQ(request.parse(buff, limits), HTTP_CODE::GET_REQUEST);
+        EXPECT_EQ(request.isKeepAlive(), keepalive);
+    }
+}
+
+/**
+ * 测试请求行长度上限：恰好等于上限时正常解析，多一个字节返回414；
+ * 请求行还没收完就已超出时不再等待
+ */
+TEST(HttpRequestTest, RequestLineLimitShouldBeExact) {
+    HttpRequest::Limits limits;
+    limits.request_line = 100;
+    std::string prefix = "GET /";
+    std::string suffix = " HTTP/1.1";
+    std::string line =
+        prefix + std::string(100 - prefix.size() - suffix.size(), 'a') + suffix;
+    ASSERT_EQ(line.size(), 100u);
+    {
+        HttpRequest request;
+        Buffer buff;
+        buff.append(line + "\r\n\r\n");
+        EXPECT_EQ(request.parse(buff, limits), HTTP_CODE::GET_REQUEST);
+    }
+    std::string longer = prefix + "b" + line.substr(prefix.size());
+    {
+        HttpRequest request;
+        Buffer buff;
+        buff.append(longer + "\r\n\r\n");
+        EXPECT_EQ(request.parse(buff, limits), HTTP_CODE::BAD_REQUEST);
+        EXPECT_EQ(request.errorStatus(), 414);
+    }
+    {
+        // 上限加CRLF之内还可能收到CRLF，继续等待；超出后立即拒绝
+        HttpRequest request;
+        Buffer buff;
+        buff.append(line + "\r");
+        EXPECT_EQ(request.parse(buff, limits), HTTP_CODE::NO_REQUEST);
+        HttpRequest partial;
+        Buffer over;
+        over.append(longer + "\r");
+        EXPECT_EQ(partial.parse(over, limits), HTTP_CODE::BAD_REQUEST);
+        EXPECT_EQ(partial.errorStatus(), 414);
+    }
+}
+
+/**
+ * 测试请求头个数上限：恰好等于上限时正常解析，多一个返回431
+ */
+TEST(HttpRequestTest, HeaderCountLimitShouldBeExact) {
+    HttpRequest::Limits limits;
+    limits.header_count = 3;
+    std::string request3 = "GET / HTTP/1.1\r\nA: 1\r\nB: 2\r\nC: 3\r\n\r\n";
+    std::string request4 =
+        "GET / HTTP/1.1\r\nA: 1\r\nB: 2\r\nC: 3\r\nD: 4\r\n\r\n";
+    HttpRequest request;
+    Buffer buff;
+    buff.append(request3);
+    EXPECT_EQ(request.parse(buff, limits), HTTP_CODE::GET_REQUEST);
+    EXPECT_EQ(request.headerCount(), 3u);
+    buff.append(request4);
+    EXPECT_EQ(request.parse(buff, limits), HTTP_CODE::BAD_REQUEST);
+    EXPECT_EQ(request.errorStatus(), 431);
+}
+
+/**
+ * 测试请求头块长度上限（含请求行和结束空行）：恰好等于上限时正常解析，
+ * 多一个字节返回431；还没收完就已超出时不再等待
+ */
+TEST(HttpRequestTest, HeaderBytesLimitShouldBeExact) {
+    HttpRequest::Limits limits;
+    limits.header_bytes = 200;
+    // 请求头块为"GET / HTTP/1.1\r\nX-Pad: "、填充和"\r\n\r\n"
+    auto makeRequest = [](size_t total) {
+        return "GET / HTTP/1.1\r\nX-Pad: " + std::string(total - 27, 'p')
+               + "\r\n\r\n";
+    };
+    ASSERT_EQ(makeRequest(200).size(), 200u);
+    {
+        HttpRequest request;
+        Buffer buff;
+        buff.append(makeRequest(200));
+        EXPECT_EQ(request.parse(buff, limits), HTTP_CODE::GET_REQUEST);
+    }
+    {
+        HttpRequest request;
+        Buffer buff;
+        buff.append(makeRequest(201));
+        EXPECT_EQ(request.parse(buff, limits), HTTP_CODE::BAD_REQUEST);
+        EXPECT_EQ(request.errorStatus(), 431);
+    }
+    {
+        // 去掉结束空行：200字节时可能还在上限之内，201字节时已经超出
+        std::string partial = makeRequest(204).substr(0, 200);
+        HttpRequest request;
+        Buffer buff;
+        buff.append(partial);
+        EXPECT_EQ(request.parse(buff, limits), HTTP_CODE::NO_REQUEST);
+        buff.append("p");
+        EXPECT_EQ(request.parse(buff, limits), HTTP_CODE::BAD_REQUEST);
+        EXPECT_EQ(request.errorStatus(), 431);
+    }
+}
+
+/**
+ * 测试请求体长度上限：恰好等于上限时正常解析，Content-Length多一个字节时
+ * 收完请求头就返回413，不等待请求体
+ */
+TEST(HttpRequestTest, BodyLimitShouldRejectEarly) {
+    HttpRequest::Limits limits;
+    limits.body_bytes = 10;
+    HttpRequest request;
+    Buffer buff;
+    buff.append("POST / HTTP/1.1\r\nContent-Length: 10\r\n\r\n0123456789");
+    EXPECT_EQ(request.parse(buff, limits), HTTP_CODE::GET_REQUEST);
+    buff.append("POST / HTTP/1.1\r\nContent-Length: 11\r\n\r\n");
+    EXPECT_EQ(request.parse(buff, limits), HTTP_CODE::BAD_REQUEST);
+    EXPECT_EQ(request.errorStatus(), 413);
+}
@@ -1,75 +1,77 @@
 // httpresponse.cpp
 #include "HttpResponse.hpp"
 #include "../log/Log.hpp"
+#include "MimeTable.hpp"
+#include "PerfectHash.hpp"
 
-// 文件后缀到MIME类型的映射
-const std::unordered_map<std::string, std::string> HttpResponse::SUFFIX_TYPE = {
-    {".html", "text/html"},
-    {".xml", "text/xml"},
-    {".xhtml", "application/xhtml+xml"},
-    {".txt", "text/plain"},
-    {".rtf", "application/rtf"},
-    {".pdf", "application/pdf"},
-    {".word", "application/nsword"},
-    {".png", "image/png"},
-    {".gif", "image/gif"},
-    {".jpg", "image/jpeg"},
-    {".jpeg", "image/jpeg"},
-    {".au", "audio/basic"},
-    {".mpeg", "video/mpeg"},
-    {".mpg", "video/mpeg"},
-    {".avi", "video/x-msvideo"},
-    {".gz", "application/x-gzip"},
-    {".tar", "application/x-tar"},
-    {".css", "text/css "},
-    {".js", "text/javascript "},
-    {".ico", "image/x - icon"}};
-
-// 状态码到状态描述的映射
-const std::unordered_map<int, std::string> HttpResponse::CODE_STATUS = {
-    {200, "OK"},
-    {400, "Bad Request"},
-    {403, "Forbidden"},
-    {404, "Not Found"},
-};
+namespace {
 
-// 状态码到错误页面路径的映射
-const std::unordered_map<int, std::string> HttpResponse::CODE_PATH = {
-    {400, "/400.html"},
-    {403, "/403.html"},
-    {404, "/404.html"},
+// 状态码对应的状态描述和错误页面
+struct StatusInfo {
+    std::string_view text; // 状态描述
+    std::string_view page; // 错误页面路径，为空时错误正文由errorContent生成
 };
 
+// 状态码表
+constexpr auto CODE_STATUS = makePerfectHash<int, StatusInfo>({
+    {200, {"OK", ""}},
+    {400, {"Bad Request", "/400.html"}},
+    {403, {"Forbidden", "/403.html"}},
+    {404, {"Not Found", "/404.html"}},
+    {408, {"Request Timeout", ""}},
+    {413, {"Content Too Large", ""}},
+    {414, {"URI Too Long", ""}},
+    {431, {"Request Header Fields Too Large", ""}},
+    {503, {"Service Unavailable", "/503.html"}},
+});
+static_assert(CODE_STATUS.perfect(), "no perfect hash for status codes");
+
+} // namespace
+
 // 构造函数
 HttpResponse::HttpResponse()
     : http_code(0), is_keepalive(false), http_path(""), http_src_dir(""),
-      http_mmfile(nullptr), http_mmfile_stat({0}) {
-}
-
-// 析构函数
-HttpResponse::~HttpResponse() {
-    unMapfile();
+      http_mmfile_stat({0}), http_content_len(0) {
 }
 
 // 初始化响应参数
 void HttpResponse::res_init(
     const std::string& srcdir, std::string& path, bool iskeepalive, int code) {
     assert(!srcdir.empty());
-    if (http_mmfile) {
-        unMapfile();
-    }
     http_code = code;
     http_path = path;
     http_src_dir = srcdir;
     is_keepalive = iskeepalive;
-    http_mmfile = nullptr;
     http_mmfile_stat = {0};
+    http_content_len = 0;
 }
 
 // 生成完整HTTP响应
-void HttpResponse::makeResponse(Buffer& buff) {
-    // 检查文件状态
-    if (stat((http_src_dir + http_path).data(), &http_mmfile_stat) < 0
+void HttpResponse::makeResponse(ChainBuffer& buff) {
+    // 预留头部空间，先写正文
+    buff.reserveHeadroom(HeaderBuilder::CAPACITY);
+    std::string_view contenttype = makeBody(buff);
+    // 正文长度已知，拼接状态行和响应头后写入预留空间
+    prependHeader(buff, contenttype);
+}
+
+// 生成动态接口的响应
+void HttpResponse::makeResponse(
+    ChainBuffer& buff,
+    std::string_view contenttype,
+    std::string_view body) {
+    buff.reserveHeadroom(HeaderBuilder::CAPACITY);
+    makeBody(buff, body);
+    prependHeader(buff, contenttype);
+}
+
+// 生成响应正文
+std::string_view HttpResponse::makeBody(ChainBuffer& buff) {
+    // 检查文件状态，已经确定的错误状态码（如请求格式错误的400）保持不变
+    if (http_code >= 400) {
+        // 由errorHtmlPath()换成对应的错误页面
+    } else if (
+        stat((http_src_dir + http_path).data(), &http_mmfile_stat) < 0
         || S_ISDIR(http_mmfile_stat.st_mode)) {
         http_code = 404;
     } else if (!(http_mmfile_stat.st_mode & S_IROTH)) {
@@ -78,27 +80,42 @@ void HttpResponse::makeResponse(Buffer& buff) {
         http_code = 200;
     }
 
-    // 处理错误页面
-    errorHtmlPath();
-    // 生成响应行
-    addStateLine(buff);
-    // 生成响应头
-    addHeader(buff);
-    // 生成响应体
+    // 处理错误页面，没有页面的错误（如超时、请求过大）直接生成简短的正文
+    if (!errorHtmlPath()) {
+        errorContent(buff, "");
+        return "text/html";
+    }
     addContent(buff);
+    return getFileType();
+}
+
+// 生成动态接口的正文
+void HttpResponse::makeBody(ChainBuffer& buff, std::string_view body) {
+    if (http_code == -1) {
+        http_code = 200;
+    }
+    buff.append(body.data(), body.size());
+    http_content_len = body.size();
 }
 
-// 解除内存映射
-void HttpResponse::unMapfile() {
-    if (http_mmfile) {
-        munmap(http_mmfile, http_mmfile_stat.st_size);
-        http_mmfile = nullptr;
+// 拼接状态行和响应头
+void HttpResponse::prependHeader(
+    ChainBuffer& buff, std::string_view contenttype) {
+    HeaderBuilder header;
+    addStateLine(header);
+    addHeader(header, contenttype);
+    if (header.overflow()) {
+        // 完整的响应头放在新插入的内存片中，预留的头部空间不再使用
+        LOG_WARN(
+            "HttpResponse.cpp: 95     response header exceeds %d bytes",
+            static_cast<int>(HeaderBuilder::CAPACITY));
     }
+    buff.prepend(header.data(), header.size());
 }
 
-// 获取映射文件指针
-char* HttpResponse::mmapFile() {
-    return http_mmfile;
+// 解除文件映射
+void HttpResponse::unmapFile(char* data, size_t len) {
+    munmap(data, len);
 }
 
 // 获取文件长度
@@ -106,22 +123,28 @@ size_t HttpResponse::fileLen() const {
     return http_mmfile_stat.st_size;
 }
 
-// 生成错误响应内容
-void HttpResponse::errorContent(Buffer& buff, std::string message) {
-    std::string body{""};
-    std::string status{""};
-    body += "<html><title>Error</title>";
-    body += "<body bgcolor=\"ffffff\">";
-    if (CODE_STATUS.count(http_code) == 1) {
-        status = CODE_STATUS.find(http_code)->second;
-    } else {
-        status = "Bad Request";
-    }
-    body += std::to_string(http_code) + " : " + status + "\n";
-    body += "<p>" + message + "</p>";
-    body += "<hr><em>TinyWebServer</em></body></html>";
-    buff.append("Content-length: " + std::to_string(body.size()) + "\r\n\r\n");
-    buff.append(body);
+// 获取正文长度
+size_t HttpResponse::contentLen() const {
+    return http_content_len;
+}
+
+// 生成错误响应内容，正文直接写入buff
+void HttpResponse::errorContent(ChainBuffer& buff, std::string_view message) {
+    const StatusInfo* info = CODE_STATUS.find(http_code);
+    std::string_view status = info ? info->text : "Bad Request";
+    char code[16];
+    std::to_chars_result ret =
+        std::to_chars(code, code + sizeof(code), http_code);
+    size_t before = buff.readableBytes();
+    buff.append("<html><title>Error</title>");
+    buff.append("<body bgcolor=\"ffffff\">");
+    buff.append(code, ret.ptr - code);
+    buff.append(" : ");
+    buff.append(status.data(), status.size());
+    buff.append("\n<p>");
+    buff.append(message.data(), message.size());
+    buff.append("</p><hr><em>TinyWebServer</em></body></html>");
+    http_content_len = buff.readableBytes() - before;
 }
 
 // 获取当前状态码
@@ -130,30 +153,37 @@ int HttpResponse::resCode() const {
 }
 
 // 添加状态行
-void HttpResponse::addStateLine(Buffer& buff) {
-    std::string status{""};
-    if (CODE_STATUS.count(http_code) != 1) {
+void HttpResponse::addStateLine(HeaderBuilder& header) {
+    const StatusInfo* info = CODE_STATUS.find(http_code);
+    if (!info) {
         http_code = 400;
+        info = CODE_STATUS.find(http_code);
     }
-    status = CODE_STATUS.find(http_code)->second;
-    buff.append(
-        "HTTP/1.1 " + std::to_string(http_code) + " " + status + "\r\n");
+    header.append("HTTP/1.1 ")
+        .appendInt(http_code)
+        .append(" ")
+        .append(info->text)
+        .append("\r\n");
 }
 
 // 添加响应头
-void HttpResponse::addHeader(Buffer& buff) {
-    buff.append("Connection: ");
+void HttpResponse::addHeader(
+    HeaderBuilder& header, std::string_view contenttype) {
     if (is_keepalive) {
-        buff.append("keep-alive\r\n");
-        buff.append("keep-alive: max=6, timeout=120\r\n");
+        header.appendHeader("Connection", "keep-alive");
+        header.appendHeader("keep-alive", "max=6, timeout=120");
     } else {
-        buff.append("close\r\n");
+        header.appendHeader("Connection", "close");
     }
-    buff.append("Content-type: " + getFileType() + "\r\n");
+    header.appendHeader("Content-type", contenttype);
+    header.appendHeader(
+        "Content-length",
+        static_cast<long long>(http_content_len));
+    header.append("\r\n");
 }
 
 // 添加响应体
-void HttpResponse::addContent(Buffer& buff) {
+void HttpResponse::addContent(ChainBuffer& buff) {
     int srcfd = open((http_src_dir + http_path).data(), O_RDONLY);
     if (srcfd == -1) {
         errorContent(buff, "File NotFount!");
@@ -163,37 +193,37 @@ void HttpResponse::addContent(Buffer& buff) {
         "HttpResponse.cpp: 151     file path %s",
         (http_src_dir + http_path).data());
 
-    int* mmret = (int*)
+    void* mmret =
         mmap(0, http_mmfile_stat.st_size, PROT_READ, MAP_PRIVATE, srcfd, 0);
-    if (*mmret == -1) {
+    close(srcfd);
+    if (mmret == MAP_FAILED) {
         errorContent(buff, "File NotFound!");
         return;
     }
-    http_mmfile = (char*)mmret;
-    close(srcfd);
-    buff.append(
-        "Content-length: " + std::to_string(http_mmfile_stat.st_size)
-        + "\r\n\r\n");
-    buff.append(http_mmfile, http_mmfile_stat.st_size);
+    // 文件内容直接引用映射区，与响应头一起writev发送。映射交给写缓冲区，
+    // 发送完或连接关闭丢弃数据时解除，不受之后生成的响应影响
+    http_content_len = http_mmfile_stat.st_size;
+    buff.appendExternal(
+        static_cast<char*>(mmret),
+        http_content_len,
+        unmapFile);
 }
 
 // 设置错误页面路径
-void HttpResponse::errorHtmlPath() {
-    if (CODE_PATH.count(http_code) != 0) {
-        http_path = CODE_PATH.find(http_code)->second;
-        stat((http_src_dir + http_path).data(), &http_mmfile_stat);
+bool HttpResponse::errorHtmlPath() {
+    if (http_code < 400) {
+        return true;
+    }
+    const StatusInfo* info = CODE_STATUS.find(http_code);
+    if (!info || info->page.empty()) {
+        return false;
     }
+    http_path = info->page;
+    stat((http_src_dir + http_path).data(), &http_mmfile_stat);
+    return true;
 }
 
 // 获取文件MIME类型
-std::string HttpResponse::getFileType() {
-    std::string::size_type idx = http_path.find_last_of('.');
-    if (idx == std::string::npos) {
-        return "text/plain";
-    }
-    std::string suffix = http_path.substr(idx);
-    if (SUFFIX_TYPE.count(suffix) == 1) {
-        return SUFFIX_TYPE.find(suffix)->second;
-    }
-    return "text/plain";
-}
\ No newline at end of file
+std::string_view HttpResponse::getFileType() const {
+    return MimeTable::forPath(http_path);
+}
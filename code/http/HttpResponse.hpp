@@ -3,20 +3,20 @@
 
 #include <fcntl.h>
 #include <string>
+#include <string_view>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
-#include <unordered_map>
 
-#include "../buffer/Buffer.hpp"
+#include "../buffer/ChainBuffer.hpp"
+#include "HeaderBuilder.hpp"
 
 // HTTP响应处理类
 class HttpResponse {
   public:
     // 构造函数
     HttpResponse();
-    // 析构函数
-    ~HttpResponse();
+    ~HttpResponse() = default;
 
     // 初始化响应参数
     void res_init(
@@ -24,42 +24,51 @@ class HttpResponse {
         std::string& path,
         bool iskeepalive = false,
         int code = -1);
-    // 生成完整的HTTP响应
-    void makeResponse(Buffer& buff);
-    // 解除内存映射
-    void unMapfile();
-    // 获取映射文件指针
-    char* mmapFile();
+    // 生成完整的HTTP响应：先在buff中预留头部空间并写入正文，
+    // 文件内容以外部内存段挂入而不拷贝，得知正文长度后再前置写入状态行和
+    // 响应头。文件映射归buff所有，这段数据被取走后解除，
+    // buff中可以同时排着多个响应
+    void makeResponse(ChainBuffer& buff);
+    // 生成以body为正文的HTTP响应（动态接口），正文拷贝到buff中，不读文件。
+    // 状态码为初始化时指定的值
+    void makeResponse(
+        ChainBuffer& buff,
+        std::string_view contenttype,
+        std::string_view body);
+    // 只生成正文追加到buff，返回正文的MIME类型，状态码和正文长度随之确定。
+    // 文件内容同样以外部内存段挂入，HTTP/2按自己的格式发送响应头时使用
+    std::string_view makeBody(ChainBuffer& buff);
+    // 以body为正文，拷贝到buff中
+    void makeBody(ChainBuffer& buff, std::string_view body);
     // 获取文件长度
     size_t fileLen() const;
-    // 生成错误响应内容
-    void errorContent(Buffer& buff, std::string message);
+    // 获取正文长度，makeBody()或makeResponse()之后有效
+    size_t contentLen() const;
+    // 把错误页面正文直接写入buff，并记录正文长度
+    void errorContent(ChainBuffer& buff, std::string_view message);
     // 获取当前状态码
     int resCode() const;
 
   private:
-    // 添加状态行到缓冲区
-    void addStateLine(Buffer& buff);
-    // 添加响应头到缓冲区
-    void addHeader(Buffer& buff);
-    // 添加响应体到缓冲区
-    void addContent(Buffer& buff);
-    // 设置错误页面路径
-    void errorHtmlPath();
+    // 添加状态行
+    void addStateLine(HeaderBuilder& header);
+    // 添加响应头，包括正文长度和空行
+    void addHeader(HeaderBuilder& header, std::string_view contenttype);
+    // 拼接状态行和响应头，写入buff中预留的头部空间，放不下时完整地插入到该处
+    void prependHeader(ChainBuffer& buff, std::string_view contenttype);
+    // 添加响应体到缓冲区，并记录正文长度
+    void addContent(ChainBuffer& buff);
+    // 设置错误页面路径，错误状态码没有对应的页面时返回false
+    bool errorHtmlPath();
     // 获取文件MIME类型
-    std::string getFileType();
+    std::string_view getFileType() const;
+    // 解除文件映射，作为映射区在写缓冲区中的释放函数
+    static void unmapFile(char* data, size_t len);
 
     int http_code;                // HTTP状态码
     bool is_keepalive;            // 是否保持连接
     std::string http_path;        // 请求的文件路径
     std::string http_src_dir;     // 资源文件根目录
-    char* http_mmfile;            // 内存映射文件指针
     struct stat http_mmfile_stat; // 文件状态信息
-
-    // 文件后缀到MIME类型的映射
-    static const std::unordered_map<std::string, std::string> SUFFIX_TYPE;
-    // 状态码到状态描述的映射
-    static const std::unordered_map<int, std::string> CODE_STATUS;
-    // 状态码到错误页面路径的映射
-    static const std::unordered_map<int, std::string> CODE_PATH;
+    size_t http_content_len;      // 正文长度
 };
\ No newline at end of file
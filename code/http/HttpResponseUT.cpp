@@ -0,0 +1,64 @@
+#include "HttpResponse.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+// 生成以body为正文的响应，返回写缓冲区中的全部内容
+std::string respond(
+    ChainBuffer& buff, std::string_view contenttype, std::string_view body) {
+    HttpResponse response;
+    std::string path = "/api";
+    response.res_init("/nonexistent", path, true);
+    response.makeResponse(buff, contenttype, body);
+    return buff.retrieveAllToStr();
+}
+
+} // namespace
+
+/**
+ * 测试响应头放进预留的头部空间，与之前的响应和正文首尾相接
+ */
+TEST(HttpResponseTest, HeaderShouldFitHeadroom) {
+    ChainBuffer buff;
+    buff.append("previous");
+    std::string data = respond(buff, "text/plain", "hello");
+    EXPECT_EQ(
+        data,
+        "previousHTTP/1.1 200 OK\r\n"
+        "Connection: keep-alive\r\n"
+        "keep-alive: max=6, timeout=120\r\n"
+        "Content-type: text/plain\r\n"
+        "Content-length: 5\r\n\r\nhello");
+}
+
+/**
+ * 测试响应头超出预留的头部空间时仍然完整发送，不被截断
+ */
+TEST(HttpResponseTest, HeaderLargerThanHeadroomShouldBeComplete) {
+    std::string contenttype =
+        "text/plain; x=" + std::string(HeaderBuilder::CAPACITY, 'a');
+    ChainBuffer buff;
+    buff.append("previous");
+    std::string data = respond(buff, contenttype, "hello");
+    EXPECT_EQ(
+        data,
+        "previousHTTP/1.1 200 OK\r\n"
+        "Connection: keep-alive\r\n"
+        "keep-alive: max=6, timeout=120\r\n"
+        "Content-type: " + contenttype + "\r\n"
+        "Content-length: 5\r\n\r\nhello");
+}
+
+/**
+ * 测试整数恰好跨过容量边界时拼接完整
+ */
+TEST(HttpResponseTest, BuilderShouldSpillInsideInteger) {
+    HeaderBuilder header;
+    header.append(std::string(HeaderBuilder::CAPACITY - 2, 'a'));
+    header.appendInt(123456).append("\r\n");
+    EXPECT_TRUE(header.overflow());
+    EXPECT_EQ(
+        std::string(header.data(), header.size()),
+        std::string(HeaderBuilder::CAPACITY - 2, 'a') + "123456\r\n");
+}
@@ -0,0 +1,110 @@
+#include "MimeTable.hpp"
+#include "PerfectHash.hpp"
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <unordered_map>
+
+namespace {
+
+// 内置的后缀到MIME类型的映射
+constexpr auto BUILTIN_TYPES =
+    makePerfectHash<std::string_view, std::string_view>({
+        {".html", "text/html"},
+        {".xml", "text/xml"},
+        {".xhtml", "application/xhtml+xml"},
+        {".txt", "text/plain"},
+        {".rtf", "application/rtf"},
+        {".pdf", "application/pdf"},
+        {".word", "application/msword"},
+        {".json", "application/json"},
+        {".png", "image/png"},
+        {".gif", "image/gif"},
+        {".jpg", "image/jpeg"},
+        {".jpeg", "image/jpeg"},
+        {".svg", "image/svg+xml"},
+        {".webp", "image/webp"},
+        {".ico", "image/x-icon"},
+        {".au", "audio/basic"},
+        {".mpeg", "video/mpeg"},
+        {".mpg", "video/mpeg"},
+        {".mp4", "video/mp4"},
+        {".avi", "video/x-msvideo"},
+        {".gz", "application/x-gzip"},
+        {".tar", "application/x-tar"},
+        {".css", "text/css"},
+        {".js", "text/javascript"},
+        {".woff", "font/woff"},
+        {".woff2", "font/woff2"},
+        {".ttf", "font/ttf"},
+        {".otf", "font/otf"},
+        {".eot", "application/vnd.ms-fontobject"},
+    });
+static_assert(BUILTIN_TYPES.perfect(), "no perfect hash for MIME types");
+
+// 支持以string_view直接查找的字符串哈希
+struct StringHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view str) const {
+        return std::hash<std::string_view>{}(str);
+    }
+};
+
+// 配置文件加载的映射，只在启动时写入
+std::unordered_map<std::string, std::string, StringHash, std::equal_to<>>
+    extra_types;
+
+} // namespace
+
+// 按后缀查找MIME类型，先查配置文件加载的映射
+std::string_view MimeTable::find(std::string_view suffix) {
+    if (!extra_types.empty()) {
+        auto iter = extra_types.find(suffix);
+        if (iter != extra_types.end()) {
+            return iter->second;
+        }
+    }
+    const std::string_view* type = BUILTIN_TYPES.find(suffix);
+    return type ? *type : std::string_view();
+}
+
+// 按路径的后缀查找MIME类型
+std::string_view MimeTable::forPath(std::string_view path) {
+    size_t idx = path.find_last_of('.');
+    if (idx == std::string_view::npos) {
+        return DEFAULT_TYPE;
+    }
+    std::string_view type = find(path.substr(idx));
+    return type.empty() ? DEFAULT_TYPE : type;
+}
+
+// 从配置文件加载
+int MimeTable::loadFile(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        return -1;
+    }
+    int count = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) {
+            line.resize(comment);
+        }
+        std::istringstream fields(line);
+        std::string type, suffix;
+        if (!(fields >> type)) {
+            continue;
+        }
+        while (fields >> suffix) {
+            extra_types["." + suffix] = type;
+            count++;
+        }
+    }
+    return count;
+}
+
+// 配置文件加载的后缀数
+size_t MimeTable::extraCount() {
+    return extra_types.size();
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// 文件后缀到MIME类型的映射
+// 内置的常用类型是编译期生成的完美哈希表；启动时还可以从mime.types格式的
+// 配置文件追加或覆盖。配置文件只能在开始处理请求之前加载，之后只读，
+// 多个线程同时查找无需加锁
+class MimeTable {
+  public:
+    // 没有后缀或后缀未知时使用的类型
+    static constexpr std::string_view DEFAULT_TYPE = "text/plain";
+
+    // 按后缀（含'.'，区分大小写）查找MIME类型，找不到时返回空
+    static std::string_view find(std::string_view suffix);
+    // 按路径最后一个'.'之后的后缀查找MIME类型，找不到时返回DEFAULT_TYPE
+    static std::string_view forPath(std::string_view path);
+    // 从配置文件加载。每行为"MIME类型 后缀1 后缀2 ..."，后缀不带'.'，
+    // '#'之后为注释。配置文件中的类型优先于内置类型。
+    // 返回加载的后缀数，文件打不开时返回-1
+    static int loadFile(const std::string& filename);
+    // 配置文件加载的后缀数
+    static size_t extraCount();
+};
@@ -0,0 +1,85 @@
+#include "MimeTable.hpp"
+#include "PerfectHash.hpp"
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+// 编译期生成并查找
+constexpr auto COLORS = makePerfectHash<std::string_view, int>({
+    {"red", 1},
+    {"green", 2},
+    {"blue", 3},
+    {"", 4},
+});
+static_assert(COLORS.perfect());
+static_assert(*COLORS.find("green") == 2);
+static_assert(COLORS.find("GREEN") == nullptr);
+
+constexpr auto CODES = makePerfectHash<int, std::string_view>({
+    {200, "OK"},
+    {404, "Not Found"},
+    {503, "Service Unavailable"},
+});
+static_assert(CODES.perfect());
+
+} // namespace
+
+/**
+ * 测试完美哈希表能找到每个键，找不到的键返回nullptr
+ */
+TEST(PerfectHashTest, FindShouldHitEveryKey) {
+    for (size_t i = 0; i < COLORS.size(); i++) {
+        const int* value = COLORS.find(COLORS[i].key);
+        ASSERT_NE(value, nullptr);
+        EXPECT_EQ(*value, COLORS[i].value);
+    }
+    EXPECT_EQ(COLORS.find("yellow"), nullptr);
+    EXPECT_EQ(COLORS.find("re"), nullptr);
+    EXPECT_EQ(*CODES.find(404), "Not Found");
+    EXPECT_EQ(CODES.find(405), nullptr);
+    EXPECT_EQ(CODES.find(-404), nullptr);
+}
+
+/**
+ * 测试按路径后缀查找内置MIME类型
+ */
+TEST(MimeTableTest, BuiltinTypesByPath) {
+    EXPECT_EQ(MimeTable::forPath("/index.html"), "text/html");
+    EXPECT_EQ(MimeTable::forPath("/css/style.min.css"), "text/css");
+    EXPECT_EQ(MimeTable::forPath("/fonts/a.woff2"), "font/woff2");
+    EXPECT_EQ(MimeTable::forPath("/README"), MimeTable::DEFAULT_TYPE);
+    EXPECT_EQ(MimeTable::forPath("/a.unknown"), MimeTable::DEFAULT_TYPE);
+    EXPECT_TRUE(MimeTable::find(".unknown").empty());
+}
+
+/**
+ * 测试配置文件追加新类型并覆盖内置类型，注释和空行被忽略
+ */
+TEST(MimeTableTest, LoadFileShouldExtendAndOverride) {
+    char filename[] = "/tmp/mimetableXXXXXX";
+    int fd = mkstemp(filename);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    {
+        std::ofstream file(filename);
+        file << "# comment line\n"
+             << "\n"
+             << "application/wasm wasm\n"
+             << "text/markdown md markdown # trailing comment\n"
+             << "image/vnd.microsoft.icon ico\n"
+             << "application/x-nothing\n";
+    }
+    EXPECT_EQ(MimeTable::loadFile(filename), 4);
+    std::remove(filename);
+
+    EXPECT_EQ(MimeTable::extraCount(), 4u);
+    EXPECT_EQ(MimeTable::forPath("/a.wasm"), "application/wasm");
+    EXPECT_EQ(MimeTable::forPath("/b.markdown"), "text/markdown");
+    EXPECT_EQ(MimeTable::find(".ico"), "image/vnd.microsoft.icon");
+    EXPECT_EQ(MimeTable::find(".html"), "text/html");
+    EXPECT_EQ(MimeTable::loadFile("/nonexistent/mime.types"), -1);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// 完美哈希表的一个键值对
+template <typename Key, typename Value> struct PerfectHashEntry {
+    Key key;     // 键，字符串或整数
+    Value value; // 值
+};
+
+// 编译期生成的只读完美哈希表
+// 构造时逐个尝试哈希种子，直到所有键落在互不相同的槽位上，槽位数为
+// 不小于键数四倍的2的幂。查找只计算一次哈希、比较一次键，不申请内存。
+// 应当定义为constexpr对象并用static_assert检查perfect()，
+// 这样种子搜索在编译期完成，也没有静态初始化顺序的问题
+template <typename Key, typename Value, size_t N> class PerfectHash {
+  public:
+    using Entry = PerfectHashEntry<Key, Value>;
+
+    // 槽位数
+    static constexpr size_t SLOTS = std::bit_ceil(N * 4);
+
+    // 复制键值对并搜索种子
+    constexpr explicit PerfectHash(const Entry (&entries)[N])
+        : ph_seed(0), ph_perfect(false) {
+        for (size_t i = 0; i < N; i++) {
+            ph_entries[i] = entries[i];
+        }
+        for (uint32_t seed = 1; seed <= MAX_SEED && !ph_perfect; seed++) {
+            ph_seed = seed;
+            ph_perfect = fill();
+        }
+    }
+
+    // 查找键，找不到时返回nullptr
+    constexpr const Value* find(Key key) const {
+        unsigned char index = ph_slots[hash(key, ph_seed) & (SLOTS - 1)];
+        if (index == EMPTY || ph_entries[index].key != key) {
+            return nullptr;
+        }
+        return &ph_entries[index].value;
+    }
+
+    // 是否找到了没有冲突的种子
+    constexpr bool perfect() const {
+        return ph_perfect;
+    }
+
+    // 键值对个数
+    constexpr size_t size() const {
+        return N;
+    }
+
+    // 按定义顺序访问键值对
+    constexpr const Entry& operator[](size_t index) const {
+        return ph_entries[index];
+    }
+
+  private:
+    // 最多尝试的种子数
+    static constexpr uint32_t MAX_SEED = 4096;
+    // 空槽位
+    static constexpr unsigned char EMPTY = 0xFF;
+    static_assert(N > 0 && N < EMPTY, "PerfectHash holds 1 to 254 entries");
+
+    // 混合哈希值的各位，使低位也受所有输入位影响
+    static constexpr uint32_t mix(uint32_t h) {
+        h ^= h >> 16;
+        h *= 0x85EBCA6Bu;
+        h ^= h >> 13;
+        return h;
+    }
+
+    // 字符串键的哈希：以种子扰动的FNV-1a
+    static constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+        uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+        for (char ch : key) {
+            h ^= static_cast<unsigned char>(ch);
+            h *= 16777619u;
+        }
+        return mix(h);
+    }
+
+    // 整数键的哈希：以种子扰动的乘法哈希
+    static constexpr uint32_t hash(int key, uint32_t seed) {
+        return mix((static_cast<uint32_t>(key) ^ seed) * 2654435761u);
+    }
+
+    // 用当前种子填充槽位，有冲突时返回false
+    constexpr bool fill() {
+        ph_slots.fill(EMPTY);
+        for (size_t i = 0; i < N; i++) {
+            size_t slot = hash(ph_entries[i].key, ph_seed) & (SLOTS - 1);
+            if (ph_slots[slot] != EMPTY) {
+                return false;
+            }
+            ph_slots[slot] = static_cast<unsigned char>(i);
+        }
+        return true;
+    }
+
+    std::array<Entry, N> ph_entries{};           // 键值对
+    std::array<unsigned char, SLOTS> ph_slots{}; // 槽位到键值对下标
+    uint32_t ph_seed;                            // 哈希种子
+    bool ph_perfect;                             // 是否没有冲突
+};
+
+// 从键值对数组生成完美哈希表，键值对个数由数组推导
+template <typename Key, typename Value, size_t N>
+constexpr PerfectHash<Key, Value, N>
+makePerfectHash(const PerfectHashEntry<Key, Value> (&entries)[N]) {
+    return PerfectHash<Key, Value, N>(entries);
+}
@@ -0,0 +1,254 @@
+#include "Router.hpp"
+#include <iterator>
+
+namespace {
+
+// 可以单独注册路由的请求方法，下标即方法编号
+constexpr std::string_view METHOD_NAMES[] = {
+    "GET",
+    "HEAD",
+    "POST",
+    "PUT",
+    "DELETE",
+    "PATCH",
+    "OPTIONS",
+};
+// 匹配任意方法的路由使用的编号
+constexpr size_t ANY_METHOD = std::size(METHOD_NAMES);
+// 方法编号的个数
+constexpr size_t METHOD_COUNT = ANY_METHOD + 1;
+
+// 获取方法编号，不支持的方法返回METHOD_COUNT
+size_t methodIndex(std::string_view method) {
+    if (method == Router::ANY) {
+        return ANY_METHOD;
+    }
+    for (size_t i = 0; i < ANY_METHOD; i++) {
+        if (METHOD_NAMES[i] == method) {
+            return i;
+        }
+    }
+    return METHOD_COUNT;
+}
+
+// 模式中pos处是否为参数或通配符的开头：段首的':'或'*'
+bool isParamStart(std::string_view pattern, size_t pos) {
+    return (pattern[pos] == ':' || pattern[pos] == '*') && pos > 0
+           && pattern[pos - 1] == '/';
+}
+
+// 两个字符串的公共前缀长度
+size_t commonPrefix(std::string_view a, std::string_view b) {
+    size_t n = 0;
+    while (n < a.size() && n < b.size() && a[n] == b[n]) {
+        n++;
+    }
+    return n;
+}
+
+} // namespace
+
+// 基数树节点
+struct Router::Node {
+    std::string prefix;  // 从父节点到本节点的静态字节，参数和通配符节点为空
+    std::string indices; // 各静态子节点前缀的首字节，与children一一对应
+    std::vector<std::unique_ptr<Node>> children; // 静态子节点
+    std::unique_ptr<Node> param;                 // ":name"子节点
+    std::unique_ptr<Node> wildcard;              // "*name"子节点
+    std::string name; // 参数或通配符节点的名称
+    std::array<int, METHOD_COUNT> routes; // 各方法的路由下标，-1表示没有
+
+    Node() {
+        routes.fill(-1);
+    }
+
+    // 获取方法对应的路由下标，没有单独注册时使用匹配任意方法的路由
+    int routeFor(size_t method) const {
+        if (method < ANY_METHOD && routes[method] >= 0) {
+            return routes[method];
+        }
+        return routes[ANY_METHOD];
+    }
+};
+
+// 构造函数
+Router::Router() : rt_root(std::make_unique<Node>()) {
+}
+
+// 析构函数，Node在这里才是完整类型
+Router::~Router() = default;
+
+// 注册路由
+bool Router::add(
+    std::string_view method,
+    std::string_view pattern,
+    Handler handler,
+    bool blocking) {
+    size_t index = methodIndex(method);
+    if (index == METHOD_COUNT || pattern.empty() || pattern[0] != '/'
+        || !handler) {
+        return false;
+    }
+    // 参数个数超过上限时匹配结果放不下
+    size_t count = 0;
+    for (size_t i = 0; i < pattern.size(); i++) {
+        if (isParamStart(pattern, i)) {
+            count++;
+        }
+    }
+    if (count > RouteParams::MAX_PARAMS) {
+        return false;
+    }
+    Node* node = insert(rt_root.get(), pattern, 0);
+    if (!node || node->routes[index] >= 0) {
+        return false;
+    }
+    node->routes[index] = static_cast<int>(rt_routes.size());
+    rt_routes.push_back(Route{std::move(handler), blocking});
+    return true;
+}
+
+// 匹配路由
+const Router::Route* Router::match(
+    std::string_view method,
+    std::string_view path,
+    RouteParams& params) const {
+    params.clear();
+    size_t index = methodIndex(method);
+    if (index == METHOD_COUNT) {
+        // 不支持单独注册的方法只能匹配任意方法的路由
+        index = ANY_METHOD;
+    }
+    int route = find(*rt_root, path, index, params);
+    if (route < 0) {
+        params.clear();
+        return nullptr;
+    }
+    return &rt_routes[route];
+}
+
+// 已注册的路由数
+size_t Router::size() const {
+    return rt_routes.size();
+}
+
+// 插入模式：参数和通配符各占一个子节点，静态部分与已有的边比较公共前缀，
+// 只有部分相同时把已有的边拆成两段
+Router::Node*
+Router::insert(Node* node, std::string_view pattern, size_t pos) {
+    while (pos < pattern.size()) {
+        if (isParamStart(pattern, pos)) {
+            bool iswildcard = pattern[pos] == '*';
+            size_t end = pattern.find('/', pos);
+            if (end == std::string_view::npos) {
+                end = pattern.size();
+            }
+            std::string_view name = pattern.substr(pos + 1, end - pos - 1);
+            // 参数必须有名称，通配符只能在末尾
+            if (name.empty() || (iswildcard && end != pattern.size())) {
+                return nullptr;
+            }
+            std::unique_ptr<Node>& child =
+                iswildcard ? node->wildcard : node->param;
+            if (!child) {
+                child = std::make_unique<Node>();
+                child->name.assign(name);
+            } else if (child->name != name) {
+                // 同一位置的参数名称不同，匹配结果无法确定用哪个名称
+                return nullptr;
+            }
+            node = child.get();
+            pos = end;
+            continue;
+        }
+
+        // 静态部分到下一个参数或通配符为止
+        size_t end = pos + 1;
+        while (end < pattern.size() && !isParamStart(pattern, end)) {
+            end++;
+        }
+        std::string_view run = pattern.substr(pos, end - pos);
+        size_t idx = node->indices.find(run[0]);
+        if (idx == std::string::npos) {
+            // 没有同一首字节的边，整段作为新的边
+            node->indices.push_back(run[0]);
+            node->children.push_back(std::make_unique<Node>());
+            node->children.back()->prefix.assign(run);
+            node = node->children.back().get();
+            pos = end;
+            continue;
+        }
+        Node* child = node->children[idx].get();
+        size_t common = commonPrefix(child->prefix, run);
+        if (common < child->prefix.size()) {
+            // 拆分已有的边：公共前缀成为新的中间节点，剩余部分挂在其下
+            std::unique_ptr<Node> mid = std::make_unique<Node>();
+            mid->prefix.assign(child->prefix, 0, common);
+            child->prefix.erase(0, common);
+            mid->indices.push_back(child->prefix[0]);
+            mid->children.push_back(std::move(node->children[idx]));
+            node->children[idx] = std::move(mid);
+            child = node->children[idx].get();
+        }
+        node = child;
+        pos += common;
+    }
+    return node;
+}
+
+// 匹配剩余路径：依次尝试静态子节点、参数子节点和通配符子节点，
+// 某个分支之下没有对应方法的路由时撤销该分支记录的参数并回溯
+int Router::find(
+    const Node& node,
+    std::string_view path,
+    size_t method,
+    RouteParams& params) const {
+    if (path.empty()) {
+        int route = node.routeFor(method);
+        if (route >= 0) {
+            return route;
+        }
+    } else {
+        // 静态子节点的首字节互不相同，最多只有一个候选
+        size_t idx = node.indices.find(path[0]);
+        if (idx != std::string::npos) {
+            const Node& child = *node.children[idx];
+            if (path.substr(0, child.prefix.size()) == child.prefix) {
+                int route = find(
+                    child,
+                    path.substr(child.prefix.size()),
+                    method,
+                    params);
+                if (route >= 0) {
+                    return route;
+                }
+            }
+        }
+        // 参数匹配到下一个'/'为止，不能为空
+        size_t end = path.find('/');
+        if (node.param && end != 0) {
+            std::string_view value = path.substr(0, end);
+            size_t mark = params.rp_count;
+            params.rp_names[mark] = node.param->name;
+            params.rp_values[mark] = value;
+            params.rp_count++;
+            int route =
+                find(*node.param, path.substr(value.size()), method, params);
+            if (route >= 0) {
+                return route;
+            }
+            params.rp_count = mark;
+        }
+    }
+    // 通配符匹配剩余的全部路径
+    if (node.wildcard) {
+        int route = node.wildcard->routeFor(method);
+        if (route >= 0) {
+            params.rp_names[params.rp_count] = node.wildcard->name;
+            params.rp_values[params.rp_count] = path;
+            params.rp_count++;
+            return route;
+        }
+    }
+    return -1;
+}
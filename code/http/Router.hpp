@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class HttpRequest;
+
+// 路由匹配得到的路径参数
+// 名称指向路由器中保存的模式，值指向匹配时传入的请求路径，都不拷贝，
+// 只在请求路径不变时有效：处理函数改写请求路径之前应先取出需要的参数
+class RouteParams {
+  public:
+    // 一个路由模式中最多的参数个数（含通配符）
+    static constexpr size_t MAX_PARAMS = 8;
+
+    RouteParams() : rp_count(0) {
+    }
+
+    // 按名称获取参数值，不存在时返回空
+    std::string_view get(std::string_view name) const {
+        for (size_t i = 0; i < rp_count; i++) {
+            if (rp_names[i] == name) {
+                return rp_values[i];
+            }
+        }
+        return {};
+    }
+
+    // 参数个数
+    size_t size() const {
+        return rp_count;
+    }
+
+    // 按模式中的顺序获取参数名称
+    std::string_view name(size_t index) const {
+        return rp_names[index];
+    }
+
+    // 按模式中的顺序获取参数值
+    std::string_view value(size_t index) const {
+        return rp_values[index];
+    }
+
+    // 清空参数
+    void clear() {
+        rp_count = 0;
+    }
+
+  private:
+    friend class Router;
+
+    std::array<std::string_view, MAX_PARAMS> rp_names;  // 参数名称
+    std::array<std::string_view, MAX_PARAMS> rp_values; // 参数值
+    size_t rp_count;                                    // 参数个数
+};
+
+// 处理函数生成的响应
+// content_type为空时不使用body，按（可能被处理函数改写的）请求路径返回
+// 静态文件；否则直接以body为正文。code为4xx/5xx时返回对应的错误页面
+struct RouteReply {
+    int code = 200;           // 状态码
+    std::string content_type; // 正文的MIME类型
+    std::string body;         // 正文
+
+    // 恢复为默认响应，保留字符串已申请的空间
+    void clear() {
+        code = 200;
+        content_type.clear();
+        body.clear();
+    }
+};
+
+// 按请求方法和路径模式分发请求的路由器
+// 路径模式以'/'开头，由以下几种段组成：
+//   静态段，如"/user/list"，逐字节匹配；
+//   ":name"，匹配一个非空的段（到下一个'/'为止）；
+//   "*name"，匹配剩余的全部路径（可以为空），只能出现在模式末尾。
+// ':'和'*'只在段首有特殊含义。所有模式编译成一棵基数树：静态部分按公共
+// 前缀合并成边，子节点按首字节查找，参数和通配符各自是一个单独的子节点。
+// 匹配时直接在请求路径的字节上沿树下降，静态边优先于参数，参数优先于
+// 通配符，走不通时回溯，整个过程不申请内存。
+// 路由只能在开始处理请求之前注册，之后只读，多个线程同时匹配无需加锁
+class Router {
+  public:
+    // 处理函数，参数依次为请求、路径参数和待填写的响应
+    using Handler =
+        std::function<void(HttpRequest&, const RouteParams&, RouteReply&)>;
+
+    // 一条路由
+    struct Route {
+        Handler handler; // 处理函数
+        bool blocking;   // 处理函数是否可能阻塞（如访问数据库）
+    };
+
+    // 匹配任意请求方法
+    static constexpr std::string_view ANY = "*";
+
+    Router();
+    ~Router();
+
+    // 注册路由，method为ANY时匹配所有方法，同一路径上指定了方法的路由优先。
+    // 可能阻塞的处理函数交给阻塞任务执行器在其他线程执行。
+    // 模式格式错误、同一位置的参数名称不同或重复注册时返回false
+    bool add(
+        std::string_view method,
+        std::string_view pattern,
+        Handler handler,
+        bool blocking = false);
+    // 按方法和路径（不含查询字符串）匹配路由，参数写入params，
+    // 找不到时返回nullptr
+    const Route*
+    match(std::string_view method, std::string_view path, RouteParams& params)
+        const;
+    // 已注册的路由数
+    size_t size() const;
+
+  private:
+    struct Node;
+
+    // 在node之下插入pattern中从pos开始的部分，返回模式末尾对应的节点，
+    // 模式格式错误或与已有模式冲突时返回nullptr
+    Node* insert(Node* node, std::string_view pattern, size_t pos);
+    // 在node之下匹配剩余路径path，返回路由下标，找不到时返回-1
+    int find(
+        const Node& node,
+        std::string_view path,
+        size_t method,
+        RouteParams& params) const;
+
+    std::unique_ptr<Node> rt_root; // 树根，对应空前缀
+    std::vector<Route> rt_routes;  // 所有路由，节点中保存下标
+};
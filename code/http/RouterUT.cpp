@@ -0,0 +1,167 @@
+#include "Router.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace {
+
+// 只记录编号的处理函数，用于区分匹配到的路由
+struct TagHandler {
+    std::string tag;
+
+    void operator()(HttpRequest&, const RouteParams&, RouteReply& reply) const {
+        reply.body = tag;
+    }
+};
+
+// 返回带编号的处理函数
+Router::Handler tagHandler(const std::string& tag) {
+    return TagHandler{tag};
+}
+
+// 匹配并取出处理函数的编号，没有匹配时返回空
+std::string dispatch(
+    const Router& router,
+    std::string_view method,
+    std::string_view path,
+    RouteParams& params) {
+    const Router::Route* route = router.match(method, path, params);
+    if (!route) {
+        return "";
+    }
+    return route->handler.target<TagHandler>()->tag;
+}
+
+} // namespace
+
+/**
+ * 测试静态路径：拆分公共前缀后每条路由仍然精确匹配，前缀和多余的字节都不匹配
+ */
+TEST(RouterTest, StaticPathsShouldMatchExactly) {
+    Router router;
+    ASSERT_TRUE(router.add("GET", "/", tagHandler("root")));
+    ASSERT_TRUE(router.add("GET", "/user", tagHandler("user")));
+    ASSERT_TRUE(router.add("GET", "/users", tagHandler("users")));
+    ASSERT_TRUE(router.add("GET", "/user/list", tagHandler("list")));
+    ASSERT_TRUE(router.add("GET", "/upload", tagHandler("upload")));
+    EXPECT_EQ(router.size(), 5u);
+
+    RouteParams params;
+    EXPECT_EQ(dispatch(router, "GET", "/", params), "root");
+    EXPECT_EQ(dispatch(router, "GET", "/user", params), "user");
+    EXPECT_EQ(dispatch(router, "GET", "/users", params), "users");
+    EXPECT_EQ(dispatch(router, "GET", "/user/list", params), "list");
+    EXPECT_EQ(dispatch(router, "GET", "/upload", params), "upload");
+    EXPECT_EQ(params.size(), 0u);
+    EXPECT_EQ(router.match("GET", "/us", params), nullptr);
+    EXPECT_EQ(router.match("GET", "/user/", params), nullptr);
+    EXPECT_EQ(router.match("GET", "/user/lists", params), nullptr);
+    EXPECT_EQ(router.match("GET", "", params), nullptr);
+}
+
+/**
+ * 测试参数和通配符：参数值指向请求路径本身，不拷贝
+ */
+TEST(RouterTest, ParamsShouldPointIntoPath) {
+    Router router;
+    ASSERT_TRUE(router.add("GET", "/user/:id", tagHandler("user")));
+    ASSERT_TRUE(router.add("GET", "/user/:id/post/:post", tagHandler("post")));
+    ASSERT_TRUE(router.add("GET", "/static/*file", tagHandler("static")));
+
+    RouteParams params;
+    std::string path = "/user/42/post/7";
+    EXPECT_EQ(dispatch(router, "GET", path, params), "post");
+    ASSERT_EQ(params.size(), 2u);
+    EXPECT_EQ(params.name(0), "id");
+    EXPECT_EQ(params.get("id"), "42");
+    EXPECT_EQ(params.get("post"), "7");
+    EXPECT_EQ(params.get("id").data(), path.data() + 6);
+    EXPECT_EQ(params.get("none"), "");
+
+    EXPECT_EQ(dispatch(router, "GET", "/user/42", params), "user");
+    EXPECT_EQ(params.size(), 1u);
+    // 参数不能为空
+    EXPECT_EQ(router.match("GET", "/user/", params), nullptr);
+    EXPECT_EQ(params.size(), 0u);
+
+    // 通配符匹配剩余的全部路径，包括'/'，也可以为空
+    EXPECT_EQ(dispatch(router, "GET", "/static/css/a.css", params), "static");
+    EXPECT_EQ(params.get("file"), "css/a.css");
+    EXPECT_EQ(dispatch(router, "GET", "/static/", params), "static");
+    EXPECT_EQ(params.get("file"), "");
+}
+
+/**
+ * 测试优先级：静态路径优先于参数，参数优先于通配符，走不通时回溯
+ */
+TEST(RouterTest, StaticShouldWinAndBacktrack) {
+    Router router;
+    ASSERT_TRUE(router.add("GET", "/user/new", tagHandler("new")));
+    ASSERT_TRUE(router.add("GET", "/user/:id", tagHandler("id")));
+    ASSERT_TRUE(router.add("GET", "/user/new/edit", tagHandler("edit")));
+    ASSERT_TRUE(router.add("GET", "/user/:id/profile", tagHandler("profile")));
+    ASSERT_TRUE(router.add("GET", "/*path", tagHandler("any")));
+
+    RouteParams params;
+    EXPECT_EQ(dispatch(router, "GET", "/user/new", params), "new");
+    EXPECT_EQ(dispatch(router, "GET", "/user/newer", params), "id");
+    EXPECT_EQ(params.get("id"), "newer");
+    EXPECT_EQ(dispatch(router, "GET", "/user/new/edit", params), "edit");
+    // 静态分支"/user/new"之下没有"/profile"，回溯到参数分支
+    EXPECT_EQ(dispatch(router, "GET", "/user/new/profile", params), "profile");
+    ASSERT_EQ(params.size(), 1u);
+    EXPECT_EQ(params.get("id"), "new");
+    // 都不匹配时由根上的通配符兜底，之前分支记录的参数已撤销
+    EXPECT_EQ(dispatch(router, "GET", "/user/new/x", params), "any");
+    ASSERT_EQ(params.size(), 1u);
+    EXPECT_EQ(params.get("path"), "user/new/x");
+}
+
+/**
+ * 测试请求方法：指定了方法的路由优先于任意方法，方法不符时继续尝试其他分支
+ */
+TEST(RouterTest, MethodShouldSelectRoute) {
+    Router router;
+    ASSERT_TRUE(router.add("GET", "/login", tagHandler("page")));
+    ASSERT_TRUE(router.add("POST", "/login", tagHandler("form")));
+    ASSERT_TRUE(router.add(Router::ANY, "/index", tagHandler("index")));
+    ASSERT_TRUE(router.add("POST", "/index", tagHandler("post")));
+    ASSERT_TRUE(router.add("DELETE", "/item/all", tagHandler("all")));
+    ASSERT_TRUE(router.add("GET", "/item/:id", tagHandler("item")));
+
+    RouteParams params;
+    EXPECT_EQ(dispatch(router, "GET", "/login", params), "page");
+    EXPECT_EQ(dispatch(router, "POST", "/login", params), "form");
+    EXPECT_EQ(router.match("PUT", "/login", params), nullptr);
+    EXPECT_EQ(dispatch(router, "GET", "/index", params), "index");
+    EXPECT_EQ(dispatch(router, "POST", "/index", params), "post");
+    // 不支持单独注册的方法只匹配任意方法的路由
+    EXPECT_EQ(dispatch(router, "BREW", "/index", params), "index");
+    EXPECT_EQ(dispatch(router, "DELETE", "/item/all", params), "all");
+    EXPECT_EQ(dispatch(router, "GET", "/item/all", params), "item");
+}
+
+/**
+ * 测试非法模式和冲突：注册失败，已有的路由不受影响
+ */
+TEST(RouterTest, BadPatternsShouldBeRejected) {
+    Router router;
+    ASSERT_TRUE(router.add("GET", "/a/:id", tagHandler("id")));
+    EXPECT_FALSE(router.add("GET", "/a/:id", tagHandler("dup")));
+    EXPECT_FALSE(router.add("GET", "/a/:name/b", tagHandler("name")));
+    EXPECT_FALSE(router.add("GET", "a", tagHandler("relative")));
+    EXPECT_FALSE(router.add("GET", "/:", tagHandler("unnamed")));
+    EXPECT_FALSE(router.add("GET", "/*rest/more", tagHandler("middle")));
+    EXPECT_FALSE(router.add("BREW", "/coffee", tagHandler("method")));
+    EXPECT_FALSE(router.add("GET", "/null", nullptr));
+    EXPECT_FALSE(router.add(
+        "GET",
+        "/:a/:b/:c/:d/:e/:f/:g/:h/:i",
+        tagHandler("too many")));
+    // 段中间的':'和'*'是普通字符
+    ASSERT_TRUE(router.add("GET", "/a:b*c", tagHandler("plain")));
+    EXPECT_EQ(router.size(), 2u);
+
+    RouteParams params;
+    EXPECT_EQ(dispatch(router, "GET", "/a/1", params), "id");
+    EXPECT_EQ(dispatch(router, "GET", "/a:b*c", params), "plain");
+}
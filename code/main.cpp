@@ -2,6 +2,13 @@
 #include <unistd.h>
 
 int main() {
+    // 可选运行参数
+    ServerOptions options;
+    options.loop_num = 0; // 子Reactor数量，0表示单Reactor+线程池模式
+    options.reuse_port = false;    // 每个子循环一个SO_REUSEPORT监听套接字
+    options.listen_backlog = 1024; // 监听队列长度
+    options.poller_backend = POLLER_BACKEND::EPOLL; // IO事件后端：EPOLL/IO_URING
+
     // 创建WebServer对象，传入各项初始化参数
     WebServer server(
         5005,        // 监听端口
@@ -16,7 +23,8 @@ int main() {
         20,          // 线程池线程数量
         true,        // 是否开启日志
         0,           // 日志等级
-        4096         // 日志队列容量
+        4096,        // 日志队列容量
+        options      // 可选运行参数
     );
     // 启动服务器主循环
     server.start();
@@ -0,0 +1,169 @@
+#pragma once
+
+#include "Task.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 队列已满时的拒绝策略
+enum class REJECT_POLICY {
+    REJECT,         // 拒绝新任务
+    DISCARD_OLDEST, // 丢弃队列中最早的任务，新任务入队
+    CALLER_RUNS,    // 在提交任务的线程中直接执行新任务
+};
+
+// 阻塞任务执行器
+// 专门执行会阻塞的任务（如访问数据库），与处理IO和静态文件的线程池隔离，
+// 数据库再慢也只会占满这里的线程，不会拖慢其他请求。
+// 线程数固定，等待队列有上限，队列满时按拒绝策略处理；
+// 被拒绝的任务不执行，改为在提交任务的线程中调用它的拒绝回调。
+// 队列是启动时按上限分配好的环形缓冲区，提交任务不申请堆内存
+class BlockingExecutor {
+  public:
+    // 构造函数：threadnum为线程数，queuemax为等待队列上限，policy为拒绝策略
+    BlockingExecutor(
+        size_t threadnum,
+        size_t queuemax,
+        REJECT_POLICY policy = REJECT_POLICY::REJECT)
+        : exec_policy(policy), exec_queue(queuemax > 0 ? queuemax : 1),
+          exec_head(0), exec_count(0), exec_is_closed(false),
+          exec_reject_count(0) {
+        if (threadnum == 0) {
+            threadnum = 1;
+        }
+        for (size_t i = 0; i < threadnum; i++) {
+            exec_threads.emplace_back([this] { run(); });
+        }
+    }
+    BlockingExecutor(const BlockingExecutor&) = delete;
+    BlockingExecutor& operator=(const BlockingExecutor&) = delete;
+
+    // 析构函数：队列中尚未开始的任务全部按拒绝处理，等待执行中的任务完成
+    ~BlockingExecutor() {
+        std::vector<Entry> rejected;
+        {
+            std::lock_guard<std::mutex> lock(exec_mtx);
+            exec_is_closed = true;
+            while (exec_count > 0) {
+                rejected.emplace_back(popFront());
+            }
+        }
+        exec_cv.notify_all();
+        for (Entry& entry : rejected) {
+            reject(entry);
+        }
+        for (std::thread& thread : exec_threads) {
+            thread.join();
+        }
+    }
+
+    // 提交任务，onreject在任务被拒绝时于当前线程中调用。
+    // 返回task是否被接受（入队或按CALLER_RUNS策略已执行）
+    bool submit(Task task, Task onreject = nullptr) {
+        Entry entry{std::move(task), std::move(onreject)};
+        Entry dropped;
+        bool accepted = false;
+        bool closed = false;
+        {
+            std::lock_guard<std::mutex> lock(exec_mtx);
+            closed = exec_is_closed;
+            if (!closed && exec_count == exec_queue.size()
+                && exec_policy == REJECT_POLICY::DISCARD_OLDEST) {
+                dropped = popFront();
+            }
+            if (!closed && exec_count < exec_queue.size()) {
+                pushBack(std::move(entry));
+                accepted = true;
+            }
+        }
+        if (accepted) {
+            exec_cv.notify_one();
+            // 被挤掉的任务在锁外回调，回调中可以再次提交
+            if (dropped.task) {
+                reject(dropped);
+            }
+            return true;
+        }
+        if (!closed && exec_policy == REJECT_POLICY::CALLER_RUNS) {
+            entry.task();
+            return true;
+        }
+        reject(entry);
+        return false;
+    }
+
+    // 获取线程数
+    size_t size() const {
+        return exec_threads.size();
+    }
+
+    // 获取等待队列上限
+    size_t capacity() const {
+        return exec_queue.size();
+    }
+
+    // 获取被拒绝的任务数
+    size_t getRejectCount() const {
+        return exec_reject_count;
+    }
+
+  private:
+    // 队列中的一项：任务及其拒绝回调
+    struct Entry {
+        Task task;
+        Task onreject;
+    };
+
+    // 工作线程主循环
+    void run() {
+        while (true) {
+            Entry entry;
+            {
+                std::unique_lock<std::mutex> lock(exec_mtx);
+                exec_cv.wait(lock, [this] {
+                    return exec_is_closed || exec_count > 0;
+                });
+                if (exec_count == 0) {
+                    return;
+                }
+                entry = popFront();
+            }
+            entry.task();
+        }
+    }
+
+    // 任务放入队尾，调用方需持有exec_mtx且队列未满
+    void pushBack(Entry&& entry) {
+        exec_queue[(exec_head + exec_count) % exec_queue.size()] =
+            std::move(entry);
+        exec_count++;
+    }
+
+    // 从队首取出任务，调用方需持有exec_mtx且队列非空
+    Entry popFront() {
+        Entry entry = std::move(exec_queue[exec_head]);
+        exec_head = (exec_head + 1) % exec_queue.size();
+        exec_count--;
+        return entry;
+    }
+
+    // 记录一次拒绝并调用拒绝回调
+    void reject(Entry& entry) {
+        exec_reject_count++;
+        if (entry.onreject) {
+            entry.onreject();
+        }
+    }
+
+    const REJECT_POLICY exec_policy;       // 拒绝策略
+    std::vector<Entry> exec_queue;         // 等待队列，容量即上限
+    size_t exec_head;                      // 队首下标
+    size_t exec_count;                     // 等待中的任务数
+    bool exec_is_closed;                   // 是否已关闭，受exec_mtx保护
+    std::atomic<size_t> exec_reject_count; // 被拒绝的任务数
+    std::mutex exec_mtx;                   // 保护队列的互斥锁
+    std::condition_variable exec_cv;       // 等待任务用的条件变量
+    std::vector<std::thread> exec_threads; // 工作线程
+};
@@ -0,0 +1,128 @@
+#include "BlockingExecutor.hpp"
+#include <chrono>
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+/**
+ * 等待计数达到期望值，超时返回false
+ */
+static bool waitCount(std::atomic<int>& count, int expect) {
+    for (int i = 0; i < 500 && count < expect; i++) {
+        std::this_thread::sleep_for(10ms);
+    }
+    return count == expect;
+}
+
+/**
+ * 占住执行器的全部线程，直到release被置位
+ */
+static void occupy(
+    BlockingExecutor& executor,
+    std::atomic<bool>& release,
+    std::atomic<int>& started) {
+    for (size_t i = 0; i < executor.size(); i++) {
+        executor.submit([&] {
+            started++;
+            while (!release) {
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+    }
+    ASSERT_TRUE(waitCount(started, static_cast<int>(executor.size())));
+}
+
+/**
+ * 测试提交的任务全部被执行
+ */
+TEST(BlockingExecutorTest, AllTasksShouldRun) {
+    BlockingExecutor executor(4, 1024);
+    std::atomic<int> count(0);
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(executor.submit([&count] { count++; }));
+    }
+    ASSERT_TRUE(waitCount(count, 1000));
+    ASSERT_EQ(executor.getRejectCount(), 0u);
+}
+
+/**
+ * 测试队列满时拒绝新任务，并在提交线程中调用拒绝回调
+ */
+TEST(BlockingExecutorTest, FullQueueShouldReject) {
+    BlockingExecutor executor(2, 2, REJECT_POLICY::REJECT);
+    std::atomic<bool> release(false);
+    std::atomic<int> started(0);
+    occupy(executor, release, started);
+    std::atomic<int> count(0);
+    std::atomic<int> rejected(0);
+    for (int i = 0; i < 5; i++) {
+        executor.submit([&count] { count++; }, [&rejected] { rejected++; });
+    }
+    // 队列上限为2，其余3个被拒绝
+    ASSERT_EQ(rejected, 3);
+    ASSERT_EQ(executor.getRejectCount(), 3u);
+    release = true;
+    ASSERT_TRUE(waitCount(count, 2));
+}
+
+/**
+ * 测试DISCARD_OLDEST策略挤掉最早排队的任务
+ */
+TEST(BlockingExecutorTest, DiscardOldestShouldDropHead) {
+    BlockingExecutor executor(1, 2, REJECT_POLICY::DISCARD_OLDEST);
+    std::atomic<bool> release(false);
+    std::atomic<int> started(0);
+    occupy(executor, release, started);
+    std::atomic<int> count(0);
+    std::atomic<int> dropped(-1);
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(executor.submit(
+            [&count] { count++; },
+            [&dropped, i] { dropped = i; }));
+    }
+    // 任务0和1先后被挤掉，最后一次挤掉的是任务1
+    ASSERT_EQ(dropped, 1);
+    ASSERT_EQ(executor.getRejectCount(), 2u);
+    release = true;
+    ASSERT_TRUE(waitCount(count, 2));
+}
+
+/**
+ * 测试CALLER_RUNS策略在提交线程中执行任务
+ */
+TEST(BlockingExecutorTest, CallerRunsShouldRunInline) {
+    BlockingExecutor executor(1, 1, REJECT_POLICY::CALLER_RUNS);
+    std::atomic<bool> release(false);
+    std::atomic<int> started(0);
+    occupy(executor, release, started);
+    executor.submit([] {});
+    std::thread::id runner;
+    ASSERT_TRUE(executor.submit([&runner] {
+        runner = std::this_thread::get_id();
+    }));
+    ASSERT_EQ(runner, std::this_thread::get_id());
+    release = true;
+}
+
+/**
+ * 测试析构时排队中的任务按拒绝处理，执行中的任务正常完成
+ */
+TEST(BlockingExecutorTest, DestructorShouldRejectQueued) {
+    std::atomic<int> count(0);
+    std::atomic<int> rejected(0);
+    {
+        BlockingExecutor executor(1, 8);
+        std::atomic<int> started(0);
+        executor.submit([&] {
+            started++;
+            std::this_thread::sleep_for(50ms);
+            count++;
+        });
+        ASSERT_TRUE(waitCount(started, 1));
+        for (int i = 0; i < 3; i++) {
+            executor.submit([&count] { count++; }, [&rejected] { rejected++; });
+        }
+    }
+    ASSERT_EQ(count, 1);
+    ASSERT_EQ(rejected, 3);
+}
@@ -1,4 +1,5 @@
 #include "SqlConnPool.hpp"
+#include <chrono>
 #include <iostream>
 
 // 获取连接池单例
@@ -8,11 +9,28 @@ SqlConnPool& SqlConnPool::instance() {
     return conn_pool;
 }
 
-// 获取一个数据库连接
+// 获取一个数据库连接，使用默认等待时间
 MYSQL* SqlConnPool::getConn() {
+    return getConn(wait_ms);
+}
+
+// 获取一个数据库连接，超时返回nullptr
+MYSQL* SqlConnPool::getConn(int timeoutms) {
     std::unique_lock<std::mutex> lock(conn_mtx);
+    if (max_conn == 0) {
+        // 一个连接都没有建立成功，等待没有意义
+        return nullptr;
+    }
     // 等待直到连接池中有可用连接
-    conn_cv.wait(lock, [this] { return !conn_que.empty(); });
+    auto ready = [this] { return !conn_que.empty(); };
+    if (timeoutms < 0) {
+        conn_cv.wait(lock, ready);
+    } else if (!conn_cv.wait_for(
+                   lock,
+                   std::chrono::milliseconds(timeoutms),
+                   ready)) {
+        return nullptr;
+    }
     // 获取队列前端的连接
     auto conn = conn_que.front();
     conn_que.pop();
@@ -48,7 +66,8 @@ void SqlConnPool::initConn(
     const char* user,
     const char* pwd,
     const char* dbname,
-    size_t connsize) {
+    size_t connsize,
+    int waitms) {
     size_t success_cnt = 0;
     // 创建指定数量的数据库连接
     for (int i = 0; i < connsize; i++) {
@@ -81,6 +100,7 @@ void SqlConnPool::initConn(
     // 更新连接池状态
     max_conn = success_cnt;
     free_conn = success_cnt;
+    wait_ms = waitms;
 }
 
 // 关闭连接池
@@ -97,7 +117,8 @@ void SqlConnPool::closePool() {
 }
 
 // 构造函数，初始化成员变量
-SqlConnPool::SqlConnPool() : use_conn(0), free_conn(0), max_conn(0) {
+SqlConnPool::SqlConnPool()
+    : use_conn(0), free_conn(0), max_conn(0), wait_ms(-1) {
 }
 
 // 析构函数，确保关闭连接池
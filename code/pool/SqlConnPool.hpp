@@ -13,10 +13,15 @@ class SqlConnPool {
     // 返回连接池单例引用
     static SqlConnPool& instance();
 
-    // 获取一个数据库连接
-    // 返回MYSQL*数据库连接指针
+    // 获取一个数据库连接，最多等待initConn中设置的时间
+    // 返回MYSQL*数据库连接指针，超时返回nullptr
     MYSQL* getConn();
 
+    // 获取一个数据库连接
+    // timeoutms: 最长等待时间（毫秒），小于0表示一直等待
+    // 返回MYSQL*数据库连接指针，超时或连接池为空时返回nullptr
+    MYSQL* getConn(int timeoutms);
+
     // 释放一个数据库连接
     // conn: 要释放的连接指针
     void freeConn(MYSQL* conn);
@@ -32,13 +37,15 @@ class SqlConnPool {
     // pwd: 密码
     // dbname: 数据库名
     // connsize: 连接池大小
+    // waitms: getConn()等待空闲连接的最长时间（毫秒），小于0表示一直等待
     void initConn(
         const char* host,
         size_t port,
         const char* user,
         const char* pwd,
         const char* dbname,
-        size_t connsize);
+        size_t connsize,
+        int waitms = -1);
 
     // 关闭连接池
     void closePool();
@@ -50,6 +57,7 @@ class SqlConnPool {
     size_t max_conn;  // 最大连接数
     size_t use_conn;  // 已使用连接数
     size_t free_conn; // 空闲连接数
+    int wait_ms;      // getConn()的默认等待时间（毫秒）
 
     std::queue<MYSQL*> conn_que;     // 连接队列
     std::mutex conn_mtx;             // 互斥锁
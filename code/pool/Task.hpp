@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// 只可移动的无参任务类型，用于线程池、定时器和事件循环之间传递回调
+// 与std::function不同，可调用对象总是直接存放在对象内部的固定缓冲区中，
+// 构造、移动和销毁都不会申请堆内存；超过INLINE_SIZE的可调用对象在编译期报错。
+// 捕获this和几个指针的lambda都远小于这个上限
+class Task {
+  public:
+    // 内部缓冲区大小，加上操作表指针后整个Task恰好占一个缓存行
+    static constexpr size_t INLINE_SIZE = 56;
+
+    Task() noexcept : task_ops(nullptr) {
+    }
+    Task(std::nullptr_t) noexcept : task_ops(nullptr) {
+    }
+
+    // 由任意无参可调用对象构造
+    template <
+        typename F,
+        typename Fn = typename std::decay<F>::type,
+        typename = typename std::enable_if<
+            !std::is_same<Fn, Task>::value>::type>
+    Task(F&& f) : task_ops(&OpsFor<Fn>::ops) {
+        static_assert(
+            sizeof(Fn) <= INLINE_SIZE,
+            "callable is too large for Task, capture less state");
+        static_assert(
+            alignof(Fn) <= alignof(void*),
+            "callable is over-aligned for Task");
+        new (task_buf) Fn(std::forward<F>(f));
+    }
+
+    Task(Task&& other) noexcept : task_ops(other.task_ops) {
+        if (task_ops) {
+            task_ops->move(task_buf, other.task_buf);
+            other.task_ops = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            task_ops = other.task_ops;
+            if (task_ops) {
+                task_ops->move(task_buf, other.task_buf);
+                other.task_ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task& operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        reset();
+    }
+
+    // 执行任务
+    void operator()() {
+        task_ops->invoke(task_buf);
+    }
+
+    // 是否持有可调用对象
+    explicit operator bool() const noexcept {
+        return task_ops != nullptr;
+    }
+
+  private:
+    // 针对具体可调用类型的操作表
+    struct Ops {
+        void (*invoke)(void* buf);          // 调用
+        void (*move)(void* dst, void* src); // 移动构造到dst并销毁src
+        void (*destroy)(void* buf);         // 销毁
+    };
+
+    template <typename Fn> struct OpsFor {
+        static void invoke(void* buf) {
+            (*static_cast<Fn*>(buf))();
+        }
+        static void move(void* dst, void* src) {
+            Fn* from = static_cast<Fn*>(src);
+            new (dst) Fn(std::move(*from));
+            from->~Fn();
+        }
+        static void destroy(void* buf) {
+            static_cast<Fn*>(buf)->~Fn();
+        }
+        // constexpr静态数据成员隐式为inline（C++17起），不需要类外定义
+        static constexpr Ops ops{invoke, move, destroy};
+    };
+
+    // 销毁持有的可调用对象
+    void reset() noexcept {
+        if (task_ops) {
+            task_ops->destroy(task_buf);
+            task_ops = nullptr;
+        }
+    }
+
+    const Ops* task_ops; // 操作表
+    // 存放可调用对象的缓冲区
+    alignas(void*) unsigned char task_buf[INLINE_SIZE];
+};
+
+static_assert(sizeof(Task) <= 64, "Task should fit in one cache line");
@@ -0,0 +1,219 @@
+#include "threadpool.hpp"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <set>
+
+using namespace std::chrono_literals;
+
+/**
+ * 等待计数达到期望值，超时返回false
+ */
+static bool waitCount(std::atomic<int>& count, int expect) {
+    for (int i = 0; i < 500 && count < expect; i++) {
+        std::this_thread::sleep_for(10ms);
+    }
+    return count == expect;
+}
+
+/**
+ * 等待线程池的线程数变为期望值，超时返回false
+ */
+static bool waitSize(ThreadPool& pool, size_t expect) {
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (pool.size() != expect
+           && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(5ms);
+    }
+    return pool.size() == expect;
+}
+
+/**
+ * 测试提交的任务全部被执行
+ */
+TEST(ThreadPoolTest, AllTasksShouldRun) {
+    ThreadPool pool(4);
+    std::atomic<int> count(0);
+    for (int i = 0; i < 10000; i++) {
+        pool.addTask([&count] { count++; });
+    }
+    ASSERT_TRUE(waitCount(count, 10000));
+}
+
+/**
+ * 测试同一hint的任务进入同一队列，队列所有者忙碌时由其他线程窃取执行
+ */
+TEST(ThreadPoolTest, IdleWorkersShouldStealFromBusyWorker) {
+    ThreadPool pool(4);
+    std::atomic<int> count(0);
+    std::mutex ids_mtx;
+    std::set<std::thread::id> ids;
+    // 全部提交到同一个队列，每个任务都会阻塞一段时间
+    for (int i = 0; i < 8; i++) {
+        pool.addTask(7, [&] {
+            {
+                std::lock_guard<std::mutex> lock(ids_mtx);
+                ids.insert(std::this_thread::get_id());
+            }
+            std::this_thread::sleep_for(50ms);
+            count++;
+        });
+    }
+    ASSERT_TRUE(waitCount(count, 8));
+    // 只靠队列所有者需要400ms，其他线程窃取后应由多个线程执行
+    ASSERT_GT(ids.size(), 1u);
+}
+
+/**
+ * 测试工作线程中提交的任务同样会被执行
+ */
+TEST(ThreadPoolTest, NestedTasksShouldRun) {
+    ThreadPool pool(2);
+    std::atomic<int> count(0);
+    for (int i = 0; i < 100; i++) {
+        pool.addTask([&pool, &count] {
+            pool.addTask([&count] { count++; });
+            count++;
+        });
+    }
+    ASSERT_TRUE(waitCount(count, 200));
+}
+
+/**
+ * 测试批量提交：一次提交的任务全部执行，提交后vector被清空
+ */
+TEST(ThreadPoolTest, BatchedTasksShouldRun) {
+    ThreadPool pool(4);
+    std::atomic<int> count(0);
+    std::vector<Task> batch;
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 32; i++) {
+            batch.emplace_back([&count] { count++; });
+        }
+        pool.addTasks(batch);
+        ASSERT_TRUE(batch.empty());
+    }
+    ASSERT_TRUE(waitCount(count, 3200));
+}
+
+/**
+ * 测试带hint的批量提交：同一hint的任务进入同一个队列并保持提交顺序，
+ * 放开一个工作线程时，它先按顺序执行完自己队列中的任务
+ */
+TEST(ThreadPoolTest, HintedBatchShouldKeepAffinity) {
+    ThreadPool pool(4);
+    std::atomic<int> released(0);
+    std::atomic<int> started(0);
+    // 先占住全部工作线程，批量任务提交时不会被立即取走；
+    // released为n时放开前n个任务
+    for (int i = 0; i < 4; i++) {
+        pool.addTask(static_cast<size_t>(i), [&released, &started, i] {
+            started++;
+            while (released <= i) {
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+    }
+    ASSERT_TRUE(waitCount(started, 4));
+    std::mutex mtx;
+    std::vector<std::pair<size_t, int>> order;
+    std::atomic<int> count(0);
+    std::vector<std::pair<size_t, Task>> batch;
+    for (int i = 0; i < 64; i++) {
+        size_t hint = static_cast<size_t>(i) * 7 % 4;
+        batch.emplace_back(hint, [&, hint, i] {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                order.emplace_back(hint, i);
+            }
+            count++;
+        });
+    }
+    pool.addTasks(batch);
+    ASSERT_TRUE(batch.empty());
+    // 只有一个线程空闲，它先取完自己的队列才会窃取
+    released = 1;
+    for (int i = 0; i < 500 && count < 16; i++) {
+        std::this_thread::sleep_for(10ms);
+    }
+    released = 4;
+    ASSERT_TRUE(waitCount(count, 64));
+    for (int i = 1; i < 16; i++) {
+        EXPECT_EQ(order[i].first, order[0].first);
+        EXPECT_LT(order[i - 1].second, order[i].second);
+    }
+}
+
+/**
+ * 测试工作线程都阻塞时线程池扩容，空闲超时后缩回常驻线程数
+ */
+TEST(ThreadPoolTest, ElasticPoolShouldGrowAndShrink) {
+    // 常驻1个线程，最多4个，任务10ms没被取走就扩容，多出的线程空闲100ms退出
+    ThreadPool pool(1, 4, 10, 64, 100);
+    ASSERT_EQ(pool.size(), 1u);
+    ASSERT_EQ(pool.maxSize(), 4u);
+    std::atomic<bool> release(false);
+    std::atomic<int> count(0);
+    // 模拟卡在数据库查询中的任务，占住当前所有线程
+    auto blocking = [&] {
+        while (!release) {
+            std::this_thread::sleep_for(1ms);
+        }
+        count++;
+    };
+    // 只在提交时检查是否扩容：队首任务等待超过阈值就增加一个线程。
+    // 持续提交阻塞任务直到达到上限，不假设每次提交恰好扩容一个线程
+    int submitted = 0;
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (pool.size() < 4 && std::chrono::steady_clock::now() < deadline) {
+        pool.addTask(blocking);
+        submitted++;
+        std::this_thread::sleep_for(15ms);
+    }
+    ASSERT_EQ(pool.size(), 4u);
+    // 已达上限，等待超过阈值后再提交也不再扩容，任务在阻塞解除后执行
+    pool.addTask([&count] { count++; });
+    std::this_thread::sleep_for(30ms);
+    pool.addTask([&count] { count++; });
+    EXPECT_EQ(pool.size(), 4u);
+    release = true;
+    ASSERT_TRUE(waitCount(count, submitted + 2));
+    // 多出来的线程逐个空闲超时退出
+    ASSERT_TRUE(waitSize(pool, 1));
+    // 缩容后仍能正常执行任务
+    pool.addTask([&count] { count++; });
+    ASSERT_TRUE(waitCount(count, submitted + 3));
+}
+
+/**
+ * 测试析构时执行完剩余任务并join所有工作线程
+ */
+TEST(ThreadPoolTest, DestructorShouldDrainAndJoin) {
+    std::atomic<int> count(0);
+    {
+        ThreadPool pool(2, 4, 1, 8, 1000);
+        for (int i = 0; i < 100; i++) {
+            pool.addTask([&count] {
+                std::this_thread::sleep_for(1ms);
+                count++;
+            });
+        }
+    }
+    ASSERT_EQ(count, 100);
+}
+
+/**
+ * 测试Task只可移动，移动后原对象为空，销毁时释放捕获的状态
+ */
+TEST(ThreadPoolTest, TaskShouldMoveAndReleaseState) {
+    auto state = std::make_shared<int>(0);
+    Task task([state] { (*state)++; });
+    ASSERT_EQ(state.use_count(), 2);
+    Task other(std::move(task));
+    ASSERT_FALSE(task);
+    ASSERT_TRUE(other);
+    other();
+    ASSERT_EQ(*state, 1);
+    other = nullptr;
+    ASSERT_EQ(state.use_count(), 1);
+}
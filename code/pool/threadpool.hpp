@@ -1,71 +1,411 @@
 #pragma once
 
+#include "Task.hpp"
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
-#include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <stdexcept>
 #include <thread>
+#include <utility>
+#include <vector>
 
+// 工作窃取线程池
+// 每个工作线程有自己的任务队列，提交任务时按hint选择一个工作线程（亲和），
+// 同一个hint（如连接的fd）的任务总是先进入同一个队列，
+// 相关数据更可能留在该线程所在核的缓存中。
+// 工作线程优先处理自己的队列，为空时从其他队列窃取，都为空时才睡眠。
+// 每个任务最多唤醒一个睡眠的线程，避免notify_all带来的惊群。
+// 任务以Task保存在只增不减的环形队列中，稳定运行时提交和执行任务都不申请堆内存
+// 线程数可以在[min, max]之间伸缩：工作线程都阻塞（如卡在mysql_query中）
+// 导致任务积压时增加线程，多出来的线程空闲一段时间后退出。
+// 析构时等待队列中的任务执行完，并join所有工作线程
 class ThreadPool {
   public:
+    // 固定大小的线程池
     ThreadPool(const size_t threadpoolsize = 8)
-        : thread_pool(std::make_shared<Pool>()) {
-        for (size_t i = 0; i < threadpoolsize; i++)
-            std::thread([temp_pool = thread_pool] {
-                std::unique_lock<std::mutex> lock(temp_pool->pool_mtx);
-                while (true) {
-                    // 改进：防止虚假唤醒
-                    while (!temp_pool->pool_is_closed
-                           && temp_pool->pool_tasks.empty()) {
-                        temp_pool->pool_cv.wait(lock);
-                    }
-
-                    if (temp_pool->pool_is_closed
-                        && temp_pool->pool_tasks.empty()) {
-                        break;
-                    }
+        : ThreadPool(threadpoolsize, threadpoolsize) {
+    }
 
-                    if (!temp_pool->pool_tasks.empty()) {
-                        auto task = std::move(temp_pool->pool_tasks.front());
-                        temp_pool->pool_tasks.pop();
-                        lock.unlock();
-                        task();
-                        lock.lock();
-                    }
-                }
-            }).detach();
+    // 弹性线程池：常驻minthreads个线程，最多maxthreads个。
+    // 提交任务时若没有空闲线程，且积压任务数达到growdepth，
+    // 或已有growwaitms毫秒没有线程取走任务，就再创建一个工作线程；
+    // 常驻数量之外的线程空闲idlems毫秒后退出
+    ThreadPool(
+        size_t minthreads,
+        size_t maxthreads,
+        int growwaitms = 20,
+        size_t growdepth = 64,
+        int idlems = 30000)
+        : thread_pool(std::make_unique<Pool>(
+            minthreads,
+            maxthreads,
+            growwaitms,
+            growdepth,
+            idlems)) {
+        std::lock_guard<std::mutex> lock(thread_pool->sleep_mtx);
+        for (size_t i = 0; i < thread_pool->min_threads; i++) {
+            thread_pool->spawn();
+        }
     }
     ThreadPool(ThreadPool&) = delete;
     ThreadPool& operator=(const ThreadPool&) = delete;
     ThreadPool(ThreadPool&&) noexcept = delete;
     ThreadPool& operator=(ThreadPool&&) noexcept = delete;
+    // 析构函数：通知关闭，工作线程处理完剩余任务后退出，逐个join
     ~ThreadPool() {
-        thread_pool->pool_is_closed = true;
-        thread_pool->pool_cv.notify_all();
+        std::vector<std::thread> threads;
+        {
+            std::lock_guard<std::mutex> lock(thread_pool->sleep_mtx);
+            thread_pool->pool_is_closed = true;
+            threads.swap(thread_pool->threads);
+        }
+        thread_pool->sleep_cv.notify_all();
+        for (std::thread& thread : threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
     }
 
+    // 提交任务：在工作线程中提交时放入该线程自己的队列，否则轮询选择队列
     template <typename T> void addTask(T&& task) {
+        size_t index;
+        if (localPool() == thread_pool.get()) {
+            index = localIndex();
+        } else {
+            index = thread_pool->next_index.fetch_add(
+                1,
+                std::memory_order_relaxed);
+        }
+        addTask(index, std::forward<T>(task));
+    }
+
+    // 提交任务到hint对应的工作线程队列，hint相同的任务亲和到同一个工作线程
+    template <typename T> void addTask(size_t hint, T&& task) {
+        if (thread_pool->pool_is_closed) {
+            throw std::runtime_error("ThreadPool is closed");
+        }
+        // 只在存活的线程之间分配，线程数变化后同一hint可能换到另一个队列
+        Worker& worker = *thread_pool->workers[hint % size()];
         {
-            std::lock_guard<std::mutex> lock(thread_pool->pool_mtx);
-            if (thread_pool->pool_is_closed) {
-                throw std::runtime_error("ThreadPool is closed");
+            // 在队列锁内增加计数，保证任务被取走前计数已经加上
+            std::lock_guard<std::mutex> lock(worker.worker_mtx);
+            worker.pushBack(Task(std::forward<T>(task)));
+            thread_pool->pending_count++;
+        }
+        // 有线程睡眠时唤醒一个，它会从自己的队列或其他队列中取到这个任务
+        thread_pool->wakeIdle(1);
+        thread_pool->tryGrow();
+    }
+
+    // 批量提交任务：一次加锁放入同一个队列，空闲线程会从中窃取，
+    // 适合提交一轮epoll_wait产生的全部任务；提交后tasks被清空但保留容量
+    void addTasks(std::vector<Task>& tasks) {
+        if (tasks.empty()) {
+            return;
+        }
+        if (thread_pool->pool_is_closed) {
+            throw std::runtime_error("ThreadPool is closed");
+        }
+        size_t index =
+            thread_pool->next_index.fetch_add(1, std::memory_order_relaxed);
+        Worker& worker = *thread_pool->workers[index % size()];
+        {
+            std::lock_guard<std::mutex> lock(worker.worker_mtx);
+            for (Task& task : tasks) {
+                worker.pushBack(std::move(task));
+            }
+            thread_pool->pending_count += tasks.size();
+        }
+        thread_pool->wakeIdle(tasks.size());
+        thread_pool->tryGrow();
+        tasks.clear();
+    }
+
+    // 批量提交带hint的任务（hint, task）：按hint % size()分到各工作线程的队列，
+    // 每个目标队列只加一次锁，与逐个addTask(hint, task)一样保持亲和，
+    // 同一队列中的任务保持提交顺序；提交后tasks被清空但保留容量
+    void addTasks(std::vector<std::pair<size_t, Task>>& tasks) {
+        if (tasks.empty()) {
+            return;
+        }
+        if (thread_pool->pool_is_closed) {
+            throw std::runtime_error("ThreadPool is closed");
+        }
+        // 取一次线程数，本批任务按同一个数量分配
+        size_t num = size();
+        // 每轮取第一个还未放入的任务所在的队列，把剩余任务中属于该队列的
+        // 一并放入；已放入的任务被移走后为空。一轮epoll_wait的任务不多，
+        // 目标队列数又不超过线程数，逐轮扫描比先排序再分组开销更小
+        for (size_t i = 0; i < tasks.size(); i++) {
+            if (!tasks[i].second) {
+                continue;
+            }
+            size_t index = tasks[i].first % num;
+            Worker& worker = *thread_pool->workers[index];
+            std::lock_guard<std::mutex> lock(worker.worker_mtx);
+            for (size_t j = i; j < tasks.size(); j++) {
+                if (tasks[j].second && tasks[j].first % num == index) {
+                    worker.pushBack(std::move(tasks[j].second));
+                    thread_pool->pending_count++;
+                }
             }
-            thread_pool->pool_tasks.emplace(std::forward<T>(task));
         }
-        thread_pool->pool_cv.notify_all();
+        thread_pool->wakeIdle(tasks.size());
+        thread_pool->tryGrow();
+        tasks.clear();
+    }
+
+    // 获取当前存活的工作线程数量
+    size_t size() const {
+        return thread_pool->live_count;
+    }
+
+    // 获取最大工作线程数量
+    size_t maxSize() const {
+        return thread_pool->max_threads;
     }
 
   private:
+    // 工作线程自己的任务队列，调用方需持有worker_mtx
+    class Worker {
+      public:
+        Worker() : worker_tasks(64), worker_head(0), worker_count(0) {
+        }
+
+        // 不加锁读取任务数，只用于窃取时跳过空队列
+        bool empty() const {
+            return worker_count.load(std::memory_order_relaxed) == 0;
+        }
+
+        // 任务放入队尾，队列满时容量翻倍
+        void pushBack(Task&& task) {
+            if (worker_count == worker_tasks.size()) {
+                std::vector<Task> temp(worker_tasks.size() * 2);
+                for (size_t i = 0; i < worker_count; i++) {
+                    temp[i] = std::move(at(i));
+                }
+                worker_tasks.swap(temp);
+                worker_head = 0;
+            }
+            at(worker_count) = std::move(task);
+            worker_count++;
+        }
+
+        // 从队首取出任务
+        bool popFront(Task& task) {
+            if (worker_count == 0) {
+                return false;
+            }
+            task = std::move(at(0));
+            worker_head = (worker_head + 1) & (worker_tasks.size() - 1);
+            worker_count--;
+            return true;
+        }
+
+        // 从队尾取出任务
+        bool popBack(Task& task) {
+            if (worker_count == 0) {
+                return false;
+            }
+            task = std::move(at(worker_count - 1));
+            worker_count--;
+            return true;
+        }
+
+        std::mutex worker_mtx; // 保护队列的互斥锁
+
+      private:
+        // 第i个任务，容量总是2的幂
+        Task& at(size_t i) {
+            return worker_tasks[(worker_head + i) & (worker_tasks.size() - 1)];
+        }
+
+        std::vector<Task> worker_tasks;   // 环形缓冲区，只增不减
+        size_t worker_head;               // 队首下标
+        std::atomic<size_t> worker_count; // 任务数
+    };
+
     class Pool {
       public:
-        Pool() : pool_is_closed(false) {
+        Pool(
+            size_t minthreads,
+            size_t maxthreads,
+            int growwaitms,
+            size_t growdepth,
+            int idlems)
+            : min_threads(minthreads > 0 ? minthreads : 1),
+              max_threads(maxthreads > min_threads ? maxthreads : min_threads),
+              grow_wait_ms(growwaitms), grow_depth(growdepth),
+              idle_ms(idlems), threads(max_threads), pool_is_closed(false),
+              pending_count(0), idle_count(0), live_count(0), next_index(0),
+              last_progress(nowMs()) {
+            // 队列按最大线程数一次建好，线程增减时队列不动
+            for (size_t i = 0; i < max_threads; i++) {
+                workers.emplace_back(std::make_unique<Worker>());
+            }
+        }
+
+        // 工作线程主循环，index为线程编号，也是它自己队列的下标
+        void run(size_t index) {
+            // 记录当前线程所属的线程池和编号，
+            // 工作线程中提交的任务放回自己的队列
+            localPool() = this;
+            localIndex() = index;
+            Task task;
+            while (true) {
+                if (popTask(index, task)) {
+                    task();
+                    task = nullptr;
+                    continue;
+                }
+                // 所有队列都为空，睡眠等待新任务
+                if (!waitTask(index)) {
+                    break;
+                }
+            }
+        }
+
+        // 创建编号为live_count的工作线程，调用方需持有sleep_mtx
+        void spawn() {
+            size_t index = live_count;
+            // 该编号上一次的线程已经空闲退出，回收后再复用
+            if (threads[index].joinable()) {
+                threads[index].join();
+            }
+            threads[index] = std::thread([this, index] { run(index); });
+            live_count++;
+        }
+
+        // 取出一个任务：先取自己队列的队首，再依次从其他队列的队尾窃取
+        bool popTask(size_t index, Task& task) {
+            if (pending_count == 0) {
+                return false;
+            }
+            // 已退出线程的队列中可能还留有任务，所有队列都要检查
+            size_t num = workers.size();
+            for (size_t k = 0; k < num; k++) {
+                Worker& worker = *workers[(index + k) % num];
+                if (worker.empty()) {
+                    continue;
+                }
+                std::lock_guard<std::mutex> lock(worker.worker_mtx);
+                // 自己的队列按提交顺序处理，从另一端窃取以减少与所有者的冲突
+                if (k == 0 ? worker.popFront(task) : worker.popBack(task)) {
+                    pending_count--;
+                    if (max_threads > min_threads) {
+                        last_progress.store(
+                            nowMs(),
+                            std::memory_order_relaxed);
+                    }
+                    return true;
+                }
+            }
+            return false;
         }
-        std::mutex pool_mtx;
-        std::condition_variable pool_cv;
-        std::atomic_bool pool_is_closed;
-        std::queue<std::function<void()>> pool_tasks;
+
+        // 有线程睡眠时最多唤醒num个
+        void wakeIdle(size_t num) {
+            size_t idle = idle_count;
+            if (idle == 0) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(sleep_mtx);
+            }
+            for (size_t i = 0; i < num && i < idle; i++) {
+                sleep_cv.notify_one();
+            }
+        }
+
+        // 没有空闲线程且任务积压或迟迟没有被取走时，增加一个工作线程。
+        // 在提交任务时检查，不需要额外的监控线程
+        void tryGrow() {
+            if (live_count >= max_threads || idle_count > 0
+                || pending_count == 0) {
+                return;
+            }
+            // 距离上次有线程取走任务的时间，近似为队首任务的等待时间
+            int64_t waitms =
+                nowMs() - last_progress.load(std::memory_order_relaxed);
+            if (pending_count < grow_depth && waitms < grow_wait_ms) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(sleep_mtx);
+            if (pool_is_closed || live_count >= max_threads
+                || idle_count > 0) {
+                return;
+            }
+            spawn();
+            // 给新线程留出取任务的时间，避免连续创建
+            last_progress.store(nowMs(), std::memory_order_relaxed);
+        }
+
+        // 没有任务时睡眠，返回false表示线程应退出：
+        // 线程池已关闭且任务已处理完，或者是多出来的线程空闲超时
+        bool waitTask(size_t index) {
+            std::unique_lock<std::mutex> lock(sleep_mtx);
+            // 先登记为空闲再检查任务数，与addTask中先增加任务数再检查空闲数
+            // 配对，保证不会出现任务已提交而没有线程被唤醒的情况
+            idle_count++;
+            while (!pool_is_closed && pending_count == 0) {
+                if (index < min_threads) {
+                    sleep_cv.wait(lock);
+                    continue;
+                }
+                // 只让编号最大的线程退出，存活线程的编号总是[0, live_count)
+                if (sleep_cv.wait_for(
+                        lock,
+                        std::chrono::milliseconds(idle_ms))
+                        == std::cv_status::timeout
+                    && !pool_is_closed && pending_count == 0
+                    && index + 1 == live_count) {
+                    live_count--;
+                    idle_count--;
+                    return false;
+                }
+            }
+            idle_count--;
+            return !(pool_is_closed && pending_count == 0);
+        }
+
+        // 单调时钟的毫秒数
+        static int64_t nowMs() {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+        }
+
+        const size_t min_threads;   // 常驻线程数
+        const size_t max_threads;   // 最大线程数
+        const int64_t grow_wait_ms; // 任务多久没被取走时扩容（毫秒）
+        const size_t grow_depth;    // 积压多少任务时扩容
+        const int idle_ms;          // 多出来的线程空闲多久后退出（毫秒）
+
+        std::vector<std::unique_ptr<Worker>> workers; // 各工作线程的队列
+        std::vector<std::thread> threads; // 各编号的线程，受sleep_mtx保护
+        std::mutex sleep_mtx;             // 睡眠和增减线程用的互斥锁
+        std::condition_variable sleep_cv; // 睡眠用的条件变量
+        std::atomic_bool pool_is_closed;  // 线程池是否关闭
+        std::atomic<size_t> pending_count;  // 尚未取出的任务数
+        std::atomic<size_t> idle_count;     // 睡眠中的线程数
+        std::atomic<size_t> live_count;     // 存活的工作线程数
+        std::atomic<size_t> next_index;     // 轮询提交的下一个队列
+        std::atomic<int64_t> last_progress; // 上次有线程取走任务的时间
     };
-    std::shared_ptr<Pool> thread_pool;
+
+    // 当前工作线程所属的线程池，非工作线程为空
+    static Pool*& localPool() {
+        static thread_local Pool* local_pool = nullptr;
+        return local_pool;
+    }
+    // 当前工作线程的编号
+    static size_t& localIndex() {
+        static thread_local size_t local_index = 0;
+        return local_index;
+    }
+
+    std::unique_ptr<Pool> thread_pool;
 };
\ No newline at end of file
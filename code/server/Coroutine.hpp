@@ -0,0 +1,97 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+// 协程任务：请求处理函数的返回类型
+// 惰性启动，被co_await时才开始执行，结束后恢复等待它的协程，
+// 处理函数因此可以像普通函数一样层层调用。协程帧由CoTask对象持有
+class CoTask {
+  public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type {
+        // 等待本任务结束的协程
+        std::coroutine_handle<> continuation;
+
+        CoTask get_return_object() noexcept {
+            return CoTask(Handle::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+        // 结束时直接转移到等待者，不会因层层恢复而加深调用栈
+        auto final_suspend() noexcept {
+            struct FinalAwaiter {
+                bool await_ready() const noexcept {
+                    return false;
+                }
+                std::coroutine_handle<> await_suspend(Handle h) noexcept {
+                    std::coroutine_handle<> next = h.promise().continuation;
+                    return next ? next : std::noop_coroutine();
+                }
+                void await_resume() const noexcept {
+                }
+            };
+            return FinalAwaiter{};
+        }
+        void return_void() noexcept {
+        }
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+
+    CoTask(CoTask&& other) noexcept
+        : co_handle(std::exchange(other.co_handle, nullptr)) {
+    }
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+    CoTask& operator=(CoTask&&) = delete;
+    ~CoTask() {
+        if (co_handle) {
+            co_handle.destroy();
+        }
+    }
+
+    // 被co_await时启动任务，当前协程挂起直到任务结束
+    bool await_ready() const noexcept {
+        return !co_handle || co_handle.done();
+    }
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<> awaiting) noexcept {
+        co_handle.promise().continuation = awaiting;
+        return co_handle;
+    }
+    void await_resume() const noexcept {
+    }
+
+  private:
+    explicit CoTask(Handle h) : co_handle(h) {
+    }
+
+    Handle co_handle; // 协程帧
+};
+
+// 分离式协程：创建后立即执行，结束时自动释放协程帧
+// 用作每个连接的顶层协程，由事件循环在IO就绪时恢复
+struct CoDetached {
+    struct promise_type {
+        CoDetached get_return_object() noexcept {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept {
+            return {};
+        }
+        void return_void() noexcept {
+        }
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+    };
+};
@@ -13,28 +13,36 @@ Epoller::~Epoller() {
 }
 
 // 向epoll实例添加文件描述符及其监听的事件
-bool Epoller::addFd(int fd, size_t events) {
+bool Epoller::addFd(int fd, size_t events, void* ptr) {
     // 检查文件描述符有效性
     if (fd < 0) {
         return false;
     }
-    // 创建epoll事件结构体并设置
+    // 创建epoll事件结构体并设置，携带指针时分发无需再按fd查找
     struct epoll_event ev {};
-    ev.data.fd = fd;
+    if (ptr) {
+        ev.data.ptr = ptr;
+    } else {
+        ev.data.fd = fd;
+    }
     ev.events = events;
     // 调用epoll_ctl添加文件描述符到epoll实例
     return 0 == epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
 }
 
 // 修改epoll实例中文件描述符的监听事件
-bool Epoller::modFd(int fd, size_t events) {
+bool Epoller::modFd(int fd, size_t events, void* ptr) {
     // 检查文件描述符有效性
     if (fd < 0) {
         return false;
     }
-    // 创建epoll事件结构体并设置
+    // 创建epoll事件结构体并设置，EPOLL_CTL_MOD会整体替换data
     struct epoll_event ev {};
-    ev.data.fd = fd;
+    if (ptr) {
+        ev.data.ptr = ptr;
+    } else {
+        ev.data.fd = fd;
+    }
     ev.events = events;
     // 调用epoll_ctl修改文件描述符的监听事件
     return 0 == epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev);
@@ -70,10 +78,28 @@ int Epoller::getEventFd(size_t i) const {
     return events[i].data.fd;
 }
 
+// 获取第i个事件携带的指针
+void* Epoller::getEventPtr(size_t i) const {
+    // 确保索引在有效范围内
+    assert(i < events.size());
+    // 返回注册时存入的data.ptr
+    return events[i].data.ptr;
+}
+
 // 获取第i个事件的事件类型
 uint32_t Epoller::getEvents(size_t i) const {
     // 确保索引在有效范围内
     assert(i < events.size() && i >= 0);
     // 返回事件类型
     return events[i].events;
-}
\ No newline at end of file
+}
+
+// 获取后端名称
+const char* Epoller::name() const {
+    return "epoll";
+}
+
+// 是否支持真正的边沿触发
+bool Epoller::edgeTriggered() const {
+    return true;
+}
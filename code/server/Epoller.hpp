@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Poller.hpp"
 #include <assert.h>
 #include <fcntl.h>
 #include <sys/epoll.h>
@@ -7,24 +8,30 @@
 #include <vector>
 
 // Epoller类：封装epoll相关操作，负责事件注册、修改、删除及等待
-class Epoller {
+class Epoller : public Poller {
   public:
     // 构造函数，初始化epoll实例和事件数组
     Epoller(int maxevent = 1024);
     // 析构函数，关闭epoll文件描述符
-    ~Epoller();
-    // 向epoll中注册新的文件描述符及其关注的事件
-    bool addFd(int fd, size_t events);
-    // 修改已注册文件描述符的事件类型
-    bool modFd(int fd, size_t events);
+    ~Epoller() override;
+    // 向epoll中注册新的文件描述符及其关注的事件，ptr不为空时存入data.ptr
+    bool addFd(int fd, size_t events, void* ptr = nullptr) override;
+    // 修改已注册文件描述符的事件类型，ptr不为空时存入data.ptr
+    bool modFd(int fd, size_t events, void* ptr = nullptr) override;
     // 从epoll中移除文件描述符
-    bool delDf(int fd);
+    bool delDf(int fd) override;
     // 等待事件发生，返回就绪事件数量
-    int wait(int timeoutms = -1);
+    int wait(int timeoutms = -1) override;
     // 获取第i个就绪事件对应的文件描述符
-    int getEventFd(size_t i) const;
+    int getEventFd(size_t i) const override;
+    // 获取第i个就绪事件的data.ptr
+    void* getEventPtr(size_t i) const override;
     // 获取第i个就绪事件的事件类型
-    uint32_t getEvents(size_t i) const;
+    uint32_t getEvents(size_t i) const override;
+    // 获取后端名称
+    const char* name() const override;
+    // 是否支持真正的边沿触发，epoll支持
+    bool edgeTriggered() const override;
 
   private:
     int epoll_fd;                           // epoll实例的文件描述符
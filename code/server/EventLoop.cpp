@@ -0,0 +1,922 @@
+#include "EventLoop.hpp"
+#include "../log/Log.hpp"
+#include <algorithm>
+#include <errno.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+// 构造函数：创建独占的IO事件后端、定时器和跨线程唤醒用的eventfd
+EventLoop::EventLoop(
+    int loopid,
+    size_t connevent,
+    int timeoutms,
+    ConnSlab* users,
+    HttpConnPool* connpool,
+    ThreadPool* threadpool,
+    BlockingExecutor* executor,
+    const ServerOptions& options)
+    : loop_id(loopid), conn_event(connevent), timeout_ms(timeoutms),
+      header_timeout_ms(options.header_timeout_ms),
+      body_timeout_ms(options.body_timeout_ms),
+      write_timeout_ms(options.write_timeout_ms), check_ms(0),
+      is_quit(false), wakeup_fd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      listen_fd(-1), thread_pool(threadpool), blocking_executor(executor),
+      eager_write(options.eager_write), dual_arm(false),
+      buffer_idle_max(options.buffer_idle_max),
+      pipeline_max(options.pipeline_max),
+      co_mode(options.coroutine && !threadpool),
+      blocking_retry_ms(options.blocking_retry_ms), uring_io(false),
+      io_inflight(0), poller(Poller::newPoller(options.poller_backend)),
+      heap_timer(std::make_unique<HeapTimer>(users->size())), users(users),
+      conn_pool(connpool), loop_tid(std::this_thread::get_id()) {
+    assert(wakeup_fd >= 0 && users && conn_pool);
+    for (int timeout :
+         {timeout_ms, header_timeout_ms, body_timeout_ms, write_timeout_ms}) {
+        if (timeout > 0 && (check_ms == 0 || timeout < check_ms)) {
+            check_ms = timeout;
+        }
+    }
+    // 连接只由本线程处理、连接为ET且后端支持真正的边沿触发时，
+    // 连接常驻注册EPOLLIN|EPOLLOUT，空闲的长连接每个请求都不需要epoll_ctl；
+    // 有线程池时工作线程与本线程可能同时处理同一连接，仍使用ONESHOT。
+    // 连接挂起期间到来的事件会被忽略，恢复后先读一次套接字补上
+    dual_arm = eager_write && !thread_pool && (conn_event & EPOLLET)
+               && poller->edgeTriggered();
+    // 连接只由本线程处理时，后端支持的话以完成方式读写：每个连接同一时刻
+    // 只有一个recv或writev在内核中，期间本线程不改动对应的缓冲区。
+    // 线程池和协程模式仍按就绪通知读写
+    uring_io = !thread_pool && !co_mode && poller->supportsIo();
+    // eventfd使用LT模式，保证每次唤醒都能被读到；
+    // 以成员地址作为事件携带的指针，与连接对象指针区分
+    poller->addFd(wakeup_fd, EPOLLIN, &wakeup_fd);
+}
+
+// 析构函数：结束剩余的连接协程，关闭eventfd
+EventLoop::~EventLoop() {
+    if (co_mode) {
+        // 循环线程已经退出，由析构的线程接管。阻塞任务执行器先于本对象销毁，
+        // 在循环退出后才完成的数据库操作把恢复协程的任务留在了队列中，
+        // 执行它们让协程继续运行，再取消其中又挂起等待IO的协程
+        loop_tid = std::this_thread::get_id();
+        doPendingFunctors();
+        cancelCoroutines();
+    }
+    close(wakeup_fd);
+}
+
+// 运行事件循环，负责本循环上的事件分发和超时处理
+void EventLoop::loop() {
+    int timems = -1;
+    loop_tid = std::this_thread::get_id();
+    LOG_INFO("EventLoop.cpp: 27     EventLoop[%d] start", loop_id);
+    while (!is_quit) {
+        // 获取下一个连接超时的时间
+        timems = heap_timer->getNextTick();
+        // 等待epoll事件，返回就绪事件数量
+        int eventcnt = poller->wait(timems);
+        for (int i = 0; i < eventcnt; i++) {
+            // 事件直接携带注册时的指针，连接事件无需按fd查表
+            void* ptr = poller->getEventPtr(i);
+            uint32_t events = poller->getEvents(i);
+            if (ptr == &listen_fd) {
+                // 有新客户端连接到来，完成方式下内核已经accept好了
+                if (poller->getOp(i) == POLLER_OP::ACCEPT) {
+                    onAccepted(poller->getResult(i));
+                } else {
+                    accept_cb();
+                }
+                continue;
+            } else if (ptr == &wakeup_fd) {
+                // 其他线程投递了任务
+                handleWakeup();
+                continue;
+            }
+            HttpConn* client = static_cast<HttpConn*>(ptr);
+            assert(client);
+            if (co_mode) {
+                // 协程模式下恢复等待该连接的协程
+                wakeConn(client, events);
+                continue;
+            }
+            if (uring_io) {
+                // 完成方式下事件就是提交的recv或writev的结果
+                onIoDone(client, poller->getOp(i), poller->getResult(i));
+                continue;
+            }
+            if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                // 客户端异常断开或出错
+                closeConn(client);
+            } else if (
+                (events & EPOLLOUT)
+                && (!dual_arm || client->toWriteBytes() > 0)) {
+                // 客户端有数据可写（常驻注册时只在有待写数据时处理）
+                dealWrite(client);
+            } else if (events & EPOLLIN) {
+                // 客户端有数据可读
+                dealRead(client);
+            } else if (!dual_arm) {
+                LOG_ERROR("EventLoop.cpp: 57     Unexpected event!");
+            }
+        }
+        // 本轮产生的读写任务按fd亲和批量提交给线程池，每个目标队列加一次锁
+        if (!batch_tasks.empty()) {
+            thread_pool->addTasks(batch_tasks);
+        }
+        // 执行其他线程投递的任务（如主Reactor分发过来的新连接）
+        doPendingFunctors();
+    }
+    if (co_mode) {
+        cancelCoroutines();
+    }
+    if (uring_io) {
+        drainIo();
+    }
+    LOG_INFO("EventLoop.cpp: 63     EventLoop[%d] quit", loop_id);
+}
+
+// 退出事件循环
+void EventLoop::quit() {
+    is_quit = true;
+    wakeup();
+}
+
+// 将任务投递到本循环线程执行
+void EventLoop::queueInLoop(Functor cb) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mtx);
+        pending_functors.emplace_back(std::move(cb));
+    }
+    wakeup();
+}
+
+// 注册监听套接字，完成方式下提交accept请求，不再关注可读事件
+bool EventLoop::addListenFd(
+    int fd, size_t events, Functor acceptcb, AcceptCallback acceptedcb) {
+    assert(fd > 0);
+    listen_fd = fd;
+    accept_cb = std::move(acceptcb);
+    if (uring_io && acceptedcb) {
+        accepted_cb = std::move(acceptedcb);
+        return poller->submitAccept(fd, &listen_fd);
+    }
+    return poller->addFd(fd, events, &listen_fd);
+}
+
+// 添加新客户端连接，初始化HttpConn并注册到epoll和定时器
+void EventLoop::addClient(int fd, const sockaddr_in& addr) {
+    assert(fd > 0 && static_cast<size_t>(fd) < users->size());
+    // 从对象池取出缓冲区已分配好的连接对象，关闭时归还
+    std::unique_ptr<HttpConn>& slot = (*users)[fd];
+    assert(!slot);
+    slot = conn_pool->acquire();
+    HttpConn* client = slot.get();
+    client->httpcnInit(fd, addr);
+    addTimer(client);
+    if (co_mode) {
+        if (static_cast<size_t>(fd) >= co_states.size()) {
+            co_states.resize(fd + 1);
+        }
+        co_states[fd] = CoState{nullptr, false, true, false};
+    }
+    if (uring_io) {
+        // 完成方式下不注册就绪通知，直接提交recv，对端关闭时recv返回0
+        if (static_cast<size_t>(fd) >= io_states.size()) {
+            io_states.resize(fd + 1);
+        }
+        io_states[fd] = IoState{false, false};
+    } else if (dual_arm) {
+        poller->addFd(
+            fd,
+            (conn_event & ~EPOLLONESHOT) | EPOLLIN | EPOLLOUT,
+            client);
+    } else {
+        poller->addFd(fd, EPOLLIN | conn_event, client);
+    }
+    LOG_INFO(
+        "EventLoop.cpp: 111     Client[%d] in loop[%d]",
+        client->getFd(),
+        loop_id);
+    if (co_mode) {
+        // 立即开始处理，读不到数据时挂起等待可读
+        runConn(client);
+    } else if (uring_io) {
+        submitRecv(client);
+    }
+}
+
+// 获取循环编号
+int EventLoop::getLoopId() const {
+    return loop_id;
+}
+
+// 获取IO事件后端名称
+const char* EventLoop::pollerName() const {
+    return poller->name();
+}
+
+// 唤醒事件循环
+void EventLoop::wakeup() {
+    uint64_t one = 1;
+    ssize_t n = write(wakeup_fd, &one, sizeof(one));
+    if (n != sizeof(one)) {
+        LOG_ERROR("EventLoop.cpp: 116     wakeup write %d bytes", n);
+    }
+}
+
+// 读取eventfd，清除唤醒状态
+void EventLoop::handleWakeup() {
+    uint64_t one = 0;
+    ssize_t n = read(wakeup_fd, &one, sizeof(one));
+    if (n != sizeof(one)) {
+        LOG_ERROR("EventLoop.cpp: 125     wakeup read %d bytes", n);
+    }
+}
+
+// 执行待处理任务，交换出来后在锁外执行，缩短持锁时间
+void EventLoop::doPendingFunctors() {
+    {
+        std::lock_guard<std::mutex> lock(pending_mtx);
+        if (pending_functors.empty()) {
+            return;
+        }
+        running_functors.swap(pending_functors);
+    }
+    for (Functor& functor : running_functors) {
+        functor();
+    }
+    // clear()保留容量，下一轮交换回去继续使用
+    running_functors.clear();
+}
+
+// 处理写事件，有线程池时交给线程池，否则在本线程内处理
+void EventLoop::dealWrite(HttpConn* client) {
+    assert(client);
+    if (client->isSuspended()) {
+        // 常驻注册时挂起期间仍可能有事件到来，由resumeConn接手
+        return;
+    }
+    addTimer(client);
+    if (thread_pool) {
+        // 先攒起来，本轮事件处理完后批量提交；
+        // 任务结束前定时器不会写出或关闭该连接
+        client->beginTask();
+        batch_tasks.emplace_back(client->getFd(), [this, client] {
+            onWrite(client);
+            client->endTask();
+        });
+    } else {
+        onWrite(client);
+    }
+}
+
+// 处理读事件，有线程池时交给线程池，否则在本线程内处理
+void EventLoop::dealRead(HttpConn* client) {
+    assert(client);
+    if (client->isSuspended()) {
+        return;
+    }
+    addTimer(client);
+    if (thread_pool) {
+        client->beginTask();
+        batch_tasks.emplace_back(client->getFd(), [this, client] {
+            onRead(client);
+            client->endTask();
+        });
+    } else {
+        onRead(client);
+    }
+}
+
+// 为连接加入超时定时器，到期时间取当前阶段的剩余时间与check_ms中较小的。
+// 阶段只会在处理连接的事件时改变，每个事件到来时都会调用这里，
+// 因此定时器总是不晚于实际的期限到期
+void EventLoop::addTimer(HttpConn* client) {
+    assert(client);
+    if (check_ms <= 0) {
+        return;
+    }
+    int64_t wait = check_ms;
+    int timeout = phaseTimeout(client->phase());
+    if (timeout > 0) {
+        wait = std::clamp<int64_t>(
+            timeout - client->phaseElapsedMs(),
+            0,
+            check_ms);
+    }
+    heap_timer->addTimeNode(
+        client->getFd(),
+        static_cast<size_t>(wait),
+        [this, client] { onTimeout(client); });
+}
+
+// 连接定时器到期，按当前阶段判断是否真的超时
+void EventLoop::onTimeout(HttpConn* client) {
+    if (client->isClose() || client->isSuspended()) {
+        // 挂起期间不计时，恢复时重新加入定时器
+        return;
+    }
+    if (client->isBusy()) {
+        // 线程池任务正在读写该连接，不能同时写出408或关闭它，稍后再检查
+        heap_timer->addTimeNode(
+            client->getFd(),
+            BUSY_RECHECK_MS,
+            [this, client] { onTimeout(client); });
+        return;
+    }
+    HttpConn::PHASE phase = client->phase();
+    int timeout = phaseTimeout(phase);
+    if (timeout <= 0 || client->phaseElapsedMs() < timeout) {
+        addTimer(client);
+        return;
+    }
+    LOG_INFO(
+        "EventLoop.cpp: 262     Client[%d] timeout in phase %d",
+        client->getFd(),
+        static_cast<int>(phase));
+    // 收到了部分请求的慢速客户端得到408，从未发送数据的连接直接关闭
+    if ((phase == HttpConn::PHASE::HEADER || phase == HttpConn::PHASE::BODY)
+        && client->toReadBytes() > 0) {
+        client->respondTimeout();
+    }
+    closeConn(client);
+}
+
+// 获取连接在某个阶段的超时时间
+int EventLoop::phaseTimeout(HttpConn::PHASE phase) const {
+    switch (phase) {
+    case HttpConn::PHASE::HEADER:
+        return header_timeout_ms;
+    case HttpConn::PHASE::BODY:
+        return body_timeout_ms;
+    case HttpConn::PHASE::WRITE:
+        return write_timeout_ms;
+    default:
+        return timeout_ms;
+    }
+}
+
+// 关闭客户端连接，从epoll中移除，释放资源并把对象归还对象池
+void EventLoop::closeConn(HttpConn* client) {
+    assert(client);
+    if (!isInLoopThread()) {
+        // 单Reactor模式下工作线程要求关闭：连接为ONESHOT且未重新注册，
+        // 不会再有事件到来，交给循环线程统一关闭，避免与定时器并发归还
+        queueInLoop([this, client] { closeConn(client); });
+        return;
+    }
+    int fd = client->getFd();
+    std::unique_ptr<HttpConn>& slot = (*users)[fd];
+    if (client->isClose() || slot.get() != client) {
+        // 已被定时器等其他路径关闭
+        return;
+    }
+    if (client->isSuspended()) {
+        // 执行器线程还在使用连接对象，恢复后写响应时会发现连接异常再关闭；
+        // 超时定时器此时已被移除，恢复时重新加入
+        return;
+    }
+    if (client->isBusy()) {
+        // 请求关闭的线程池任务还没有返回，等它结束后再归还对象，
+        // 否则它对连接对象的最后访问会落到被复用的对象上
+        queueInLoop([this, client] { closeConn(client); });
+        return;
+    }
+    if (co_mode && co_states[fd].running) {
+        // 连接协程还在运行：标记为取消，正在等待IO时立即恢复它，
+        // 协程退出后再真正关闭；等待数据库时由数据库操作完成后恢复
+        CoState& state = co_states[fd];
+        state.cancelled = true;
+        if (state.waiter) {
+            // coSleep以连接的定时器节点计时，先删除，到期时不会再恢复协程
+            heap_timer->erase(fd);
+            state.sleeping = false;
+            std::exchange(state.waiter, nullptr).resume();
+        }
+        return;
+    }
+    if (uring_io && io_states[fd].pending) {
+        // 内核还在读写连接的缓冲区：取消未完成的IO，等它的完成事件到来后
+        // 再关闭fd、归还对象，否则内核可能写入已被复用的缓冲区
+        IoState& state = io_states[fd];
+        if (!state.closing) {
+            state.closing = true;
+            heap_timer->erase(fd);
+            poller->cancelIo(fd);
+        }
+        return;
+    }
+    LOG_INFO("EventLoop.cpp: 178     Client[%d] quit!", fd);
+    poller->delDf(fd);
+    heap_timer->erase(fd);
+    // 先腾出槽位再关闭fd：fd关闭后可能立刻被其他循环accept复用
+    std::unique_ptr<HttpConn> conn = std::move(slot);
+    client->httpcnClose();
+    conn_pool->release(std::move(conn));
+}
+
+// 当前线程是否为本循环线程
+bool EventLoop::isInLoopThread() const {
+    return loop_tid == std::this_thread::get_id();
+}
+
+// 读取客户端数据，出错则关闭连接，否则处理请求
+void EventLoop::onRead(HttpConn* client) {
+    assert(client);
+    int ret = -1;
+    int readerror = 0;
+    ret = client->httpcnRead(&readerror);
+    if (ret <= 0 && readerror != EAGAIN) {
+        closeConn(client);
+        return;
+    }
+    if (client->toWriteBytes() > 0) {
+        // 常驻注册时上一个响应可能还没写完，新数据先留在读缓冲区，
+        // 写完后再处理
+        return;
+    }
+    onProcess(client);
+}
+
+// 向客户端发送响应，长连接写完后继续处理下一个请求
+void EventLoop::onWrite(HttpConn* client) {
+    assert(client);
+    // 常驻注册时读写通知可能同时到来而只处理了写，
+    // 写完后要先读一次套接字，否则边沿触发下这部分数据不会再有通知
+    writeResponse(client, dual_arm);
+}
+
+// 写出响应，写完后继续处理长连接上的下一个请求
+void EventLoop::writeResponse(HttpConn* client, bool rereadfirst) {
+    int ret = -1;
+    int writeerror = 0;
+    ret = client->httpcnWrite(&writeerror);
+    if (client->toWriteBytes() == 0) {
+        if (client->isKeepAlive()) {
+            if (rereadfirst) {
+                onRead(client);
+            } else {
+                onProcess(client);
+            }
+            return;
+        }
+    } else if (ret > 0 || writeerror == EAGAIN) {
+        // 内核发送缓冲区已满，等待可写通知后继续写
+        if (!dual_arm) {
+            poller->modFd(client->getFd(), conn_event | EPOLLOUT, client);
+        }
+        return;
+    }
+    closeConn(client);
+}
+
+// 没有待处理的请求时重新关注读事件
+void EventLoop::rearmRead(HttpConn* client) {
+    // 连接开始等待下一个请求，处理大请求时扩出的读缓冲区还给BufferPool
+    client->shrinkBuffer(buffer_idle_max);
+    if (uring_io) {
+        submitRecv(client);
+        return;
+    }
+    // 常驻注册时读事件一直有效
+    if (!dual_arm) {
+        poller->modFd(client->getFd(), conn_event | EPOLLIN, client);
+    }
+}
+
+// 解析请求并生成响应，根据结果切换关注的事件
+void EventLoop::onProcess(HttpConn* client) {
+    if (!client->parse()) {
+        if (dual_arm && client->isReadCapped()) {
+            // 上次只读到当前请求为止，常驻注册时内核中剩下的数据
+            // 不会再有通知，接着读
+            onRead(client);
+            return;
+        }
+        rearmRead(client);
+        return;
+    }
+    if (blocking_executor && client->isBlocking()) {
+        // 登录/注册需要访问数据库，不占用本线程和处理静态文件的线程池
+        suspendConn(client);
+        return;
+    }
+    onRespond(client, false);
+}
+
+// 生成响应并写出，未开启立即写出时注册写事件
+void EventLoop::onRespond(HttpConn* client, bool rereadfirst) {
+    respondPipelined(client);
+    if (uring_io) {
+        // 与下一次等待一起提交，不单独执行writev
+        submitWrite(client);
+    } else if (eager_write) {
+        // 大多数响应一次writev就能写完，省去一次epoll_ctl和epoll_wait
+        writeResponse(client, rereadfirst);
+    } else {
+        poller->modFd(client->getFd(), conn_event | EPOLLOUT, client);
+    }
+}
+
+// 依次生成流水线上各请求的响应，所有响应排在同一个写缓冲区中，
+// 写出时一次writev跨越多个响应的响应头和文件映射区
+void EventLoop::respondPipelined(HttpConn* client) {
+    client->respond();
+    while (client->isKeepAlive()
+           && static_cast<size_t>(client->toWriteBytes()) < pipeline_max
+           && client->parse()) {
+        if (blocking_executor && client->isBlocking()) {
+            // 请求保留在连接中，写完前面的响应后parse()会再次返回它
+            break;
+        }
+        client->respond();
+    }
+}
+
+// 挂起连接，阻塞操作完成或被拒绝后都投递回本循环恢复
+void EventLoop::suspendConn(HttpConn* client) {
+    client->setSuspended(true);
+    blocking_executor->submit(
+        [this, client] {
+            client->runBlocking();
+            queueInLoop([this, client] { resumeConn(client); });
+        },
+        [this, client] {
+            // 执行器队列已满，直接返回503，不再等待数据库
+            client->rejectBlocking();
+            queueInLoop([this, client] { resumeConn(client); });
+        });
+}
+
+// 恢复挂起的连接，重新加入定时器后生成响应
+void EventLoop::resumeConn(HttpConn* client) {
+    client->setSuspended(false);
+    addTimer(client);
+    // 常驻注册时挂起期间的读事件被忽略了，写完后要先读一次套接字
+    onRespond(client, dual_arm);
+}
+
+// 提交一次接收，数据由内核直接读入连接的读缓冲区
+void EventLoop::submitRecv(HttpConn* client) {
+    char* buf = nullptr;
+    size_t len = client->prepareRecv(&buf);
+    if (len == 0 || !poller->submitRecv(client->getFd(), buf, len, client)) {
+        closeConn(client);
+        return;
+    }
+    io_states[client->getFd()].pending = true;
+    io_inflight++;
+}
+
+// 提交一次写出，内核直接从写缓冲区的各内存段写出
+void EventLoop::submitWrite(HttpConn* client) {
+    if (client->toWriteBytes() == 0) {
+        // 写完了（或HTTP/2连接只处理了控制帧），继续处理下一个请求
+        if (client->isKeepAlive()) {
+            onProcess(client);
+        } else {
+            closeConn(client);
+        }
+        return;
+    }
+    int cnt = 0;
+    const iovec* iov = client->prepareWritev(&cnt);
+    if (!poller->submitWritev(client->getFd(), iov, cnt, client)) {
+        closeConn(client);
+        return;
+    }
+    io_states[client->getFd()].pending = true;
+    io_inflight++;
+}
+
+// 处理recv或writev的结果：已要求关闭时完成关闭，
+// 否则与就绪方式读写完成后的处理相同
+void EventLoop::onIoDone(HttpConn* client, POLLER_OP op, int res) {
+    IoState& state = io_states[client->getFd()];
+    assert(state.pending);
+    state.pending = false;
+    io_inflight--;
+    if (state.closing) {
+        // 被取消的IO已经结束，内核不再使用连接的缓冲区
+        state.closing = false;
+        closeConn(client);
+        return;
+    }
+    if (op == POLLER_OP::RECV) {
+        if (res <= 0) {
+            // 对端关闭或出错
+            closeConn(client);
+            return;
+        }
+        client->recvDone(static_cast<size_t>(res));
+        addTimer(client);
+        onProcess(client);
+        return;
+    }
+    if (res < 0) {
+        closeConn(client);
+        return;
+    }
+    client->writevDone(static_cast<size_t>(res));
+    addTimer(client);
+    submitWrite(client);
+}
+
+// accept到新连接：multishot accept不返回对端地址，按fd查询后交给回调
+void EventLoop::onAccepted(int res) {
+    if (res < 0) {
+        LOG_WARN("EventLoop.cpp: 470     accept error: %d", -res);
+        return;
+    }
+    sockaddr_in addr{};
+    socklen_t len = sizeof(addr);
+    getpeername(res, reinterpret_cast<sockaddr*>(&addr), &len);
+    accepted_cb(res, addr);
+}
+
+// 取消所有未完成的IO，收割它们的完成事件，连接随之关闭
+void EventLoop::drainIo() {
+    for (size_t fd = 0; fd < io_states.size(); fd++) {
+        if (io_states[fd].pending) {
+            closeConn((*users)[fd].get());
+        }
+    }
+    while (io_inflight > 0) {
+        int eventcnt = poller->wait(static_cast<int>(DRAIN_WAIT_MS));
+        if (eventcnt <= 0) {
+            LOG_WARN(
+                "EventLoop.cpp: 490     %d IO still in flight",
+                static_cast<int>(io_inflight));
+            break;
+        }
+        for (int i = 0; i < eventcnt; i++) {
+            void* ptr = poller->getEventPtr(i);
+            if (ptr == &listen_fd) {
+                // 退出前刚accept的连接不再处理
+                if (poller->getOp(i) == POLLER_OP::ACCEPT
+                    && poller->getResult(i) >= 0) {
+                    close(poller->getResult(i));
+                }
+            } else if (ptr != &wakeup_fd) {
+                onIoDone(
+                    static_cast<HttpConn*>(ptr),
+                    poller->getOp(i),
+                    poller->getResult(i));
+            }
+        }
+    }
+}
+
+// 获取连接的协程状态
+EventLoop::CoState& EventLoop::coState(HttpConn* client) {
+    return co_states[client->getFd()];
+}
+
+// 取消所有挂起等待IO的连接协程，它们随即运行结束、关闭连接并释放协程帧；
+// 等待数据库的协程由数据库操作完成后恢复
+void EventLoop::cancelCoroutines() {
+    for (size_t fd = 0; fd < co_states.size(); fd++) {
+        if (co_states[fd].running && co_states[fd].waiter) {
+            closeConn((*users)[fd].get());
+        }
+    }
+}
+
+// 连接的顶层协程，serveConn返回即表示连接可以关闭
+CoDetached EventLoop::runConn(HttpConn* client) {
+    co_await serveConn(client);
+    coState(client).running = false;
+    closeConn(client);
+}
+
+// 逐个处理长连接上的请求，读、写和访问数据库都不占用线程。
+// co_await的结果先存入变量再判断，GCC 12会错误编译条件表达式中的co_await
+CoTask EventLoop::serveConn(HttpConn* client) {
+    while (true) {
+        if (!client->parse()) {
+            // 缓冲区中没有请求，读套接字，没有数据时挂起等待可读
+            bool ok = co_await coRead(client);
+            if (!ok) {
+                co_return;
+            }
+            continue;
+        }
+        co_await handleRequest(client);
+        if (coState(client).cancelled) {
+            co_return;
+        }
+        while (client->toWriteBytes() > 0) {
+            bool ok = co_await coWrite(client);
+            if (!ok) {
+                co_return;
+            }
+        }
+        if (!client->isKeepAlive()) {
+            co_return;
+        }
+    }
+}
+
+// 生成响应，登录/注册在阻塞任务执行器中访问数据库，期间本协程挂起。
+// 执行器队列已满时可以coSleep一会儿再提交一次
+CoTask EventLoop::handleRequest(HttpConn* client) {
+    if (client->isBlocking()) {
+        bool accepted = false;
+        for (int attempt = 0;; attempt++) {
+            // 与回调方式相同，等待数据库期间连接挂起，不会被超时关闭，
+            // 恢复后重新加入定时器
+            client->setSuspended(true);
+            accepted =
+                co_await coBlocking([client] { client->runBlocking(); });
+            client->setSuspended(false);
+            addTimer(client);
+            if (accepted || attempt > 0 || blocking_retry_ms <= 0) {
+                break;
+            }
+            bool slept = co_await coSleep(client, blocking_retry_ms);
+            if (!slept) {
+                co_return;
+            }
+        }
+        if (!accepted) {
+            // 执行器队列已满，返回503
+            client->rejectBlocking();
+        }
+    }
+    respondPipelined(client);
+}
+
+// 处理连接上的IO事件：异常时关闭，否则恢复等待IO的协程
+void EventLoop::wakeConn(HttpConn* client, uint32_t events) {
+    if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+        closeConn(client);
+        return;
+    }
+    CoState& state = coState(client);
+    if (!state.waiter || state.sleeping) {
+        // 常驻注册时协程可能正在等待数据库或定时，事件留给它之后的读写处理
+        return;
+    }
+    addTimer(client);
+    std::exchange(state.waiter, nullptr).resume();
+}
+
+// 创建读awaitable
+EventLoop::ReadAwaiter EventLoop::coRead(HttpConn* client) {
+    return ReadAwaiter(this, client);
+}
+
+// 创建写awaitable
+EventLoop::WriteAwaiter EventLoop::coWrite(HttpConn* client) {
+    return WriteAwaiter(this, client);
+}
+
+// 创建定时awaitable
+EventLoop::SleepAwaiter EventLoop::coSleep(HttpConn* client, int timems) {
+    return SleepAwaiter(this, client, timems);
+}
+
+// 创建阻塞操作awaitable
+EventLoop::BlockingAwaiter EventLoop::coBlocking(Task fn) {
+    return BlockingAwaiter(this, std::move(fn));
+}
+
+// 读awaitable构造函数
+EventLoop::ReadAwaiter::ReadAwaiter(EventLoop* loop, HttpConn* client)
+    : rd_loop(loop), rd_client(client), rd_ok(false) {
+}
+
+// 先直接读一次，读到新数据或连接异常时不挂起。
+// 缓冲区中可能留有不完整的请求，只有新数据才值得再解析一次
+bool EventLoop::ReadAwaiter::await_ready() {
+    if (rd_loop->coState(rd_client).cancelled) {
+        return true;
+    }
+    size_t before = rd_client->toReadBytes();
+    int readerror = 0;
+    ssize_t ret = rd_client->httpcnRead(&readerror);
+    if (ret <= 0 && readerror != EAGAIN) {
+        return true;
+    }
+    rd_ok = true;
+    return rd_client->toReadBytes() > before;
+}
+
+// 挂起等待可读
+void EventLoop::ReadAwaiter::await_suspend(std::coroutine_handle<> h) {
+    rd_loop->coState(rd_client).waiter = h;
+    rd_loop->rearmRead(rd_client);
+}
+
+// 被唤醒后由调用方再读一次，这里只报告连接状态
+bool EventLoop::ReadAwaiter::await_resume() {
+    return rd_ok && !rd_loop->coState(rd_client).cancelled;
+}
+
+// 写awaitable构造函数
+EventLoop::WriteAwaiter::WriteAwaiter(EventLoop* loop, HttpConn* client)
+    : wr_loop(loop), wr_client(client), wr_ok(false) {
+}
+
+// 先直接写一次，写完或连接异常时不挂起
+bool EventLoop::WriteAwaiter::await_ready() {
+    if (wr_loop->coState(wr_client).cancelled) {
+        return true;
+    }
+    int writeerror = 0;
+    ssize_t ret = wr_client->httpcnWrite(&writeerror);
+    if (wr_client->toWriteBytes() == 0) {
+        wr_ok = true;
+        return true;
+    }
+    wr_ok = ret > 0 || writeerror == EAGAIN;
+    return !wr_ok;
+}
+
+// 内核发送缓冲区已满，挂起等待可写
+void EventLoop::WriteAwaiter::await_suspend(std::coroutine_handle<> h) {
+    wr_loop->coState(wr_client).waiter = h;
+    if (!wr_loop->dual_arm) {
+        wr_loop->poller->modFd(
+            wr_client->getFd(),
+            wr_loop->conn_event | EPOLLOUT,
+            wr_client);
+    }
+}
+
+// 被唤醒后由调用方继续写，这里只报告连接状态
+bool EventLoop::WriteAwaiter::await_resume() {
+    return wr_ok && !wr_loop->coState(wr_client).cancelled;
+}
+
+// 定时awaitable构造函数
+EventLoop::SleepAwaiter::SleepAwaiter(
+    EventLoop* loop, HttpConn* client, int timems)
+    : sl_loop(loop), sl_client(client), sl_time_ms(timems) {
+}
+
+// 连接已被要求关闭或时长不为正时不挂起
+bool EventLoop::SleepAwaiter::await_ready() const {
+    return sl_loop->coState(sl_client).cancelled || sl_time_ms <= 0;
+}
+
+// 用连接的定时器节点计时，替换掉其中的超时检查，到期时恢复协程并重新
+// 加入超时检查。closeConn取消协程时删除该节点，连接关闭后不会再被恢复
+void EventLoop::SleepAwaiter::await_suspend(std::coroutine_handle<> h) {
+    CoState& state = sl_loop->coState(sl_client);
+    state.waiter = h;
+    state.sleeping = true;
+    sl_loop->heap_timer->addTimeNode(
+        sl_client->getFd(),
+        static_cast<size_t>(sl_time_ms),
+        [loop = sl_loop, client = sl_client] {
+            CoState& slept = loop->coState(client);
+            slept.sleeping = false;
+            loop->addTimer(client);
+            std::exchange(slept.waiter, nullptr).resume();
+        });
+    // 期间不关注读写，只关注对端关闭，以便立即取消
+    if (!sl_loop->dual_arm) {
+        sl_loop->poller->modFd(
+            sl_client->getFd(),
+            sl_loop->conn_event,
+            sl_client);
+    }
+}
+
+// 返回是否睡满了时长，连接被要求关闭时为false
+bool EventLoop::SleepAwaiter::await_resume() const {
+    return !sl_loop->coState(sl_client).cancelled;
+}
+
+// 阻塞操作awaitable构造函数
+EventLoop::BlockingAwaiter::BlockingAwaiter(EventLoop* loop, Task fn)
+    : bk_loop(loop), bk_fn(std::move(fn)), bk_accepted(true) {
+}
+
+// 没有阻塞任务执行器时在当前线程直接执行
+bool EventLoop::BlockingAwaiter::await_ready() {
+    if (bk_loop->blocking_executor) {
+        return false;
+    }
+    bk_fn();
+    return true;
+}
+
+// 交给阻塞任务执行器，完成或被拒绝后都投递回本循环恢复协程；
+// awaitable本身保存在协程帧中，挂起期间一直有效
+void EventLoop::BlockingAwaiter::await_suspend(std::coroutine_handle<> h) {
+    bk_loop->blocking_executor->submit(
+        [this, h] {
+            bk_fn();
+            bk_loop->queueInLoop([h] { h.resume(); });
+        },
+        [this, h] {
+            bk_accepted = false;
+            bk_loop->queueInLoop([h] { h.resume(); });
+        });
+}
+
+// 返回执行器是否接受了该操作
+bool EventLoop::BlockingAwaiter::await_resume() const {
+    return bk_accepted;
+}
@@ -0,0 +1,307 @@
+#pragma once
+
+#include "../http/HttpConn.hpp"
+#include "../http/HttpConnPool.hpp"
+#include "../pool/BlockingExecutor.hpp"
+#include "../pool/threadpool.hpp"
+#include "../timer/HeapTimer.hpp"
+#include "Coroutine.hpp"
+#include "Poller.hpp"
+#include "ServerOptions.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <thread>
+#include <vector>
+
+// EventLoop类：事件循环（one loop per thread）
+// 每个EventLoop独占自己的Epoller、HeapTimer和它负责的那一部分连接。
+// 单Reactor模式下只有一个EventLoop，读写任务交给线程池；
+// 主从Reactor模式下每个子循环运行在独立线程中，
+// 连接的所有处理都在所属线程内完成。
+// 需要访问数据库的请求交给独立的阻塞任务执行器，期间连接挂起，
+// 完成后回到所属循环线程继续处理，数据库变慢不会影响其他请求。
+// 开启协程模式时，每个连接由一个协程从头到尾处理，
+// 读、写、定时和数据库访问都以co_await挂起，由本循环在就绪时恢复。
+// 后端为io_uring且连接只由本线程处理（没有线程池、不是协程模式）时，
+// accept、recv和writev以完成方式提交，内核直接读写连接的缓冲区
+class EventLoop {
+  public:
+    // 投递到事件循环中执行的任务类型，只可移动且不申请堆内存
+    using Functor = Task;
+    // 以fd为下标的连接槽位表，由WebServer预先分配并在所有事件循环间共享，
+    // 每个fd同一时刻只属于一个事件循环，因此各循环只访问自己的槽位。
+    // 连接建立时从对象池取出HttpConn放入槽位，关闭时归还，槽位置空
+    using ConnSlab = std::vector<std::unique_ptr<HttpConn>>;
+    // 完成方式下内核已经accept的新连接交给该回调，参数为fd和对端地址
+    using AcceptCallback = std::function<void(int, const sockaddr_in&)>;
+
+    // 构造函数：loopid为循环编号，connevent为连接的事件模式，
+    // timeoutms为长连接的空闲超时时间，users为连接槽位表，
+    // connpool为HttpConn对象池，
+    // threadpool为空时在本线程内直接处理读写，
+    // executor为空时访问数据库的请求也在处理它的线程内直接执行，
+    // options提供IO事件后端类型、是否立即写出、各阶段超时等运行参数
+    EventLoop(
+        int loopid,
+        size_t connevent,
+        int timeoutms,
+        ConnSlab* users,
+        HttpConnPool* connpool,
+        ThreadPool* threadpool = nullptr,
+        BlockingExecutor* executor = nullptr,
+        const ServerOptions& options = ServerOptions());
+    // 析构函数：结束剩余的连接协程，关闭唤醒描述符。
+    // 协程模式下阻塞任务执行器需要先于本对象销毁
+    ~EventLoop();
+
+    // 运行事件循环，直到quit()被调用
+    void loop();
+    // 退出事件循环，可在任意线程调用
+    void quit();
+    // 将任务投递到本循环所在线程执行，可在任意线程调用
+    void queueInLoop(Functor cb);
+    // 注册监听套接字，可读时调用acceptcb；
+    // 以完成方式accept时改为每个新连接调用一次acceptedcb
+    bool addListenFd(
+        int fd,
+        size_t events,
+        Functor acceptcb,
+        AcceptCallback acceptedcb = nullptr);
+    // 添加新的客户端连接，只能在本循环线程中调用
+    void addClient(int fd, const sockaddr_in& addr);
+    // 获取循环编号
+    int getLoopId() const;
+    // 获取IO事件后端名称
+    const char* pollerName() const;
+
+    class ReadAwaiter;
+    class WriteAwaiter;
+    class SleepAwaiter;
+    class BlockingAwaiter;
+    // 以下awaitable只能在本循环线程的协程中co_await
+    // 读取套接字，没有数据时挂起等待可读；
+    // 结果为false表示连接已关闭、出错或被要求关闭
+    ReadAwaiter coRead(HttpConn* client);
+    // 写出待写数据，内核发送缓冲区满时挂起等待可写，结果含义同coRead
+    WriteAwaiter coWrite(HttpConn* client);
+    // 挂起连接的协程timems毫秒，以连接的定时器节点计时，期间不检查超时，
+    // 只关注对端关闭；结果为false表示连接在此期间被要求关闭
+    SleepAwaiter coSleep(HttpConn* client, int timems);
+    // 在阻塞任务执行器中执行fn（如数据库查询），期间挂起当前协程，
+    // 完成后回到本循环恢复；结果为false表示执行器拒绝了fn
+    BlockingAwaiter coBlocking(Task fn);
+
+    // 读awaitable
+    class ReadAwaiter {
+      public:
+        ReadAwaiter(EventLoop* loop, HttpConn* client);
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> h);
+        bool await_resume();
+
+      private:
+        EventLoop* rd_loop;  // 所属事件循环
+        HttpConn* rd_client; // 读取的连接
+        bool rd_ok;          // 连接是否正常
+    };
+
+    // 写awaitable
+    class WriteAwaiter {
+      public:
+        WriteAwaiter(EventLoop* loop, HttpConn* client);
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> h);
+        bool await_resume();
+
+      private:
+        EventLoop* wr_loop;  // 所属事件循环
+        HttpConn* wr_client; // 写出的连接
+        bool wr_ok;          // 连接是否正常
+    };
+
+    // 定时awaitable
+    class SleepAwaiter {
+      public:
+        SleepAwaiter(EventLoop* loop, HttpConn* client, int timems);
+        bool await_ready() const;
+        void await_suspend(std::coroutine_handle<> h);
+        bool await_resume() const;
+
+      private:
+        EventLoop* sl_loop;  // 所属事件循环
+        HttpConn* sl_client; // 挂起的连接
+        int sl_time_ms;      // 挂起时长（毫秒）
+    };
+
+    // 阻塞操作awaitable
+    class BlockingAwaiter {
+      public:
+        BlockingAwaiter(EventLoop* loop, Task fn);
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> h);
+        bool await_resume() const;
+
+      private:
+        EventLoop* bk_loop; // 所属事件循环
+        Task bk_fn;         // 阻塞操作
+        bool bk_accepted;   // 是否被执行器接受
+    };
+
+  private:
+    // 连接超时时线程池任务还在处理它，隔这么久（毫秒）再检查
+    static constexpr size_t BUSY_RECHECK_MS = 10;
+    // 循环退出时等待被取消的IO结束，超过这么久（毫秒）没有结果就不再等待
+    static constexpr size_t DRAIN_WAIT_MS = 1000;
+
+    // 写eventfd唤醒阻塞在epoll_wait上的循环
+    void wakeup();
+    // 读取eventfd，清除唤醒状态
+    void handleWakeup();
+    // 执行其他线程投递过来的任务
+    void doPendingFunctors();
+    // 处理写事件
+    void dealWrite(HttpConn* client);
+    // 处理读事件
+    void dealRead(HttpConn* client);
+    // 为连接加入超时定时器，已存在时重新设置：在当前阶段的期限到达时到期，
+    // 但最迟check_ms之后到期，阶段随后切换成期限更短的阶段时也不会错过。
+    // 请求头和请求体阶段从阶段开始计时，收到数据不会推迟期限
+    void addTimer(HttpConn* client);
+    // 连接定时器到期：当前阶段的期限还没到时重新加入定时器，否则关闭连接，
+    // 请求头或请求体没有按时收完时先回复408
+    void onTimeout(HttpConn* client);
+    // 获取连接在某个阶段的超时时间（毫秒），不大于0表示不限时
+    int phaseTimeout(HttpConn::PHASE phase) const;
+    // 关闭客户端连接并归还对象池，非本循环线程调用时转交给本循环执行
+    void closeConn(HttpConn* client);
+    // 当前线程是否为本循环线程
+    bool isInLoopThread() const;
+    // 读事件的处理逻辑
+    void onRead(HttpConn* client);
+    // 写事件的处理逻辑
+    void onWrite(HttpConn* client);
+    // 写出响应，写完后继续处理长连接上的下一个请求，
+    // rereadfirst为真时先读一次套接字再处理
+    void writeResponse(HttpConn* client, bool rereadfirst);
+    // 没有待处理的请求时重新关注读事件，并缩小多占的读缓冲区
+    void rearmRead(HttpConn* client);
+    // 解析请求，需要访问数据库的请求挂起连接交给阻塞任务执行器
+    void onProcess(HttpConn* client);
+    // 生成响应并写出，未开启立即写出时注册写事件，
+    // rereadfirst含义同writeResponse
+    void onRespond(HttpConn* client, bool rereadfirst);
+    // 生成响应，再为读缓冲区中已经收完整的后续请求依次生成响应（流水线），
+    // 遇到需要交给阻塞任务执行器的请求时停下，等前面的响应写完后再处理
+    void respondPipelined(HttpConn* client);
+    // 挂起连接，把请求中的阻塞操作交给阻塞任务执行器
+    void suspendConn(HttpConn* client);
+    // 阻塞操作完成或被拒绝后，在本循环线程中恢复连接并生成响应
+    void resumeConn(HttpConn* client);
+
+    // 完成方式下每个连接的IO状态
+    struct IoState {
+        bool pending; // 是否有提交给内核还没完成的recv或writev
+        bool closing; // 是否已要求关闭，等未完成的IO结束后再关闭
+    };
+    // 完成方式下提交一次接收，不需要或无法接收时关闭连接
+    void submitRecv(HttpConn* client);
+    // 完成方式下提交一次写出；已经写完时继续处理长连接上的下一个请求
+    void submitWrite(HttpConn* client);
+    // 完成方式下处理recv或writev的结果，res为字节数或-errno
+    void onIoDone(HttpConn* client, POLLER_OP op, int res);
+    // 完成方式下accept到新连接，res为新连接的fd或-errno
+    void onAccepted(int res);
+    // 循环退出时取消所有未完成的IO，等它们结束并关闭对应的连接
+    void drainIo();
+
+    // 协程模式下每个连接的状态
+    struct CoState {
+        std::coroutine_handle<> waiter; // 等待IO就绪或定时结束的协程
+        bool cancelled;                 // 连接是否被要求关闭
+        bool running;                   // 连接协程是否还在运行
+        bool sleeping;                  // 协程是否在coSleep中
+    };
+    // 获取连接的协程状态
+    CoState& coState(HttpConn* client);
+    // 连接的顶层协程，所有请求处理完后关闭连接
+    CoDetached runConn(HttpConn* client);
+    // 逐个处理长连接上的请求
+    CoTask serveConn(HttpConn* client);
+    // 为一个已解析的请求生成响应，需要访问数据库时挂起
+    CoTask handleRequest(HttpConn* client);
+    // 协程模式下处理连接上的IO事件，恢复等待中的协程
+    void wakeConn(HttpConn* client, uint32_t events);
+    // 循环退出时取消所有挂起等待IO的连接协程
+    void cancelCoroutines();
+
+    // 循环编号
+    int loop_id;
+    // 连接事件类型（ET/LT/ONESHOT等）
+    size_t conn_event;
+    // 长连接空闲等待下一个请求的超时时间（毫秒）
+    int timeout_ms;
+    // 请求头从开始接收到收完的期限（毫秒）
+    int header_timeout_ms;
+    // 请求体从请求头收完到收完的期限（毫秒）
+    int body_timeout_ms;
+    // 写响应时没有任何进展的最长时间（毫秒）
+    int write_timeout_ms;
+    // 连接定时器的最长间隔，即各阶段中最短的超时时间，都不限时为0
+    int check_ms;
+    // 事件循环是否退出
+    std::atomic_bool is_quit;
+    // 用于跨线程唤醒的eventfd
+    int wakeup_fd;
+    // 注册在本循环上的监听套接字，没有则为-1
+    int listen_fd;
+    // 监听套接字可读时的回调
+    Functor accept_cb;
+    // 线程池，为空时读写在本线程内处理
+    ThreadPool* thread_pool;
+    // 阻塞任务执行器，为空时阻塞操作在处理请求的线程内执行
+    BlockingExecutor* blocking_executor;
+    // 是否在生成响应后立即尝试写出，写不完再关注写事件
+    bool eager_write;
+    // 连接是否常驻注册读写两个方向（ET且不带ONESHOT），此时不再需要modFd
+    bool dual_arm;
+    // 连接空闲时读缓冲区最多保留的容量
+    size_t buffer_idle_max;
+    // 流水线上待写出的响应达到该字节数后不再解析后续请求
+    size_t pipeline_max;
+    // 是否以协程处理连接（只在没有线程池时生效）
+    bool co_mode;
+    // 阻塞任务执行器拒绝请求后协程等待多久（毫秒）再提交一次，不大于0不重试
+    int blocking_retry_ms;
+    // 协程模式下各连接的状态，按fd下标访问，按需扩容
+    std::vector<CoState> co_states;
+    // 连接的读写是否以完成方式提交给io_uring
+    bool uring_io;
+    // 完成方式下各连接的IO状态，按fd下标访问，按需扩容
+    std::vector<IoState> io_states;
+    // 完成方式下提交给内核还没完成的recv和writev总数
+    size_t io_inflight;
+    // 完成方式下accept到新连接时的回调
+    AcceptCallback accepted_cb;
+    // 本循环独占的IO事件后端（epoll或io_uring）
+    std::unique_ptr<Poller> poller;
+    // 本循环独占的定时器
+    std::unique_ptr<HeapTimer> heap_timer;
+    // 连接槽位表，按fd直接下标访问，无需哈希
+    ConnSlab* users;
+    // HttpConn对象池，多个循环共享
+    HttpConnPool* conn_pool;
+    // 运行loop()的线程
+    std::thread::id loop_tid;
+    // 保护待执行任务队列的互斥锁
+    std::mutex pending_mtx;
+    // 其他线程投递过来的待执行任务
+    std::vector<Functor> pending_functors;
+    // 正在执行的任务，与pending_functors交换使用，两者的容量都得以复用
+    std::vector<Functor> running_functors;
+    // 本轮事件中要交给线程池的任务及其fd，事件处理完后一次性提交
+    std::vector<std::pair<size_t, Task>> batch_tasks;
+};
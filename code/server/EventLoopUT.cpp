@@ -0,0 +1,546 @@
+#include "EventLoop.hpp"
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <poll.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// 一个响应：状态行和正文
+struct Response {
+    std::string status;
+    std::string body;
+};
+
+} // namespace
+
+// 在独立线程中运行一个事件循环，通过socketpair的一端向它发送请求，
+// 另一端作为连接交给事件循环
+class EventLoopTest : public ::testing::Test {
+  protected:
+    EventLoopTest() : users(4096), conn_pool(4, 1024) {
+        HttpConn::src_dir = "/nonexistent";
+        HttpConn::router = &router;
+        HttpConn::limits = HttpRequest::Limits();
+        HttpConn::h2c = false;
+        router.add("GET", "/seq/:n", [this](HttpRequest&,
+                                            const RouteParams& params,
+                                            RouteReply& reply) {
+            // 记录处理函数执行时前面的响应已经写出了多少字节
+            int queued = 0;
+            ioctl(client_fd, FIONREAD, &queued);
+            std::lock_guard<std::mutex> lock(mtx);
+            written.push_back(queued);
+            reply.content_type = "text/plain";
+            reply.body = std::string(params.get("n"));
+        });
+    }
+
+    ~EventLoopTest() override {
+        stop();
+        if (client_fd >= 0) {
+            close(client_fd);
+        }
+    }
+
+    // 启动事件循环，把socketpair的一端作为连接交给它，另一端留给客户端
+    void start(
+        const ServerOptions& options,
+        size_t connevent = EPOLLONESHOT | EPOLLRDHUP,
+        BlockingExecutor* executor = nullptr) {
+        HttpConn::is_et = connevent & EPOLLET;
+        loop = std::make_unique<EventLoop>(
+            0,
+            connevent,
+            60000,
+            &users,
+            &conn_pool,
+            nullptr,
+            executor,
+            options);
+        loop_thread = std::thread([this] { loop->loop(); });
+        int fds[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+        client_fd = fds[0];
+        server_fd = fds[1];
+        loop->queueInLoop([this] {
+            loop->addClient(server_fd, sockaddr_in{});
+        });
+    }
+
+    // 停止事件循环
+    void stop() {
+        if (loop_thread.joinable()) {
+            loop->quit();
+            loop_thread.join();
+        }
+    }
+
+    // 客户端发送数据
+    void send(const std::string& data) {
+        ASSERT_EQ(
+            write(client_fd, data.data(), data.size()),
+            static_cast<ssize_t>(data.size()));
+    }
+
+    // 最多等待timeout读出一个完整的响应，超时或连接关闭时状态行为空
+    Response recvResponse(std::chrono::milliseconds timeout = 2000ms) {
+        Response response;
+        size_t headerend;
+        while ((headerend = recv_buff.find("\r\n\r\n")) == std::string::npos) {
+            if (!recvMore(timeout)) {
+                return response;
+            }
+        }
+        size_t len = 0;
+        size_t pos = recv_buff.find("Content-length: ");
+        if (pos != std::string::npos && pos < headerend) {
+            len = std::stoul(recv_buff.substr(pos + 16));
+        }
+        while (recv_buff.size() < headerend + 4 + len) {
+            if (!recvMore(timeout)) {
+                return response;
+            }
+        }
+        response.status = recv_buff.substr(0, recv_buff.find("\r\n"));
+        response.body = recv_buff.substr(headerend + 4, len);
+        recv_buff.erase(0, headerend + 4 + len);
+        return response;
+    }
+
+    // 等待并读取更多数据，超时或连接关闭时返回false
+    bool recvMore(std::chrono::milliseconds timeout) {
+        pollfd pfd{client_fd, POLLIN, 0};
+        if (poll(&pfd, 1, static_cast<int>(timeout.count())) <= 0) {
+            return false;
+        }
+        char buf[4096];
+        ssize_t len = read(client_fd, buf, sizeof(buf));
+        if (len <= 0) {
+            return false;
+        }
+        recv_buff.append(buf, len);
+        return true;
+    }
+
+    // 等待num个/seq请求的处理函数执行完，返回各自执行时已经写出的字节数。
+    // 客户端在此之前不读取，写出的响应都留在套接字中
+    std::vector<int> writtenBefore(size_t num) {
+        for (int i = 0; i < 200; i++) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (written.size() >= num) {
+                    return written;
+                }
+            }
+            std::this_thread::sleep_for(10ms);
+        }
+        std::lock_guard<std::mutex> lock(mtx);
+        return written;
+    }
+
+    // 用两个等到release才结束的任务占满单线程、队列长度为1的执行器：
+    // 一个正在执行，一个在队列中
+    void fillExecutor(BlockingExecutor& executor, std::atomic<bool>& release) {
+        for (int i = 0; i < 2; i++) {
+            ASSERT_TRUE(executor.submit([this, &release] {
+                blockers_started++;
+                while (!release) {
+                    std::this_thread::sleep_for(1ms);
+                }
+            }));
+            // 等第一个任务被取走再提交第二个，第二个留在队列中
+            while (i == 0 && blockers_started == 0) {
+                std::this_thread::sleep_for(1ms);
+            }
+        }
+    }
+
+    // 最多等待两秒，直到连接对象归还对象池，返回池中的空闲对象数
+    size_t idleAfterClose() {
+        for (int i = 0; i < 200 && conn_pool.getIdleCount() < 4; i++) {
+            std::this_thread::sleep_for(10ms);
+        }
+        return conn_pool.getIdleCount();
+    }
+
+    EventLoop::ConnSlab users;
+    HttpConnPool conn_pool;
+    Router router;
+    std::unique_ptr<EventLoop> loop;
+    std::thread loop_thread;
+    int client_fd = -1;
+    int server_fd = -1;
+    std::string recv_buff;
+    std::mutex mtx;
+    std::vector<int> written;
+    std::atomic<int> blockers_started{0};
+};
+
+/**
+ * 测试一次到达的多个请求按顺序响应，响应一起生成后再写出，
+ * 没有Connection请求头的HTTP/1.1请求保持连接
+ */
+TEST_F(EventLoopTest, PipelinedRequestsShouldAnswerInOrder) {
+    start(ServerOptions());
+    std::string requests;
+    for (int i = 1; i <= 5; i++) {
+        requests += "GET /seq/" + std::to_string(i) + " HTTP/1.1\r\n\r\n";
+    }
+    send(requests);
+    EXPECT_EQ(writtenBefore(5), std::vector<int>(5, 0));
+    for (int i = 1; i <= 5; i++) {
+        Response response = recvResponse();
+        EXPECT_EQ(response.status, "HTTP/1.1 200 OK");
+        EXPECT_EQ(response.body, std::to_string(i));
+    }
+}
+
+/**
+ * 测试待写出的响应达到pipeline_max后先写出，再处理后面的请求
+ */
+TEST_F(EventLoopTest, PipelineShouldStopAtPipelineMax) {
+    ServerOptions options;
+    options.pipeline_max = 1;
+    start(options);
+    std::string requests;
+    for (int i = 1; i <= 4; i++) {
+        requests += "GET /seq/" + std::to_string(i) + " HTTP/1.1\r\n\r\n";
+    }
+    send(requests);
+    // 第一个响应已经达到上限，之后每个请求都在前一个响应写出后才处理
+    std::vector<int> written = writtenBefore(4);
+    ASSERT_EQ(written.size(), 4u);
+    EXPECT_EQ(written[0], 0);
+    for (size_t i = 1; i < written.size(); i++) {
+        EXPECT_GT(written[i], written[i - 1]);
+    }
+    for (int i = 1; i <= 4; i++) {
+        EXPECT_EQ(recvResponse().body, std::to_string(i));
+    }
+}
+
+/**
+ * 测试流水线在需要阻塞执行器的请求处停下：前面的响应先写出，
+ * 阻塞请求完成后再按顺序响应它和后面的请求
+ */
+TEST_F(EventLoopTest, PipelineShouldStopAtBlockingRequest) {
+    std::atomic<bool> release(false);
+    router.add(
+        "GET",
+        "/block",
+        [&release](HttpRequest&, const RouteParams&, RouteReply& reply) {
+            while (!release) {
+                std::this_thread::sleep_for(1ms);
+            }
+            reply.content_type = "text/plain";
+            reply.body = "block";
+        },
+        true);
+    BlockingExecutor executor(1, 16);
+    start(ServerOptions(), EPOLLONESHOT | EPOLLRDHUP, &executor);
+    send(
+        "GET /seq/1 HTTP/1.1\r\n\r\nGET /block HTTP/1.1\r\n\r\n"
+        "GET /seq/2 HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(recvResponse().body, "1");
+    // 阻塞请求还没完成，后面的请求不能越过它
+    EXPECT_TRUE(recvResponse(100ms).status.empty());
+    release = true;
+    EXPECT_EQ(recvResponse().body, "block");
+    EXPECT_EQ(recvResponse().body, "2");
+    stop();
+}
+
+/**
+ * 测试请求头没有在期限内收完：到期后回复408并关闭连接
+ */
+TEST_F(EventLoopTest, HeaderExpiryShouldAnswer408) {
+    ServerOptions options;
+    options.header_timeout_ms = 100;
+    // 请求头的期限从连接建立时算起
+    auto begin = std::chrono::steady_clock::now();
+    start(options);
+    send("GET /seq/1 HTTP/1.1\r\nHost: ");
+    Response response = recvResponse();
+    EXPECT_EQ(response.status, "HTTP/1.1 408 Request Timeout");
+    // 定时器以毫秒计，允许取整带来的误差
+    EXPECT_GE(std::chrono::steady_clock::now() - begin, 90ms);
+    EXPECT_FALSE(recvMore(2000ms));
+}
+
+/**
+ * 测试请求体没有在期限内收完：请求头收完后开始计时，到期后回复408
+ */
+TEST_F(EventLoopTest, BodyExpiryShouldAnswer408) {
+    ServerOptions options;
+    options.body_timeout_ms = 100;
+    start(options);
+    send("POST /seq/1 HTTP/1.1\r\nContent-Length: 10\r\n\r\n012");
+    Response response = recvResponse();
+    EXPECT_EQ(response.status, "HTTP/1.1 408 Request Timeout");
+    EXPECT_FALSE(recvMore(2000ms));
+    EXPECT_TRUE(writtenBefore(0).empty());
+}
+
+/**
+ * 测试写响应时客户端一直不读取：期限内没有写出任何数据后直接关闭，
+ * 不再追加408响应
+ */
+TEST_F(EventLoopTest, WriteExpiryShouldCloseSilently) {
+    router.add("GET", "/big", [](HttpRequest&, const RouteParams&,
+                                 RouteReply& reply) {
+        reply.content_type = "text/plain";
+        reply.body = std::string(8 * 1024 * 1024, 'x');
+    });
+    ServerOptions options;
+    options.write_timeout_ms = 100;
+    start(options);
+    send("GET /big HTTP/1.1\r\n\r\n");
+    // 等待服务端写满套接字缓冲区并超时关闭，之后再读出已写出的部分
+    std::this_thread::sleep_for(500ms);
+    while (recvMore(2000ms)) {
+    }
+    EXPECT_EQ(recv_buff.compare(0, 15, "HTTP/1.1 200 OK"), 0);
+    EXPECT_LT(recv_buff.size(), 8u * 1024 * 1024);
+    EXPECT_EQ(recv_buff.find("408"), std::string::npos);
+}
+
+/**
+ * 测试协程模式下请求分几次到达：协程挂起等待可读，数据到来后恢复并响应，
+ * 之后继续在同一连接上处理下一个请求
+ */
+TEST_F(EventLoopTest, CoroutineShouldResumeOnReadiness) {
+    ServerOptions options;
+    options.coroutine = true;
+    start(options);
+    send("GET /seq/1 HTTP/1.1\r\n");
+    EXPECT_TRUE(recvResponse(100ms).status.empty());
+    send("\r\n");
+    EXPECT_EQ(recvResponse().body, "1");
+    send("GET /seq/2 HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(recvResponse().body, "2");
+}
+
+/**
+ * 测试协程挂起等待可读时客户端关闭：协程被恢复并结束，连接对象归还对象池
+ */
+TEST_F(EventLoopTest, CoroutineShouldEndWhenClosedWhileSuspended) {
+    ServerOptions options;
+    options.coroutine = true;
+    start(options);
+    send("GET /seq/1 HTTP/1.1\r\n");
+    EXPECT_TRUE(recvResponse(100ms).status.empty());
+    shutdown(client_fd, SHUT_WR);
+    EXPECT_FALSE(recvMore(2000ms));
+    EXPECT_EQ(idleAfterClose(), 4u);
+    EXPECT_TRUE(writtenBefore(0).empty());
+}
+
+/**
+ * 测试循环退出时协程挂起等待可读或可写：协程被取消并结束，
+ * 连接关闭，连接对象归还对象池
+ */
+TEST_F(EventLoopTest, CoroutineShouldEndAtLoopShutdown) {
+    router.add("GET", "/big", [](HttpRequest&, const RouteParams&,
+                                 RouteReply& reply) {
+        reply.content_type = "text/plain";
+        reply.body = std::string(8 * 1024 * 1024, 'x');
+    });
+    for (const char* request :
+         {"GET /seq/1 HTTP/1.1\r\n", "GET /big HTTP/1.1\r\n\r\n"}) {
+        ServerOptions options;
+        options.coroutine = true;
+        start(options);
+        send(request);
+        // 客户端不读取，等待协程挂起
+        std::this_thread::sleep_for(100ms);
+        stop();
+        EXPECT_EQ(conn_pool.getIdleCount(), 4u);
+        EXPECT_FALSE(users[server_fd]);
+        loop.reset();
+        close(client_fd);
+        client_fd = -1;
+        recv_buff.clear();
+    }
+}
+
+/**
+ * 测试循环退出时协程还在等待阻塞任务执行器：执行器销毁后投递的恢复任务
+ * 在事件循环析构时执行，协程写出响应后被取消，连接对象归还对象池
+ */
+TEST_F(EventLoopTest, CoroutineShouldEndAfterBlockingAtShutdown) {
+    std::atomic<bool> release(false);
+    router.add(
+        "GET",
+        "/block",
+        [&release](HttpRequest&, const RouteParams&, RouteReply& reply) {
+            while (!release) {
+                std::this_thread::sleep_for(1ms);
+            }
+            reply.content_type = "text/plain";
+            reply.body = "block";
+        },
+        true);
+    auto executor = std::make_unique<BlockingExecutor>(1, 16);
+    ServerOptions options;
+    options.coroutine = true;
+    start(options, EPOLLONESHOT | EPOLLRDHUP, executor.get());
+    send("GET /block HTTP/1.1\r\n\r\n");
+    std::this_thread::sleep_for(50ms);
+    stop();
+    release = true;
+    executor.reset();
+    EXPECT_EQ(conn_pool.getIdleCount(), 3u);
+    loop.reset();
+    EXPECT_EQ(conn_pool.getIdleCount(), 4u);
+    EXPECT_EQ(recvResponse().body, "block");
+    EXPECT_FALSE(recvMore(2000ms));
+}
+
+/**
+ * 测试阻塞任务执行器已满时协程coSleep后重新提交：执行器在等待期间空出，
+ * 重新提交被接受并正常响应
+ */
+TEST_F(EventLoopTest, CoroutineShouldRetryBlockingAfterSleep) {
+    std::atomic<bool> release(false);
+    router.add(
+        "GET",
+        "/block",
+        [](HttpRequest&, const RouteParams&, RouteReply& reply) {
+            reply.content_type = "text/plain";
+            reply.body = "block";
+        },
+        true);
+    BlockingExecutor executor(1, 1);
+    fillExecutor(executor, release);
+    ServerOptions options;
+    options.coroutine = true;
+    options.blocking_retry_ms = 200;
+    start(options, EPOLLONESHOT | EPOLLRDHUP, &executor);
+    send("GET /block HTTP/1.1\r\n\r\n");
+    // 第一次提交被拒绝，协程等待期间执行器空出
+    EXPECT_TRUE(recvResponse(100ms).status.empty());
+    release = true;
+    Response response = recvResponse();
+    EXPECT_EQ(response.status, "HTTP/1.1 200 OK");
+    EXPECT_EQ(response.body, "block");
+    stop();
+}
+
+/**
+ * 测试协程在coSleep中时客户端关闭：定时器节点被删除，协程立即结束，
+ * 连接对象归还对象池，到期后也不会再恢复已释放的协程帧
+ */
+TEST_F(EventLoopTest, CoroutineShouldEndWhenClosedWhileSleeping) {
+    std::atomic<bool> release(false);
+    std::atomic<bool> handled(false);
+    router.add(
+        "GET",
+        "/block",
+        [&handled](HttpRequest&, const RouteParams&, RouteReply& reply) {
+            handled = true;
+            reply.content_type = "text/plain";
+            reply.body = "block";
+        },
+        true);
+    BlockingExecutor executor(1, 1);
+    fillExecutor(executor, release);
+    ServerOptions options;
+    options.coroutine = true;
+    options.blocking_retry_ms = 300;
+    start(options, EPOLLONESHOT | EPOLLRDHUP, &executor);
+    send("GET /block HTTP/1.1\r\n\r\n");
+    std::this_thread::sleep_for(50ms);
+    auto begin = std::chrono::steady_clock::now();
+    shutdown(client_fd, SHUT_WR);
+    EXPECT_FALSE(recvMore(2000ms));
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, 250ms);
+    EXPECT_EQ(idleAfterClose(), 4u);
+    // 越过原定的到期时间，循环仍正常运行
+    std::this_thread::sleep_for(400ms);
+    stop();
+    release = true;
+    EXPECT_FALSE(handled);
+}
+
+/**
+ * 测试io_uring后端以完成方式读写：分几次到达的请求和流水线请求按顺序响应，
+ * 超过套接字缓冲区的大响应分多次writev写完，之后连接继续处理请求
+ */
+TEST_F(EventLoopTest, UringCompletionShouldServeRequests) {
+    router.add("GET", "/big", [](HttpRequest&, const RouteParams&,
+                                 RouteReply& reply) {
+        reply.content_type = "text/plain";
+        reply.body = std::string(8 * 1024 * 1024, 'x');
+    });
+    ServerOptions options;
+    options.poller_backend = POLLER_BACKEND::IO_URING;
+    start(options);
+    if (std::string(loop->pollerName()) != "io_uring") {
+        GTEST_SKIP() << "io_uring unavailable";
+    }
+    send("GET /seq/1 HTTP/1.1\r\n");
+    EXPECT_TRUE(recvResponse(100ms).status.empty());
+    send("\r\nGET /seq/2 HTTP/1.1\r\n\r\nGET /big HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(recvResponse().body, "1");
+    EXPECT_EQ(recvResponse().body, "2");
+    EXPECT_EQ(recvResponse().body.size(), 8u * 1024 * 1024);
+    send("GET /seq/3 HTTP/1.1\r\n\r\n");
+    EXPECT_EQ(recvResponse().body, "3");
+}
+
+/**
+ * 测试完成方式下recv还在内核中时连接超时：回复408后取消recv，
+ * 等它结束后才关闭连接并归还连接对象
+ */
+TEST_F(EventLoopTest, UringCompletionShouldCloseAfterCancel) {
+    ServerOptions options;
+    options.poller_backend = POLLER_BACKEND::IO_URING;
+    options.header_timeout_ms = 100;
+    start(options);
+    if (std::string(loop->pollerName()) != "io_uring") {
+        GTEST_SKIP() << "io_uring unavailable";
+    }
+    send("GET /seq/1 HTTP/1.1\r\nHost: ");
+    EXPECT_EQ(recvResponse().status, "HTTP/1.1 408 Request Timeout");
+    EXPECT_FALSE(recvMore(2000ms));
+    EXPECT_EQ(idleAfterClose(), 4u);
+}
+
+/**
+ * 测试循环退出时recv或writev还在内核中：取消后等它们结束，
+ * 连接关闭，连接对象归还对象池
+ */
+TEST_F(EventLoopTest, UringCompletionShouldDrainAtLoopShutdown) {
+    router.add("GET", "/big", [](HttpRequest&, const RouteParams&,
+                                 RouteReply& reply) {
+        reply.content_type = "text/plain";
+        reply.body = std::string(8 * 1024 * 1024, 'x');
+    });
+    for (const char* request :
+         {"GET /seq/1 HTTP/1.1\r\n", "GET /big HTTP/1.1\r\n\r\n"}) {
+        ServerOptions options;
+        options.poller_backend = POLLER_BACKEND::IO_URING;
+        start(options);
+        if (std::string(loop->pollerName()) != "io_uring") {
+            GTEST_SKIP() << "io_uring unavailable";
+        }
+        send(request);
+        // 客户端不读取，等待recv或writev挂在内核中
+        std::this_thread::sleep_for(100ms);
+        stop();
+        EXPECT_EQ(conn_pool.getIdleCount(), 4u);
+        EXPECT_FALSE(users[server_fd]);
+        loop.reset();
+        close(client_fd);
+        client_fd = -1;
+        recv_buff.clear();
+    }
+}
@@ -0,0 +1,20 @@
+#include "Poller.hpp"
+#include "Epoller.hpp"
+#include "UringPoller.hpp"
+#include "../log/Log.hpp"
+
+// 创建指定类型的IO事件后端
+std::unique_ptr<Poller>
+Poller::newPoller(POLLER_BACKEND backend, int maxevent) {
+    if (backend == POLLER_BACKEND::IO_URING) {
+        std::unique_ptr<UringPoller> poller =
+            std::make_unique<UringPoller>(maxevent);
+        if (poller->isValid()) {
+            return poller;
+        }
+        // 内核不支持或被禁用（如容器seccomp限制）时退回到epoll
+        LOG_WARN(
+            "Poller.cpp: 16     io_uring unavailable, fall back to epoll");
+    }
+    return std::make_unique<Epoller>(maxevent);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+// IO事件后端类型
+enum class POLLER_BACKEND { EPOLL, IO_URING };
+
+// 完成事件的类型：READY为就绪通知，其余为提交给后端的IO操作已完成
+enum class POLLER_OP { READY, ACCEPT, RECV, WRITEV };
+
+// Poller类：IO多路复用后端的抽象接口
+// 事件类型统一使用EPOLLIN/EPOLLOUT/EPOLLRDHUP/EPOLLONESHOT等epoll标志，
+// EventLoop只依赖这一接口，不关心底层是epoll还是io_uring
+class Poller {
+  public:
+    virtual ~Poller() = default;
+
+    // 创建指定类型的后端，io_uring不可用时自动退回到epoll
+    static std::unique_ptr<Poller>
+    newPoller(POLLER_BACKEND backend, int maxevent = 1024);
+
+    // 向后端中注册新的文件描述符及其关注的事件
+    // ptr不为空时随事件一起返回（如连接对象指针），分发时无需再按fd查表
+    virtual bool addFd(int fd, size_t events, void* ptr = nullptr) = 0;
+    // 修改已注册文件描述符的事件类型，ptr含义同addFd
+    virtual bool modFd(int fd, size_t events, void* ptr = nullptr) = 0;
+    // 从后端中移除文件描述符
+    virtual bool delDf(int fd) = 0;
+    // 等待事件发生，返回就绪事件数量
+    virtual int wait(int timeoutms = -1) = 0;
+    // 获取第i个就绪事件对应的文件描述符（仅适用于注册时未携带ptr的描述符）
+    virtual int getEventFd(size_t i) const = 0;
+    // 获取第i个就绪事件注册时携带的指针
+    virtual void* getEventPtr(size_t i) const = 0;
+    // 获取第i个就绪事件的事件类型
+    virtual uint32_t getEvents(size_t i) const = 0;
+    // 获取后端名称，用于日志输出
+    virtual const char* name() const = 0;
+    // 是否支持真正的边沿触发：不带EPOLLONESHOT常驻注册EPOLLOUT时，
+    // 只在套接字由不可写变为可写时通知一次，不会反复上报
+    virtual bool edgeTriggered() const = 0;
+
+    // 以下为完成方式的IO，只有supportsIo()为真的后端支持，
+    // 其余后端提交时返回false。操作完成后由wait()返回一个事件，
+    // getOp()为操作类型，getResult()为系统调用的返回值（失败时为-errno），
+    // getEventPtr()为提交时的ptr。每个fd同一时刻最多一个RECV和一个WRITEV
+    // 是否支持完成方式的IO
+    virtual bool supportsIo() const {
+        return false;
+    }
+    // 在监听套接字上持续accept，每个新连接一个ACCEPT事件，结果为新的fd
+    virtual bool submitAccept(int fd, void* ptr) {
+        return false;
+    }
+    // 接收最多len字节到buf，完成前buf必须保持有效且不被改动
+    virtual bool submitRecv(int fd, char* buf, size_t len, void* ptr) {
+        return false;
+    }
+    // 写出iov描述的数据，完成前各段数据必须保持有效，iov本身可在返回后释放
+    virtual bool submitWritev(int fd, const iovec* iov, int cnt, void* ptr) {
+        return false;
+    }
+    // 取消fd上未完成的RECV和WRITEV，被取消的操作仍会返回一个事件
+    virtual bool cancelIo(int fd) {
+        return false;
+    }
+    // 获取第i个事件的操作类型
+    virtual POLLER_OP getOp(size_t i) const {
+        return POLLER_OP::READY;
+    }
+    // 获取第i个事件对应操作的结果，就绪通知为0
+    virtual int getResult(size_t i) const {
+        return 0;
+    }
+};
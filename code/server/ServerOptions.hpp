@@ -0,0 +1,94 @@
+#pragma once
+
+#include "../pool/BlockingExecutor.hpp"
+#include "Poller.hpp"
+#include <string>
+
+// ServerOptions结构体：WebServer的可选运行参数
+// 构造函数中的位置参数保持不变，新增的调优开关统一放在这里，均带有默认值
+struct ServerOptions {
+    // 子Reactor（事件循环线程）数量
+    // 0表示单Reactor模式：主线程负责所有IO事件，读写任务交给线程池
+    // 大于0表示主从Reactor模式：主线程只负责accept，连接被分发到各子循环线程
+    int loop_num = 0;
+    // 是否为每个子循环创建一个SO_REUSEPORT监听套接字（仅主从Reactor模式）
+    // 由内核把新连接分散到各个套接字，各子循环直接accept，不再经过主循环
+    bool reuse_port = false;
+    // 是否让各子循环共享一个监听套接字，并以EPOLLEXCLUSIVE方式注册
+    // （仅主从Reactor模式），reuse_port设置失败时也会自动退回到该方式
+    bool exclusive_accept = false;
+    // listen()的backlog，即全连接队列长度
+    int listen_backlog = 1024;
+    // IO事件后端：EPOLL或IO_URING，io_uring不可用时自动退回到epoll。
+    // io_uring下连接只由事件循环线程处理时（主从Reactor或混合分发），
+    // accept、recv和writev以完成方式提交；线程池和协程模式仍按就绪通知读写
+    POLLER_BACKEND poller_backend = POLLER_BACKEND::EPOLL;
+    // HttpConn对象池保留的空闲对象上限，启动时预先创建这么多个
+    size_t conn_pool_size = 1024;
+    // 每个连接读写缓冲区的初始大小（字节）
+    size_t buffer_reserve = 1024;
+    // 连接空闲（等待下一个请求）时读缓冲区最多保留的容量（字节），
+    // 收过大请求的长连接把多出的内存还给BufferPool
+    size_t buffer_idle_max = 16 * 1024;
+    // HTTP/1.1流水线：生成一个响应后，读缓冲区中已经收完整的后续请求接着
+    // 生成响应，一起writev写出，直到待写出数据达到该值（字节）或遇到
+    // 需要访问数据库的请求。0表示每个请求的响应写完后才处理下一个请求
+    size_t pipeline_max = 64 * 1024;
+    // MIME类型配置文件（mime.types格式：每行"类型 后缀1 后缀2 ..."），
+    // 启动时加载，其中的类型追加到内置表或覆盖内置类型。为空表示只用内置表
+    std::string mime_file;
+    // 混合分发（仅单Reactor模式）：读写、解析和静态文件响应都在事件循环线程内
+    // 完成，不再创建线程池；登录/注册这类请求照常交给阻塞任务执行器
+    bool hybrid_dispatch = false;
+    // 生成响应后立即writev，只有内核发送缓冲区满（EAGAIN）时才关注EPOLLOUT。
+    // 连接只由事件循环线程处理（主从Reactor且未开启混合分发）、连接为ET
+    // 且后端为epoll时，连接常驻注册EPOLLIN|EPOLLOUT，不再逐请求epoll_ctl
+    bool eager_write = false;
+    // 线程池最大线程数，大于构造函数中的threadnum时线程池可伸缩：
+    // 常驻threadnum个线程，工作线程都阻塞（如等待数据库）导致任务积压时
+    // 逐个增加到thread_max个，多出来的线程空闲thread_idle_ms毫秒后退出
+    int thread_max = 0;
+    // 没有空闲线程且任务已有这么久（毫秒）没被取走时增加线程
+    int thread_grow_wait_ms = 20;
+    // 没有空闲线程且积压任务数达到该值时增加线程
+    size_t thread_grow_depth = 64;
+    // 多出来的线程空闲多久（毫秒）后退出
+    int thread_idle_ms = 30000;
+    // 阻塞任务执行器（处理登录/注册等访问数据库的请求）的线程数，
+    // 0表示与数据库连接池大小相同
+    int blocking_threads = 0;
+    // 阻塞任务执行器的等待队列上限，超出后按blocking_policy处理
+    size_t blocking_queue = 256;
+    // 阻塞任务执行器队列满时的拒绝策略，默认拒绝新请求并返回503
+    REJECT_POLICY blocking_policy = REJECT_POLICY::REJECT;
+    // 等待空闲数据库连接的最长时间（毫秒），超时返回503，小于0表示一直等待
+    int sql_wait_ms = 1000;
+    // 协程模式：每个连接由一个协程从头到尾处理，读、写和数据库访问都以
+    // co_await挂起而不占用线程，由事件循环在就绪时恢复。单Reactor模式下开启时
+    // 不再创建线程池；同时在途的登录/注册数受blocking_queue限制
+    bool coroutine = false;
+    // 协程模式下阻塞任务执行器拒绝了登录/注册请求时，协程coSleep这么久（毫秒）
+    // 后再提交一次，仍被拒绝才返回503；等待期间不占用线程。不大于0表示立即503
+    int blocking_retry_ms = 0;
+    // 分阶段超时（毫秒），不大于0表示该阶段不限时。长连接等待下一个请求的
+    // 空闲超时仍是构造函数中的timeoutMS。请求头从开始接收（新连接从建立）
+    // 算起、请求体从请求头收完算起，期间收到数据不会推迟期限，
+    // 逐字节慢速发送的客户端到期后收到408并被关闭
+    int header_timeout_ms = 10000;
+    int body_timeout_ms = 30000;
+    // 写响应时这么久（毫秒）没有写出任何数据则关闭连接
+    int write_timeout_ms = 30000;
+    // 请求行的最大长度（字节），超出返回414
+    size_t max_request_line = 8 * 1024;
+    // 请求头的最多个数，超出返回431
+    size_t max_header_count = 100;
+    // 请求头块（请求行、请求头和结束空行）的最大长度（字节），超出返回431。
+    // 请求头还没收完就超出时立即返回，不再等待
+    size_t max_header_bytes = 32 * 1024;
+    // 请求体的最大长度（字节），Content-Length超出时在收到请求体之前返回413
+    size_t max_body_bytes = 8 * 1024 * 1024;
+    // 明文HTTP/2（h2c）：连接以HTTP/2连接前言开始（prior knowledge），
+    // 或无请求体的请求带"Upgrade: h2c"时切换到HTTP/2。一个连接上的多个流
+    // 并发处理，请求大小上限、路由和静态文件与HTTP/1.1相同。默认关闭
+    bool http2 = false;
+};
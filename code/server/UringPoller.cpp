@@ -0,0 +1,542 @@
+#include "UringPoller.hpp"
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// 可以交给poll请求的事件位，EPOLLET/EPOLLONESHOT/EPOLLEXCLUSIVE由本类自行处理
+static const uint32_t POLL_MASK =
+    EPOLLIN | EPOLLPRI | EPOLLOUT | EPOLLERR | EPOLLHUP | EPOLLRDHUP;
+
+// 5.19之前的头文件没有multishot accept，提交后由内核决定是否支持
+#ifndef IORING_ACCEPT_MULTISHOT
+#define IORING_ACCEPT_MULTISHOT (1U << 0)
+#endif
+
+// 构造函数：创建io_uring实例，SQ容量取maxevent向上的2的幂
+UringPoller::UringPoller(int maxevent)
+    : ring_fd(-1), max_event(maxevent), ring_ptr(MAP_FAILED), ring_size(0),
+      sqes(static_cast<struct io_uring_sqe*>(MAP_FAILED)), sqes_size(0),
+      to_submit(0), accept_multishot(true) {
+    assert(maxevent > 0);
+    unsigned entries = 1;
+    while (entries < static_cast<unsigned>(maxevent)) {
+        entries <<= 1;
+    }
+    if (!setupRing(entries)) {
+        if (ring_fd >= 0) {
+            close(ring_fd);
+            ring_fd = -1;
+        }
+    }
+    ready.reserve(max_event);
+}
+
+// 析构函数：解除映射并关闭io_uring实例
+UringPoller::~UringPoller() {
+    if (sqes != MAP_FAILED) {
+        munmap(sqes, sqes_size);
+    }
+    if (ring_ptr != MAP_FAILED) {
+        munmap(ring_ptr, ring_size);
+    }
+    if (ring_fd >= 0) {
+        close(ring_fd);
+    }
+}
+
+// io_uring实例是否创建成功
+bool UringPoller::isValid() const {
+    return ring_fd >= 0;
+}
+
+// 注册新的文件描述符
+bool UringPoller::addFd(int fd, size_t events, void* ptr) {
+    if (fd < 0 || !isValid()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(uring_mtx);
+        FdState& state = stateOf(fd);
+        if (state.armed) {
+            prepPollRemove(fd);
+        }
+        state.ptr = ptr;
+        state.events = static_cast<uint32_t>(events);
+        state.gen++;
+        state.active = true;
+        prepPollAdd(fd);
+    }
+    submitIfForeign();
+    return true;
+}
+
+// 修改已注册描述符的事件，先撤销未完成的poll再按新事件重新提交
+bool UringPoller::modFd(int fd, size_t events, void* ptr) {
+    if (fd < 0 || !isValid()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(uring_mtx);
+        if (static_cast<size_t>(fd) >= fd_states.size()
+            || !fd_states[fd].active) {
+            return false;
+        }
+        FdState& state = fd_states[fd];
+        if (state.armed) {
+            prepPollRemove(fd);
+        }
+        state.ptr = ptr;
+        state.events = static_cast<uint32_t>(events);
+        state.gen++;
+        prepPollAdd(fd);
+    }
+    submitIfForeign();
+    return true;
+}
+
+// 移除文件描述符，撤销未完成的poll请求和持续的accept
+bool UringPoller::delDf(int fd) {
+    if (fd < 0 || !isValid()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(uring_mtx);
+        if (static_cast<size_t>(fd) >= fd_states.size()
+            || (!fd_states[fd].active && !fd_states[fd].accepting)) {
+            return false;
+        }
+        FdState& state = fd_states[fd];
+        if (state.accepting) {
+            state.accepting = false;
+            prepCancel(
+                (static_cast<uint64_t>(POLLER_OP::ACCEPT) << OP_SHIFT)
+                | static_cast<uint32_t>(fd));
+        }
+        if (state.armed) {
+            prepPollRemove(fd);
+        }
+        state.gen++;
+        state.active = false;
+    }
+    submitIfForeign();
+    return true;
+}
+
+// 批量提交积攒的请求并等待完成事件
+int UringPoller::wait(int timeoutms) {
+    unsigned submitnr = 0;
+    {
+        std::lock_guard<std::mutex> lock(uring_mtx);
+        loop_tid = std::this_thread::get_id();
+        submitnr = to_submit;
+        to_submit = 0;
+    }
+    // 一次系统调用完成提交和等待；超时或被信号打断时返回-1，照常收割
+    enter(submitnr, 1, timeoutms);
+    reap();
+    return static_cast<int>(ready.size());
+}
+
+// 获取第i个就绪事件对应的文件描述符
+int UringPoller::getEventFd(size_t i) const {
+    assert(i < ready.size());
+    return ready[i].fd;
+}
+
+// 获取第i个就绪事件注册时携带的指针
+void* UringPoller::getEventPtr(size_t i) const {
+    assert(i < ready.size());
+    return ready[i].ptr;
+}
+
+// 获取第i个就绪事件的事件类型
+uint32_t UringPoller::getEvents(size_t i) const {
+    assert(i < ready.size());
+    return ready[i].events;
+}
+
+// 获取第i个事件的操作类型
+POLLER_OP UringPoller::getOp(size_t i) const {
+    assert(i < ready.size());
+    return ready[i].op;
+}
+
+// 获取第i个事件对应操作的结果
+int UringPoller::getResult(size_t i) const {
+    assert(i < ready.size());
+    return ready[i].res;
+}
+
+// 获取后端名称
+const char* UringPoller::name() const {
+    return "io_uring";
+}
+
+// 是否支持真正的边沿触发
+bool UringPoller::edgeTriggered() const {
+    return false;
+}
+
+// 是否支持完成方式的IO
+bool UringPoller::supportsIo() const {
+    return isValid();
+}
+
+// 在监听套接字上持续accept，新连接随下一次wait一起返回
+bool UringPoller::submitAccept(int fd, void* ptr) {
+    if (fd < 0 || !isValid()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(uring_mtx);
+        FdState& state = stateOf(fd);
+        if (state.accepting) {
+            return false;
+        }
+        state.io_ptr = ptr;
+        state.accepting = true;
+        prepAccept(fd);
+    }
+    submitIfForeign();
+    return true;
+}
+
+// 提交recv，数据由内核直接写入buf
+bool UringPoller::submitRecv(int fd, char* buf, size_t len, void* ptr) {
+    if (fd < 0 || !isValid()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(uring_mtx);
+        FdState& state = stateOf(fd);
+        if (state.receiving) {
+            return false;
+        }
+        struct io_uring_sqe* sqe = getSqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(buf);
+        sqe->len = static_cast<uint32_t>(len);
+        sqe->user_data = (static_cast<uint64_t>(POLLER_OP::RECV) << OP_SHIFT)
+                         | static_cast<uint32_t>(fd);
+        commitSqe();
+        state.io_ptr = ptr;
+        state.receiving = true;
+    }
+    submitIfForeign();
+    return true;
+}
+
+// 提交writev，内核在提交时读取iov，完成前各段数据必须有效
+bool UringPoller::submitWritev(int fd, const iovec* iov, int cnt, void* ptr) {
+    if (fd < 0 || cnt <= 0 || !isValid()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(uring_mtx);
+        FdState& state = stateOf(fd);
+        if (state.writing) {
+            return false;
+        }
+        struct io_uring_sqe* sqe = getSqe();
+        sqe->opcode = IORING_OP_WRITEV;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<uint64_t>(iov);
+        sqe->len = static_cast<uint32_t>(cnt);
+        sqe->user_data =
+            (static_cast<uint64_t>(POLLER_OP::WRITEV) << OP_SHIFT)
+            | static_cast<uint32_t>(fd);
+        commitSqe();
+        state.io_ptr = ptr;
+        state.writing = true;
+    }
+    submitIfForeign();
+    return true;
+}
+
+// 取消fd上未完成的recv和writev，被取消的请求以-ECANCELED完成
+bool UringPoller::cancelIo(int fd) {
+    if (fd < 0 || !isValid()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(uring_mtx);
+        if (static_cast<size_t>(fd) >= fd_states.size()) {
+            return false;
+        }
+        FdState& state = fd_states[fd];
+        for (POLLER_OP op : {POLLER_OP::RECV, POLLER_OP::WRITEV}) {
+            bool pending =
+                op == POLLER_OP::RECV ? state.receiving : state.writing;
+            if (pending) {
+                prepCancel(
+                    (static_cast<uint64_t>(op) << OP_SHIFT)
+                    | static_cast<uint32_t>(fd));
+            }
+        }
+    }
+    submitIfForeign();
+    return true;
+}
+
+// 创建io_uring实例并映射SQ/CQ环形队列和SQE数组
+bool UringPoller::setupRing(unsigned entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // 每个描述符最多有一个未完成的poll，CQ放大一些避免溢出
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * 4;
+    ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd < 0) {
+        return false;
+    }
+    // 需要单次映射（5.4+）和带超时的等待参数（5.11+）
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP)
+        || !(params.features & IORING_FEAT_EXT_ARG)) {
+        return false;
+    }
+
+    size_t sqsize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t cqsize = params.cq_off.cqes
+                    + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring_size = sqsize > cqsize ? sqsize : cqsize;
+    ring_ptr = mmap(
+        nullptr,
+        ring_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        ring_fd,
+        IORING_OFF_SQ_RING);
+    if (ring_ptr == MAP_FAILED) {
+        return false;
+    }
+    sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes = static_cast<struct io_uring_sqe*>(mmap(
+        nullptr,
+        sqes_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        ring_fd,
+        IORING_OFF_SQES));
+    if (sqes == MAP_FAILED) {
+        return false;
+    }
+
+    char* base = static_cast<char*>(ring_ptr);
+    sq_head = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+    sq_entries = params.sq_entries;
+    cq_head = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<struct io_uring_cqe*>(base + params.cq_off.cqes);
+    return true;
+}
+
+// 从SQ中取一个空闲的SQE
+struct io_uring_sqe* UringPoller::getSqe() {
+    unsigned head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    unsigned tail = *sq_tail;
+    if (tail - head >= sq_entries) {
+        // SQ已满，先把已有请求提交给内核
+        enter(to_submit, 0, 0);
+        to_submit = 0;
+    }
+    unsigned index = tail & *sq_mask;
+    struct io_uring_sqe* sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array[index] = index;
+    return sqe;
+}
+
+// 移动SQ尾，SQE随下一次io_uring_enter提交
+void UringPoller::commitSqe() {
+    __atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+    to_submit++;
+}
+
+// 取出fd的状态，新出现的fd按下标扩容
+UringPoller::FdState& UringPoller::stateOf(int fd) {
+    if (static_cast<size_t>(fd) >= fd_states.size()) {
+        fd_states.resize(
+            fd + 1,
+            FdState{nullptr, 0, 0, false, false, nullptr, false, false, false});
+    }
+    return fd_states[fd];
+}
+
+// 为fd准备一个POLL_ADD请求，user_data中携带fd和注册代数
+void UringPoller::prepPollAdd(int fd) {
+    FdState& state = fd_states[fd];
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = state.events & POLL_MASK;
+    sqe->user_data = (static_cast<uint64_t>(state.gen & GEN_MASK) << 32)
+                     | static_cast<uint32_t>(fd);
+    commitSqe();
+    state.armed = true;
+}
+
+// 撤销fd当前未完成的poll请求
+void UringPoller::prepPollRemove(int fd) {
+    FdState& state = fd_states[fd];
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = (static_cast<uint64_t>(state.gen & GEN_MASK) << 32)
+                | static_cast<uint32_t>(fd);
+    sqe->user_data = REMOVE_TAG;
+    commitSqe();
+    state.armed = false;
+}
+
+// 为监听套接字准备accept请求，支持multishot时一次提交持续产出新连接
+void UringPoller::prepAccept(int fd) {
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    if (accept_multishot) {
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    }
+    sqe->user_data = (static_cast<uint64_t>(POLLER_OP::ACCEPT) << OP_SHIFT)
+                     | static_cast<uint32_t>(fd);
+    commitSqe();
+}
+
+// 按user_data撤销一个IO请求，撤销请求本身的完成事件被忽略
+void UringPoller::prepCancel(uint64_t target) {
+    struct io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target;
+    sqe->user_data = REMOVE_TAG;
+    commitSqe();
+}
+
+// 线程池中的工作线程修改注册时，事件循环可能正阻塞在wait中，需要立即提交
+void UringPoller::submitIfForeign() {
+    std::lock_guard<std::mutex> lock(uring_mtx);
+    if (to_submit > 0 && std::this_thread::get_id() != loop_tid) {
+        enter(to_submit, 0, 0);
+        to_submit = 0;
+    }
+}
+
+// 调用io_uring_enter提交请求，并按需等待至少waitnr个完成事件
+int UringPoller::enter(unsigned tosubmit, unsigned waitnr, int timeoutms) {
+    unsigned flags = 0;
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    memset(&arg, 0, sizeof(arg));
+    if (waitnr > 0) {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        arg.sigmask_sz = _NSIG / 8;
+        if (timeoutms >= 0) {
+            ts.tv_sec = timeoutms / 1000;
+            ts.tv_nsec = static_cast<long long>(timeoutms % 1000) * 1000000;
+            arg.ts = reinterpret_cast<uint64_t>(&ts);
+        }
+    }
+    return static_cast<int>(syscall(
+        __NR_io_uring_enter,
+        ring_fd,
+        tosubmit,
+        waitnr,
+        flags,
+        waitnr > 0 ? &arg : nullptr,
+        waitnr > 0 ? sizeof(arg) : 0));
+}
+
+// 收割完成事件：poll请求和IO请求分别处理
+void UringPoller::reap() {
+    std::lock_guard<std::mutex> lock(uring_mtx);
+    ready.clear();
+    unsigned head = *cq_head;
+    unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+    while (head != tail && ready.size() < max_event) {
+        const struct io_uring_cqe& cqe = cqes[head & *cq_mask];
+        head++;
+        if (cqe.user_data == REMOVE_TAG) {
+            continue;
+        }
+        int fd = static_cast<int>(cqe.user_data & 0xffffffffu);
+        if (static_cast<size_t>(fd) >= fd_states.size()) {
+            continue;
+        }
+        POLLER_OP op = static_cast<POLLER_OP>(cqe.user_data >> OP_SHIFT);
+        if (op == POLLER_OP::READY) {
+            reapPoll(
+                cqe,
+                fd,
+                static_cast<uint32_t>(cqe.user_data >> 32) & GEN_MASK);
+        } else {
+            reapIo(cqe, fd, op);
+        }
+    }
+    __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+}
+
+// 收割poll请求：丢弃过期和已撤销的请求，非ONESHOT描述符自动重新提交
+void UringPoller::reapPoll(
+    const struct io_uring_cqe& cqe, int fd, uint32_t gen) {
+    FdState& state = fd_states[fd];
+    if (!state.active || (state.gen & GEN_MASK) != gen) {
+        // 已被modFd/delDf替换的旧请求
+        return;
+    }
+    state.armed = false;
+    if (cqe.res == -ECANCELED) {
+        return;
+    }
+    uint32_t events = cqe.res < 0 ? EPOLLERR : static_cast<uint32_t>(cqe.res);
+    ready.push_back(ReadyEvent{state.ptr, fd, events, POLLER_OP::READY, 0});
+    if (!(state.events & EPOLLONESHOT)) {
+        // 随下一次wait一起提交，相当于水平触发
+        prepPollAdd(fd);
+    }
+}
+
+// 收割IO请求：recv和writev的结果都上报，包括被取消的，
+// 调用方据此确认内核不再使用它的缓冲区；accept在结束时重新提交
+void UringPoller::reapIo(
+    const struct io_uring_cqe& cqe, int fd, POLLER_OP op) {
+    FdState& state = fd_states[fd];
+    if (op == POLLER_OP::RECV) {
+        state.receiving = false;
+    } else if (op == POLLER_OP::WRITEV) {
+        state.writing = false;
+    } else {
+        if (!state.accepting) {
+            // 已被delDf撤销，撤销前刚接受的连接直接关闭
+            if (cqe.res >= 0) {
+                close(cqe.res);
+            }
+            return;
+        }
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            if (cqe.res == -EINVAL && accept_multishot) {
+                // 内核不支持multishot，改为每次完成后重新提交
+                accept_multishot = false;
+                prepAccept(fd);
+                return;
+            }
+            if (cqe.res == -EINVAL || cqe.res == -EBADF
+                || cqe.res == -ENOTSOCK) {
+                // 不是监听套接字，不再重新提交
+                state.accepting = false;
+            } else {
+                prepAccept(fd);
+            }
+        }
+    }
+    ready.push_back(ReadyEvent{state.io_ptr, fd, 0, op, cqe.res});
+}
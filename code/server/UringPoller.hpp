@@ -0,0 +1,139 @@
+#pragma once
+
+#include "Poller.hpp"
+#include <linux/io_uring.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// UringPoller类：基于io_uring的IO事件后端
+// 使用IORING_OP_POLL_ADD提交就绪通知请求，
+// 注册、修改、删除都只是往SQ中放一个SQE，
+// 在wait()中与等待完成事件合并为一次io_uring_enter系统调用批量提交，
+// 省去了epoll方式下每个请求都要执行的epoll_ctl。
+// poll请求本身是一次性的：带EPOLLONESHOT的描述符触发后需要modFd重新注册，
+// 其余描述符在收割完成事件时自动重新提交。
+// 还支持完成方式的IO：accept（内核支持时为multishot，一次提交持续产出
+// 新连接）、recv和writev直接作为SQE提交，与其他请求一起批量进入内核，
+// 完成时数据已经在调用方的缓冲区中，不需要再为每次读写单独执行系统调用
+class UringPoller : public Poller {
+  public:
+    // 构造函数，初始化io_uring实例，maxevent为单次wait返回的最大事件数
+    explicit UringPoller(int maxevent = 1024);
+    // 析构函数，解除映射并关闭io_uring实例
+    ~UringPoller() override;
+
+    // io_uring实例是否创建成功
+    bool isValid() const;
+    // 向io_uring中注册新的文件描述符及其关注的事件
+    bool addFd(int fd, size_t events, void* ptr = nullptr) override;
+    // 修改已注册文件描述符的事件类型
+    bool modFd(int fd, size_t events, void* ptr = nullptr) override;
+    // 移除文件描述符
+    bool delDf(int fd) override;
+    // 提交积攒的SQE并等待完成事件，返回就绪事件数量
+    int wait(int timeoutms = -1) override;
+    // 获取第i个就绪事件对应的文件描述符
+    int getEventFd(size_t i) const override;
+    // 获取第i个就绪事件注册时携带的指针
+    void* getEventPtr(size_t i) const override;
+    // 获取第i个就绪事件的事件类型
+    uint32_t getEvents(size_t i) const override;
+    // 获取后端名称
+    const char* name() const override;
+    // 是否支持真正的边沿触发，poll请求被自动重新提交，相当于水平触发，不支持
+    bool edgeTriggered() const override;
+    // 支持完成方式的IO
+    bool supportsIo() const override;
+    // 提交accept，内核不支持multishot时每完成一次自动重新提交
+    bool submitAccept(int fd, void* ptr) override;
+    // 提交recv
+    bool submitRecv(int fd, char* buf, size_t len, void* ptr) override;
+    // 提交writev，iov在操作完成前必须保持有效
+    bool submitWritev(int fd, const iovec* iov, int cnt, void* ptr) override;
+    // 取消fd上未完成的recv和writev
+    bool cancelIo(int fd) override;
+    // 获取第i个事件的操作类型
+    POLLER_OP getOp(size_t i) const override;
+    // 获取第i个事件对应操作的结果
+    int getResult(size_t i) const override;
+
+  private:
+    // 每个文件描述符的注册状态
+    struct FdState {
+        void* ptr;       // 注册时携带的指针
+        uint32_t events; // 关注的事件（epoll标志）
+        uint32_t gen;    // 注册代数，用于丢弃过期的完成事件
+        bool active;     // 是否处于注册状态
+        bool armed;      // 内核中是否有未完成的poll请求
+        void* io_ptr;    // 完成方式IO提交时携带的指针
+        bool accepting;  // 是否在持续accept
+        bool receiving;  // 内核中是否有未完成的recv
+        bool writing;    // 内核中是否有未完成的writev
+    };
+    // 就绪事件或IO操作的完成事件
+    struct ReadyEvent {
+        void* ptr;       // 注册或提交时携带的指针
+        int fd;          // 文件描述符
+        uint32_t events; // 就绪的事件
+        POLLER_OP op;    // 事件类型
+        int res;         // IO操作的结果
+    };
+
+    // 创建io_uring实例并映射SQ/CQ环形队列
+    bool setupRing(unsigned entries);
+    // 从SQ中取一个空闲的SQE，队列满时先提交，调用方需持有uring_mtx
+    struct io_uring_sqe* getSqe();
+    // 把getSqe()取出并填好的SQE放入SQ，调用方需持有uring_mtx
+    void commitSqe();
+    // 为fd准备一个POLL_ADD请求，调用方需持有uring_mtx
+    void prepPollAdd(int fd);
+    // 撤销fd当前未完成的poll请求，调用方需持有uring_mtx
+    void prepPollRemove(int fd);
+    // 为监听套接字fd准备一个accept请求，调用方需持有uring_mtx
+    void prepAccept(int fd);
+    // 撤销user_data为target的IO请求，调用方需持有uring_mtx
+    void prepCancel(uint64_t target);
+    // 取出fd的状态，不存在时扩容，调用方需持有uring_mtx
+    FdState& stateOf(int fd);
+    // 非事件循环线程修改注册状态时立即提交，保证及时生效
+    void submitIfForeign();
+    // 调用io_uring_enter提交请求，waitnr>0时等待完成事件
+    int enter(unsigned tosubmit, unsigned waitnr, int timeoutms);
+    // 收割CQ中的完成事件
+    void reap();
+
+    // 收割已完成的poll请求
+    void reapPoll(const struct io_uring_cqe& cqe, int fd, uint32_t gen);
+    // 收割已完成的IO请求
+    void reapIo(const struct io_uring_cqe& cqe, int fd, POLLER_OP op);
+
+    // user_data的布局：低32位为fd，32~55位为poll请求的注册代数，
+    // 高8位为请求类型（POLLER_OP），READY即poll请求
+    static constexpr int OP_SHIFT = 56;
+    static constexpr uint32_t GEN_MASK = 0xffffff;
+    // 删除、取消请求完成事件的标记，收割时直接忽略
+    static constexpr uint64_t REMOVE_TAG = ~0ULL;
+
+    int ring_fd;                      // io_uring实例的文件描述符
+    size_t max_event;                 // 单次wait返回的最大事件数
+    void* ring_ptr;                   // SQ/CQ环形队列映射区
+    size_t ring_size;                 // 环形队列映射区大小
+    struct io_uring_sqe* sqes;        // SQE数组映射区
+    size_t sqes_size;                 // SQE数组映射区大小
+    unsigned* sq_head;                // SQ头（内核更新）
+    unsigned* sq_tail;                // SQ尾（用户更新）
+    unsigned* sq_mask;                // SQ下标掩码
+    unsigned* sq_array;               // SQ下标数组
+    unsigned sq_entries;              // SQ容量
+    unsigned* cq_head;                // CQ头（用户更新）
+    unsigned* cq_tail;                // CQ尾（内核更新）
+    unsigned* cq_mask;                // CQ下标掩码
+    struct io_uring_cqe* cqes;        // CQE数组
+    unsigned to_submit;               // 已放入SQ但尚未提交的请求数
+    bool accept_multishot;            // 内核是否支持multishot accept
+    std::thread::id loop_tid;         // 调用wait()的事件循环线程
+    std::vector<FdState> fd_states;   // 以fd为下标的注册状态
+    std::vector<ReadyEvent> ready;    // 本轮就绪事件
+    std::mutex uring_mtx;             // 保护SQ和注册状态的互斥锁
+};
@@ -0,0 +1,174 @@
+#include "UringPoller.hpp"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <gtest/gtest.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// 在一对本地套接字上测试io_uring后端，内核不支持或被禁用时跳过
+class UringPollerTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        if (!poller.isValid()) {
+            GTEST_SKIP() << "io_uring unavailable";
+        }
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    }
+
+    void TearDown() override {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+
+    UringPoller poller;
+    int fds[2] = {-1, -1};
+    int tag1 = 1;
+    int tag2 = 2;
+};
+
+/**
+ * 测试注册、修改和移除：事件携带注册时的指针，修改后按新的事件和指针通知，
+ * 移除后不再通知
+ */
+TEST_F(UringPollerTest, AddModDelShouldTakeEffect) {
+    ASSERT_TRUE(poller.addFd(fds[0], EPOLLIN, &tag1));
+    EXPECT_EQ(poller.wait(50), 0);
+    ASSERT_EQ(write(fds[1], "x", 1), 1);
+    ASSERT_EQ(poller.wait(1000), 1);
+    EXPECT_EQ(poller.getEventPtr(0), &tag1);
+    EXPECT_TRUE(poller.getEvents(0) & EPOLLIN);
+
+    ASSERT_TRUE(poller.modFd(fds[0], EPOLLOUT, &tag2));
+    ASSERT_EQ(poller.wait(1000), 1);
+    EXPECT_EQ(poller.getEventPtr(0), &tag2);
+    EXPECT_EQ(poller.getEvents(0) & (EPOLLIN | EPOLLOUT), EPOLLOUT);
+
+    ASSERT_TRUE(poller.delDf(fds[0]));
+    EXPECT_EQ(poller.wait(50), 0);
+}
+
+/**
+ * 测试EPOLLONESHOT：触发一次后不再通知，modFd重新注册后再次通知
+ */
+TEST_F(UringPollerTest, OneShotShouldNeedRearm) {
+    ASSERT_TRUE(poller.addFd(fds[0], EPOLLIN | EPOLLONESHOT, &tag1));
+    ASSERT_EQ(write(fds[1], "x", 1), 1);
+    ASSERT_EQ(poller.wait(1000), 1);
+    EXPECT_EQ(poller.getEventPtr(0), &tag1);
+    // 数据还没有读走，但请求已经用掉
+    EXPECT_EQ(poller.wait(50), 0);
+    ASSERT_TRUE(poller.modFd(fds[0], EPOLLIN | EPOLLONESHOT, &tag1));
+    ASSERT_EQ(poller.wait(1000), 1);
+    EXPECT_TRUE(poller.getEvents(0) & EPOLLIN);
+}
+
+/**
+ * 测试对端关闭时上报EPOLLRDHUP
+ */
+TEST_F(UringPollerTest, PeerCloseShouldReportRdhup) {
+    ASSERT_TRUE(poller.addFd(fds[0], EPOLLIN | EPOLLRDHUP, &tag1));
+    close(fds[1]);
+    fds[1] = -1;
+    ASSERT_EQ(poller.wait(1000), 1);
+    EXPECT_TRUE(poller.getEvents(0) & EPOLLRDHUP);
+}
+
+/**
+ * 测试recv以完成方式返回：数据直接读入提交时的缓冲区，事件携带提交时的
+ * 指针和读到的字节数，同一fd同时只能有一个recv；对端关闭时结果为0
+ */
+TEST_F(UringPollerTest, RecvShouldCompleteIntoBuffer) {
+    ASSERT_TRUE(poller.supportsIo());
+    char buf[16] = {};
+    ASSERT_TRUE(poller.submitRecv(fds[0], buf, sizeof(buf), &tag1));
+    EXPECT_FALSE(poller.submitRecv(fds[0], buf, sizeof(buf), &tag1));
+    EXPECT_EQ(poller.wait(50), 0);
+    ASSERT_EQ(write(fds[1], "hello", 5), 5);
+    ASSERT_EQ(poller.wait(1000), 1);
+    EXPECT_EQ(poller.getOp(0), POLLER_OP::RECV);
+    EXPECT_EQ(poller.getEventPtr(0), &tag1);
+    EXPECT_EQ(poller.getResult(0), 5);
+    EXPECT_EQ(std::string(buf, 5), "hello");
+
+    ASSERT_TRUE(poller.submitRecv(fds[0], buf, sizeof(buf), &tag1));
+    close(fds[1]);
+    fds[1] = -1;
+    ASSERT_EQ(poller.wait(1000), 1);
+    EXPECT_EQ(poller.getResult(0), 0);
+}
+
+/**
+ * 测试writev以完成方式返回：各段数据按顺序写出，结果为写出的字节数
+ */
+TEST_F(UringPollerTest, WritevShouldComplete) {
+    char first[] = "hello ";
+    char second[] = "world";
+    iovec iov[2] = {{first, 6}, {second, 5}};
+    ASSERT_TRUE(poller.submitWritev(fds[0], iov, 2, &tag2));
+    ASSERT_EQ(poller.wait(1000), 1);
+    EXPECT_EQ(poller.getOp(0), POLLER_OP::WRITEV);
+    EXPECT_EQ(poller.getEventPtr(0), &tag2);
+    EXPECT_EQ(poller.getResult(0), 11);
+    char buf[16];
+    ASSERT_EQ(read(fds[1], buf, sizeof(buf)), 11);
+    EXPECT_EQ(std::string(buf, 11), "hello world");
+}
+
+/**
+ * 测试取消未完成的recv：被取消的请求仍返回一个事件，结果为-ECANCELED，
+ * 之后可以再次提交
+ */
+TEST_F(UringPollerTest, CancelledRecvShouldStillReport) {
+    char buf[16];
+    ASSERT_TRUE(poller.submitRecv(fds[0], buf, sizeof(buf), &tag1));
+    EXPECT_EQ(poller.wait(50), 0);
+    ASSERT_TRUE(poller.cancelIo(fds[0]));
+    ASSERT_EQ(poller.wait(1000), 1);
+    EXPECT_EQ(poller.getOp(0), POLLER_OP::RECV);
+    EXPECT_EQ(poller.getResult(0), -ECANCELED);
+    EXPECT_TRUE(poller.submitRecv(fds[0], buf, sizeof(buf), &tag1));
+}
+
+/**
+ * 测试accept只提交一次就持续产出新连接（内核不支持multishot时自动重新
+ * 提交），移除监听套接字后不再accept
+ */
+TEST_F(UringPollerTest, AcceptShouldKeepProducing) {
+    int listenfd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listenfd, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(bind(listenfd, reinterpret_cast<sockaddr*>(&addr), len), 0);
+    ASSERT_EQ(listen(listenfd, 8), 0);
+    ASSERT_EQ(
+        getsockname(listenfd, reinterpret_cast<sockaddr*>(&addr), &len),
+        0);
+    ASSERT_TRUE(poller.submitAccept(listenfd, &tag1));
+    for (int i = 0; i < 4; i++) {
+        int client = socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_EQ(
+            connect(client, reinterpret_cast<sockaddr*>(&addr), len),
+            0);
+        if (i == 3) {
+            // 最后一次在移除之后连接，留在全连接队列中
+            ASSERT_TRUE(poller.delDf(listenfd));
+            EXPECT_EQ(poller.wait(50), 0);
+            close(client);
+            break;
+        }
+        ASSERT_EQ(poller.wait(1000), 1);
+        EXPECT_EQ(poller.getOp(0), POLLER_OP::ACCEPT);
+        EXPECT_EQ(poller.getEventPtr(0), &tag1);
+        EXPECT_GE(poller.getResult(0), 0);
+        close(poller.getResult(0));
+        close(client);
+    }
+    close(listenfd);
+}
@@ -1,7 +1,11 @@
 #include "WebServer.hpp" // 假设头文件名为 WebServer.hpp
+#include "../buffer/BufferPool.hpp"
+#include "../buffer/ByteScan.hpp"
+#include "../http/MimeTable.hpp"
 #include "../log/Log.hpp"
 #include "../pool/SqlConnPool.hpp"
 #include <errno.h>
+#include <utility>
 
 // 构造函数实现框架（使用成员初始化列表）
 WebServer::WebServer(
@@ -17,11 +21,10 @@ WebServer::WebServer(
     int threadnum,
     bool openlog,
     int loglevel,
-    int logquesize)
+    int logquesize,
+    const ServerOptions& options)
     : ws_port(port), open_linger(optlinger), timeout_ms(timeoutms),
-      is_close(false), heap_timer(std::make_unique<HeapTimer>()),
-      thread_pool(std::make_unique<ThreadPool>(threadnum)),
-      epoller(std::make_unique<Epoller>()) {
+      is_close(false), ws_options(options), users(MAX_FD), next_loop(0) {
     // 设置服务器资源目录路径
     const char* basePath = "/root/Code/MyTinyWebServer/resources";
     src_dir = new char[std::strlen(basePath) + 1];
@@ -30,14 +33,88 @@ WebServer::WebServer(
     // 初始化Http连接相关静态成员变量
     HttpConn::user_count = 0;    // 当前连接用户数
     HttpConn::src_dir = src_dir; // 静态资源目录
+    HttpConn::router = &ws_router; // 路由器
+    // 请求大小上限
+    HttpConn::limits.request_line = ws_options.max_request_line;
+    HttpConn::limits.header_count = ws_options.max_header_count;
+    HttpConn::limits.header_bytes = ws_options.max_header_bytes;
+    HttpConn::limits.body_bytes = ws_options.max_body_bytes;
+    HttpConn::h2c = ws_options.http2; // 是否支持明文HTTP/2
+
+    // 注册默认路由，之后还可以通过router()注册其他接口
+    initRoutes();
+
+    // 加载MIME类型配置文件，必须在开始处理请求之前完成
+    int mimecount = 0;
+    if (!ws_options.mime_file.empty()) {
+        mimecount = MimeTable::loadFile(ws_options.mime_file);
+    }
 
     // 初始化数据库连接池，便于后续高效复用数据库连接
-    SqlConnPool::instance()
-        .initConn("localhost", sqlport, sqluser, sqlpwd, dbname, connpollnum);
+    SqlConnPool::instance().initConn(
+        "localhost",
+        sqlport,
+        sqluser,
+        sqlpwd,
+        dbname,
+        connpollnum,
+        ws_options.sql_wait_ms);
+
+    // 创建阻塞任务执行器，访问数据库的请求与其他请求使用不同的线程
+    blocking_executor = std::make_unique<BlockingExecutor>(
+        ws_options.blocking_threads > 0 ? ws_options.blocking_threads
+                                        : connpollnum,
+        ws_options.blocking_queue,
+        ws_options.blocking_policy);
 
     // 设置epoll事件触发模式（ET/LT等）
     initEventMode(trigmode);
 
+    // 创建HttpConn对象池，预先分配连接对象及其读写缓冲区
+    conn_pool = std::make_unique<HttpConnPool>(
+        ws_options.conn_pool_size,
+        ws_options.buffer_reserve);
+
+    // 创建事件循环：单Reactor模式下主循环处理所有连接，读写交给线程池；
+    // 主从Reactor模式下主循环只负责accept，每个子循环独占一个线程
+    if (ws_options.loop_num > 0) {
+        main_loop = std::make_unique<EventLoop>(
+            -1,
+            conn_event,
+            timeout_ms,
+            &users,
+            conn_pool.get(),
+            nullptr,
+            nullptr,
+            ws_options);
+        for (int i = 0; i < ws_options.loop_num; i++) {
+            sub_loops.emplace_back(std::make_unique<EventLoop>(
+                i,
+                conn_event,
+                timeout_ms,
+                &users,
+                conn_pool.get(),
+                nullptr,
+                blocking_executor.get(),
+                ws_options));
+        }
+    } else {
+        // 混合分发或协程模式下所有非阻塞处理都在主循环线程内完成，
+        // 不需要线程池
+        if (!ws_options.hybrid_dispatch && !ws_options.coroutine) {
+            thread_pool = newThreadPool(threadnum);
+        }
+        main_loop = std::make_unique<EventLoop>(
+            0,
+            conn_event,
+            timeout_ms,
+            &users,
+            conn_pool.get(),
+            thread_pool.get(),
+            blocking_executor.get(),
+            ws_options);
+    }
+
     // 初始化监听套接字，若失败则标记服务器关闭
     if (!initSocket()) {
         is_close = true;
@@ -64,19 +141,102 @@ WebServer::WebServer(
             (conn_event & EPOLLET ? "ET" : "LT"));
         LOG_INFO("WebServer.cpp: 54     LogSys level: %d", loglevel);
         LOG_INFO("WebServer.cpp: 55     srcdir: %s", HttpConn::src_dir);
+        if (mimecount < 0) {
+            LOG_ERROR(
+                "WebServer.cpp: 55     MIME file %s open failed",
+                ws_options.mime_file.c_str());
+        } else if (!ws_options.mime_file.empty()) {
+            LOG_INFO(
+                "WebServer.cpp: 55     MIME file %s: %d types",
+                ws_options.mime_file.c_str(),
+                mimecount);
+        }
+        LOG_INFO(
+            "WebServer.cpp: 56     ByteScan: %s",
+            ByteScan::levelName(ByteScan::level()));
         LOG_INFO(
-            "WebServer.cpp: 56     SqlConnPool num: %d, ThreadPool num: %d",
+            "WebServer.cpp: 56     SqlConnPool num: %d, ThreadPool num: %d, "
+            "max: %d",
             connpollnum,
-            threadnum);
+            thread_pool ? static_cast<int>(thread_pool->size()) : 0,
+            thread_pool ? static_cast<int>(thread_pool->maxSize()) : 0);
+        LOG_INFO(
+            "WebServer.cpp: 60     Reactor Mode: %s, SubLoop num: %d, "
+            "Poller: %s, Dispatch: %s",
+            (sub_loops.empty() ? "single" : "main-sub"),
+            static_cast<int>(sub_loops.size()),
+            main_loop->pollerName(),
+            (thread_pool ? "thread pool"
+                         : (ws_options.coroutine ? "coroutine" : "in loop")));
+        LOG_INFO(
+            "WebServer.cpp: 70     BlockingExecutor threads: %d, queue: %d",
+            static_cast<int>(blocking_executor->size()),
+            static_cast<int>(blocking_executor->capacity()));
+        LOG_INFO(
+            "WebServer.cpp: 66     ConnPool size: %d, buffer reserve: %d, "
+            "idle max: %d, pipeline max: %d",
+            static_cast<int>(ws_options.conn_pool_size),
+            static_cast<int>(ws_options.buffer_reserve),
+            static_cast<int>(ws_options.buffer_idle_max),
+            static_cast<int>(ws_options.pipeline_max));
+        LOG_INFO(
+            "WebServer.cpp: 72     Timeout idle: %d, header: %d, body: %d, "
+            "write: %d",
+            timeout_ms,
+            ws_options.header_timeout_ms,
+            ws_options.body_timeout_ms,
+            ws_options.write_timeout_ms);
+        LOG_INFO(
+            "WebServer.cpp: 74     Limit request line: %zu, headers: %zu, "
+            "header bytes: %zu, body bytes: %zu",
+            ws_options.max_request_line,
+            ws_options.max_header_count,
+            ws_options.max_header_bytes,
+            ws_options.max_body_bytes);
+        LOG_INFO(
+            "WebServer.cpp: 76     HTTP/2 (h2c): %s",
+            HttpConn::h2c ? "on" : "off");
     }
 }
 
 // 析构函数：释放所有分配的资源，确保无内存泄漏
 WebServer::~WebServer() {
+    // 通知子事件循环退出并等待线程结束
+    for (auto& loop : sub_loops) {
+        loop->quit();
+    }
+    for (auto& thread : loop_threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    // 等待线程池中剩余的任务执行完并join工作线程，
+    // 这些任务引用着事件循环和连接，必须先于它们销毁
+    thread_pool.reset();
+    // 执行器中排队的请求按拒绝处理，执行中的等待完成
+    LOG_INFO(
+        "WebServer.cpp: 140     BlockingExecutor rejected: %d",
+        static_cast<int>(blocking_executor->getRejectCount()));
+    blocking_executor.reset();
     // 关闭监听套接字
-    if (listen_fd > 0) {
-        close(listen_fd);
+    for (int fd : listen_fds) {
+        close(fd);
     }
+    LOG_INFO(
+        "WebServer.cpp: 112     ConnPool hit: %d, miss: %d, idle: %d",
+        static_cast<int>(conn_pool->getHitCount()),
+        static_cast<int>(conn_pool->getMissCount()),
+        static_cast<int>(conn_pool->getIdleCount()));
+    BufferPool::Stats bufferstats = BufferPool::stats();
+    LOG_INFO(
+        "WebServer.cpp: 118     BufferPool in use: %dKB/%d blocks, "
+        "cached: %dKB/%d blocks, hit: %d, miss: %d",
+        static_cast<int>(bufferstats.in_use_bytes / 1024),
+        static_cast<int>(bufferstats.in_use_blocks),
+        static_cast<int>(bufferstats.cached_bytes / 1024),
+        static_cast<int>(bufferstats.cached_blocks),
+        static_cast<int>(bufferstats.hit_count),
+        static_cast<int>(bufferstats.miss_count));
     is_close = true;
     // 释放资源目录字符串
     if (src_dir) {
@@ -88,112 +248,239 @@ WebServer::~WebServer() {
 
 // 启动主循环，负责事件分发和处理
 void WebServer::start() {
-    int timems = -1;
-    if (!is_close) {
-        LOG_INFO("WebServer.cpp: 77     ==========Server start==========");
+    if (is_close) {
+        return;
     }
-    while (!is_close) {
-        // 获取下一个定时任务的超时时间（用于连接超时管理）
-        if (timeout_ms > 0) {
-            timems = heap_timer->getNextTick();
-        }
-        // 等待epoll事件，返回就绪事件数量
-        int eventcnt = epoller->wait(timems);
-        for (int i = 0; i < eventcnt; i++) {
-            int fd = epoller->getEventFd(i);
-            size_t events = epoller->getEvents(i);
-            if (fd == listen_fd) {
-                // 有新客户端连接到来
-                dealListen();
-            } else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
-                // 客户端异常断开或出错
-                assert(users.count(fd) > 0);
-                closeConn(&users[fd]);
-            } else if (events & EPOLLIN) {
-                // 客户端有数据可读
-                assert(users.count(fd) > 0);
-                dealRead(&users[fd]);
-            } else if (events & EPOLLOUT) {
-                // 客户端有数据可写
-                assert(users.count(fd) > 0);
-                dealWrite(&users[fd]);
-            } else {
-                LOG_ERROR("WebServer.cpp: 100     Unexpected event!");
+    LOG_INFO("WebServer.cpp: 103     ==========Server start==========");
+    LOG_INFO(
+        "WebServer.cpp: 104     Routes: %d",
+        static_cast<int>(ws_router.size()));
+    // 主从Reactor模式下，每个子循环运行在独立线程中
+    for (auto& loop : sub_loops) {
+        EventLoop* subloop = loop.get();
+        loop_threads.emplace_back([subloop] { subloop->loop(); });
+    }
+    // 主循环运行在当前线程
+    main_loop->loop();
+}
+
+// 获取路由器
+Router& WebServer::router() {
+    return ws_router;
+}
+
+// 注册默认路由：省略了.html后缀的页面改写为实际文件路径，
+// 登录和注册表单访问数据库，交给阻塞任务执行器
+void WebServer::initRoutes() {
+    static constexpr std::pair<const char*, const char*> DEFAULT_HTML[] = {
+        {"/", "/index.html"},
+        {"/index", "/index.html"},
+        {"/register", "/register.html"},
+        {"/login", "/login.html"},
+        {"/welcome", "/welcome.html"},
+        {"/video", "/video.html"},
+        {"/picture", "/picture.html"},
+    };
+    for (const auto& [path, page] : DEFAULT_HTML) {
+        const char* file = page;
+        ws_router.add(
+            Router::ANY,
+            path,
+            [file](HttpRequest& request, const RouteParams&, RouteReply&) {
+                request.path() = file;
+            });
+    }
+
+    // 表单提交到页面本身或省略后缀的路径，验证结果决定返回的页面
+    static constexpr std::pair<const char*, bool> DEFAULT_FORM[] = {
+        {"/register", false},
+        {"/register.html", false},
+        {"/login", true},
+        {"/login.html", true},
+    };
+    for (const auto& [path, islogin] : DEFAULT_FORM) {
+        bool login = islogin;
+        Router::Handler verify = [login](
+                                     HttpRequest& request,
+                                     const RouteParams&,
+                                     RouteReply& reply) {
+            if (!request.verify(login)) {
+                // 数据库不可用
+                reply.code = 503;
             }
-        }
+        };
+        ws_router.add("POST", path, std::move(verify), true);
     }
 }
 
 // 初始化监听套接字，绑定端口并加入epoll
 bool WebServer::initSocket() {
-    int ret;
-    struct sockaddr_in addr;
     // 检查端口合法性
     if (ws_port > 65535 || ws_port < 1024) {
         LOG_ERROR("Port: %d error!", ws_port);
         return false;
     }
+
+    if (!sub_loops.empty() && ws_options.reuse_port) {
+        // 每个子循环一个SO_REUSEPORT监听套接字，由内核在各套接字间分散新连接
+        for (auto& loop : sub_loops) {
+            int fd = createListenFd(true);
+            if (fd < 0) {
+                break;
+            }
+            listen_fds.push_back(fd);
+            EventLoop* subloop = loop.get();
+            if (!subloop->addListenFd(
+                    fd,
+                    listen_event | EPOLLIN,
+                    [this, fd, subloop] { dealListen(fd, subloop); },
+                    [this, subloop](int connfd, const sockaddr_in& addr) {
+                        acceptClient(connfd, addr, subloop);
+                    })) {
+                LOG_ERROR(
+                    "WebServer.cpp: 156     Add listen fd to epoll error!");
+                return false;
+            }
+        }
+        if (listen_fds.size() == sub_loops.size()) {
+            LOG_INFO(
+                "WebServer.cpp: 161     Listen Mode: SO_REUSEPORT x%d",
+                static_cast<int>(listen_fds.size()));
+            return true;
+        }
+        // 内核不支持SO_REUSEPORT时退回到共享监听套接字+EPOLLEXCLUSIVE
+        LOG_WARN(
+            "WebServer.cpp: 165     SO_REUSEPORT unavailable, "
+            "fall back to EPOLLEXCLUSIVE");
+        for (int fd : listen_fds) {
+            close(fd);
+        }
+        listen_fds.clear();
+        ws_options.exclusive_accept = true;
+    }
+
+    int fd = createListenFd(false);
+    if (fd < 0) {
+        return false;
+    }
+    listen_fds.push_back(fd);
+
+    bool ret = true;
+    if (!sub_loops.empty() && ws_options.exclusive_accept) {
+        // 共享监听套接字注册到每个子循环，EPOLLEXCLUSIVE保证一次只唤醒其中一个
+        // EPOLLEXCLUSIVE只能与EPOLLIN/EPOLLOUT/EPOLLET/EPOLLWAKEUP组合使用
+        size_t events = EPOLLIN | EPOLLEXCLUSIVE | (listen_event & EPOLLET);
+        for (auto& loop : sub_loops) {
+            EventLoop* subloop = loop.get();
+            ret = ret
+                  && subloop->addListenFd(
+                      fd,
+                      events,
+                      [this, fd, subloop] { dealListen(fd, subloop); },
+                      [this, subloop](int connfd, const sockaddr_in& addr) {
+                          acceptClient(connfd, addr, subloop);
+                      });
+        }
+        LOG_INFO(
+            "WebServer.cpp: 191     Listen Mode: EPOLLEXCLUSIVE x%d",
+            static_cast<int>(sub_loops.size()));
+    } else {
+        // 监听套接字只注册在主循环：单Reactor模式直接添加连接，
+        // 主从Reactor模式由主循环轮询分发给子循环
+        EventLoop* owner = sub_loops.empty() ? main_loop.get() : nullptr;
+        ret = main_loop->addListenFd(
+            fd,
+            listen_event | EPOLLIN,
+            [this, fd, owner] { dealListen(fd, owner); },
+            [this, owner](int connfd, const sockaddr_in& addr) {
+                acceptClient(connfd, addr, owner);
+            });
+    }
+    if (!ret) {
+        LOG_ERROR("WebServer.cpp: 202     Add listen fd to epoll error!");
+        return false;
+    }
+    return true;
+}
+
+// 创建、绑定并监听一个套接字，失败返回-1
+int WebServer::createListenFd(bool reuseport) {
+    int ret;
+    struct sockaddr_in addr;
     addr.sin_family = AF_INET;
     addr.sin_port = htons(ws_port);
     addr.sin_addr.s_addr = htonl(INADDR_ANY);
 
-    struct linger optlinger {};
+    // 创建socket文件描述符
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        LOG_ERROR(
+            "WebServer.cpp: 220     Create socket error! port: %d",
+            ws_port);
+        return -1;
+    }
+
     if (open_linger) {
         // 设置优雅关闭，延迟关闭连接
+        struct linger optlinger {};
         optlinger.l_onoff = 1;
         optlinger.l_linger = 1;
-    }
-
-    // 创建socket文件描述符
-    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (listen_fd < 0) {
-        LOG_ERROR(
-            "WebServer.cpp: 125     Create socket error! port: %d",
-            ws_port);
-        return false;
+        ret = setsockopt(
+            fd,
+            SOL_SOCKET,
+            SO_LINGER,
+            &optlinger,
+            sizeof(optlinger));
+        if (ret == -1) {
+            LOG_ERROR("WebServer.cpp: 237     set socket linger error!");
+            close(fd);
+            return -1;
+        }
     }
 
     // 设置端口复用，避免TIME_WAIT导致的端口占用
-    ret = setsockopt(
-        listen_fd,
-        SOL_SOCKET,
-        SO_REUSEADDR,
-        (const void*)&optlinger,
-        sizeof(int));
+    int optval = 1;
+    ret = setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
     if (ret == -1) {
-        LOG_ERROR("WebServer.cpp: 130     set socket setsockopt error!");
-        close(listen_fd);
-        return false;
+        LOG_ERROR("WebServer.cpp: 247     set socket setsockopt error!");
+        close(fd);
+        return -1;
     }
 
-    // 绑定本地地址和端口
-    ret = bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr));
-    if (ret < 0) {
-        LOG_ERROR("WebServer.cpp: 136     Bind Port: %d error!", ws_port);
-        close(listen_fd);
-        return false;
+    // 多个套接字绑定同一端口，由内核做连接的负载均衡
+    if (reuseport) {
+        ret =
+            setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof(optval));
+        if (ret == -1) {
+            LOG_WARN("WebServer.cpp: 257     set SO_REUSEPORT error!");
+            close(fd);
+            return -1;
+        }
     }
 
-    // 开始监听，最大连接数为6
-    ret = listen(listen_fd, 6);
+    // 绑定本地地址和端口
+    ret = bind(fd, (struct sockaddr*)&addr, sizeof(addr));
     if (ret < 0) {
-        LOG_ERROR("WebServer.cpp: 142     Listen port: %d error!", ws_port);
-        close(listen_fd);
-        return false;
+        LOG_ERROR("WebServer.cpp: 266     Bind Port: %d error!", ws_port);
+        close(fd);
+        return -1;
     }
 
-    // 将监听fd加入epoll监听
-    ret = epoller->addFd(listen_fd, listen_event | EPOLLIN);
+    // 开始监听，backlog决定全连接队列长度，过小会在突发连接时丢弃SYN
+    ret = listen(fd, ws_options.listen_backlog);
     if (ret < 0) {
-        LOG_ERROR("WebServer.cpp: 148     Add listen fd to epoll error!");
-        close(listen_fd);
-        return false;
+        LOG_ERROR("WebServer.cpp: 274     Listen port: %d error!", ws_port);
+        close(fd);
+        return -1;
     }
 
     // 设置监听fd为非阻塞模式
-    setFdNonBlock(listen_fd);
-    LOG_INFO("WebServer.cpp: 153     Server Port: %d", ws_port);
-    return true;
+    setFdNonBlock(fd);
+    LOG_INFO(
+        "WebServer.cpp: 282     Server Port: %d, backlog: %d",
+        ws_port,
+        ws_options.listen_backlog);
+    return fd;
 }
 
 // 初始化epoll事件触发模式（ET/LT/ONESHOT等）
@@ -226,56 +513,54 @@ void WebServer::initEventMode(int trigmode) {
     HttpConn::is_et = (conn_event & EPOLLET);
 }
 
+// 创建线程池，thread_max大于threadnum时线程数可在两者之间伸缩
+std::unique_ptr<ThreadPool> WebServer::newThreadPool(int threadnum) const {
+    size_t maxthreads = static_cast<size_t>(
+        ws_options.thread_max > threadnum ? ws_options.thread_max : threadnum);
+    return std::make_unique<ThreadPool>(
+        static_cast<size_t>(threadnum),
+        maxthreads,
+        ws_options.thread_grow_wait_ms,
+        ws_options.thread_grow_depth,
+        ws_options.thread_idle_ms);
+}
+
 // 添加新客户端连接（私有成员函数）
-void WebServer::addClient(int fd, sockaddr_in addr) {
-    // 实现框架（待补充：初始化 HttpConn 对象、注册到 epoll 和定时器）
+void WebServer::addClient(int fd, sockaddr_in addr, EventLoop* loop) {
     assert(fd > 0);
-    users[fd].httpcnInit(fd, addr);
-    if (timeout_ms > 0) {
-        // std::cout << "WebServer.cpp : 189  " << timeout_ms << std::endl;
-        heap_timer->addTimeNode(
-            fd,
-            timeout_ms,
-            std::bind(&WebServer::closeConn, this, &users[fd]));
-    }
-    epoller->addFd(fd, EPOLLIN | conn_event);
     setFdNonBlock(fd);
-    LOG_INFO("WebServer.cpp: 193     Client[%d] in", users[fd].getFd());
+    if (loop) {
+        // 监听套接字注册在该循环上，当前线程就是该循环线程，直接添加
+        loop->addClient(fd, addr);
+    } else {
+        // 主Reactor负责accept：投递给子循环，由子循环线程完成注册
+        loop = nextLoop();
+        loop->queueInLoop([loop, fd, addr] { loop->addClient(fd, addr); });
+    }
 }
 
 // 处理监听套接字事件（私有成员函数）
-void WebServer::dealListen() {
-    // 实现框架（待补充：accept() 新连接、处理 ET 模式下的批量读取）
+void WebServer::dealListen(int listenfd, EventLoop* loop) {
     struct sockaddr_in addr;
     socklen_t len = sizeof(addr);
     do {
-        int fd = accept(listen_fd, (struct sockaddr*)&addr, &len);
-        if (fd < 0) {
+        len = sizeof(addr);
+        int fd = accept(listenfd, (struct sockaddr*)&addr, &len);
+        if (fd < 0 || !acceptClient(fd, addr, loop)) {
             return;
         }
-        if (HttpConn::user_count >= MAX_FD) {
-            sendError(fd, "Server busy!");
-            LOG_WARN("WebServer.cpp: 208     Client is full!");
-            return;
-        }
-        addClient(fd, addr);
     } while (listen_event & EPOLLET);
 }
 
-// 处理写事件（私有成员函数）
-void WebServer::dealWrite(HttpConn* client) {
-    // 实现框架（待补充：将写任务提交到线程池）
-    assert(client);
-    extentTime(client);
-    thread_pool->addTask(std::bind(&WebServer::onWrite, this, client));
-}
-
-// 处理读事件（私有成员函数）
-void WebServer::dealRead(HttpConn* client) {
-    // 实现框架（待补充：将读任务提交到线程池）
-    assert(client);
-    extentTime(client);
-    thread_pool->addTask(std::bind(&WebServer::onRead, this, client));
+// 接收一个已经accept的新连接（私有成员函数）
+bool WebServer::acceptClient(int fd, const sockaddr_in& addr, EventLoop* loop) {
+    if (HttpConn::user_count >= MAX_FD || fd >= MAX_FD) {
+        sendError(fd, "Server busy!");
+        LOG_WARN("WebServer.cpp: 208     Client is full!");
+        return false;
+    }
+    addClient(fd, addr, loop);
+    return true;
 }
 
 // 发送错误信息（私有成员函数）
@@ -289,73 +574,13 @@ void WebServer::sendError(int fd, const char* info) {
     close(fd);
 }
 
-// 延长连接超时时间（私有成员函数）
-void WebServer::extentTime(HttpConn* client) {
-    // 实现框架（待补充：调整堆定时器中的超时时间）
-    assert(client);
-    if (timeout_ms > 0) {
-        heap_timer->adjust(client->getFd(), timeout_ms);
-    }
-}
-
-// 关闭客户端连接（私有成员函数）
-void WebServer::closeConn(HttpConn* client) {
-    // 实现框架（待补充：从 epoll/定时器中移除连接，释放资源）
-    assert(client);
-    int fd = client->getFd();
-    // std::cout << "Closing connection for user with fd: " << fd << std::endl;
-    LOG_INFO("WebServer.cpp: 256     Client[%d] quit!", fd);
-    epoller->delDf(fd);
-    client->httpcnClose();
-}
-
-// 处理读事件逻辑（私有成员函数）
-void WebServer::onRead(HttpConn* client) {
-    // 实现框架（待补充：调用 HttpConn::read() 读取数据）
-    assert(client);
-    int ret = -1;
-    int readerror = 0;
-    ret = client->httpcnRead(&readerror);
-    if (ret <= 0 && readerror != EAGAIN) {
-        // std::cout << "WebServer.cpp : 270  " << ret << "  " << readerror <<
-        // std::endl;
-        closeConn(client);
-        return;
-    }
-    onProcess(client);
-}
-
-// 处理写事件逻辑（私有成员函数）
-void WebServer::onWrite(HttpConn* client) {
-    // 实现框架（待补充：调用 HttpConn::write() 发送数据）
-    assert(client);
-    int ret = -1;
-    int writeerror = 0;
-    ret = client->httpcnWrite(&writeerror);
-    if (client->toWriteBytes() == 0) {
-        if (client->isKeepAlive()) {
-            onProcess(client);
-            return;
-        }
-    } else if (ret < 0) {
-        if (writeerror == EAGAIN) {
-            epoller->modFd(client->getFd(), conn_event | EPOLLOUT);
-            return;
-        }
-    }
-    // std::cout << "WebServer.cpp: 295  " << ret << "  " << writeerror <<
-    // std::endl;
-    closeConn(client);
-}
-
-// 处理 HTTP 请求逻辑（私有成员函数）
-void WebServer::onProcess(HttpConn* client) {
-    // 实现框架（待补充：调用 HttpConn::process() 解析请求并生成响应）
-    if (client->process()) {
-        epoller->modFd(client->getFd(), conn_event | EPOLLOUT);
-    } else {
-        epoller->modFd(client->getFd(), conn_event | EPOLLIN);
-    }
+// 选择接收新连接的子事件循环（私有成员函数）
+EventLoop* WebServer::nextLoop() {
+    assert(!sub_loops.empty());
+    // 轮询分配，使各子循环的连接数大致均衡
+    EventLoop* loop = sub_loops[next_loop].get();
+    next_loop = (next_loop + 1) % sub_loops.size();
+    return loop;
 }
 
 // 设置文件描述符为非阻塞模式（静态成员函数）
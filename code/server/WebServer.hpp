@@ -3,14 +3,16 @@
 #include "../http/HttpConn.hpp"
 #include "../pool/threadpool.hpp"
 #include "../timer/HeapTimer.hpp"
-#include "Epoller.hpp"
+#include "EventLoop.hpp"
+#include "ServerOptions.hpp"
 #include <arpa/inet.h>
 #include <assert.h>
 #include <fcntl.h>
 #include <netinet/in.h>
 #include <sys/socket.h>
+#include <thread>
 #include <unistd.h>
-#include <unordered_map>
+#include <vector>
 
 // WebServer类：负责整个Web服务器的初始化、运行和资源管理
 class WebServer {
@@ -29,39 +31,39 @@ class WebServer {
         int threadnum,
         bool openlog,
         int loglevel,
-        int logquesize);
+        int logquesize,
+        const ServerOptions& options = ServerOptions());
 
     // 析构函数：释放所有资源
     ~WebServer();
 
     // 启动服务器主循环
     void start();
+    // 获取路由器，用于注册动态接口，只能在start()之前调用。
+    // 构造时已注册默认页面和登录/注册表单的路由
+    Router& router();
 
   private:
-    // 初始化监听套接字
+    // 初始化监听套接字，并按模式注册到主循环或各子循环
     bool initSocket();
+    // 创建、绑定并监听一个套接字，reuseport为真时设置SO_REUSEPORT
+    int createListenFd(bool reuseport);
     // 初始化epoll事件触发模式
     void initEventMode(int trigmode);
-    // 添加新客户端连接
-    void addClient(int fd, sockaddr_in addr);
-    // 处理监听套接字上的新连接
-    void dealListen();
-    // 处理写事件，将写任务交给线程池
-    void dealWrite(HttpConn* client);
-    // 处理读事件，将读任务交给线程池
-    void dealRead(HttpConn* client);
+    // 注册默认页面和登录/注册表单的路由
+    void initRoutes();
+    // 按运行参数创建线程池，threadnum为常驻线程数
+    std::unique_ptr<ThreadPool> newThreadPool(int threadnum) const;
+    // 添加新客户端连接，loop为空时轮询分发给子循环
+    void addClient(int fd, sockaddr_in addr, EventLoop* loop);
+    // 处理监听套接字上的新连接，loop为接收该连接的事件循环
+    void dealListen(int listenfd, EventLoop* loop);
+    // 接收一个已经accept的新连接，连接数已满时回复错误并关闭，返回false
+    bool acceptClient(int fd, const sockaddr_in& addr, EventLoop* loop);
     // 发送错误信息给客户端
     void sendError(int fd, const char* info);
-    // 延长连接的超时时间
-    void extentTime(HttpConn* client);
-    // 关闭客户端连接
-    void closeConn(HttpConn* client);
-    // 线程池中处理读事件的回调
-    void onRead(HttpConn* client);
-    // 线程池中处理写事件的回调
-    void onWrite(HttpConn* client);
-    // 处理HTTP请求的回调
-    void onProcess(HttpConn* client);
+    // 选择下一个接收新连接的子事件循环（轮询）
+    EventLoop* nextLoop();
     // 设置文件描述符为非阻塞
     static int setFdNonBlock(int fd);
     // 支持的最大客户端连接数
@@ -70,24 +72,36 @@ class WebServer {
     int ws_port;
     // 是否开启优雅关闭
     bool open_linger;
-    // 连接超时时间（毫秒）
+    // 长连接空闲超时时间（毫秒）
     int timeout_ms;
     // 服务器是否关闭
     bool is_close;
-    // 监听套接字文件描述符
-    int listen_fd;
+    // 监听套接字文件描述符（SO_REUSEPORT模式下每个子循环一个）
+    std::vector<int> listen_fds;
     // 静态资源目录路径
     char* src_dir;
     // 监听事件类型（ET/LT等）
     size_t listen_event;
     // 连接事件类型（ET/LT/ONESHOT等）
     size_t conn_event;
-    // 定时器，用于管理连接超时
-    std::unique_ptr<HeapTimer> heap_timer;
-    // 线程池，用于处理业务逻辑
+    // 可选运行参数
+    ServerOptions ws_options;
+    // 路由器，按方法和路径把请求分发给处理函数
+    Router ws_router;
+    // HttpConn对象池，连接建立时取出，关闭时归还
+    std::unique_ptr<HttpConnPool> conn_pool;
+    // 以fd为下标的连接槽位表，预先分配MAX_FD个槽位，所有事件循环共享
+    EventLoop::ConnSlab users;
+    // 线程池，用于处理业务逻辑（仅单Reactor模式且未开启混合分发）
     std::unique_ptr<ThreadPool> thread_pool;
-    // epoll实例，用于事件驱动
-    std::unique_ptr<Epoller> epoller;
-    // 保存所有客户端连接的映射表
-    std::unordered_map<int, HttpConn> users;
+    // 阻塞任务执行器，执行登录/注册等需要访问数据库的请求
+    std::unique_ptr<BlockingExecutor> blocking_executor;
+    // 主事件循环，负责监听套接字（单Reactor模式下也负责所有连接）
+    std::unique_ptr<EventLoop> main_loop;
+    // 子事件循环，主从Reactor模式下每个循环独占一个线程
+    std::vector<std::unique_ptr<EventLoop>> sub_loops;
+    // 运行子事件循环的线程
+    std::vector<std::thread> loop_threads;
+    // 下一个接收新连接的子循环下标
+    size_t next_loop;
 };
\ No newline at end of file
@@ -3,9 +3,8 @@
 #include <cstddef>
 
 // 构造函数
-HeapTimer::HeapTimer()
-    : heap_timer(std::vector<TimerNode>()),
-      heap_ref(std::unordered_map<size_t, size_t>()) {
+HeapTimer::HeapTimer(size_t idcapacity)
+    : heap_timer(std::vector<TimerNode>()), heap_ref(idcapacity, NPOS) {
     // 初始化定时器堆和索引映射
 }
 
@@ -16,7 +15,7 @@ HeapTimer::~HeapTimer() {
 
 // 调整定时器过期时间
 void HeapTimer::adjust(size_t id, size_t newexpires) {
-    assert(!heap_timer.empty() && heap_ref.count(id) > 0);
+    assert(!heap_timer.empty() && contains(id));
     // 更新过期时间
     heap_timer[heap_ref[id]].expires =
         std::chrono::high_resolution_clock::now() + static_cast<ms>(newexpires);
@@ -29,22 +28,25 @@ void HeapTimer::adjust(size_t id, size_t newexpires) {
 // 添加定时器节点
 void HeapTimer::addTimeNode(size_t id, size_t timeout, timeOutCallBack cb) {
     assert(id > 0);
-    if (heap_ref.count(id) == 0) {
+    if (id >= heap_ref.size()) {
+        heap_ref.resize(id + 1, NPOS);
+    }
+    if (heap_ref[id] == NPOS) {
         // 新增定时器节点
         heap_timer.emplace_back(
             id,
             std::chrono::high_resolution_clock::now()
                 + static_cast<ms>(timeout),
-            cb);
+            std::move(cb));
         heap_ref[id] = heap_timer.size() - 1;
         // 向上调整堆
         siftUp(heap_timer.size() - 1);
     } else {
         // 更新已有定时器节点
-        int i = heap_ref[id];
+        size_t i = heap_ref[id];
         heap_timer[i].expires = std::chrono::high_resolution_clock::now()
                                 + static_cast<ms>(timeout);
-        heap_timer[i].cb = cb;
+        heap_timer[i].cb = std::move(cb);
         // 调整堆结构
         if (!siftDown(i)) {
             siftUp(i);
@@ -54,26 +56,35 @@ void HeapTimer::addTimeNode(size_t id, size_t timeout, timeOutCallBack cb) {
 
 // 执行指定定时器任务
 void HeapTimer::doWork(size_t id) {
-    if (heap_timer.empty() || heap_ref.count(id) == 0) {
+    if (!contains(id)) {
         return;
     }
+    // 先删除再执行回调，回调中可能会增删定时器节点
+    timeOutCallBack cb = std::move(heap_timer[heap_ref[id]].cb);
+    del(heap_ref[id]);
     // 执行回调函数
-    heap_timer[heap_ref[id]].cb();
-    // 删除已执行的定时器
+    cb();
+}
+
+// 删除指定ID的定时器节点，不执行回调
+void HeapTimer::erase(size_t id) {
+    if (!contains(id)) {
+        return;
+    }
     del(heap_ref[id]);
 }
 
 // 清空定时器
 void HeapTimer::clear() {
     heap_timer.clear();
-    heap_ref.clear();
+    heap_ref.assign(heap_ref.size(), NPOS);
 }
 
 // 处理到期的定时器
 void HeapTimer::tick() {
     // 循环处理所有到期的定时器
     while (!heap_timer.empty()) {
-        TimerNode node = heap_timer.front();
+        TimerNode& node = heap_timer.front();
         // 检查是否到期
         if (std::chrono::duration_cast<ms>(
                 node.expires - std::chrono::high_resolution_clock::now())
@@ -81,10 +92,11 @@ void HeapTimer::tick() {
             > 0) {
             break;
         }
-        // 执行回调函数
-        node.cb();
-        // 移除已处理的定时器
+        // 先移除再执行回调，回调中可能会增删定时器节点
+        timeOutCallBack cb = std::move(node.cb);
         pop();
+        // 执行回调函数
+        cb();
     }
 }
 
@@ -118,11 +130,11 @@ void HeapTimer::del(size_t i) {
     // 将要删除的节点与最后一个节点交换
     swapNode(i, heap_timer.size() - 1);
     // 移除索引映射
-    heap_ref.erase(heap_timer[heap_timer.size() - 1].id);
+    heap_ref[heap_timer[heap_timer.size() - 1].id] = NPOS;
     // 删除最后一个节点
     heap_timer.pop_back();
-    // 调整堆结构
-    if (!heap_timer.empty() && !siftDown(i)) {
+    // 调整堆结构，被删除的恰好是最后一个节点时无需调整
+    if (i < heap_timer.size() && !siftDown(i)) {
         siftUp(i);
     }
 }
@@ -193,6 +205,11 @@ void HeapTimer::swapNode(size_t i, size_t j) {
     }
 }
 
+// 指定ID的定时器节点是否在堆中
+bool HeapTimer::contains(size_t id) const {
+    return id < heap_ref.size() && heap_ref[id] != NPOS;
+}
+
 // 定时器节点比较运算符
 bool TimerNode::operator<(TimerNode& t) {
     return expires < t.expires;
@@ -1,13 +1,14 @@
 #pragma once
 
+#include "../pool/Task.hpp"
 #include <assert.h>
 #include <chrono>
-#include <functional>
-#include <unordered_map>
+#include <cstddef>
 #include <vector>
 
 // 定义超时回调函数类型，该函数无参数且无返回值
-using timeOutCallBack = std::function<void()>;
+// 使用只可移动的Task，添加定时器时不申请堆内存
+using timeOutCallBack = Task;
 // 定义时间戳类型，使用高精度时钟的时间点
 using timestamp = std::chrono::high_resolution_clock::time_point;
 // 定义毫秒类型
@@ -16,7 +17,8 @@ using ms = std::chrono::milliseconds;
 // 定时器节点类，代表一个定时器任务
 class TimerNode {
    public:
-    TimerNode(size_t id, timestamp expires, timeOutCallBack cb) : id(id), expires(expires), cb(cb) {}
+    TimerNode(size_t id, timestamp expires, timeOutCallBack cb)
+        : id(id), expires(expires), cb(std::move(cb)) {}
     // 定时器节点的唯一标识符
     size_t id;
     // 定时器的过期时间点
@@ -28,10 +30,13 @@ class TimerNode {
 };
 
 // 堆定时器类，使用堆结构管理定时器节点
+// 定时器ID即连接的文件描述符，ID到堆中下标的映射是按ID下标访问的数组，
+// 增删定时器节点都不申请释放内存
 class HeapTimer {
    public:
-    // 构造函数，初始化堆定时器
-    HeapTimer();
+    // 构造函数，idcapacity为预先分配映射的ID个数（如连接表的大小），
+    // 更大的ID在第一次添加时扩容
+    explicit HeapTimer(size_t idcapacity = 0);
     // 析构函数，清理堆定时器资源
     ~HeapTimer();
     // 调整指定ID的定时器的过期时间
@@ -40,6 +45,8 @@ class HeapTimer {
     void addTimeNode(size_t id, size_t timeout, timeOutCallBack cb);
     // 执行指定ID的定时器任务
     void doWork(size_t id);
+    // 删除指定ID的定时器节点，不执行回调
+    void erase(size_t id);
     // 清除所有定时器节点
     void clear();
     // 检查并执行过期的定时器任务
@@ -58,9 +65,14 @@ class HeapTimer {
     bool siftDown(size_t i);
     // 交换两个索引对应的定时器节点
     void swapNode(size_t i, size_t j);
+    // 指定ID的定时器节点是否在堆中
+    bool contains(size_t id) const;
+
+    // 映射中表示ID没有定时器节点
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
 
     // 存储定时器节点的堆
     std::vector<TimerNode> heap_timer;
-    // 存储定时器ID到堆中索引的映射
-    std::unordered_map<size_t, size_t> heap_ref;
+    // 定时器ID到堆中索引的映射，按ID下标访问，没有节点时为NPOS
+    std::vector<size_t> heap_ref;
 };
\ No newline at end of file
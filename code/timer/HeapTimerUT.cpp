@@ -138,4 +138,71 @@ TEST_F(HeapTimerTest, MultipleTimersShouldMaintainPriority) {
     // 验证下一个是第三个定时器
     next = timer->getNextTick();
     ASSERT_LE(next, 200);
-}
\ No newline at end of file
+}
+/**
+ * 测试删除定时器
+ * 验证erase()删除节点后回调不会执行，且删除堆尾节点不会破坏堆
+ */
+TEST_F(HeapTimerTest, EraseShouldRemoveTimerWithoutCallback) {
+    timer->addTimeNode(1, 50, [this]() { callback1_executed = true; });
+    timer->addTimeNode(2, 100, [this]() { callback2_executed = true; });
+
+    // 删除堆尾节点，再删除不存在的节点
+    timer->erase(2);
+    timer->erase(3);
+
+    std::this_thread::sleep_for(110ms);
+    timer->tick();
+
+    ASSERT_TRUE(callback1_executed);
+    ASSERT_FALSE(callback2_executed);
+    ASSERT_EQ(timer->getNextTick(), -1);
+}
+
+/**
+ * 测试回调中删除其他定时器
+ * 验证tick()先移除到期节点再执行回调，回调中修改定时器是安全的
+ */
+TEST_F(HeapTimerTest, CallbackMayEraseOtherTimers) {
+    timer->addTimeNode(1, 10, [this]() {
+        callback1_executed = true;
+        timer->erase(2);
+    });
+    timer->addTimeNode(2, 1000, [this]() { callback2_executed = true; });
+    timer->addTimeNode(3, 2000, [this]() { callback3_executed = true; });
+
+    std::this_thread::sleep_for(20ms);
+    timer->tick();
+
+    ASSERT_TRUE(callback1_executed);
+    // 节点3仍然存在
+    int next = timer->getNextTick();
+    ASSERT_GT(next, 1000);
+    ASSERT_LE(next, 2000);
+}
+
+/**
+ * 测试ID超出预先分配的映射时自动扩容，到期的节点可以在回调中以同一ID重新加入
+ */
+TEST_F(HeapTimerTest, IdsShouldGrowAndBeReused) {
+    timer = std::make_unique<HeapTimer>(4);
+    int fired = 0;
+    timer->addTimeNode(1000, 10, [this, &fired]() {
+        fired++;
+        // 与事件循环的阶段检查相同：到期后以同一ID重新加入
+        timer->addTimeNode(1000, 10, [&fired]() { fired++; });
+    });
+    timer->addTimeNode(3, 2000, [this]() { callback3_executed = true; });
+
+    std::this_thread::sleep_for(20ms);
+    timer->tick();
+    ASSERT_EQ(fired, 1);
+    std::this_thread::sleep_for(20ms);
+    timer->tick();
+    ASSERT_EQ(fired, 2);
+
+    // 节点3不受影响，删除后堆为空
+    ASSERT_FALSE(callback3_executed);
+    timer->erase(3);
+    ASSERT_EQ(timer->getNextTick(), -1);
+}